@@ -75,8 +75,16 @@ void ExecuteCmd::runCmd(unsigned long cmdId, std::string cmd, bool deleteOnFinis
     }
 }
 
+void ExecuteCmd::setFinishedCallback(FinishedCallback callback)
+{
+    mutex_.lock();
+    finishedCallback_ = callback;
+    mutex_.unlock();
+}
+
 void ExecuteCmd::cmdFinished(unsigned long cmdId, bool bSuccess, std::string log, bool del)
 {
+    FinishedCallback callback;
     mutex_.lock();
     for (auto it = executingCmds_.begin(); it != executingCmds_.end(); ++it) {
         if ((*it)->cmdId == cmdId) {
@@ -87,11 +95,16 @@ void ExecuteCmd::cmdFinished(unsigned long cmdId, bool bSuccess, std::string log
                 (*it)->bFinished = true;
                 (*it)->bSuccess = bSuccess;
                 (*it)->log = log;
+                callback = finishedCallback_;
             }
             break;
         }
     }
     mutex_.unlock();
+
+    if (callback) {
+        callback(cmdId, bSuccess, log);
+    }
 }
 
 bool ExecuteCmd::isCmdExist(unsigned long cmdId)
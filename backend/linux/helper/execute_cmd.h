@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <stdio.h>
 #include <string>
 #include <list>
@@ -18,6 +19,10 @@ public:
     void getStatus(unsigned long cmdId, bool &bFinished, std::string &log);
     void clearCmds();
 
+    // called from the command thread when a command finishes (unless it is deleted on finish)
+    typedef std::function<void(unsigned long cmdId, bool bSuccess, const std::string &log)> FinishedCallback;
+    void setFinishedCallback(FinishedCallback callback);
+
 private:
     ExecuteCmd();
 
@@ -37,4 +42,5 @@ private:
 
     std::list<CmdDescr *> executingCmds_;
     std::mutex mutex_;
+    FinishedCallback finishedCallback_;
 };
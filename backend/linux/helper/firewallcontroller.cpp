@@ -3,7 +3,10 @@
 #include <algorithm>
 #include <fcntl.h>
 #include <fstream>
+#include <map>
+#include <set>
 #include <sstream>
+#include <unistd.h>
 
 #include "split_tunneling/cgroups.h"
 #include "logger.h"
@@ -12,6 +15,9 @@
 FirewallController::FirewallController() : splitTunnelEnabled_(false), splitTunnelExclude_(true)
 {
     connectStatus_.isConnected = false;
+    splitTunnelIpSet_.name = kSplitTunnelIpSet;
+    whitelistIpSet_.name = kWhitelistIpSet;
+    isIpSetAvailable_ = createIpSet(kSplitTunnelIpSet) && createIpSet(kWhitelistIpSet);
 
     // If firewall on boot is enabled, restore boot rules
     if (Utils::isFileExists("/etc/windscribe/boot_rules.v4")) {
@@ -55,9 +61,7 @@ bool FirewallController::enable(bool ipv6, const std::string &rules)
     }
 
     // reapply split tunneling rules if necessary
-    setSplitTunnelIpExceptions(splitTunnelIps_);
-    setSplitTunnelAppExceptions();
-    setSplitTunnelIngressRules();
+    updateSplitTunnelRules();
 
     return 0;
 }
@@ -93,139 +97,211 @@ void FirewallController::disable()
 
 void FirewallController::setSplitTunnelingEnabled(CMD_SEND_CONNECT_STATUS connectStatus, bool isEnabled, bool isExclude)
 {
-    prevAdapter_ = connectStatus.defaultAdapter.adapterName;
-
     connectStatus_ = connectStatus;
     splitTunnelEnabled_ = isEnabled;
     splitTunnelExclude_ = isExclude;
-    setSplitTunnelIpExceptions(splitTunnelIps_);
-    setSplitTunnelAppExceptions();
-    setSplitTunnelIngressRules();
+    updateSplitTunnelRules();
 }
 
-void FirewallController::removeExclusiveIpRules()
+void FirewallController::setSplitTunnelIpExceptions(const std::vector<std::string> &ips)
 {
-    for (auto ip : splitTunnelIps_) {
-        Utils::executeCommand("iptables", {"-D", "windscribe_input", "-s", ip.c_str(), "-j", "ACCEPT", "-m", "comment", "--comment", kTag});
-        Utils::executeCommand("iptables", {"-D", "windscribe_output", "-d", ip.c_str(), "-j", "ACCEPT", "-m", "comment", "--comment", kTag});
+    if (isIpSetAvailable_) {
+        syncIpSet(splitTunnelIpSet_, ips);
     }
-}
+    splitTunnelIps_ = ips;
 
-void FirewallController::removeInclusiveIpRules()
-{
-    Utils::executeCommand("iptables", {"-D", "windscribe_input", "-j", "ACCEPT", "-m", "comment", "--comment", kTag});
-    Utils::executeCommand("iptables", {"-D", "windscribe_output", "-j", "ACCEPT", "-m", "comment", "--comment", kTag});
+    // With the ipset the rules only reference the set, so changing the addresses does not touch the chains.
+    if (!isIpSetAvailable_) {
+        updateSplitTunnelRules();
+    }
 }
 
-void FirewallController::removeExclusiveAppRules()
+bool FirewallController::setWhitelist(const std::vector<std::string> &entries)
 {
-    Utils::executeCommand("iptables", {"-D", "OUTPUT", "-t", "mangle", "-m", "cgroup", "--cgroup", CGroups::instance().netClassId(), "-j", "MARK", "--set-mark", CGroups::instance().mark(), "-m", "comment", "--comment", kTag});
-    if (!prevAdapter_.empty()) {
-        Utils::executeCommand("iptables", {"-D", "POSTROUTING", "-t", "nat", "-m", "cgroup", "--cgroup", CGroups::instance().netClassId(), "-o", prevAdapter_.c_str(), "-j", "MASQUERADE", "-m", "comment", "--comment", kTag});
+    if (!isIpSetAvailable_) {
+        return false;
     }
-
-    Utils::executeCommand("iptables", {"-D", "windscribe_input", "-j", "ACCEPT", "-m", "comment", "--comment", kTag});
-    Utils::executeCommand("iptables", {"-D", "windscribe_output", "-j", "ACCEPT", "-m", "comment", "--comment", kTag});
+    return syncIpSet(whitelistIpSet_, entries);
 }
 
-void FirewallController::removeInclusiveAppRules()
+bool FirewallController::createIpSet(const std::string &name)
 {
-    Utils::executeCommand("iptables", {"-D", "OUTPUT", "-t", "mangle", "-m", "cgroup", "!", "--cgroup", CGroups::instance().netClassId(), "-j", "MARK", "--set-mark", CGroups::instance().mark(), "-m", "comment", "--comment", kTag});
-    if (!prevAdapter_.empty()) {
-        Utils::executeCommand("iptables", {"-D", "POSTROUTING", "-t", "nat", "-m", "cgroup", "!", "--cgroup", CGroups::instance().netClassId(), "-o", prevAdapter_.c_str(), "-j", "MASQUERADE", "-m", "comment", "--comment", kTag});
+    std::string output;
+    int ret = Utils::executeCommand("ipset", {"create", name, "hash:net", "family", "inet", "-exist"}, &output);
+    if (ret != 0) {
+        Logger::instance().out("ipset is not available, firewall and split tunneling IP lists fall back to per-address rules: %s", output.c_str());
+        return false;
     }
+    return true;
 }
 
-void FirewallController::setSplitTunnelIngressRules()
+bool FirewallController::syncIpSet(IpSet &ipSet, const std::vector<std::string> &entries)
 {
-    if (!connectStatus_.isConnected) {
-        Utils::executeCommand("iptables", {"-D", "PREROUTING", "-t", "mangle", "-i", connectStatus_.defaultAdapter.adapterName.c_str(), "!", "-s", connectStatus_.remoteIp.c_str(), "-j", "CONNMARK", "--set-mark", CGroups::instance().mark().c_str(), "-m", "comment", "--comment", kTag.c_str()});
-        Utils::executeCommand("iptables", {"-D", "OUTPUT", "-t", "mangle", "-j", "CONNMARK", "--restore-mark", "-m", "comment", "--comment", kTag});
-        return;
+    std::set<std::string> newEntries;
+    for (const auto &entry : entries) {
+        // the sets and the iptables rules are IPv4 only
+        if (entry.find(':') == std::string::npos) {
+            newEntries.insert(entry);
+        }
     }
 
-	addRule({"PREROUTING", "-t", "mangle", "-i", connectStatus_.defaultAdapter.adapterName.c_str(), "!", "-s", connectStatus_.remoteIp.c_str(), "-j", "CONNMARK", "--set-mark", CGroups::instance().mark(), "-m", "comment", "--comment", kTag});
-	addRule({"OUTPUT", "-t", "mangle", "-j", "CONNMARK", "--restore-mark", "-m", "comment", "--comment", kTag});
-}
-
-void FirewallController::setSplitTunnelAppExceptions()
-{
-    if (!connectStatus_.isConnected || !splitTunnelEnabled_) {
-        removeExclusiveAppRules();
-        removeInclusiveAppRules();
-        return;
+    // only the difference is sent to the kernel, in a single "ipset restore"
+    std::ostringstream script;
+    size_t changes = 0;
+    if (!ipSet.isSynced) {
+        script << "flush " << ipSet.name << "\n";
+        for (const auto &entry : newEntries) {
+            script << "add " << ipSet.name << " " << entry << "\n";
+        }
+        changes = newEntries.size() + 1;
+    } else {
+        // additions first, so an address moved into another prefix stays matched all the time
+        for (const auto &entry : newEntries) {
+            if (ipSet.entries.find(entry) == ipSet.entries.end()) {
+                script << "add " << ipSet.name << " " << entry << "\n";
+                changes++;
+            }
+        }
+        for (const auto &entry : ipSet.entries) {
+            if (newEntries.find(entry) == newEntries.end()) {
+                script << "del " << ipSet.name << " " << entry << "\n";
+                changes++;
+            }
+        }
     }
 
-    if (splitTunnelExclude_) {
-        removeInclusiveAppRules();
+    if (changes == 0) {
+        return true;
+    }
 
-        addRule({"POSTROUTING",  "-t", "nat", "-m", "cgroup", "--cgroup", CGroups::instance().netClassId(), "-o", connectStatus_.defaultAdapter.adapterName.c_str(), "-j", "MASQUERADE", "-m", "comment", "--comment", kTag});
-        addRule({"OUTPUT", "-t", "mangle", "-m", "cgroup", "--cgroup", CGroups::instance().netClassId(), "-j", "MARK", "--set-mark", CGroups::instance().mark(), "-m", "comment", "--comment", kTag});
+    const std::string filename = "/etc/windscribe/" + ipSet.name;
+    std::ofstream ofs(filename.c_str(), std::ios::trunc);
+    ofs << script.str();
+    ofs.close();
 
-        // allow packets from excluded apps, if firewall is on
-        if (enabled()) {
-            addRule({"windscribe_input", "-m", "cgroup", "--cgroup", CGroups::instance().netClassId(), "-j", "ACCEPT", "-m", "comment", "--comment", kTag});
-            addRule({"windscribe_output", "-m", "cgroup", "--cgroup", CGroups::instance().netClassId(), "-j", "ACCEPT", "-m", "comment", "--comment", kTag});
-        }
+    std::string output;
+    if (Utils::executeCommand("ipset", {"-exist", "-file", filename, "restore"}, &output) != 0) {
+        Logger::instance().out("Could not update ipset %s: %s", ipSet.name.c_str(), output.c_str());
+        // rebuild the whole set next time
+        ipSet.isSynced = false;
     } else {
-        removeExclusiveAppRules();
+        ipSet.entries = std::move(newEntries);
+        ipSet.isSynced = true;
+    }
+    unlink(filename.c_str());
+    return ipSet.isSynced;
+}
 
-        addRule({"POSTROUTING", "-t", "nat", "-m", "cgroup", "!", "--cgroup", CGroups::instance().netClassId(), "-o", connectStatus_.defaultAdapter.adapterName.c_str(), "-j", "MASQUERADE", "-m", "comment", "--comment", kTag});
-        addRule({"OUTPUT", "-t", "mangle", "-m", "cgroup", "!", "--cgroup", CGroups::instance().netClassId(), "-j", "MARK", "--set-mark", CGroups::instance().mark(), "-m", "comment", "--comment", kTag});
+std::vector<FirewallController::Rule> FirewallController::splitTunnelRules()
+{
+    std::vector<Rule> rules;
+    if (!connectStatus_.isConnected) {
+        return rules;
+    }
 
-        // For inclusive, allow all packets
-        if (enabled()) {
-            addRule({"windscribe_input", "-j", "ACCEPT", "-m", "comment", "--comment", kTag});
-            addRule({"windscribe_output", "-j", "ACCEPT", "-m", "comment", "--comment", kTag});
+    if (splitTunnelEnabled_) {
+        const std::string cgroup = "-m cgroup " + std::string(splitTunnelExclude_ ? "" : "! ") + "--cgroup " + CGroups::instance().netClassId();
+        const std::string &adapter = connectStatus_.defaultAdapter.adapterName;
+        bool isFirewallEnabled = enabled();
+
+        // IP exceptions
+        if (isFirewallEnabled) {
+            if (splitTunnelExclude_) {
+                if (isIpSetAvailable_) {
+                    rules.push_back({"filter", "windscribe_input -m set --match-set " + kSplitTunnelIpSet + " src -j ACCEPT"});
+                    rules.push_back({"filter", "windscribe_output -m set --match-set " + kSplitTunnelIpSet + " dst -j ACCEPT"});
+                } else {
+                    for (const auto &ip : splitTunnelIps_) {
+                        // iptables is IPv4 only, an IPv6 address would fail the whole restore
+                        if (ip.find(':') != std::string::npos) {
+                            continue;
+                        }
+                        rules.push_back({"filter", "windscribe_input -s " + ip + " -j ACCEPT"});
+                        rules.push_back({"filter", "windscribe_output -d " + ip + " -j ACCEPT"});
+                    }
+                }
+            } else {
+                // For inclusive, allow all packets; these rules only apply to non-included apps
+                rules.push_back({"filter", "windscribe_input -j ACCEPT"});
+                rules.push_back({"filter", "windscribe_output -j ACCEPT"});
+            }
+        }
+
+        // app exceptions
+        rules.push_back({"nat", "POSTROUTING " + cgroup + " -o " + adapter + " -j MASQUERADE"});
+        rules.push_back({"mangle", "OUTPUT " + cgroup + " -j MARK --set-mark " + CGroups::instance().mark()});
+        if (isFirewallEnabled && splitTunnelExclude_) {
+            // allow packets from excluded apps
+            rules.push_back({"filter", "windscribe_input " + cgroup + " -j ACCEPT"});
+            rules.push_back({"filter", "windscribe_output " + cgroup + " -j ACCEPT"});
         }
     }
+
+    // ingress rules
+    rules.push_back({"mangle", "PREROUTING -i " + connectStatus_.defaultAdapter.adapterName + " ! -s " + connectStatus_.remoteIp + " -j CONNMARK --set-mark " + CGroups::instance().mark()});
+    rules.push_back({"mangle", "OUTPUT -j CONNMARK --restore-mark"});
+    return rules;
 }
 
-void FirewallController::setSplitTunnelIpExceptions(const std::vector<std::string> &ips)
+void FirewallController::updateSplitTunnelRules()
 {
-    if (!connectStatus_.isConnected || !splitTunnelEnabled_ || !enabled()) {
-        removeInclusiveIpRules();
-        removeExclusiveIpRules();
-        splitTunnelIps_ = ips;
+    // table -> commands, deletions of the current rules first, then the new rules, all committed in one transaction
+    std::map<std::string, std::vector<std::string>> commands;
+
+    std::string output;
+    if (Utils::executeCommand("iptables-save", {}, &output, false) != 0) {
+        Logger::instance().out("Could not read firewall rules: %s", output.c_str());
         return;
     }
 
-    // Otherwise, split tunneling is still enabled.
-    if (splitTunnelExclude_) {
-        removeInclusiveIpRules();
-
-        // For exclusive, remove rules for addresses no longer in "ips"
-        for (auto ip : splitTunnelIps_) {
-            if (std::find(ips.begin(), ips.end(), ip) == ips.end()) {
-                Utils::executeCommand("iptables", {"-D", "windscribe_input", "-s", ip.c_str(), "-j", "ACCEPT", "-m", "comment", "--comment", kTag});
-                Utils::executeCommand("iptables", {"-D", "windscribe_output", "-d", ip.c_str(), "-j", "ACCEPT", "-m", "comment", "--comment", kTag});
+    // Split tunneling rules are deleted by their saved spec. Older versions tagged them with kTag, which in the
+    // nat and mangle tables is used by split tunneling only.
+    const std::string splitTunnelComment = "--comment \"" + kSplitTunnelTag + "\"";
+    const std::string legacyComment = "--comment \"" + kTag + "\"";
+    std::istringstream stream(output);
+    std::string line;
+    std::string table;
+    while (std::getline(stream, line)) {
+        if (!line.empty() && line[0] == '*') {
+            table = line.substr(1);
+        } else if (line.compare(0, 3, "-A ") == 0) {
+            if (line.find(splitTunnelComment) != std::string::npos ||
+                ((table == "nat" || table == "mangle") && line.find(legacyComment) != std::string::npos)) {
+                commands[table].push_back("-D " + line.substr(3));
             }
         }
+    }
 
-        // Add rules for new IPs
-        for (auto ip : ips) {
-            addRule({"windscribe_input", "-s", ip.c_str(), "-j", "ACCEPT", "-m", "comment", "--comment", kTag});
-            addRule({"windscribe_output", "-d", ip.c_str(), "-j", "ACCEPT", "-m", "comment", "--comment", kTag});
+    // rules are inserted at the top of the chains, so the last one ends up first
+    std::set<std::pair<std::string, std::string>> added;
+    for (const auto &rule : splitTunnelRules()) {
+        if (added.insert(std::make_pair(rule.table, rule.spec)).second) {
+            commands[rule.table].push_back("-I " + rule.spec + " -m comment " + splitTunnelComment);
         }
-    } else {
-        removeExclusiveIpRules();
+    }
 
-        // For inclusive, keep the "allow all" rules; these rules only apply to non-included apps
-        addRule({"windscribe_input", "-j", "ACCEPT", "-m", "comment", "--comment", kTag});
-        addRule({"windscribe_output", "-j", "ACCEPT", "-m", "comment", "--comment", kTag});
+    std::ostringstream script;
+    for (const auto &it : commands) {
+        if (it.second.empty()) {
+            continue;
+        }
+        script << "*" << it.first << "\n";
+        for (const auto &cmd : it.second) {
+            script << cmd << "\n";
+        }
+        script << "COMMIT\n";
+    }
+    if (script.tellp() == 0) {
+        return;
     }
 
-    splitTunnelIps_ = ips;
-}
+    const std::string filename = "/etc/windscribe/split_tunnel_rules.v4";
+    std::ofstream ofs(filename.c_str(), std::ios::trunc);
+    ofs << script.str();
+    ofs.close();
 
-void FirewallController::addRule(const std::vector<std::string> &args)
-{
-    std::vector<std::string> checkArgs = args;
-    checkArgs.insert(checkArgs.begin(), "-C");
-    int ret = Utils::executeCommand("iptables", checkArgs);
-    if (ret) {
-        std::vector<std::string> insertArgs = args;
-        insertArgs.insert(insertArgs.begin(), "-I");
-        Utils::executeCommand("iptables", insertArgs);
+    if (Utils::executeCommand("iptables-restore", {"-n", filename}, &output) != 0) {
+        Logger::instance().out("Could not apply split tunneling rules: %s", output.c_str());
     }
+    unlink(filename.c_str());
 }
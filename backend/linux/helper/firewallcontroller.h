@@ -1,5 +1,6 @@
 #pragma once
 
+#include <set>
 #include <string>
 #include <vector>
 #include "../../posix_common/helper_commands.h"
@@ -8,6 +9,9 @@ class FirewallController
 {
 public:
     inline static const std::string kTag = "Windscribe client rule";
+    inline static const std::string kSplitTunnelTag = "Windscribe client split tunnel rule";
+    inline static const std::string kSplitTunnelIpSet = "windscribe_split_ips";
+    inline static const std::string kWhitelistIpSet = HELPER_FIREWALL_WHITELIST_IPSET;
 
     static FirewallController & instance()
     {
@@ -22,22 +26,38 @@ public:
 
     void setSplitTunnelingEnabled(CMD_SEND_CONNECT_STATUS connectStatus_, bool isEnabled, bool isExclude);
     void setSplitTunnelIpExceptions(const std::vector<std::string> &ips);
+    // the addresses allowed by the client rules; returns false if ipset is not available, then the client has to use a rule per address
+    bool setWhitelist(const std::vector<std::string> &entries);
 
 private:
     FirewallController();
     ~FirewallController();
 
+    // a rule in iptables-restore syntax without the "-I" command, e.g. "OUTPUT -j ACCEPT"
+    struct Rule
+    {
+        std::string table;
+        std::string spec;
+    };
+
+    // an ipset and the entries it holds, only the difference is sent to the kernel on change
+    struct IpSet
+    {
+        std::string name;
+        std::set<std::string> entries;
+        bool isSynced = false;  // false if the entries are unknown, then the set is rebuilt
+    };
+
     CMD_SEND_CONNECT_STATUS connectStatus_;
     bool splitTunnelEnabled_;
     bool splitTunnelExclude_;
     std::vector<std::string> splitTunnelIps_;
-    std::string prevAdapter_;
-
-    void removeExclusiveIpRules();
-    void removeInclusiveIpRules();
-    void removeExclusiveAppRules();
-    void removeInclusiveAppRules();
-    void setSplitTunnelAppExceptions();
-    void setSplitTunnelIngressRules();
-    void addRule(const std::vector<std::string> &args);
+    bool isIpSetAvailable_;
+    IpSet splitTunnelIpSet_;
+    IpSet whitelistIpSet_;
+
+    bool createIpSet(const std::string &name);
+    bool syncIpSet(IpSet &ipSet, const std::vector<std::string> &entries);
+    std::vector<Rule> splitTunnelRules();
+    void updateSplitTunnelRules();
 };
@@ -0,0 +1,237 @@
+#include "command_server.h"
+
+#include <boost/archive/text_oarchive.hpp>
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/serialization/vector.hpp>
+#include <sstream>
+#include <unistd.h>
+
+#include "../../../posix_common/helper_commands_serialize.h"
+#include "../logger.h"
+
+CommandServer::CommandServer(boost::asio::io_service &service, CommandHandler commandHandler, PeerCheck peerCheck)
+    : service_(service), commandHandler_(commandHandler), peerCheck_(peerCheck)
+{
+}
+
+CommandServer::~CommandServer()
+{
+    stop();
+}
+
+void CommandServer::start()
+{
+    if (workerThread_) {
+        return;
+    }
+    workerService_.reset();
+    workerWork_.reset(new boost::asio::io_service::work(workerService_));
+    workerThread_.reset(new std::thread([this]() { workerService_.run(); }));
+}
+
+void CommandServer::stop()
+{
+    workerWork_.reset();
+    workerService_.stop();
+    if (workerThread_ && workerThread_->joinable()) {
+        workerThread_->join();
+    }
+    workerThread_.reset();
+}
+
+void CommandServer::addConnection(socket_ptr sock)
+{
+    boost::shared_ptr<boost::asio::streambuf> buf(new boost::asio::streambuf);
+    boost::asio::async_read(*sock, *buf, boost::asio::transfer_at_least(1),
+                            [this, sock, buf](const boost::system::error_code &ec, std::size_t bytes_transferred) {
+        receiveCmdHandle(sock, buf, ec, bytes_transferred);
+    });
+}
+
+bool CommandServer::readAndHandleCommand(socket_ptr sock, boost::asio::streambuf *buf)
+{
+    // not enough data for read command
+    if (buf->size() < sizeof(int)*3) {
+        return false;
+    }
+
+    const char *bufPtr = boost::asio::buffer_cast<const char*>(buf->data());
+
+    uint32_t magic;
+    memcpy(&magic, bufPtr, sizeof(magic));
+    if (magic == HelperProtocol::kMagic) {
+        if (buf->size() < sizeof(HelperProtocol::Header)) {
+            return false;
+        }
+        HelperProtocol::Header header;
+        memcpy(&header, bufPtr, sizeof(header));
+        if (!HelperProtocol::isValidHeader(header) || header.type != HelperProtocol::kRequest) {
+            Logger::instance().out("invalid message header (version %d, type %d, length %u)", header.version, header.type, header.length);
+            sock->close();
+            return false;
+        }
+        if (buf->size() < sizeof(header) + header.length) {
+            return false;
+        }
+        if (!peerCheck_(sock)) {
+            return false;
+        }
+
+        std::string packet(bufPtr + sizeof(header), header.length);
+        buf->consume(sizeof(header) + header.length);
+        if (framedSockets_.insert(sock).second) {
+            Logger::instance().out("client app uses protocol version %d", header.version);
+        }
+        handleFramedRequest(sock, header, std::move(packet));
+        return true;
+    }
+
+    size_t headerSize = 0;
+    int cmdId;
+    memcpy(&cmdId, bufPtr + headerSize, sizeof(cmdId));
+    headerSize += sizeof(cmdId);
+    pid_t pid;
+    memcpy(&pid, bufPtr + headerSize, sizeof(pid));
+    headerSize += sizeof(pid);
+    int length;
+    memcpy(&length, bufPtr + headerSize, sizeof(length));
+    headerSize += sizeof(length);
+
+    // not enough data for read command
+    if (buf->size() < (headerSize + length)) {
+        return false;
+    }
+
+    if (!peerCheck_(sock)) {
+        return false;
+    }
+
+    std::string packet(bufPtr + headerSize, length);
+    buf->consume(headerSize + length);
+    handleLegacyCommand(sock, cmdId, std::move(packet));
+    return true;
+}
+
+void CommandServer::handleLegacyCommand(socket_ptr sock, int cmdId, std::string packet)
+{
+    // the legacy client waits for each answer, so the answers stay in order
+    workerService_.post([this, sock, cmdId, packet]() {
+        CMD_ANSWER cmdAnswer = commandHandler_(cmdId, packet);
+        service_.post([this, sock, cmdAnswer]() {
+            if (!sendAnswerCmd(sock, cmdAnswer)) {
+                Logger::instance().out("client app disconnected");
+            }
+        });
+    });
+}
+
+void CommandServer::handleFramedRequest(socket_ptr sock, const HelperProtocol::Header &header, std::string packet)
+{
+    const uint32_t requestId = header.requestId;
+    const int cmdId = header.id;
+
+    // status polling only reads the ExecuteCmd state, answer it right away instead of queueing behind slow commands
+    if (cmdId == HELPER_CMD_GET_CMD_STATUS) {
+        std::string answer = serializeAnswer(commandHandler_(cmdId, packet));
+        sendMessage(sock, HelperProtocol::makeMessage(HelperProtocol::kAnswer, requestId, cmdId, getpid(), answer));
+        return;
+    }
+
+    workerService_.post([this, sock, requestId, cmdId, packet]() {
+        std::string answer = serializeAnswer(commandHandler_(cmdId, packet));
+        std::string message = HelperProtocol::makeMessage(HelperProtocol::kAnswer, requestId, cmdId, getpid(), answer);
+        service_.post([this, sock, message]() {
+            sendMessage(sock, message);
+        });
+    });
+}
+
+void CommandServer::broadcastEvent(int eventId, const std::string &payload)
+{
+    std::string message = HelperProtocol::makeMessage(HelperProtocol::kEvent, 0, eventId, getpid(), payload);
+
+    service_.post([this, message]() {
+        std::set<socket_ptr> sockets = framedSockets_;
+        for (auto &sock : sockets) {
+            sendMessage(sock, message);
+        }
+    });
+}
+
+void CommandServer::setLastConnectionClosedHandler(ClosedHandler handler)
+{
+    lastConnectionClosedHandler_ = handler;
+}
+
+void CommandServer::removeFramedSocket(socket_ptr sock)
+{
+    if (framedSockets_.erase(sock) && framedSockets_.empty() && lastConnectionClosedHandler_) {
+        lastConnectionClosedHandler_();
+    }
+}
+
+void CommandServer::receiveCmdHandle(socket_ptr sock, boost::shared_ptr<boost::asio::streambuf> buf, const boost::system::error_code &ec, std::size_t bytes_transferred)
+{
+    (void)bytes_transferred;
+
+    if (!ec.value()) {
+        // read and handle commands, the answers are sent when they are ready
+        while (readAndHandleCommand(sock, buf.get())) {
+        }
+
+        if (!sock->is_open()) {
+            removeFramedSocket(sock);
+            return;
+        }
+
+        // goto receive next commands
+        boost::asio::async_read(*sock, *buf, boost::asio::transfer_at_least(1),
+                                [this, sock, buf](const boost::system::error_code &ec, std::size_t bytes_transferred) {
+            receiveCmdHandle(sock, buf, ec, bytes_transferred);
+        });
+    } else {
+        removeFramedSocket(sock);
+        Logger::instance().out("client app disconnected");
+    }
+}
+
+std::string CommandServer::serializeAnswer(const CMD_ANSWER &cmdAnswer)
+{
+    std::stringstream stream;
+    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
+    oa << cmdAnswer;
+    return stream.str();
+}
+
+bool CommandServer::sendAnswerCmd(socket_ptr sock, const CMD_ANSWER &cmdAnswer)
+{
+    std::string str = serializeAnswer(cmdAnswer);
+    int length = (int)str.length();
+    // send answer to client
+    boost::system::error_code er;
+    boost::asio::write(*sock, boost::asio::buffer(&length, sizeof(length)), boost::asio::transfer_exactly(sizeof(length)), er);
+    if (er.value()) {
+        return false;
+    } else {
+        boost::asio::write(*sock, boost::asio::buffer(str.data(), str.length()), boost::asio::transfer_exactly(str.length()), er);
+        if (er.value()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CommandServer::sendMessage(socket_ptr sock, const std::string &message)
+{
+    if (!sock->is_open()) {
+        return false;
+    }
+
+    boost::system::error_code er;
+    boost::asio::write(*sock, boost::asio::buffer(message.data(), message.size()), boost::asio::transfer_exactly(message.size()), er);
+    if (er.value()) {
+        removeFramedSocket(sock);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <boost/shared_ptr.hpp>
+#include <functional>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+
+#include "../../../posix_common/helper_commands.h"
+#include "../../../posix_common/helper_protocol.h"
+
+typedef boost::shared_ptr<boost::asio::local::stream_protocol::socket> socket_ptr;
+
+// The engine connections of the helper: reads the requests of both the framed and the legacy protocol, runs the
+// commands and sends the answers and events back. Sockets are read and written on the thread of the io_service.
+class CommandServer
+{
+public:
+    typedef std::function<CMD_ANSWER(int cmdId, const std::string &packet)> CommandHandler;
+    typedef std::function<bool(socket_ptr sock)> PeerCheck;
+    typedef std::function<void()> ClosedHandler;
+
+    CommandServer(boost::asio::io_service &service, CommandHandler commandHandler, PeerCheck peerCheck);
+    ~CommandServer();
+
+    // starts and stops the worker thread which runs the commands
+    void start();
+    void stop();
+
+    // starts reading the requests of a connected socket
+    void addConnection(socket_ptr sock);
+    // can be called from any thread, the event is sent to the framed connections from the socket thread
+    void broadcastEvent(int eventId, const std::string &payload);
+    // called on the socket thread when the last framed connection is closed, so that nobody receives the events
+    void setLastConnectionClosedHandler(ClosedHandler handler);
+
+private:
+    boost::asio::io_service &service_;
+    CommandHandler commandHandler_;
+    PeerCheck peerCheck_;
+    ClosedHandler lastConnectionClosedHandler_;
+
+    // Commands which change the system state run here one at a time, in arrival order, so that the socket
+    // thread keeps reading requests and answering the cheap ones while a slow command executes.
+    boost::asio::io_service workerService_;
+    std::unique_ptr<boost::asio::io_service::work> workerWork_;
+    std::unique_ptr<std::thread> workerThread_;
+
+    // connections using the framed protocol, which receive events; accessed from the socket thread only
+    std::set<socket_ptr> framedSockets_;
+
+    bool readAndHandleCommand(socket_ptr sock, boost::asio::streambuf *buf);
+    void handleLegacyCommand(socket_ptr sock, int cmdId, std::string packet);
+    void handleFramedRequest(socket_ptr sock, const HelperProtocol::Header &header, std::string packet);
+    void removeFramedSocket(socket_ptr sock);
+    void receiveCmdHandle(socket_ptr sock, boost::shared_ptr<boost::asio::streambuf> buf, const boost::system::error_code &ec, std::size_t bytes_transferred);
+
+    static std::string serializeAnswer(const CMD_ANSWER &cmdAnswer);
+    bool sendAnswerCmd(socket_ptr sock, const CMD_ANSWER &cmdAnswer);
+    bool sendMessage(socket_ptr sock, const std::string &message);
+};
@@ -223,6 +223,17 @@ CMD_ANSWER getWireGuardStatus(boost::archive::text_iarchive &ia)
     return answer;
 }
 
+CMD_ANSWER subscribeWireGuardStatus(boost::archive::text_iarchive &ia)
+{
+    CMD_ANSWER answer;
+    CMD_SUBSCRIBE_WIREGUARD_STATUS cmd;
+    ia >> cmd;
+
+    WireGuardController::instance().subscribeStatus(cmd.statsIntervalMs);
+    answer.executed = 1;
+    return answer;
+}
+
 CMD_ANSWER changeMtu(boost::archive::text_iarchive &ia)
 {
     CMD_ANSWER answer;
@@ -296,6 +307,17 @@ CMD_ANSWER getFirewallRules(boost::archive::text_iarchive &ia)
     return answer;
 }
 
+CMD_ANSWER setFirewallWhitelist(boost::archive::text_iarchive &ia)
+{
+    CMD_ANSWER answer;
+    CMD_SET_FIREWALL_WHITELIST cmd;
+    ia >> cmd;
+
+    answer.executed = 1;
+    answer.exitCode = FirewallController::instance().setWhitelist(cmd.entries) ? 1 : 0;
+    return answer;
+}
+
 CMD_ANSWER setFirewallOnBoot(boost::archive::text_iarchive &ia)
 {
     CMD_ANSWER answer;
@@ -18,12 +18,14 @@ CMD_ANSWER startWireGuard(boost::archive::text_iarchive &ia);
 CMD_ANSWER stopWireGuard(boost::archive::text_iarchive &ia);
 CMD_ANSWER configureWireGuard(boost::archive::text_iarchive &ia);
 CMD_ANSWER getWireGuardStatus(boost::archive::text_iarchive &ia);
+CMD_ANSWER subscribeWireGuardStatus(boost::archive::text_iarchive &ia);
 CMD_ANSWER changeMtu(boost::archive::text_iarchive &ia);
 CMD_ANSWER setDnsLeakProtectEnabled(boost::archive::text_iarchive &ia);
 CMD_ANSWER clearFirewallRules(boost::archive::text_iarchive &ia);
 CMD_ANSWER checkFirewallState(boost::archive::text_iarchive &ia);
 CMD_ANSWER setFirewallRules(boost::archive::text_iarchive &ia);
 CMD_ANSWER getFirewallRules(boost::archive::text_iarchive &ia);
+CMD_ANSWER setFirewallWhitelist(boost::archive::text_iarchive &ia);
 CMD_ANSWER setFirewallOnBoot(boost::archive::text_iarchive &ia);
 CMD_ANSWER setMacAddress(boost::archive::text_iarchive &ia);
 CMD_ANSWER taskKill(boost::archive::text_iarchive &ia);
@@ -42,12 +44,14 @@ static const std::map<const int, std::function<CMD_ANSWER(boost::archive::text_i
     { HELPER_CMD_STOP_WIREGUARD, stopWireGuard },
     { HELPER_CMD_CONFIGURE_WIREGUARD, configureWireGuard },
     { HELPER_CMD_GET_WIREGUARD_STATUS, getWireGuardStatus },
+    { HELPER_CMD_SUBSCRIBE_WIREGUARD_STATUS, subscribeWireGuardStatus },
     { HELPER_CMD_CHANGE_MTU, changeMtu },
     { HELPER_CMD_SET_DNS_LEAK_PROTECT_ENABLED, setDnsLeakProtectEnabled },
     { HELPER_CMD_CLEAR_FIREWALL_RULES, clearFirewallRules },
     { HELPER_CMD_CHECK_FIREWALL_STATE, checkFirewallState },
     { HELPER_CMD_SET_FIREWALL_RULES, setFirewallRules },
     { HELPER_CMD_GET_FIREWALL_RULES, getFirewallRules },
+    { HELPER_CMD_SET_FIREWALL_WHITELIST, setFirewallWhitelist },
     { HELPER_CMD_SET_FIREWALL_ON_BOOT, setFirewallOnBoot },
     { HELPER_CMD_SET_MAC_ADDRESS, setMacAddress },
     { HELPER_CMD_TASK_KILL, taskKill },
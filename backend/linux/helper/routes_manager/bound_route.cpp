@@ -1,5 +1,6 @@
 #include "bound_route.h"
-#include "../utils.h"
+#include <string.h>
+#include "netlink_routes.h"
 #include "../logger.h"
 
 BoundRoute::BoundRoute() : isBoundRouteAdded_(false)
@@ -19,19 +20,38 @@ void BoundRoute::create(const std::string &ipAddress, const std::string &interfa
     ipAddress_ = ipAddress;
     interfaceName_ = interfaceName;
 
-    std::string cmd = "ip route add -net 0.0.0.0 via " + ipAddress_ + " dev " + interfaceName_;
-    Logger::instance().out("execute: %s", cmd.c_str());
-    Utils::executeCommand(cmd);
-    isBoundRouteAdded_ = true;
+    NetlinkRoutes::Route route;
+    route.ip = "0.0.0.0";
+    route.prefixLength = 0;
+    route.gateway = ipAddress_;
+    route.interface = interfaceName_;
+    int result = NetlinkRoutes::add({ route }).front();
+    if (result == 0)
+    {
+        Logger::instance().out("bound route added: %s", route.toString().c_str());
+        isBoundRouteAdded_ = true;
+    }
+    else
+    {
+        // do not take ownership of an existing default route, otherwise remove() would delete it
+        Logger::instance().out("failed to add bound route %s: %s", route.toString().c_str(), strerror(result));
+    }
 }
 
 void BoundRoute::remove()
 {
     if (isBoundRouteAdded_)
     {
-        std::string cmd = "ip route delete -net 0.0.0.0 via " + ipAddress_ + " dev " + interfaceName_;
-        Logger::instance().out("execute: %s", cmd.c_str());
-        Utils::executeCommand(cmd);
+        NetlinkRoutes::Route route;
+        route.ip = "0.0.0.0";
+        route.prefixLength = 0;
+        route.gateway = ipAddress_;
+        route.interface = interfaceName_;
+        int result = NetlinkRoutes::remove({ route }).front();
+        if (result == 0)
+            Logger::instance().out("bound route deleted: %s", route.toString().c_str());
+        else
+            Logger::instance().out("failed to delete bound route %s: %s", route.toString().c_str(), strerror(result));
         isBoundRouteAdded_ = false;
     }
 }
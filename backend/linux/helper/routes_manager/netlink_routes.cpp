@@ -0,0 +1,301 @@
+#include "netlink_routes.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "../logger.h"
+
+namespace
+{
+
+const int kReceiveTimeoutMs = 2000;
+const size_t kReceiveBufferSize = 64 * 1024;
+
+// room for nlmsghdr + rtmsg + RTA_DST, RTA_GATEWAY, RTA_OIF
+const size_t kMaxRouteMessageSize = NLMSG_SPACE(sizeof(rtmsg)) + 3 * RTA_SPACE(sizeof(uint32_t));
+
+void addAttr(nlmsghdr *nh, unsigned short type, const void *data, size_t len)
+{
+    rtattr *rta = reinterpret_cast<rtattr *>(reinterpret_cast<char *>(nh) + NLMSG_ALIGN(nh->nlmsg_len));
+    rta->rta_type = type;
+    rta->rta_len = RTA_LENGTH(len);
+    memcpy(RTA_DATA(rta), data, len);
+    nh->nlmsg_len = NLMSG_ALIGN(nh->nlmsg_len) + RTA_ALIGN(rta->rta_len);
+}
+
+std::string addressToString(const void *data)
+{
+    char buf[INET_ADDRSTRLEN];
+    if (inet_ntop(AF_INET, data, buf, sizeof(buf)) == nullptr)
+        return std::string();
+    return buf;
+}
+
+// fills the message for the route, returns 0 or an errno value if the route is invalid
+int buildRouteMessage(nlmsghdr *nh, int type, uint32_t seq, const NetlinkRoutes::Route &route)
+{
+    in_addr dst, gateway;
+    if (inet_pton(AF_INET, route.ip.c_str(), &dst) != 1 || route.prefixLength < 0 || route.prefixLength > 32)
+        return EINVAL;
+    if (!route.gateway.empty() && inet_pton(AF_INET, route.gateway.c_str(), &gateway) != 1)
+        return EINVAL;
+    uint32_t ifIndex = 0;
+    if (!route.interface.empty()) {
+        ifIndex = if_nametoindex(route.interface.c_str());
+        if (ifIndex == 0)
+            return ENODEV;
+    }
+
+    memset(nh, 0, kMaxRouteMessageSize);
+    nh->nlmsg_len = NLMSG_LENGTH(sizeof(rtmsg));
+    nh->nlmsg_type = type;
+    nh->nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK;
+    if (type == RTM_NEWROUTE)
+        nh->nlmsg_flags |= NLM_F_CREATE | NLM_F_EXCL;   // same as "ip route add"
+    nh->nlmsg_seq = seq;
+
+    rtmsg *rtm = static_cast<rtmsg *>(NLMSG_DATA(nh));
+    rtm->rtm_family = AF_INET;
+    rtm->rtm_dst_len = route.prefixLength;
+    rtm->rtm_table = RT_TABLE_MAIN;
+    if (type == RTM_NEWROUTE) {
+        rtm->rtm_protocol = RTPROT_BOOT;
+        rtm->rtm_scope = route.gateway.empty() ? RT_SCOPE_LINK : RT_SCOPE_UNIVERSE;
+        rtm->rtm_type = RTN_UNICAST;
+    } else {
+        rtm->rtm_scope = RT_SCOPE_NOWHERE;
+    }
+
+    addAttr(nh, RTA_DST, &dst, sizeof(dst));
+    if (!route.gateway.empty())
+        addAttr(nh, RTA_GATEWAY, &gateway, sizeof(gateway));
+    if (ifIndex != 0)
+        addAttr(nh, RTA_OIF, &ifIndex, sizeof(ifIndex));
+    return 0;
+}
+
+} // namespace
+
+std::string NetlinkRoutes::Route::toString() const
+{
+    std::string str = ip + "/" + std::to_string(prefixLength);
+    if (!gateway.empty())
+        str += " via " + gateway;
+    if (!interface.empty())
+        str += " dev " + interface;
+    return str;
+}
+
+std::vector<int> NetlinkRoutes::add(const std::vector<Route> &routes)
+{
+    return execute(RTM_NEWROUTE, routes);
+}
+
+std::vector<int> NetlinkRoutes::remove(const std::vector<Route> &routes)
+{
+    return execute(RTM_DELROUTE, routes);
+}
+
+int NetlinkRoutes::openSocket()
+{
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0) {
+        Logger::instance().out("NetlinkRoutes: failed to open netlink socket (%s)", strerror(errno));
+        return -1;
+    }
+
+    sockaddr_nl addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+        Logger::instance().out("NetlinkRoutes: failed to bind netlink socket (%s)", strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    // the acks of a whole batch must fit in the receive buffer
+    int bufSize = kSocketBufferSize;
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &bufSize, sizeof(bufSize));
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufSize, sizeof(bufSize));
+
+    timeval tv;
+    tv.tv_sec = kReceiveTimeoutMs / 1000;
+    tv.tv_usec = (kReceiveTimeoutMs % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    return fd;
+}
+
+std::vector<int> NetlinkRoutes::execute(int type, const std::vector<Route> &routes)
+{
+    std::vector<int> results(routes.size(), 0);
+    if (routes.empty())
+        return results;
+
+    int fd = openSocket();
+    if (fd < 0) {
+        std::fill(results.begin(), results.end(), EIO);
+        return results;
+    }
+
+    std::vector<char> sendBuf(kMaxMessagesPerSend * kMaxRouteMessageSize);
+    std::vector<char> recvBuf(kReceiveBufferSize);
+
+    // the sequence number is the index of the route, so the acks map directly back to the routes
+    for (size_t start = 0; start < routes.size(); start += kMaxMessagesPerSend) {
+        const size_t end = std::min(routes.size(), start + kMaxMessagesPerSend);
+        size_t len = 0;
+        size_t pending = 0;
+        for (size_t i = start; i < end; ++i) {
+            nlmsghdr *nh = reinterpret_cast<nlmsghdr *>(sendBuf.data() + len);
+            results[i] = buildRouteMessage(nh, type, i + 1, routes[i]);
+            if (results[i] == 0) {
+                len += NLMSG_ALIGN(nh->nlmsg_len);
+                pending++;
+            }
+        }
+        if (pending == 0)
+            continue;
+
+        sockaddr_nl dest;
+        memset(&dest, 0, sizeof(dest));
+        dest.nl_family = AF_NETLINK;
+        iovec iov = { sendBuf.data(), len };
+        msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_name = &dest;
+        msg.msg_namelen = sizeof(dest);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+
+        // until an ack arrives, a route is considered failed
+        std::vector<bool> isAcked(end - start, false);
+        if (sendmsg(fd, &msg, 0) < 0) {
+            const int err = errno;
+            for (size_t i = start; i < end; ++i) {
+                if (results[i] == 0)
+                    results[i] = err;
+            }
+            continue;
+        }
+
+        while (pending > 0) {
+            ssize_t n = recv(fd, recvBuf.data(), recvBuf.size(), 0);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                break;
+            }
+            for (nlmsghdr *nh = reinterpret_cast<nlmsghdr *>(recvBuf.data()); NLMSG_OK(nh, (size_t)n); nh = NLMSG_NEXT(nh, n)) {
+                if (nh->nlmsg_type != NLMSG_ERROR || nh->nlmsg_seq < start + 1 || nh->nlmsg_seq > end)
+                    continue;
+                const size_t ind = nh->nlmsg_seq - 1;
+                if (isAcked[ind - start])
+                    continue;
+                const nlmsgerr *err = static_cast<const nlmsgerr *>(NLMSG_DATA(nh));
+                results[ind] = -err->error;
+                isAcked[ind - start] = true;
+                pending--;
+            }
+        }
+
+        if (pending > 0) {
+            for (size_t i = start; i < end; ++i) {
+                if (results[i] == 0 && !isAcked[i - start])
+                    results[i] = ETIMEDOUT;
+            }
+        }
+    }
+
+    close(fd);
+    return results;
+}
+
+bool NetlinkRoutes::dump(std::vector<Route> &routes)
+{
+    routes.clear();
+    int fd = openSocket();
+    if (fd < 0)
+        return false;
+
+    struct
+    {
+        nlmsghdr nh;
+        rtmsg rtm;
+    } req;
+    memset(&req, 0, sizeof(req));
+    req.nh.nlmsg_len = NLMSG_LENGTH(sizeof(rtmsg));
+    req.nh.nlmsg_type = RTM_GETROUTE;
+    req.nh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.nh.nlmsg_seq = 1;
+    req.rtm.rtm_family = AF_INET;
+
+    if (send(fd, &req, req.nh.nlmsg_len, 0) < 0) {
+        Logger::instance().out("NetlinkRoutes: failed to request routes (%s)", strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    std::vector<char> recvBuf(kReceiveBufferSize);
+    bool isDone = false;
+    bool isSuccess = true;
+    while (!isDone && isSuccess) {
+        ssize_t n = recv(fd, recvBuf.data(), recvBuf.size(), 0);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            Logger::instance().out("NetlinkRoutes: failed to read routes (%s)", strerror(errno));
+            isSuccess = false;
+            break;
+        }
+        for (nlmsghdr *nh = reinterpret_cast<nlmsghdr *>(recvBuf.data()); NLMSG_OK(nh, (size_t)n); nh = NLMSG_NEXT(nh, n)) {
+            if (nh->nlmsg_type == NLMSG_DONE) {
+                isDone = true;
+                break;
+            }
+            if (nh->nlmsg_type == NLMSG_ERROR) {
+                const nlmsgerr *err = static_cast<const nlmsgerr *>(NLMSG_DATA(nh));
+                Logger::instance().out("NetlinkRoutes: route dump failed (%s)", strerror(-err->error));
+                isSuccess = false;
+                break;
+            }
+            if (nh->nlmsg_type != RTM_NEWROUTE)
+                continue;
+
+            const rtmsg *rtm = static_cast<const rtmsg *>(NLMSG_DATA(nh));
+            if (rtm->rtm_family != AF_INET || rtm->rtm_type != RTN_UNICAST)
+                continue;
+
+            Route route;
+            route.ip = "0.0.0.0";
+            route.prefixLength = rtm->rtm_dst_len;
+            uint32_t table = rtm->rtm_table;
+            int attrLen = RTM_PAYLOAD(nh);
+            for (const rtattr *rta = RTM_RTA(rtm); RTA_OK(rta, attrLen); rta = RTA_NEXT(rta, attrLen)) {
+                if (rta->rta_type == RTA_DST) {
+                    route.ip = addressToString(RTA_DATA(rta));
+                } else if (rta->rta_type == RTA_GATEWAY) {
+                    route.gateway = addressToString(RTA_DATA(rta));
+                } else if (rta->rta_type == RTA_OIF) {
+                    char name[IF_NAMESIZE];
+                    if (if_indextoname(*static_cast<const uint32_t *>(RTA_DATA(rta)), name))
+                        route.interface = name;
+                } else if (rta->rta_type == RTA_TABLE) {
+                    table = *static_cast<const uint32_t *>(RTA_DATA(rta));
+                }
+            }
+            if (table == RT_TABLE_MAIN)
+                routes.push_back(route);
+        }
+    }
+
+    close(fd);
+    return isSuccess;
+}
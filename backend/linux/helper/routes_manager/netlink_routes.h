@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Programs IPv4 routes of the main routing table via rtnetlink instead of spawning "ip route".
+// Requests are batched, so hundreds of routes take a few sendmsg() calls, and every route gets its own result.
+class NetlinkRoutes
+{
+public:
+    struct Route
+    {
+        std::string ip;
+        int prefixLength = 32;
+        std::string gateway;    // can be empty for a device route
+        std::string interface;  // can be empty for a gateway route
+
+        std::string toString() const;
+    };
+
+    // returns an errno value for each route (0 on success) in the same order as routes
+    static std::vector<int> add(const std::vector<Route> &routes);
+    static std::vector<int> remove(const std::vector<Route> &routes);
+
+    // reads the IPv4 unicast routes of the main table
+    static bool dump(std::vector<Route> &routes);
+
+private:
+    static constexpr int kMaxMessagesPerSend = 64;
+    static constexpr int kSocketBufferSize = 1024 * 1024;
+
+    static int openSocket();
+    static std::vector<int> execute(int type, const std::vector<Route> &routes);
+};
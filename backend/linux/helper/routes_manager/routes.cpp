@@ -1,50 +1,62 @@
 #include "routes.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
 #include "../logger.h"
-#include "../utils.h"
 
 void Routes::add(const std::string &ip, const std::string &gateway, const std::string &mask)
 {
-    RouteDescr rd;
-    rd.ip = ip;
-    rd.gateway = gateway;
-    rd.mask = mask;
-    routes_.push_back(rd);
-
-    std::string cmd = "ip route add " + ip + "/" + mask + " via " + gateway;
-    Logger::instance().out("execute: %s", cmd.c_str());
-    Utils::executeCommand(cmd);
+    NetlinkRoutes::Route route;
+    route.ip = ip;
+    route.prefixLength = atoi(mask.c_str());
+    route.gateway = gateway;
+    pendingRoutes_.push_back(route);
 }
 
 void Routes::addWithInterface(const std::string &ip, const std::string &interface, const std::string &mask)
 {
-    RouteDescr rd;
-    rd.ip = ip;
-    rd.interface = interface;
-    rd.mask = mask;
-    routes_.push_back(rd);
-
-    std::string cmd = "ip route add " + ip + "/" + mask + " dev " + interface;
-    Logger::instance().out("execute: %s", cmd.c_str());
-    Utils::executeCommand(cmd);
+    NetlinkRoutes::Route route;
+    route.ip = ip;
+    route.prefixLength = atoi(mask.c_str());
+    route.interface = interface;
+    pendingRoutes_.push_back(route);
 }
 
-
-void Routes::clear()
+void Routes::apply()
 {
-    for(auto const& rd: routes_)
+    if (pendingRoutes_.empty())
+        return;
+
+    std::vector<int> results = NetlinkRoutes::add(pendingRoutes_);
+    for (size_t i = 0; i < pendingRoutes_.size(); ++i)
     {
-        if (rd.interface.empty())
+        if (results[i] == 0)
         {
-            std::string cmd = "ip route delete " + rd.ip + "/" + rd.mask + " via " + rd.gateway;
-            Logger::instance().out("execute: %s", cmd.c_str());
-            Utils::executeCommand(cmd);
+            Logger::instance().out("route added: %s", pendingRoutes_[i].toString().c_str());
+            routes_.push_back(pendingRoutes_[i]);
         }
         else
         {
-            std::string cmd = "ip route delete " + rd.ip + "/" + rd.mask + " dev " + rd.interface;
-            Logger::instance().out("execute: %s", cmd.c_str());
-            Utils::executeCommand(cmd);
+            // a route that already existed is not ours, so it is not removed in clear()
+            Logger::instance().out("failed to add route %s: %s", pendingRoutes_[i].toString().c_str(), strerror(results[i]));
         }
     }
+    pendingRoutes_.clear();
+}
+
+void Routes::clear()
+{
+    pendingRoutes_.clear();
+    if (routes_.empty())
+        return;
+
+    std::vector<int> results = NetlinkRoutes::remove(routes_);
+    for (size_t i = 0; i < routes_.size(); ++i)
+    {
+        if (results[i] == 0 || results[i] == ESRCH)
+            Logger::instance().out("route deleted: %s", routes_[i].toString().c_str());
+        else
+            Logger::instance().out("failed to delete route %s: %s", routes_[i].toString().c_str(), strerror(results[i]));
+    }
     routes_.clear();
 }
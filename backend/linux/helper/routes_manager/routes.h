@@ -2,24 +2,18 @@
 
 #include <string>
 #include <vector>
+#include "netlink_routes.h"
 
-
-// helper for add and clear routes via system "route" command
+// helper for add and clear routes via rtnetlink, routes are added in one batch by apply()
 class Routes
 {
 public:
     void add(const std::string &ip, const std::string &gateway, const std::string &mask);
     void addWithInterface(const std::string &ip, const std::string &interface, const std::string &mask);
+    void apply();
     void clear();
 
 private:
-    struct RouteDescr
-    {
-        std::string ip;
-        std::string gateway;
-        std::string mask;
-        std::string interface;
-    };
-
-    std::vector<RouteDescr> routes_;
+    std::vector<NetlinkRoutes::Route> pendingRoutes_;
+    std::vector<NetlinkRoutes::Route> routes_;
 };
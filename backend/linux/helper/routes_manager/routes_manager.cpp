@@ -32,11 +32,13 @@ void RoutesManager::updateState(const CMD_SEND_CONNECT_STATUS &connectStatus, bo
                     vpnRoutes_.add(connectStatus.remoteIp, connectStatus.defaultAdapter.gatewayIp, "32");
                     vpnRoutes_.add("0.0.0.0", connectStatus.vpnAdapter.gatewayIp, "1");
                     vpnRoutes_.add("128.0.0.0", connectStatus.vpnAdapter.gatewayIp, "1");
+                    vpnRoutes_.apply();
                     boundRoute_.create(connectStatus.defaultAdapter.gatewayIp, connectStatus.vpnAdapter.adapterName);
                 } else if (connectStatus.protocol == kCmdProtocolWireGuard) {
                     // add wireguard default routes
                     vpnRoutes_.addWithInterface("0.0.0.0", connectStatus.vpnAdapter.adapterName, "1");
                     vpnRoutes_.addWithInterface("128.0.0.0", connectStatus.vpnAdapter.adapterName, "1");
+                    vpnRoutes_.apply();
                 }
                 boundRoute_.create(connectStatus.defaultAdapter.gatewayIp, connectStatus.defaultAdapter.adapterName);
             }
@@ -60,6 +62,7 @@ void RoutesManager::addDnsRoutes(const CMD_SEND_CONNECT_STATUS &connectStatus)
     for (auto it = connectStatus.vpnAdapter.dnsServers.begin(); it != connectStatus.vpnAdapter.dnsServers.end(); ++it) {
         dnsServersRoutes_.addWithInterface(*it, connectStatus.vpnAdapter.adapterName, "32");
     }
+    dnsServersRoutes_.apply();
 }
 
 void RoutesManager::clearAllRoutes()
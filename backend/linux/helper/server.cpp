@@ -25,14 +25,24 @@
 
 #define SOCK_PATH "/var/run/windscribe/helper.sock"
 
-Server::Server()
+Server::Server() : commandServer_(service_, processCommand, [this](socket_ptr sock) { return isPeerAllowed(sock); })
 {
     acceptor_ = NULL;
+    // the subscription is made by the client app, which receives the status over its connection
+    commandServer_.setLastConnectionClosedHandler([]() {
+        WireGuardController::instance().subscribeStatus(0);
+    });
 }
 
 Server::~Server()
 {
+    // the controllers are singletons which outlive the server
+    WireGuardController::instance().setStatusCallback(nullptr);
+    WireGuardController::instance().subscribeStatus(0);
+    ExecuteCmd::instance().setFinishedCallback(nullptr);
+
     service_.stop();
+    commandServer_.stop();
 
     if (acceptor_) {
         delete acceptor_;
@@ -41,30 +51,8 @@ Server::~Server()
     unlink(SOCK_PATH);
 }
 
-bool Server::readAndHandleCommand(socket_ptr sock, boost::asio::streambuf *buf, CMD_ANSWER &outCmdAnswer)
+bool Server::isPeerAllowed(socket_ptr sock)
 {
-    // not enough data for read command
-    if (buf->size() < sizeof(int)*3) {
-        return false;
-    }
-
-    const char *bufPtr = boost::asio::buffer_cast<const char*>(buf->data());
-    size_t headerSize = 0;
-    int cmdId;
-    memcpy(&cmdId, bufPtr + headerSize, sizeof(cmdId));
-    headerSize += sizeof(cmdId);
-    pid_t pid;
-    memcpy(&pid, bufPtr + headerSize, sizeof(pid));
-    headerSize += sizeof(pid);
-    int length;
-    memcpy(&length, bufPtr + headerSize, sizeof(length));
-    headerSize += sizeof(length);
-
-    // not enough data for read command
-    if (buf->size() < (headerSize + length)) {
-        return false;
-    }
-
     struct ucred peerCred;
     socklen_t lenPeerCred = sizeof(peerCred);
     int retCode = getsockopt(sock->native_handle(), SOL_SOCKET, SO_PEERCRED, &peerCred, &lenPeerCred);
@@ -74,54 +62,41 @@ bool Server::readAndHandleCommand(socket_ptr sock, boost::asio::streambuf *buf,
         return false;
     }
 
-    if (!HelperSecurity::instance().verifySignature()) {
-        return false;
-    }
-
-    std::vector<char> vector(length);
-    memcpy(&vector[0], bufPtr + headerSize, length);
-    std::string str(vector.begin(), vector.end());
-    std::istringstream stream(str);
-    outCmdAnswer = processCommand(cmdId, str);
+    return HelperSecurity::instance().verifySignature();
+}
 
-    buf->consume(headerSize + length);
+void Server::onCmdFinished(unsigned long cmdId, bool bSuccess, const std::string &log)
+{
+    EVENT_CMD_FINISHED event;
+    event.cmdId = cmdId;
+    event.success = bSuccess;
+    event.log = log;
 
-    return true;
+    std::stringstream stream;
+    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
+    oa << event;
+    commandServer_.broadcastEvent(HELPER_EVENT_CMD_FINISHED, stream.str());
 }
 
-void Server::receiveCmdHandle(socket_ptr sock, boost::shared_ptr<boost::asio::streambuf> buf, const boost::system::error_code& ec, std::size_t bytes_transferred)
+void Server::onWireGuardStatusChanged(const WireGuardStatusMonitor::Status &status)
 {
-    UNUSED(bytes_transferred);
+    EVENT_WIREGUARD_STATUS event;
+    event.state = status.state;
+    event.errorCode = status.errorCode;
+    event.bytesReceived = status.bytesReceived;
+    event.bytesTransmitted = status.bytesTransmitted;
 
-    if (!ec.value()) {
-        // read and handle commands
-        while (true) {
-            CMD_ANSWER cmdAnswer;
-            if (!readAndHandleCommand(sock, buf.get(), cmdAnswer)) {
-                // goto receive next commands
-                boost::asio::async_read(*sock, *buf, boost::asio::transfer_at_least(1),
-                                        boost::bind(&Server::receiveCmdHandle, this, sock, buf, _1, _2));
-                break;
-            } else {
-                if (!sendAnswerCmd(sock, cmdAnswer)) {
-                    Logger::instance().out("client app disconnected");
-                    return;
-                }
-            }
-        }
-    } else {
-        Logger::instance().out("client app disconnected");
-    }
+    std::stringstream stream;
+    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
+    oa << event;
+    commandServer_.broadcastEvent(HELPER_EVENT_WIREGUARD_STATUS, stream.str());
 }
 
 void Server::acceptHandler(const boost::system::error_code & ec, socket_ptr sock)
 {
     if (!ec.value()) {
         Logger::instance().out("client app connected");
-
-        boost::shared_ptr<boost::asio::streambuf> buf(new boost::asio::streambuf);
-        boost::asio::async_read(*sock, *buf, boost::asio::transfer_at_least(1),
-                                boost::bind(&Server::receiveCmdHandle, this, sock, buf, _1, _2));
+        commandServer_.addConnection(sock);
     }
 
     startAccept();
@@ -133,27 +108,6 @@ void Server::startAccept()
     acceptor_->async_accept(*sock, boost::bind(&Server::acceptHandler, this, boost::asio::placeholders::error, sock));
 }
 
-bool Server::sendAnswerCmd(socket_ptr sock, const CMD_ANSWER &cmdAnswer)
-{
-    std::stringstream stream;
-    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
-    oa << cmdAnswer;
-    std::string str = stream.str();
-    int length = (int)str.length();
-    // send answer to client
-    boost::system::error_code er;
-    boost::asio::write(*sock, boost::asio::buffer(&length, sizeof(length)), boost::asio::transfer_exactly(sizeof(length)), er);
-    if (er.value()) {
-        return false;
-    } else {
-        boost::asio::write(*sock, boost::asio::buffer(str.data(), str.length()), boost::asio::transfer_exactly(str.length()), er);
-        if (er.value()) {
-            return false;
-        }
-    }
-    return true;
-}
-
 void Server::run()
 {
     Utils::createWindscribeUserAndGroup();
@@ -176,6 +130,14 @@ void Server::run()
     // Cause the FirewallController to be constructed here, so that on-boot rules are processed, even if the Windscribe app/service does not start.
     FirewallController::instance();
 
+    commandServer_.start();
+    ExecuteCmd::instance().setFinishedCallback([this](unsigned long cmdId, bool bSuccess, const std::string &log) {
+        onCmdFinished(cmdId, bSuccess, log);
+    });
+    WireGuardController::instance().setStatusCallback([this](const WireGuardStatusMonitor::Status &status) {
+        onWireGuardStatusChanged(status);
+    });
+
     startAccept();
 
     service_.run();
@@ -8,15 +8,15 @@
 #include <boost/asio.hpp>
 #include <boost/thread.hpp>
 #include <list>
+#include <memory>
 
 #include "../../posix_common/helper_commands.h"
+#include "ipc/command_server.h"
 #include "routes_manager/routes_manager.h"
 #include "wireguard/defaultroutemonitor.h"
 #include "wireguard/wireguardadapter.h"
 #include "wireguard/wireguardcontroller.h"
 
-typedef boost::shared_ptr<boost::asio::local::stream_protocol::socket> socket_ptr;
-
 class Server
 {
 public:
@@ -27,13 +27,13 @@ public:
 private:
     boost::asio::io_service service_;
     boost::asio::local::stream_protocol::acceptor *acceptor_;
+    CommandServer commandServer_;
 
-    bool readAndHandleCommand(socket_ptr sock, boost::asio::streambuf *buf, CMD_ANSWER &outCmdAnswer);
+    bool isPeerAllowed(socket_ptr sock);
+    void onCmdFinished(unsigned long cmdId, bool bSuccess, const std::string &log);
+    void onWireGuardStatusChanged(const WireGuardStatusMonitor::Status &status);
 
-    void receiveCmdHandle(socket_ptr sock, boost::shared_ptr<boost::asio::streambuf> buf, const boost::system::error_code& ec, std::size_t bytes_transferred);
     void acceptHandler(const boost::system::error_code & ec, socket_ptr sock);
     void startAccept();
-
-    bool sendAnswerCmd(socket_ptr sock, const CMD_ANSWER &cmdAnswer);
 };
 
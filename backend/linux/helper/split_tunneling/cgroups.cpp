@@ -1,7 +1,10 @@
 #include "cgroups.h"
 
-#include <fstream>
+#include <errno.h>
+#include <fcntl.h>
 #include <sstream>
+#include <string.h>
+#include <unistd.h>
 
 #include "../logger.h"
 #include "../utils.h"
@@ -48,18 +51,44 @@ void CGroups::disable()
 
 void CGroups::addApp(pid_t pid)
 {
-    std::ofstream out;
-    out.open((findNetclsRoot() + "/windscribe/cgroup.procs").c_str());
-    out << pid;
-    out.close();
+    addApps({ pid });
 }
 
 void CGroups::removeApp(pid_t pid)
 {
-    std::ofstream out;
-    out.open((findNetclsRoot() + "/cgroup.procs").c_str());
-    out << pid;
-    out.close();
+    removeApps({ pid });
+}
+
+void CGroups::addApps(const std::vector<pid_t> &pids)
+{
+    writePids(findNetclsRoot() + "/windscribe/cgroup.procs", pids);
+}
+
+void CGroups::removeApps(const std::vector<pid_t> &pids)
+{
+    writePids(findNetclsRoot() + "/cgroup.procs", pids);
+}
+
+void CGroups::writePids(const std::string &path, const std::vector<pid_t> &pids)
+{
+    if (pids.empty()) {
+        return;
+    }
+
+    int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
+        Logger::instance().out("cgroups could not open %s", path.c_str());
+        return;
+    }
+
+    // the kernel takes one pid per write(), but the file is opened only once for the whole batch
+    for (auto pid : pids) {
+        std::string str = std::to_string(pid);
+        if (write(fd, str.c_str(), str.size()) < 0 && errno != ESRCH) {
+            Logger::instance().out("cgroups could not move pid %d: %s", pid, strerror(errno));
+        }
+    }
+    close(fd);
 }
 
 std::string CGroups::findNetclsRoot()
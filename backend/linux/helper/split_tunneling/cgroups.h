@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include "../../../posix_common/helper_commands.h"
 
 class CGroups
@@ -17,6 +18,8 @@ public:
 
     void addApp(pid_t pid);
     void removeApp(pid_t pid);
+    void addApps(const std::vector<pid_t> &pids);
+    void removeApps(const std::vector<pid_t> &pids);
 
     std::string mark() const { return mark_; };
     std::string netClassId() const { return netClassId_; };
@@ -31,4 +34,5 @@ private:
     ~CGroups();
 
     std::string findNetclsRoot();
+    void writePids(const std::string &path, const std::vector<pid_t> &pids);
 };
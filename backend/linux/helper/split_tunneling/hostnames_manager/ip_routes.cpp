@@ -1,72 +1,126 @@
 #include "ip_routes.h"
 
+#include <errno.h>
 #include <set>
+#include <string.h>
 
 #include "../../logger.h"
-#include "../../utils.h"
 
 void IpRoutes::setIps(const std::string &defaultRouteIp, const std::vector<std::string> &ips)
 {
     std::lock_guard<std::recursive_mutex> guard(mutex_);
 
     // exclude duplicates
-    std::set<std::string> ipsSet;
-    for (auto ip = ips.begin(); ip != ips.end(); ++ip) {
-        ipsSet.insert(*ip);
+    std::set<std::string> ipsSet(ips.begin(), ips.end());
+
+    // host routes (ip, gateway) currently present in the kernel
+    std::vector<NetlinkRoutes::Route> kernelRoutes;
+    bool isKernelRoutesValid = NetlinkRoutes::dump(kernelRoutes);
+    std::set<std::pair<std::string, std::string>> kernelHostRoutes;
+    for (const auto &route : kernelRoutes) {
+        if (route.prefixLength == 32) {
+            kernelHostRoutes.insert(std::make_pair(route.ip, route.gateway));
+        }
     }
 
-    // find route which need to delete
-    std::set<std::string> ipsDelete;
-    for (auto it = activeRoutes_.begin(); it != activeRoutes_.end(); ++it) {
+    // if the table could not be read, assume our routes are still in place as before
+    auto isInKernel = [&](const RouteDescr &rd) {
+        if (isKernelRoutesValid) {
+            return kernelHostRoutes.find(std::make_pair(rd.ip, rd.defaultRouteIp)) != kernelHostRoutes.end();
+        }
+        auto it = activeRoutes_.find(rd.ip);
+        return it != activeRoutes_.end() && it->second.defaultRouteIp == rd.defaultRouteIp;
+    };
+
+    // find routes which need to delete, the ones already gone from the kernel are just forgotten
+    std::vector<RouteDescr> routesDelete;
+    for (auto it = activeRoutes_.begin(); it != activeRoutes_.end(); ) {
         if (it->second.defaultRouteIp != defaultRouteIp || ipsSet.find(it->first) == ipsSet.end()) {
-            ipsDelete.insert(it->first);
+            if (isInKernel(it->second)) {
+                routesDelete.push_back(it->second);
+            }
+            it = activeRoutes_.erase(it);
+        } else {
+            ++it;
         }
     }
+    deleteRoutes(routesDelete);
 
-    // delete routes
-    for (auto ip = ipsDelete.begin(); ip != ipsDelete.end(); ++ip) {
-        auto fr = activeRoutes_.find(*ip);
-        if (fr != activeRoutes_.end()) {
-            deleteRoute(fr->second);
-            activeRoutes_.erase(fr);
+    // find routes which need to add, including our routes removed by someone else
+    std::vector<RouteDescr> routesAdd;
+    for (const auto &ip : ipsSet) {
+        RouteDescr rd;
+        rd.ip = ip;
+        rd.defaultRouteIp = defaultRouteIp;
+        if (isInKernel(rd)) {
+            activeRoutes_[ip] = rd;
+        } else {
+            routesAdd.push_back(rd);
         }
     }
 
-    // add routes
-    for (auto ip = ipsSet.begin(); ip != ipsSet.end(); ++ip) {
-        auto ar = activeRoutes_.find(*ip);
-        if (ar != activeRoutes_.end()) {
-            continue;
+    if (routesAdd.empty()) {
+        return;
+    }
+
+    std::vector<NetlinkRoutes::Route> routes;
+    routes.reserve(routesAdd.size());
+    for (const auto &rd : routesAdd) {
+        routes.push_back(toNetlinkRoute(rd));
+    }
+    std::vector<int> results = NetlinkRoutes::add(routes);
+    size_t errors = 0;
+    for (size_t i = 0; i < routesAdd.size(); ++i) {
+        if (results[i] == 0 || results[i] == EEXIST) {
+            activeRoutes_[routesAdd[i].ip] = routesAdd[i];
         } else {
-            RouteDescr rd;
-            rd.ip = *ip;
-            rd.defaultRouteIp = defaultRouteIp;
-            addRoute(rd);
-            activeRoutes_[*ip] = rd;
+            Logger::instance().out("IpRoutes: failed to add route %s: %s", routes[i].toString().c_str(), strerror(results[i]));
+            errors++;
         }
     }
+    Logger::instance().out("IpRoutes: added %zu routes via %s, errors: %zu", routesAdd.size() - errors, defaultRouteIp.c_str(), errors);
 }
 
 void IpRoutes::clear()
 {
     std::lock_guard<std::recursive_mutex> guard(mutex_);
+    std::vector<RouteDescr> routesDelete;
+    routesDelete.reserve(activeRoutes_.size());
     for (auto it = activeRoutes_.begin(); it != activeRoutes_.end(); ++it) {
-        deleteRoute(it->second);
+        routesDelete.push_back(it->second);
     }
+    deleteRoutes(routesDelete);
     activeRoutes_.clear();
 }
 
-void IpRoutes::addRoute(const RouteDescr &rd)
+NetlinkRoutes::Route IpRoutes::toNetlinkRoute(const RouteDescr &rd)
 {
-    std::string cmd = "ip route add " + rd.ip + " via " + rd.defaultRouteIp;
-    Logger::instance().out("cmd: %s", cmd.c_str());
-
-    Utils::executeCommand(cmd);
+    NetlinkRoutes::Route route;
+    route.ip = rd.ip;
+    route.prefixLength = 32;
+    route.gateway = rd.defaultRouteIp;
+    return route;
 }
 
-void IpRoutes::deleteRoute(const RouteDescr &rd)
+void IpRoutes::deleteRoutes(const std::vector<RouteDescr> &routesDelete)
 {
-    std::string cmd = "ip route del " + rd.ip + " via " + rd.defaultRouteIp;
-    Logger::instance().out("cmd: %s", cmd.c_str());
-    Utils::executeCommand(cmd);
+    if (routesDelete.empty()) {
+        return;
+    }
+
+    std::vector<NetlinkRoutes::Route> routes;
+    routes.reserve(routesDelete.size());
+    for (const auto &rd : routesDelete) {
+        routes.push_back(toNetlinkRoute(rd));
+    }
+    std::vector<int> results = NetlinkRoutes::remove(routes);
+    size_t errors = 0;
+    for (size_t i = 0; i < routes.size(); ++i) {
+        // ESRCH: the route is already gone
+        if (results[i] != 0 && results[i] != ESRCH) {
+            Logger::instance().out("IpRoutes: failed to delete route %s: %s", routes[i].toString().c_str(), strerror(results[i]));
+            errors++;
+        }
+    }
+    Logger::instance().out("IpRoutes: deleted %zu routes, errors: %zu", routes.size() - errors, errors);
 }
@@ -5,7 +5,10 @@
 #include <mutex>
 #include <map>
 
-// manage Ip route via "route add" and "route delete" commands
+#include "../../routes_manager/netlink_routes.h"
+
+// manage Ip routes via rtnetlink, the desired state is diffed against the kernel routing table
+// and the difference is applied in batches
 class IpRoutes
 {
 public:
@@ -23,6 +26,6 @@ private:
 
     std::map<std::string, RouteDescr> activeRoutes_;
 
-    void addRoute(const RouteDescr &rd);
-    void deleteRoute(const RouteDescr &rd);
+    static NetlinkRoutes::Route toNetlinkRoute(const RouteDescr &rd);
+    void deleteRoutes(const std::vector<RouteDescr> &routes);
 };
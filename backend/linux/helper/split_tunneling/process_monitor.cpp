@@ -53,21 +53,19 @@ void ProcessMonitor::monitorWorker(void *ctx)
             break;
         }
 
-        std::string cmd;
         switch (nlcn_msg.proc_ev.what) {
             case 0x00000001: // PROC_EVENT_FORK:
-                if (compareCmd(nlcn_msg.proc_ev.event_data.fork.child_pid, apps_)) {
-                    CGroups::instance().addApp(nlcn_msg.proc_ev.event_data.fork.child_pid);
+                // threads share the process exe and cgroup
+                if (nlcn_msg.proc_ev.event_data.fork.child_pid == nlcn_msg.proc_ev.event_data.fork.child_tgid) {
+                    onFork(nlcn_msg.proc_ev.event_data.fork.parent_tgid, nlcn_msg.proc_ev.event_data.fork.child_pid);
                 }
                 break;
             case 0x00000002: // PROC_EVENT_EXEC:
-                if (compareCmd(nlcn_msg.proc_ev.event_data.exec.process_pid, apps_)) {
-                    CGroups::instance().addApp(nlcn_msg.proc_ev.event_data.exec.process_pid);
-                }
+                onExec(nlcn_msg.proc_ev.event_data.exec.process_tgid);
                 break;
             case 0x80000000: // PROC_EVENT_EXIT:
-                if (compareCmd(nlcn_msg.proc_ev.event_data.exit.process_pid, apps_)) {
-                    CGroups::instance().removeApp(nlcn_msg.proc_ev.event_data.exit.process_pid);
+                if (nlcn_msg.proc_ev.event_data.exit.process_pid == nlcn_msg.proc_ev.event_data.exit.process_tgid) {
+                    onExit(nlcn_msg.proc_ev.event_data.exit.process_pid);
                 }
                 break;
             default:
@@ -92,21 +90,12 @@ ProcessMonitor::~ProcessMonitor()
 
 void ProcessMonitor::setApps(const std::vector<std::string> &apps)
 {
+    std::lock_guard<std::mutex> guard(mutex_);
+    apps_ = apps;
+    matcher_.setApps(apps);
     if (isEnabled_) {
-        for (auto app : apps) {
-            if (std::find(apps_.begin(), apps_.end(), app) == apps_.end()) {
-                addApp(app);
-            }
-        }
-
-        for (auto app : apps_) {
-            if (std::find(apps.begin(), apps.end(), app) == apps.end()) {
-                removeApp(app);
-            }
-        }
+        rescanProcesses();
     }
-
-    apps_ = apps;
 }
 
 bool ProcessMonitor::enable()
@@ -132,9 +121,8 @@ bool ProcessMonitor::enable()
         return false;
     }
 
-    for (auto app : apps_) {
-        addApp(app);
-    }
+    std::lock_guard<std::mutex> guard(mutex_);
+    rescanProcesses();
     isEnabled_ = true;
     return true;
 }
@@ -149,79 +137,145 @@ void ProcessMonitor::disable()
 
     stopMonitoring();
 
+    std::lock_guard<std::mutex> guard(mutex_);
+    processes_.clear();
     isEnabled_ = false;
 }
 
-void ProcessMonitor::addApp(const std::string &exe) {
-    Logger::instance().out("process monitor add app: %s", exe.c_str());
-    std::vector<pid_t> pids = findPids(exe);
-    for (auto pid : pids) {
-        CGroups::instance().addApp(pid);
+void ProcessMonitor::AppMatcher::setApps(const std::vector<std::string> &apps)
+{
+    exes_.clear();
+    flatpakSuffixes_.clear();
+    snapPrefixSuffixes_.clear();
+
+    for (const auto &exe : apps) {
+        exes_.insert(exe);
+
+        // handle snap
+        size_t idx = exe.find("/snap/");
+        if (idx != std::string::npos) {
+            snapPrefixSuffixes_.push_back(std::make_pair(exe.substr(0, idx + 6), exe.substr(exe.rfind("/"))));
+            continue;
+        }
+
+        // handle flatpak
+        if (exe.rfind("/app/", 0) == 0) {
+            flatpakSuffixes_.insert(exe.substr(exe.rfind("/")));
+            continue;
+        }
+
+        // /proc/<pid>/exe is always the resolved path, so also match the target of a symlinked app
+        char resolved[PATH_MAX];
+        if (realpath(exe.c_str(), resolved) != nullptr) {
+            exes_.insert(resolved);
+        }
     }
 }
 
-void ProcessMonitor::removeApp(const std::string &exe) {
-    Logger::instance().out("process monitor remove app: %s", exe.c_str());
-    std::vector<pid_t> pids = findPids(exe);
-    for (auto pid : pids) {
-        CGroups::instance().removeApp(pid);
+bool ProcessMonitor::AppMatcher::matches(const std::string &exe) const
+{
+    if (exe.empty()) {
+        return false;
+    }
+
+    if (exes_.find(exe) != exes_.end()) {
+        return true;
+    }
+
+    for (const auto &it : snapPrefixSuffixes_) {
+        const std::string &suffix = it.second;
+        if (exe.size() >= suffix.size() && exe.rfind(it.first, 0) == 0 &&
+            exe.compare(exe.size() - suffix.size(), suffix.size(), suffix) == 0) {
+            return true;
+        }
     }
+
+    if (!flatpakSuffixes_.empty() && exe.rfind("/app/", 0) == 0) {
+        if (flatpakSuffixes_.find(exe.substr(exe.rfind("/"))) != flatpakSuffixes_.end()) {
+            return true;
+        }
+    }
+
+    return false;
 }
 
-std::vector<pid_t> ProcessMonitor::findPids(const std::string &exe)
+void ProcessMonitor::rescanProcesses()
 {
-    std::vector<pid_t> pids;
-
-    DIR *dp = NULL;
-    struct dirent *ep;
+    std::unordered_map<pid_t, ProcessInfo> processes;
+    std::vector<pid_t> pidsAdd;
+    std::vector<pid_t> pidsRemove;
 
-    dp = opendir("/proc");
+    DIR *dp = opendir("/proc");
     if (dp == NULL) {
         Logger::instance().out("process monitor could not open /proc filesystem");
-        return pids;
+        return;
     }
 
-    while (ep = readdir(dp)) {
+    struct dirent *ep;
+    while ((ep = readdir(dp)) != NULL) {
         // numeric directories are pids in /proc
-        if (ep->d_type == DT_DIR && ep->d_name[0] >= '0' && ep->d_name[0] <= '9') {
-            if (compareCmd(std::stoi(ep->d_name), {exe})) {
-                pids.push_back(std::stoi(ep->d_name));
-            }
+        if (ep->d_type != DT_DIR || ep->d_name[0] < '0' || ep->d_name[0] > '9') {
+            continue;
+        }
+        pid_t pid = atoi(ep->d_name);
+        ProcessInfo info;
+        info.exe = getCmdByPid(pid);
+        info.isMatched = matcher_.matches(info.exe);
+
+        auto prev = processes_.find(pid);
+        bool wasMatched = prev != processes_.end() && prev->second.isMatched && prev->second.exe == info.exe;
+        if (info.isMatched && !wasMatched) {
+            pidsAdd.push_back(pid);
+        } else if (!info.isMatched && wasMatched) {
+            pidsRemove.push_back(pid);
         }
+        processes.emplace(pid, std::move(info));
     }
     closedir(dp);
 
-    return pids;
+    processes_.swap(processes);
+    Logger::instance().out("process monitor scanned %zu processes, add %zu, remove %zu",
+                           processes_.size(), pidsAdd.size(), pidsRemove.size());
+    CGroups::instance().addApps(pidsAdd);
+    CGroups::instance().removeApps(pidsRemove);
 }
 
-bool ProcessMonitor::compareCmd(pid_t pid, const std::vector<std::string> &exes) {
-    std::string cmd = getCmdByPid(pid);
-
-    for (auto exe : exes) {
-        if (cmd == exe) {
-            return true;
-        }
+void ProcessMonitor::onFork(pid_t parentPid, pid_t childPid)
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto parent = processes_.find(parentPid);
+    if (parent != processes_.end()) {
+        // the child runs the same exe and the kernel keeps it in the parent's cgroup
+        processes_[childPid] = parent->second;
+        return;
+    }
 
-        // handle snap
-        int idx = exe.find("/snap/");
-        if (idx != std::string::npos) {
-            std::string prefix = exe.substr(0, idx + 6);
-            std::string suffix = exe.substr(exe.rfind("/"));
-            if (cmd.rfind(prefix, 0) == 0 && cmd.find(suffix, cmd.size() - suffix.length()) == cmd.size() - suffix.length()) {
-                return true;
-            }
-        }
+    ProcessInfo info;
+    info.exe = getCmdByPid(childPid);
+    info.isMatched = matcher_.matches(info.exe);
+    if (info.isMatched) {
+        CGroups::instance().addApp(childPid);
+    }
+    processes_[childPid] = std::move(info);
+}
 
-        // handle flatpak
-        if (cmd.rfind("/app/", 0) == 0 && exe.rfind("/app/", 0) == 0) {
-            std::string suffix = exe.substr(exe.rfind("/"));
-            if (cmd.find(suffix, cmd.size() - suffix.length()) == cmd.size() - suffix.length()) {
-                return true;
-            }
-        }
+void ProcessMonitor::onExec(pid_t pid)
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    ProcessInfo &info = processes_[pid];
+    bool wasMatched = info.isMatched;
+    info.exe = getCmdByPid(pid);
+    info.isMatched = matcher_.matches(info.exe);
+    if (info.isMatched && !wasMatched) {
+        CGroups::instance().addApp(pid);
     }
+}
 
-    return false;
+void ProcessMonitor::onExit(pid_t pid)
+{
+    // the process is gone along with its cgroup membership, only the cache needs updating
+    std::lock_guard<std::mutex> guard(mutex_);
+    processes_.erase(pid);
 }
 
 std::string ProcessMonitor::getCmdByPid(pid_t pid)
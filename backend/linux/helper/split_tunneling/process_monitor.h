@@ -1,7 +1,11 @@
 #pragma once
 
+#include <mutex>
 #include <string>
+#include <sys/types.h>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 class ProcessMonitor
@@ -18,8 +22,30 @@ public:
     void disable();
 
 private:
+    // matches an executable path against the configured apps without iterating over them
+    class AppMatcher
+    {
+    public:
+        void setApps(const std::vector<std::string> &apps);
+        bool matches(const std::string &exe) const;
+
+    private:
+        std::unordered_set<std::string> exes_;
+        std::unordered_set<std::string> flatpakSuffixes_;
+        std::vector<std::pair<std::string, std::string>> snapPrefixSuffixes_;
+    };
+
+    struct ProcessInfo
+    {
+        std::string exe;
+        bool isMatched = false;
+    };
+
     bool isEnabled_;
     std::vector<std::string> apps_;
+    AppMatcher matcher_;
+    std::mutex mutex_;
+    std::unordered_map<pid_t, ProcessInfo> processes_;    // pid -> exe cache, maintained from the proc connector
     std::thread *thread_;
     int sock_;
     bool running_;
@@ -30,9 +56,7 @@ private:
     ProcessMonitor();
     ~ProcessMonitor();
 
-    void addApp(const std::string &exe);
-    void removeApp(const std::string &exe);
-    std::vector<pid_t> findPids(const std::string &exe);
+    void rescanProcesses();
     std::string getCmdByPid(pid_t pid);
 
     void selfTest();
@@ -40,6 +64,8 @@ private:
     bool startMonitoring();
     void stopMonitoring();
     void monitorWorker(void *ctx);
-    bool compareCmd(pid_t pid, const std::vector<std::string> &exes);
+    void onFork(pid_t parentPid, pid_t childPid);
+    void onExec(pid_t pid);
+    void onExit(pid_t pid);
 };
 
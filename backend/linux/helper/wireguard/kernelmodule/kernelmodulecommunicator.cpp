@@ -7,6 +7,11 @@
 #include <boost/algorithm/hex.hpp>
 #include <sys/socket.h>
 
+KernelModuleCommunicator::~KernelModuleCommunicator()
+{
+    closeSession();
+}
+
 bool KernelModuleCommunicator::start(const std::string &deviceName)
 {
     assert(!deviceName.empty());
@@ -24,6 +29,7 @@ bool KernelModuleCommunicator::stop()
     // This is a workaround for #996; this is not really our bug but it's a bad user experience otherwise.
     Utils::executeCommand("nmcli", {"con", "down", deviceName_.c_str()});
 
+    closeSession();
     wg_del_device(deviceName_.c_str());
     return true;
 }
@@ -207,7 +213,7 @@ unsigned long KernelModuleCommunicator::getStatus(unsigned int *errorCode,
     UNUSED(errorCode);
 
     wg_device *device = nullptr;
-    if (wg_get_device(&device, deviceName_.c_str()) < 0)
+    if (getDevice(&device) < 0)
         return kWgStateListening;
 
     if (device->first_peer != nullptr && device->first_peer->last_handshake_time.tv_sec > 0)
@@ -217,10 +223,13 @@ unsigned long KernelModuleCommunicator::getStatus(unsigned int *errorCode,
         if (rc || tv.tv_sec - device->first_peer->last_handshake_time.tv_sec > 180)
         {
             Logger::instance().out("Time since last handshake time exceeded 3 minutes, disconnecting");
+            wg_free_device(device);
             return kWgStateError;
         }
-        *bytesReceived = device->first_peer->rx_bytes;
-        *bytesTransmitted = device->first_peer->tx_bytes;
+        if (bytesReceived)
+            *bytesReceived = device->first_peer->rx_bytes;
+        if (bytesTransmitted)
+            *bytesTransmitted = device->first_peer->tx_bytes;
         wg_free_device(device);
         return kWgStateActive;
     }
@@ -228,3 +237,27 @@ unsigned long KernelModuleCommunicator::getStatus(unsigned int *errorCode,
     wg_free_device(device);
     return kWgStateConnecting;
 }
+
+int KernelModuleCommunicator::getDevice(wg_device **device)
+{
+    // reopen the session once, in case the previous query failed or the module was reloaded
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (session_ == nullptr) {
+            session_ = wg_open_session();
+            if (session_ == nullptr)
+                return -errno;
+        }
+        // the device does not exist until the tunnel is configured, this is not a session error
+        int ret = wg_get_device_with_session(session_, device, deviceName_.c_str());
+        if (ret >= 0 || ret == -ENODEV)
+            return ret;
+        closeSession();
+    }
+    return -EIO;
+}
+
+void KernelModuleCommunicator::closeSession()
+{
+    wg_close_session(session_);
+    session_ = nullptr;
+}
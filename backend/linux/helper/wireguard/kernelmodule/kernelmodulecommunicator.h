@@ -11,6 +11,7 @@ class KernelModuleCommunicator: public IWireGuardCommunicator
 {
 public:
     KernelModuleCommunicator() = default;
+    ~KernelModuleCommunicator();
 
     virtual bool start(const std::string &deviceName);
     virtual bool stop();
@@ -31,5 +32,10 @@ private:
     bool setPeerAllowedIps(wg_peer *peer, const std::vector<std::string> &ips);
     bool setPeerEndpoint(wg_peer *peer, const std::string &endpoint);
     void freeAllowedIps(wg_allowedip *ips);
+    int getDevice(wg_device **device);
+    void closeSession();
+
     std::string deviceName_;
+    // kept open while the tunnel is up, the status is read several times per second while connecting
+    struct mnlg_socket *session_ = nullptr;
 };
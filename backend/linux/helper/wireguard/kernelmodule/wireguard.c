@@ -1411,24 +1411,15 @@ static void coalesce_peers(wg_device *device)
     }
 }
 
-int wg_get_device(wg_device **device, const char *device_name)
+static int get_device(struct mnlg_socket *nlg, wg_device **device, const char *device_name)
 {
     int ret = 0;
     struct nlmsghdr *nlh;
-    struct mnlg_socket *nlg;
 
-try_again:
     *device = calloc(1, sizeof(wg_device));
     if (!*device)
         return -errno;
 
-    nlg = mnlg_socket_open(WG_GENL_NAME, WG_GENL_VERSION);
-    if (!nlg) {
-        wg_free_device(*device);
-        *device = NULL;
-        return -errno;
-    }
-
     nlh = mnlg_msg_prepare(nlg, WG_CMD_GET_DEVICE, NLM_F_REQUEST | NLM_F_ACK | NLM_F_DUMP);
     mnl_attr_put_strz(nlh, WGDEVICE_A_IFNAME, device_name);
     if (mnlg_socket_send(nlg, nlh) < 0) {
@@ -1443,18 +1434,51 @@ try_again:
     coalesce_peers(*device);
 
 out:
-    if (nlg)
-        mnlg_socket_close(nlg);
     if (ret) {
         wg_free_device(*device);
-        if (ret == -EINTR)
-            goto try_again;
         *device = NULL;
     }
     errno = -ret;
     return ret;
 }
 
+int wg_get_device(wg_device **device, const char *device_name)
+{
+    int ret;
+    struct mnlg_socket *nlg;
+
+try_again:
+    nlg = mnlg_socket_open(WG_GENL_NAME, WG_GENL_VERSION);
+    if (!nlg) {
+        *device = NULL;
+        return -errno;
+    }
+
+    ret = get_device(nlg, device, device_name);
+    mnlg_socket_close(nlg);
+    if (ret == -EINTR)
+        goto try_again;
+    errno = -ret;
+    return ret;
+}
+
+struct mnlg_socket *wg_open_session(void)
+{
+    return mnlg_socket_open(WG_GENL_NAME, WG_GENL_VERSION);
+}
+
+void wg_close_session(struct mnlg_socket *session)
+{
+    if (session)
+        mnlg_socket_close(session);
+}
+
+int wg_get_device_with_session(struct mnlg_socket *session, wg_device **device, const char *device_name)
+{
+    /* A failed dump may leave messages in the socket, so the caller must reopen the session on error. */
+    return get_device(session, device, device_name);
+}
+
 /* first\0second\0third\0forth\0last\0\0 */
 char *wg_list_device_names(void)
 {
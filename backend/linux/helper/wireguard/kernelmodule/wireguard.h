@@ -98,6 +98,12 @@ int wg_get_device(wg_device **dev, const char *device_name);
 int wg_add_device(const char *device_name);
 int wg_del_device(const char *device_name);
 void wg_free_device(wg_device *dev);
+
+/* A long-lived generic netlink session, so that repeated queries skip the socket setup and the family lookup. */
+struct mnlg_socket;
+struct mnlg_socket *wg_open_session(void);
+void wg_close_session(struct mnlg_socket *session);
+int wg_get_device_with_session(struct mnlg_socket *session, wg_device **dev, const char *device_name);
 char *wg_list_device_names(void); /* first\0second\0third\0forth\0last\0\0 */
 void wg_key_to_base64(wg_key_b64_string base64, const wg_key key);
 int wg_key_from_base64(wg_key key, const wg_key_b64_string base64);
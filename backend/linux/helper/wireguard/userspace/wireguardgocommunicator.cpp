@@ -167,6 +167,7 @@ bool WireGuardGoCommunicator::start(const std::string &deviceName)
 
 bool WireGuardGoCommunicator::stop()
 {
+    statusConnection_.reset();
     if (!deviceName_.empty()) {
         Utils::executeCommand("rm", {"-f", ("/var/run/wireguard/" + deviceName_ + ".sock").c_str()});
     }
@@ -236,19 +237,25 @@ unsigned long WireGuardGoCommunicator::getStatus(unsigned int *errorCode,
     ExecuteCmd::instance().getStatus(daemonCmdId_, is_daemon_dead, log);
     if (is_daemon_dead) {
         // Special error code means the daemon is dead.
+        statusConnection_.reset();
         *errorCode = 666u;
         return kWgStateError;
     }
 
-    Connection connection(deviceName_);
-    const auto connection_status = connection.getStatus();
-    if (connection_status != Connection::Status::OK) {
-        if (connection.getStatus() == Connection::Status::NO_SOCKET)
-            return kWgStateStarting;
-        if (errorCode)
-            *errorCode = static_cast<unsigned int>(errno);
-        return kWgStateError;
+    if (!statusConnection_) {
+        statusConnection_.reset(new Connection(deviceName_));
+        const auto connection_status = statusConnection_->getStatus();
+        if (connection_status != Connection::Status::OK) {
+            const int err = errno;
+            statusConnection_.reset();
+            if (connection_status == Connection::Status::NO_SOCKET)
+                return kWgStateStarting;
+            if (errorCode)
+                *errorCode = static_cast<unsigned int>(err);
+            return kWgStateError;
+        }
     }
+    Connection &connection = *statusConnection_;
 
     // Send get command.
     fputs("get=1\n\n", connection);
@@ -263,8 +270,11 @@ unsigned long WireGuardGoCommunicator::getStatus(unsigned int *errorCode,
         std::make_pair("last_handshake_time_sec", "")
     };
     bool success = connection.getOutput(&results);
-    if (!success)
+    if (!success) {
+        // the daemon closed the connection, open a new one next time
+        statusConnection_.reset();
         return kWgStateStarting;
+    }
 
     // Check for errors.
     const auto errno_value = stringToValue<unsigned int>(results["errno"]);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -51,4 +52,6 @@ private:
     std::string deviceName_;
     std::string executable_;
     unsigned long daemonCmdId_;
+    // the UAPI serves any number of requests on one connection, so the status is read over a long-lived one
+    std::unique_ptr<Connection> statusConnection_;
 };
@@ -12,12 +12,16 @@
 #include <boost/algorithm/string/split.hpp>
 
 WireGuardController::WireGuardController()
-    : comm_(nullptr), is_initialized_(false)
+    : comm_(nullptr), is_initialized_(false),
+      statusMonitor_([this](unsigned int *errorCode, unsigned long long *bytesReceived, unsigned long long *bytesTransmitted) {
+          return getStatus(errorCode, bytesReceived, bytesTransmitted);
+      })
 {
 }
 
 bool WireGuardController::start()
 {
+    std::lock_guard<std::mutex> lock(mutex_);
     adapter_.reset(new WireGuardAdapter(kDeviceName));
 
     bool isUsingKernelModule = !Utils::executeCommand("modprobe", {"wireguard"});
@@ -31,6 +35,7 @@ bool WireGuardController::start()
 
     if (comm_->start(kDeviceName)) {
         is_initialized_ = true;
+        statusMonitor_.wake();
         return true;
     }
     return false;
@@ -38,6 +43,7 @@ bool WireGuardController::start()
 
 bool WireGuardController::stop()
 {
+    std::lock_guard<std::mutex> lock(mutex_);
     if (!is_initialized_)
         return false;
 
@@ -48,6 +54,7 @@ bool WireGuardController::stop()
     adapter_.reset();
     drm_.reset();
     is_initialized_ = false;
+    statusMonitor_.wake();
 
     return true;
 }
@@ -61,7 +68,8 @@ bool WireGuardController::configure(
     uint32_t fwmark,
     uint16_t listenPort)
 {
-    return is_initialized_
+    std::lock_guard<std::mutex> lock(mutex_);
+    const bool success = is_initialized_
         && comm_->configure(clientPrivateKey,
                             peerPublicKey,
                             peerPresharedKey,
@@ -69,6 +77,8 @@ bool WireGuardController::configure(
                             allowedIps,
                             fwmark,
                             listenPort);
+    statusMonitor_.wake();
+    return success;
 }
 
 unsigned long WireGuardController::getStatus(
@@ -76,11 +86,22 @@ unsigned long WireGuardController::getStatus(
     unsigned long long *bytesReceived,
     unsigned long long *bytesTransmitted) const
 {
+    std::lock_guard<std::mutex> lock(mutex_);
     if (!is_initialized_)
         return kWgStateNone;
     return comm_->getStatus(errorCode, bytesReceived, bytesTransmitted);
 }
 
+void WireGuardController::setStatusCallback(WireGuardStatusMonitor::StatusCallback callback)
+{
+    statusMonitor_.setCallback(callback);
+}
+
+void WireGuardController::subscribeStatus(unsigned int statsIntervalMs)
+{
+    statusMonitor_.setStatsInterval(statsIntervalMs);
+}
+
 
 bool WireGuardController::configureAdapter(const std::string &ipAddress,
     const std::string &dnsAddressList,
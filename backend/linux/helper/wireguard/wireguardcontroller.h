@@ -1,12 +1,14 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 #include "iwireguardcommunicator.h"
 #include "defaultroutemonitor.h"
 #include "wireguardadapter.h"
+#include "wireguardstatusmonitor.h"
 
 class WireGuardController
 {
@@ -44,6 +46,10 @@ public:
 
     bool isInitialized() const { return is_initialized_; }
 
+    // status changes are reported to the callback while someone is subscribed, see WireGuardStatusMonitor
+    void setStatusCallback(WireGuardStatusMonitor::StatusCallback callback);
+    void subscribeStatus(unsigned int statsIntervalMs);
+
     static std::vector<std::string> splitAndDeduplicateAllowedIps(
         const std::string &allowedIps);
     static uint32_t getFwmark();
@@ -55,6 +61,9 @@ private:
     std::unique_ptr<DefaultRouteMonitor> drm_;
     std::shared_ptr<IWireGuardCommunicator> comm_;
     bool is_initialized_;
+    // guards comm_, getStatus() is also called from the status monitor thread
+    mutable std::mutex mutex_;
+    WireGuardStatusMonitor statusMonitor_;
 
     WireGuardController();
 };
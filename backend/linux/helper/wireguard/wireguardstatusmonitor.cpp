@@ -0,0 +1,94 @@
+#include "wireguardstatusmonitor.h"
+#include "../../../posix_common/helper_commands.h"
+#include <chrono>
+
+WireGuardStatusMonitor::WireGuardStatusMonitor(GetStatusFunc getStatus)
+    : getStatus_(getStatus), isStopping_(false), isWoken_(false), isResendRequested_(false), statsIntervalMs_(0)
+{
+}
+
+WireGuardStatusMonitor::~WireGuardStatusMonitor()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        isStopping_ = true;
+    }
+    condition_.notify_all();
+    if (monitorThread_ && monitorThread_->joinable()) {
+        monitorThread_->join();
+    }
+}
+
+void WireGuardStatusMonitor::setCallback(StatusCallback callback)
+{
+    std::lock_guard<std::mutex> lock(callbackMutex_);
+    callback_ = callback;
+}
+
+void WireGuardStatusMonitor::setStatsInterval(unsigned int statsIntervalMs)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        statsIntervalMs_ = statsIntervalMs;
+        // a new subscriber gets the current status even if it did not change
+        isResendRequested_ = true;
+        isWoken_ = true;
+        if (!monitorThread_ && statsIntervalMs_ != 0) {
+            monitorThread_.reset(new std::thread(&WireGuardStatusMonitor::run, this));
+        }
+    }
+    condition_.notify_all();
+}
+
+void WireGuardStatusMonitor::wake()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        isWoken_ = true;
+    }
+    condition_.notify_all();
+}
+
+void WireGuardStatusMonitor::run()
+{
+    Status last;
+    bool hasLast = false;
+    auto isWakeNeeded = [this]() { return isStopping_ || isWoken_; };
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!isStopping_) {
+        if (statsIntervalMs_ == 0) {
+            hasLast = false;
+            isWoken_ = false;
+            condition_.wait(lock, isWakeNeeded);
+            continue;
+        }
+
+        const bool isResend = isResendRequested_;
+        isResendRequested_ = false;
+        isWoken_ = false;
+        lock.unlock();
+
+        Status status;
+        status.state = getStatus_(&status.errorCode, &status.bytesReceived, &status.bytesTransmitted);
+        const bool isChanged = !hasLast || status.state != last.state || status.errorCode != last.errorCode ||
+                               status.bytesReceived != last.bytesReceived || status.bytesTransmitted != last.bytesTransmitted;
+        if (isChanged || isResend) {
+            std::lock_guard<std::mutex> callbackLock(callbackMutex_);
+            if (callback_) {
+                callback_(status);
+            }
+        }
+        last = status;
+        hasLast = true;
+
+        lock.lock();
+        if (status.state == kWgStateNone || status.state == kWgStateError) {
+            // nothing changes until the tunnel is started or stopped, which wakes the monitor
+            condition_.wait(lock, isWakeNeeded);
+        } else {
+            const unsigned int waitMs = status.state == kWgStateActive ? statsIntervalMs_ : kTransitionPollMs;
+            condition_.wait_for(lock, std::chrono::milliseconds(waitMs), isWakeNeeded);
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Watches the WireGuard status on behalf of the client app and reports only the changes, so the app waits for
+// the reports instead of polling the helper. The state is read often while the tunnel is coming up, to detect the
+// handshake quickly, and once per statistics interval while it is active. Nothing is read while it is stopped.
+class WireGuardStatusMonitor final
+{
+public:
+    struct Status
+    {
+        unsigned long state = 0;    // CmdWireGuardServiceState
+        unsigned int errorCode = 0;
+        unsigned long long bytesReceived = 0;
+        unsigned long long bytesTransmitted = 0;
+    };
+
+    typedef std::function<unsigned long(unsigned int *errorCode, unsigned long long *bytesReceived,
+                                        unsigned long long *bytesTransmitted)> GetStatusFunc;
+    typedef std::function<void(const Status &status)> StatusCallback;
+
+    explicit WireGuardStatusMonitor(GetStatusFunc getStatus);
+    ~WireGuardStatusMonitor();
+
+    // the callback is called from the monitor thread; once this returns, the previous callback is not running
+    // and will not be called anymore
+    void setCallback(StatusCallback callback);
+    // starts reporting and sends the current status; statsIntervalMs == 0 stops reporting
+    void setStatsInterval(unsigned int statsIntervalMs);
+    // re-reads the status right away, called when the tunnel is started, configured or stopped
+    void wake();
+
+private:
+    static constexpr unsigned int kTransitionPollMs = 50;
+
+    void run();
+
+    GetStatusFunc getStatus_;
+    StatusCallback callback_;
+    // held while the callback runs, so that it can be replaced by its owner before the owner is destroyed
+    std::mutex callbackMutex_;
+    std::unique_ptr<std::thread> monitorThread_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    bool isStopping_;
+    bool isWoken_;
+    bool isResendRequested_;
+    unsigned int statsIntervalMs_;
+};
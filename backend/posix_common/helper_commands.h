@@ -43,6 +43,15 @@
 #define HELPER_CMD_HELPER_VERSION                    36
 #define HELPER_CMD_GET_INTERFACE_SSID                37
 #define HELPER_CMD_RESET_MAC_ADDRESSES               38 // Linux only
+#define HELPER_CMD_SUBSCRIBE_WIREGUARD_STATUS        39 // Linux only
+#define HELPER_CMD_SET_FIREWALL_WHITELIST            40 // Linux only
+
+// the ipset with the firewall whitelist, the client rules match it with "-m set --match-set"
+#define HELPER_FIREWALL_WHITELIST_IPSET "windscribe_whitelist"
+
+// events pushed by the helper, Linux only (see helper_protocol.h)
+#define HELPER_EVENT_CMD_FINISHED                    1
+#define HELPER_EVENT_WIREGUARD_STATUS                2
 
 // enums
 
@@ -279,3 +288,27 @@ struct CMD_RESET_MAC_ADDRESSES {
     std::string ignoreNetwork;
 };
 
+struct CMD_SUBSCRIBE_WIREGUARD_STATUS {
+    unsigned int statsIntervalMs; // 0 to unsubscribe
+};
+
+// the answer exitCode is 1 if the entries are in HELPER_FIREWALL_WHITELIST_IPSET, 0 if ipset is not available
+struct CMD_SET_FIREWALL_WHITELIST {
+    std::vector<std::string> entries;   // IPv4 addresses and prefixes in the "a.b.c.d/n" format
+};
+
+// event structs
+
+struct EVENT_CMD_FINISHED {
+    unsigned long cmdId;
+    bool success;
+    std::string log;
+};
+
+// sent when the state changes, and at most once per statsIntervalMs when only the byte counters change
+struct EVENT_WIREGUARD_STATUS {
+    unsigned long state;                // CmdWireGuardServiceState
+    unsigned int errorCode;
+    unsigned long long bytesReceived;   // totals since the tunnel was started
+    unsigned long long bytesTransmitted;
+};
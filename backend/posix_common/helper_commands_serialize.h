@@ -287,5 +287,38 @@ void serialize(Archive &ar, CMD_RESET_MAC_ADDRESSES &a, const unsigned int versi
     ar & a.ignoreNetwork;
 }
 
+template<class Archive>
+void serialize(Archive &ar, CMD_SUBSCRIBE_WIREGUARD_STATUS &a, const unsigned int version)
+{
+    UNUSED(version);
+    ar & a.statsIntervalMs;
+}
+
+template<class Archive>
+void serialize(Archive &ar, CMD_SET_FIREWALL_WHITELIST &a, const unsigned int version)
+{
+    UNUSED(version);
+    ar & a.entries;
+}
+
+template<class Archive>
+void serialize(Archive &ar, EVENT_CMD_FINISHED &a, const unsigned int version)
+{
+    UNUSED(version);
+    ar & a.cmdId;
+    ar & a.success;
+    ar & a.log;
+}
+
+template<class Archive>
+void serialize(Archive &ar, EVENT_WIREGUARD_STATUS &a, const unsigned int version)
+{
+    UNUSED(version);
+    ar & a.state;
+    ar & a.errorCode;
+    ar & a.bytesReceived;
+    ar & a.bytesTransmitted;
+}
+
 }
 }
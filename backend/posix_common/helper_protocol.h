@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Framing of the messages between the engine and the Linux helper.
+// Every message is a fixed binary header followed by a payload of `length` bytes: a serialized command,
+// CMD_ANSWER or event. Requests carry an id which the helper copies into the answer, so several requests
+// can be in flight on one connection and answered out of order. Events are pushed by the helper with requestId 0.
+// The first word of the legacy framing is a small command id, so the helper tells the two apart by kMagic.
+namespace HelperProtocol {
+
+const uint32_t kMagic = 0x32485357;     // "WSH2"
+const uint16_t kVersion = 1;
+const uint32_t kMaxPayloadSize = 64 * 1024 * 1024;
+
+enum MessageType : uint16_t {
+    kRequest = 1,
+    kAnswer = 2,
+    kEvent = 3,
+};
+
+#pragma pack(push, 1)
+struct Header
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t type;
+    uint32_t requestId;
+    int32_t id;         // command id for requests and answers, event id for events
+    int32_t pid;        // pid of the sender
+    uint32_t length;
+};
+#pragma pack(pop)
+
+// header and payload in one buffer, so a message is sent with a single write
+inline std::string makeMessage(MessageType type, uint32_t requestId, int32_t id, int32_t pid, const std::string &payload)
+{
+    Header header;
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.type = type;
+    header.requestId = requestId;
+    header.id = id;
+    header.pid = pid;
+    header.length = (uint32_t)payload.size();
+
+    std::string message;
+    message.reserve(sizeof(header) + payload.size());
+    message.append(reinterpret_cast<const char *>(&header), sizeof(header));
+    message.append(payload);
+    return message;
+}
+
+inline bool isValidHeader(const Header &header)
+{
+    return header.magic == kMagic && header.version == kVersion && header.length <= kMaxPayloadSize;
+}
+
+} // namespace HelperProtocol
@@ -39,6 +39,7 @@ Backend::Backend(QObject *parent) : QObject(parent),
     connect(&preferences_, &Preferences::engineSettingsChanged, this, &Backend::onEngineSettingsChangedInPreferences);
 
     locationsModelManager_ = new gui_locations::LocationsModelManager(this);
+    connect(locationsModelManager_, &gui_locations::LocationsModelManager::favoriteLocationsChanged, this, &Backend::onFavoriteLocationsChanged);
 
     connect(&connectStateHelper_, &ConnectStateHelper::connectStateChanged, this, &Backend::connectStateChanged);
     connect(&emergencyConnectStateHelper_, &ConnectStateHelper::connectStateChanged, this, &Backend::emergencyConnectStateChanged);
@@ -408,6 +409,7 @@ void Backend::onEngineInitFinished(ENGINE_INIT_RET_CODE retCode, bool isCanLogin
         connect(engine_->getLocationsModel(), &locationsmodel::LocationsModel::bestLocationUpdated, this, &Backend::onEngineLocationsModelBestLocationUpdated);
         connect(engine_->getLocationsModel(), &locationsmodel::LocationsModel::customConfigsLocationsUpdated, this, &Backend::onEngineLocationsModelCustomConfigItemsUpdated);
         connect(engine_->getLocationsModel(), &locationsmodel::LocationsModel::locationPingTimeChanged, this, &Backend::onEngineLocationsModelPingChangedChanged);
+        engine_->setFavoriteLocations(locationsModelManager_->favoriteLocations());
 
         preferences_.setEngineSettings(engineSettings);
         // WiFi sharing supported state
@@ -950,6 +952,13 @@ void Backend::onEngineAutoEnableAntiCensorship()
     preferences_.setAntiCensorship(true);
 }
 
+void Backend::onFavoriteLocationsChanged()
+{
+    // the engine uses them to prefetch the connection configs
+    if (engine_)
+        engine_->setFavoriteLocations(locationsModelManager_->favoriteLocations());
+}
+
 void Backend::updateCurrentNetworkInterface()
 {
     engine_->updateCurrentNetworkInterface();
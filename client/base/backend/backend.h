@@ -181,6 +181,8 @@ private slots:
     void onEngineHostsFileBecameWritable();
     void onEngineAutoEnableAntiCensorship();
 
+    void onFavoriteLocationsChanged();
+
 signals:
     // emited when connected to engine and received the engine settings, or error in initState variable
     void initFinished(INIT_STATE initState);
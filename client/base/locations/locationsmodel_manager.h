@@ -42,9 +42,11 @@ public:
     void setFilterString(const QString &filterString);
 
     void saveFavoriteLocations();
+    QVector<LocationID> favoriteLocations() const;
 
 signals:
     void deviceNameChanged(const QString &deviceName);
+    void favoriteLocationsChanged();
 
 private slots:
     void onChangeConnectionSpeedTimer();
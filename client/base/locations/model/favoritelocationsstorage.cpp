@@ -36,6 +36,11 @@ bool FavoriteLocationsStorage::isFavorite(const LocationID &locationId) const
     return favoriteLocations_.find(locationId) != favoriteLocations_.end();
 }
 
+QVector<LocationID> FavoriteLocationsStorage::favorites() const
+{
+    return QVector<LocationID>(favoriteLocations_.begin(), favoriteLocations_.end());
+}
+
 void FavoriteLocationsStorage::readFromSettings()
 {
     favoriteLocations_.clear();
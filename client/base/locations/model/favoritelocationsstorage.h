@@ -2,6 +2,7 @@
 
 #include <QObject>
 #include <QSet>
+#include <QVector>
 #include "types/locationid.h"
 
 namespace gui_locations {
@@ -14,6 +15,7 @@ public:
     void addToFavorites(const LocationID &locationId);
     void removeFromFavorites(const LocationID &locationId);
     bool isFavorite(const LocationID &locationId) const;
+    QVector<LocationID> favorites() const;
 
     void readFromSettings();
     void writeToSettings();
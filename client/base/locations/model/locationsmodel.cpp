@@ -357,6 +357,7 @@ bool LocationsModel::setData(const QModelIndex &index, const QVariant &value, in
                 favoriteLocationsStorage_.removeFromFavorites(lid);
             }
             emit dataChanged(index, index, QList<int>() << kIsFavorite);
+            emit favoriteLocationsChanged();
             return true;
         }
     }
@@ -459,6 +460,11 @@ void LocationsModel::saveFavoriteLocations()
     favoriteLocationsStorage_.writeToSettings();
 }
 
+QVector<LocationID> LocationsModel::favoriteLocations() const
+{
+    return favoriteLocationsStorage_.favorites();
+}
+
 QVariant LocationsModel::dataForLocation(int row, int role) const
 {
     if (role == Qt::DisplayRole)
@@ -63,9 +63,11 @@ public:
 
     // the client of the class must explicitly save locations  if required
     void saveFavoriteLocations();
+    QVector<LocationID> favoriteLocations() const;
 
 signals:
     void deviceNameChanged(const QString &deviceName);
+    void favoriteLocationsChanged();
 
 private slots:
     void onLanguageChanged();
@@ -1,5 +1,6 @@
 #include "group.h"
 #include <QJsonArray>
+#include <wsnet/WSNetServerList.h>
 #include "utils/ws_assert.h"
 
 namespace api_responses {
@@ -75,6 +76,30 @@ bool Group::initFromJson(QJsonObject &obj, QStringList &forceDisconnectNodes)
     return true;
 }
 
+void Group::initFromServerList(const wsnet::WSNetServerList &serverList, std::uint32_t ind, const QVector<QString> &strings)
+{
+    d->id_ = serverList.groupId(ind);
+    d->city_ = strings[serverList.groupCity(ind)];
+    d->nick_ = strings[serverList.groupNick(ind)];
+    d->pro_ = serverList.groupPro(ind);
+    d->pingIp_ = strings[serverList.groupPingIp(ind)];
+    d->pingHost_ = strings[serverList.groupPingHost(ind)];
+    d->wg_pubkey_ = strings[serverList.groupWgPubKey(ind)];
+    d->ovpn_x509_ = strings[serverList.groupOvpnX509(ind)];
+    d->link_speed_ = serverList.groupLinkSpeed(ind);
+    d->health_ = serverList.groupHealth(ind);
+
+    const std::uint32_t firstNode = serverList.groupFirstNode(ind);
+    const std::uint32_t nodesCount = serverList.groupNodesCount(ind);
+    d->nodes_.reserve(nodesCount);
+    for (std::uint32_t i = firstNode; i < firstNode + nodesCount; ++i) {
+        Node node;
+        node.initFromServerList(serverList, i, strings);
+        d->nodes_ << node;
+    }
+    d->isValid_ = true;
+}
+
 bool Group::operator==(const Group &other) const
 {
     return d->id_ == other.d->id_ &&
@@ -57,6 +57,7 @@ public:
     Group(const Group &other) : d (other.d) {}
 
     bool initFromJson(QJsonObject &obj, QStringList &forceDisconnectNodes);
+    void initFromServerList(const wsnet::WSNetServerList &serverList, std::uint32_t ind, const QVector<QString> &strings);
 
     int getId() const { WS_ASSERT(d->isValid_); return d->id_; }
     QString getCity() const { WS_ASSERT(d->isValid_); return d->city_; }
@@ -4,6 +4,7 @@
 #include <QJsonObject>
 #include <QJsonValue>
 #include <QJsonArray>
+#include <wsnet/WSNetServerList.h>
 
 const int typeIdApiLocation = qRegisterMetaType<api_responses::Location>("apiinfo::Location");
 const int typeIdApiLocationVector = qRegisterMetaType<QVector<api_responses::Location>>("QVector<apiinfo::Location>");
@@ -48,6 +49,26 @@ bool Location::initFromJson(const QJsonObject &obj, QStringList &forceDisconnect
     return true;
 }
 
+void Location::initFromServerList(const wsnet::WSNetServerList &serverList, std::uint32_t ind, const QVector<QString> &strings)
+{
+    d->id_ = serverList.locationId(ind);
+    d->name_ = strings[serverList.locationName(ind)];
+    d->countryCode_ = strings[serverList.locationCountryCode(ind)];
+    d->premiumOnly_ = serverList.locationPremiumOnly(ind);
+    d->p2p_ = serverList.locationP2P(ind);
+    d->dnsHostName_ = strings[serverList.locationDnsHostName(ind)];
+
+    const std::uint32_t firstGroup = serverList.locationFirstGroup(ind);
+    const std::uint32_t groupsCount = serverList.locationGroupsCount(ind);
+    d->groups_.reserve(groupsCount);
+    for (std::uint32_t i = firstGroup; i < firstGroup + groupsCount; ++i) {
+        Group group;
+        group.initFromServerList(serverList, i, strings);
+        d->groups_ << group;
+    }
+    d->isValid_ = true;
+}
+
 QStringList Location::getAllPingIps() const
 {
     WS_ASSERT(d->isValid_);
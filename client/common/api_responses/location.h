@@ -46,6 +46,7 @@ public:
     Location(const Location &other) : d (other.d) {}
 
     bool initFromJson(const QJsonObject &obj, QStringList &forceDisconnectNodes);
+    void initFromServerList(const wsnet::WSNetServerList &serverList, std::uint32_t ind, const QVector<QString> &strings);
 
     int getId() const { WS_ASSERT(d->isValid_); return d->id_; }
     QString getName() const { WS_ASSERT(d->isValid_); return d->name_; }
@@ -1,4 +1,5 @@
 #include "node.h"
+#include <wsnet/WSNetServerList.h>
 #include "utils/ws_assert.h"
 
 namespace api_responses {
@@ -30,6 +31,18 @@ bool Node::initFromJson(QJsonObject &obj)
     return true;
 }
 
+void Node::initFromServerList(const wsnet::WSNetServerList &serverList, std::uint32_t ind, const QVector<QString> &strings)
+{
+    d->ips_.reserve(3);
+    for (std::uint32_t i = 0; i < 3; ++i)
+        d->ips_ << strings[serverList.nodeIp(ind, i)];
+    d->hostname_ = strings[serverList.nodeHostname(ind)];
+    d->weight_ = serverList.nodeWeight(ind);
+    // nodes with the force_disconnect flag are not included in the groups of the server list
+    d->forceDisconnect_ = 0;
+    d->isValid_ = true;
+}
+
 QString Node::getHostname() const
 {
     WS_ASSERT(d->isValid_);
@@ -4,6 +4,10 @@
 #include <QSharedDataPointer>
 #include <QStringList>
 
+namespace wsnet {
+class WSNetServerList;
+}
+
 namespace api_responses {
 
 class NodeData : public QSharedData
@@ -29,6 +33,8 @@ public:
     Node() : d(new NodeData) {}
 
     bool initFromJson(QJsonObject &obj);
+    // strings is the strings table of the server list converted to QString
+    void initFromServerList(const wsnet::WSNetServerList &serverList, std::uint32_t ind, const QVector<QString> &strings);
 
     QString getHostname() const;
     bool isForceDisconnect() const;
@@ -1,6 +1,7 @@
 #include "serverlist.h"
 #include <QJsonDocument>
 #include <QJsonArray>
+#include <wsnet/WSNetServerList.h>
 
 namespace api_responses {
 
@@ -36,5 +37,23 @@ ServerList::ServerList(const std::string &json)
     }
 }
 
+ServerList::ServerList(const wsnet::WSNetServerList &serverList)
+{
+    QVector<QString> strings;
+    strings.reserve(serverList.stringsCount());
+    for (std::uint32_t i = 0; i < serverList.stringsCount(); ++i)
+        strings << QString::fromStdString(serverList.string(i));
+
+    countryOverride_ = QString::fromStdString(serverList.countryOverride());
+    for (auto ind : serverList.forceDisconnectNodes())
+        forceDisconnectNodes_ << strings[ind];
+
+    locations_.reserve(serverList.locationsCount());
+    for (std::uint32_t i = 0; i < serverList.locationsCount(); ++i) {
+        Location sl;
+        sl.initFromServerList(serverList, i, strings);
+        locations_ << sl;
+    }
+}
 
 } // namespace api_responses
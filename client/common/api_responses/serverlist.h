@@ -8,7 +8,10 @@ namespace api_responses {
 class ServerList
 {
 public:
-    ServerList(const std::string &json);
+    ServerList() {}
+    explicit ServerList(const std::string &json);
+    // from the typed server list parsed by wsnet, each interned string is converted to QString once and shared by all its users
+    explicit ServerList(const wsnet::WSNetServerList &serverList);
 
     QVector<Location> locations() const { return locations_; }
     QStringList forceDisconnectNodes() const { return forceDisconnectNodes_; }
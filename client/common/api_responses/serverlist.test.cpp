@@ -0,0 +1,143 @@
+#include "serverlist.test.h"
+
+#include <QElapsedTimer>
+#include <wsnet/WSNetServerList.h>
+
+#include "serverlist.h"
+
+namespace {
+
+void compareServerLists(const api_responses::ServerList &actual, const api_responses::ServerList &expected)
+{
+    QCOMPARE(actual.countryOverride(), expected.countryOverride());
+    QCOMPARE(actual.forceDisconnectNodes(), expected.forceDisconnectNodes());
+    QCOMPARE(actual.locations().size(), expected.locations().size());
+    for (int i = 0; i < expected.locations().size(); ++i)
+        QVERIFY(actual.locations()[i] == expected.locations()[i]);
+}
+
+} // namespace
+
+void TestServerList::testSameAsJson()
+{
+    const std::string json = makeServerList(20, 5, 4);
+    auto serverList = wsnet::WSNetServerList::createFromJson(json);
+    QVERIFY(serverList != nullptr);
+    QCOMPARE(serverList->locationsCount(), 20u);
+
+    api_responses::ServerList fromJson(json);
+    api_responses::ServerList fromTyped(*serverList);
+    compareServerLists(fromTyped, fromJson);
+    QCOMPARE(fromTyped.countryOverride(), QString("CA"));
+    QVERIFY(!fromTyped.forceDisconnectNodes().isEmpty());
+}
+
+void TestServerList::testInvalidEntries()
+{
+    // the 2nd location misses a field, the 3rd one has a node without an ip, the 4th one has invalid health and link speed values
+    const std::string json = R"({"info": {}, "data": [
+        {"id": 1, "name": "A", "country_code": "AA", "premium_only": 0, "p2p": 1, "dns_hostname": "a.example.com", "groups": [
+            {"id": 10, "city": "CityA", "nick": "NickA", "pro": 1, "ping_ip": "10.0.0.1", "wg_pubkey": "key", "link_speed": "1000", "health": 20, "nodes": [
+                {"ip": "1.1.1.1", "ip2": "1.1.1.2", "ip3": "1.1.1.3", "hostname": "a1.example.com", "weight": 1},
+                {"ip": "1.1.1.4", "ip2": "1.1.1.5", "ip3": "1.1.1.6", "hostname": "a2.example.com", "weight": 1, "force_disconnect": 1}]}]},
+        {"id": 2, "name": "B", "country_code": "BB", "p2p": 1, "groups": []},
+        {"id": 3, "name": "C", "country_code": "CC", "premium_only": 0, "p2p": 1, "groups": [
+            {"id": 30, "city": "CityC", "nick": "NickC", "pro": 0, "ping_ip": "10.0.0.3", "wg_pubkey": "key", "nodes": [
+                {"ip2": "3.3.3.2", "ip3": "3.3.3.3", "hostname": "c1.example.com", "weight": 1}]}]},
+        {"id": 4, "name": "D", "country_code": "DD", "premium_only": 1, "p2p": 0, "groups": [
+            {"id": 40, "city": "CityD", "nick": "NickD", "pro": 1, "ping_ip": "10.0.0.4", "wg_pubkey": "key", "link_speed": "fast", "health": 101},
+            {"id": 41, "city": "CityD", "nick": "NickD2", "pro": 1, "ping_ip": "10.0.0.5", "wg_pubkey": "key", "link_speed": 10, "health": "50"}]}
+    ]})";
+
+    auto serverList = wsnet::WSNetServerList::createFromJson(json);
+    QVERIFY(serverList != nullptr);
+    QCOMPARE(serverList->locationsCount(), 2u);
+    QCOMPARE(serverList->locationId(0), 1);
+    QCOMPARE(serverList->locationId(1), 4);
+    QCOMPARE(serverList->groupHealth(serverList->locationFirstGroup(1)), -1);
+    QCOMPARE(serverList->groupLinkSpeed(serverList->locationFirstGroup(1)), 100);
+    QCOMPARE(serverList->groupLinkSpeed(serverList->locationFirstGroup(1) + 1), 100);
+
+    compareServerLists(api_responses::ServerList(*serverList), api_responses::ServerList(json));
+
+    QVERIFY(wsnet::WSNetServerList::createFromJson("not a json") == nullptr);
+    QVERIFY(wsnet::WSNetServerList::createFromJson("[]") == nullptr);
+}
+
+void TestServerList::benchmarkParse()
+{
+    int locationsCount = qEnvironmentVariableIntValue("WS_SERVERLIST_BENCHMARK_LOCATIONS");
+    if (locationsCount <= 0)
+        locationsCount = 500;
+    const std::string json = makeServerList(locationsCount, 8, 6);
+    const int kIterations = 5;
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < kIterations; ++i) {
+        api_responses::ServerList fromJson(json);
+        QCOMPARE(fromJson.locations().size(), locationsCount);
+    }
+    const double jsonMs = timer.nsecsElapsed() / 1e6 / kIterations;
+
+    std::shared_ptr<wsnet::WSNetServerList> serverList;
+    timer.restart();
+    for (int i = 0; i < kIterations; ++i)
+        serverList = wsnet::WSNetServerList::createFromJson(json);
+    const double parseMs = timer.nsecsElapsed() / 1e6 / kIterations;
+
+    timer.restart();
+    for (int i = 0; i < kIterations; ++i) {
+        api_responses::ServerList fromTyped(*serverList);
+        QCOMPARE(fromTyped.locations().size(), locationsCount);
+    }
+    const double convertMs = timer.nsecsElapsed() / 1e6 / kIterations;
+
+    std::uint32_t nodesCount = 0;
+    for (std::uint32_t i = 0; i < serverList->locationsCount(); ++i) {
+        const std::uint32_t firstGroup = serverList->locationFirstGroup(i);
+        for (std::uint32_t g = firstGroup; g < firstGroup + serverList->locationGroupsCount(i); ++g)
+            nodesCount += serverList->groupNodesCount(g);
+    }
+
+    qInfo("server list of %lld KB, %d locations, %u nodes, %u unique strings", (long long)json.size() / 1024, locationsCount, nodesCount,
+          serverList->stringsCount());
+    qInfo("QJsonDocument parse: %.1f ms; wsnet parse: %.1f ms + conversion: %.1f ms", jsonMs, parseMs, convertMs);
+}
+
+// the groups of a location share the city, keys and x509 name, as in the real server list
+std::string TestServerList::makeServerList(int locationsCount, int groupsCount, int nodesCount)
+{
+    std::string json = R"({"info": {"revision": 1, "country_override": "CA"}, "data": [)";
+    for (int l = 0; l < locationsCount; ++l) {
+        const std::string ls = std::to_string(l);
+        if (l > 0)
+            json += ",";
+        json += R"({"id": )" + ls + R"(, "name": "Location )" + ls + R"(", "country_code": "C)" + std::to_string(l % 100) +
+                R"(", "premium_only": )" + std::to_string(l % 2) + R"(, "p2p": 1, "dns_hostname": "loc)" + ls + R"(.example.com", "groups": [)";
+        for (int g = 0; g < groupsCount; ++g) {
+            const std::string gs = ls + "-" + std::to_string(g);
+            if (g > 0)
+                json += ",";
+            json += R"({"id": )" + std::to_string(l * groupsCount + g) + R"(, "city": "City )" + ls + R"(", "nick": "Nick )" + gs +
+                    R"(", "pro": )" + std::to_string(g % 2) + R"(, "ping_ip": "10.)" + std::to_string(l % 256) + "." + std::to_string(g) +
+                    R"(.1", "ping_host": "https://ping)" + gs + R"(.example.com:6363/latency", "wg_pubkey": "PublicKey)" + std::to_string(l % 10) +
+                    R"(AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA=", "ovpn_x509": "x509.example.com", "link_speed": "1000", "health": )" +
+                    std::to_string((l + g) % 100) + R"(, "nodes": [)";
+            for (int n = 0; n < nodesCount; ++n) {
+                const std::string ns = gs + "-" + std::to_string(n);
+                const std::string ip = std::to_string(l % 256) + "." + std::to_string(g) + "." + std::to_string(n) + ".";
+                if (n > 0)
+                    json += ",";
+                json += R"({"ip": ")" + ip + R"(1", "ip2": ")" + ip + R"(2", "ip3": ")" + ip + R"(3", "hostname": "node)" + ns +
+                        R"(.example.com", "weight": 1)" + ((l + g + n) % 97 == 0 ? R"(, "force_disconnect": 1})" : "}");
+            }
+            json += "]}";
+        }
+        json += "]}";
+    }
+    json += "]}";
+    return json;
+}
+
+QTEST_MAIN(TestServerList)
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <QObject>
+#include <QTest>
+
+// checks that the server list built from the typed list of wsnet is the same as the one parsed from json by Qt,
+// and a benchmark of both ways on a large synthetic server list
+// the number of locations for the benchmark can be set with the WS_SERVERLIST_BENCHMARK_LOCATIONS environment variable (500 by default)
+class TestServerList : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testSameAsJson();
+    void testInvalidEntries();
+    void benchmarkParse();
+
+private:
+    static std::string makeServerList(int locationsCount, int groupsCount, int nodesCount);
+};
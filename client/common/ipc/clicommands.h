@@ -17,17 +17,14 @@ public:
     Acknowledge() {}
     explicit Acknowledge(char *buf, int size)
     {
-        QByteArray arr(buf, size);
+        QByteArray arr = QByteArray::fromRawData(buf, size);
         QDataStream ds(&arr, QIODevice::ReadOnly);
         ds >> code_ >> message_;
     }
 
-    std::vector<char> getData() const override
+    void writeData(QDataStream &ds) const override
     {
-        QByteArray arr;
-        QDataStream ds(&arr, QIODevice::WriteOnly);
         ds << code_ << message_;
-        return std::vector<char>(arr.begin(), arr.end());
     }
 
     std::string getStringId() const override { return getCommandStringId(); }
@@ -47,17 +44,14 @@ public:
     Connect() {}
     explicit Connect(char *buf, int size)
     {
-        QByteArray arr(buf, size);
+        QByteArray arr = QByteArray::fromRawData(buf, size);
         QDataStream ds(&arr, QIODevice::ReadOnly);
         ds >> location_ >> protocol_;
     }
 
-    std::vector<char> getData() const override
+    void writeData(QDataStream &ds) const override
     {
-        QByteArray arr;
-        QDataStream ds(&arr, QIODevice::WriteOnly);
         ds << location_ << protocol_;
-        return std::vector<char>(arr.begin(), arr.end());
     }
 
     std::string getStringId() const override { return getCommandStringId(); }
@@ -81,9 +75,9 @@ public:
         Q_UNUSED(size)
     }
 
-    std::vector<char> getData() const override
+    void writeData(QDataStream &ds) const override
     {
-        return std::vector<char>();
+        Q_UNUSED(ds)
     }
 
     std::string getStringId() const override { return getCommandStringId(); }
@@ -104,9 +98,9 @@ public:
         Q_UNUSED(size)
     }
 
-    std::vector<char> getData() const override
+    void writeData(QDataStream &ds) const override
     {
-        return std::vector<char>();
+        Q_UNUSED(ds)
     }
 
     std::string getStringId() const override { return getCommandStringId(); }
@@ -123,17 +117,14 @@ public:
     LocationsList() {}
     explicit LocationsList(char *buf, int size)
     {
-        QByteArray arr(buf, size);
+        QByteArray arr = QByteArray::fromRawData(buf, size);
         QDataStream ds(&arr, QIODevice::ReadOnly);
         ds >> locations_;
     }
 
-    std::vector<char> getData() const override
+    void writeData(QDataStream &ds) const override
     {
-        QByteArray arr;
-        QDataStream ds(&arr, QIODevice::WriteOnly);
         ds << locations_;
-        return std::vector<char>(arr.begin(), arr.end());
     }
 
     std::string getStringId() const override { return getCommandStringId(); }
@@ -152,17 +143,14 @@ public:
     Firewall() {}
     explicit Firewall(char *buf, int size)
     {
-        QByteArray arr(buf, size);
+        QByteArray arr = QByteArray::fromRawData(buf, size);
         QDataStream ds(&arr, QIODevice::ReadOnly);
         ds >> isEnable_;
     }
 
-    std::vector<char> getData() const override
+    void writeData(QDataStream &ds) const override
     {
-        QByteArray arr;
-        QDataStream ds(&arr, QIODevice::WriteOnly);
         ds << isEnable_;
-        return std::vector<char>(arr.begin(), arr.end());
     }
 
     std::string getStringId() const override { return getCommandStringId(); }
@@ -185,9 +173,9 @@ public:
         Q_UNUSED(size)
     }
 
-    std::vector<char> getData() const override
+    void writeData(QDataStream &ds) const override
     {
-        return std::vector<char>();
+        Q_UNUSED(ds)
     }
 
     std::string getStringId() const override { return getCommandStringId(); }
@@ -204,17 +192,14 @@ public:
     Login() {}
     explicit Login(char *buf, int size)
     {
-        QByteArray arr(buf, size);
+        QByteArray arr = QByteArray::fromRawData(buf, size);
         QDataStream ds(&arr, QIODevice::ReadOnly);
         ds >> username_ >> password_ >> code2fa_;
     }
 
-    std::vector<char> getData() const override
+    void writeData(QDataStream &ds) const override
     {
-        QByteArray arr;
-        QDataStream ds(&arr, QIODevice::WriteOnly);
         ds << username_ << password_ << code2fa_;
-        return std::vector<char>(arr.begin(), arr.end());
     }
 
     std::string getStringId() const override { return getCommandStringId(); }
@@ -235,17 +220,14 @@ public:
     Logout() {}
     explicit Logout(char *buf, int size)
     {
-        QByteArray arr(buf, size);
+        QByteArray arr = QByteArray::fromRawData(buf, size);
         QDataStream ds(&arr, QIODevice::ReadOnly);
         ds >> isKeepFirewallOn_;
     }
 
-    std::vector<char> getData() const override
+    void writeData(QDataStream &ds) const override
     {
-        QByteArray arr;
-        QDataStream ds(&arr, QIODevice::WriteOnly);
         ds << isKeepFirewallOn_;
-        return std::vector<char>(arr.begin(), arr.end());
     }
 
     std::string getStringId() const override { return getCommandStringId(); }
@@ -268,9 +250,9 @@ public:
         Q_UNUSED(size);
     }
 
-    std::vector<char> getData() const override
+    void writeData(QDataStream &ds) const override
     {
-        return std::vector<char>();
+        Q_UNUSED(ds)
     }
 
     std::string getStringId() const override { return getCommandStringId(); }
@@ -287,7 +269,7 @@ public:
     State() {}
     explicit State(char *buf, int size)
     {
-        QByteArray arr(buf, size);
+        QByteArray arr = QByteArray::fromRawData(buf, size);
         QDataStream ds(&arr, QIODevice::ReadOnly);
         ds >> language_ >> connectivity_ >> loginState_ >> loginError_ >> loginErrorMessage_ >> connectState_
            >> protocol_ >> port_ >> tunnelTestState_ >> location_ >> isFirewallOn_ >> isFirewallAlwaysOn_
@@ -295,15 +277,12 @@ public:
            >> trafficUsed_ >> trafficMax_;
     }
 
-    std::vector<char> getData() const override
+    void writeData(QDataStream &ds) const override
     {
-        QByteArray arr;
-        QDataStream ds(&arr, QIODevice::WriteOnly);
         ds << language_ << connectivity_ << loginState_ << loginError_ << loginErrorMessage_ << connectState_
            << protocol_ << port_ << tunnelTestState_ << location_ << isFirewallOn_ << isFirewallAlwaysOn_
            << updateState_ << updateError_ << updateProgress_ << updatePath_ << updateAvailable_
            << trafficUsed_ << trafficMax_;
-        return std::vector<char>(arr.begin(), arr.end());
     }
 
     std::string getStringId() const override { return getCommandStringId(); }
@@ -344,9 +323,9 @@ public:
         Q_UNUSED(size);
     }
 
-    std::vector<char> getData() const override
+    void writeData(QDataStream &ds) const override
     {
-        return std::vector<char>();
+        Q_UNUSED(ds)
     }
 
     std::string getStringId() const override { return getCommandStringId(); }
@@ -367,9 +346,9 @@ public:
         Q_UNUSED(size);
     }
 
-    std::vector<char> getData() const override
+    void writeData(QDataStream &ds) const override
     {
-        return std::vector<char>();
+        Q_UNUSED(ds)
     }
 
     std::string getStringId() const override { return getCommandStringId(); }
@@ -386,17 +365,14 @@ public:
     SetKeyLimitBehavior() {}
     explicit SetKeyLimitBehavior(char *buf, int size)
     {
-        QByteArray arr(buf, size);
+        QByteArray arr = QByteArray::fromRawData(buf, size);
         QDataStream ds(&arr, QIODevice::ReadOnly);
         ds >> keyLimitDelete_;
     }
 
-    std::vector<char> getData() const override
+    void writeData(QDataStream &ds) const override
     {
-        QByteArray arr;
-        QDataStream ds(&arr, QIODevice::WriteOnly);
         ds << keyLimitDelete_;
-        return std::vector<char>(arr.begin(), arr.end());
     }
 
     std::string getStringId() const override { return getCommandStringId(); }
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <vector>
+#include <QDataStream>
 #include <string>
 
 namespace IPC
@@ -12,7 +12,8 @@ class Command
 public:
     virtual ~Command() {}
 
-    virtual std::vector<char> getData() const = 0;
+    // serializes the body of the command, the stream writes directly into the frame sent by Connection
+    virtual void writeData(QDataStream &ds) const = 0;
 
     // return unique static string ID for command
     virtual std::string getStringId() const = 0;
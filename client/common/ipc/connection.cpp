@@ -6,7 +6,7 @@
 namespace IPC
 {
 
-Connection::Connection(QLocalSocket *localSocket) : localSocket_(localSocket), bytesWrittingInProgress_(0)
+Connection::Connection(QLocalSocket *localSocket) : localSocket_(localSocket), readPos_(0), bytesWrittingInProgress_(0)
 {
     QObject::connect(localSocket_, &QLocalSocket::disconnected, this, &Connection::onSocketDisconnected);
     QObject::connect(localSocket_, &QLocalSocket::bytesWritten, this, &Connection::onSocketBytesWritten);
@@ -14,7 +14,7 @@ Connection::Connection(QLocalSocket *localSocket) : localSocket_(localSocket), b
     QObject::connect(localSocket_, &QLocalSocket::errorOccurred, this, &Connection::onSocketError);
 }
 
-Connection::Connection() : localSocket_(NULL), bytesWrittingInProgress_(0)
+Connection::Connection() : localSocket_(NULL), readPos_(0), bytesWrittingInProgress_(0)
 {
 }
 
@@ -55,34 +55,33 @@ void Connection::sendCommand(const Command &commandl)
     // 3) (string) message string id
     // 4) (byte array) body of protobuf message
 
-    std::vector<char> buf = commandl.getData();
-    int sizeOfBuf = buf.size();
     std::string strId = commandl.getStringId();
     int sizeOfStringId = strId.length();
 
     WS_ASSERT(sizeOfStringId > 0);
 
-    bool isWriteBufIsEmpty = writeBuf_.isEmpty();
+    // the body is serialized right after the header and its size is patched in afterwards,
+    // so the frame is built in one buffer and handed to the socket's write queue as is
+    QByteArray frame;
+    frame.resize(kHeaderSize);
+    memcpy(frame.data() + sizeof(int), &sizeOfStringId, sizeof(sizeOfStringId));
+    frame.append(strId.c_str(), sizeOfStringId);
+    {
+        QDataStream ds(&frame, QIODevice::WriteOnly | QIODevice::Append);
+        commandl.writeData(ds);
+    }
+    int sizeOfBuf = frame.size() - kHeaderSize - sizeOfStringId;
+    memcpy(frame.data(), &sizeOfBuf, sizeof(sizeOfBuf));
 
-    writeBuf_.append((const char *)&sizeOfBuf, sizeof(sizeOfBuf));
-    writeBuf_.append((const char *)&sizeOfStringId, sizeof(sizeOfStringId));
-    writeBuf_.append(strId.c_str(), sizeOfStringId);
-    if (sizeOfBuf > 0)
+    // QLocalSocket queues everything that is not written right away, so there is nothing left to track here
+    qint64 bytesWritten = localSocket_->write(frame);
+    if (bytesWritten == -1)
     {
-        writeBuf_.append(&buf[0], sizeOfBuf);
+        emit stateChanged(CONNECTION_DISCONNECTED, this);
     }
-    if (isWriteBufIsEmpty)
+    else
     {
-        qint64 bytesWritten = localSocket_->write(writeBuf_);
-        if (bytesWritten == -1)
-        {
-            emit stateChanged(CONNECTION_DISCONNECTED, this);
-        }
-        else
-        {
-            bytesWrittingInProgress_ += bytesWritten;
-            writeBuf_.remove(0, bytesWritten);
-        }
+        bytesWrittingInProgress_ += bytesWritten;
     }
 }
 
@@ -116,21 +115,7 @@ void Connection::onSocketDisconnected()
 void Connection::onSocketBytesWritten(qint64 bytes)
 {
     bytesWrittingInProgress_ -= bytes;
-
-    if (!writeBuf_.isEmpty())
-    {
-        qint64 bytesWritten = localSocket_->write(writeBuf_);
-        if (bytesWritten == -1)
-        {
-            emit stateChanged(CONNECTION_DISCONNECTED, this);
-        }
-        else
-        {
-            bytesWrittingInProgress_ += bytesWritten;
-            writeBuf_.remove(0, bytesWritten);
-        }
-    }
-    else if (bytesWrittingInProgress_ == 0)
+    if (bytesWrittingInProgress_ == 0)
     {
         emit allWritten(this);
     }
@@ -138,12 +123,20 @@ void Connection::onSocketBytesWritten(qint64 bytes)
 
 void Connection::onReadyRead()
 {
-    readBuf_.append(localSocket_->readAll());
+    const qint64 available = localSocket_->bytesAvailable();
+    if (available > 0)
+    {
+        const int oldSize = readBuf_.size();
+        readBuf_.resize(oldSize + available);
+        const qint64 bytesRead = localSocket_->read(readBuf_.data() + oldSize, available);
+        readBuf_.resize(oldSize + qMax<qint64>(bytesRead, 0));
+    }
     while (canReadCommand())
     {
         Command *cmd = readCommand();
         emit newCommand(cmd, this);
     }
+    compactReadBuf();
 }
 
 void Connection::onSocketError(QLocalSocket::LocalSocketError socketError)
@@ -159,14 +152,15 @@ void Connection::onSocketError(QLocalSocket::LocalSocketError socketError)
 
 bool Connection::canReadCommand()
 {
-    if (readBuf_.size() > (int)(sizeof(int) * 2))
+    const int available = readBuf_.size() - readPos_;
+    if (available > kHeaderSize)
     {
         int sizeOfCmd;
         int sizeOfId;
-        memcpy(&sizeOfCmd, readBuf_.data(), sizeof(int));
-        memcpy(&sizeOfId, readBuf_.data() + sizeof(int), sizeof(int));
+        memcpy(&sizeOfCmd, readBuf_.constData() + readPos_, sizeof(int));
+        memcpy(&sizeOfId, readBuf_.constData() + readPos_ + sizeof(int), sizeof(int));
 
-        if (readBuf_.size() >= (int)(sizeof(int) * 2 + sizeOfCmd + sizeOfId))
+        if (available >= (int)(kHeaderSize + sizeOfCmd + sizeOfId))
         {
             return true;
         }
@@ -178,16 +172,32 @@ Command *Connection::readCommand()
 {
     int sizeOfCmd;
     int sizeOfId;
-    memcpy(&sizeOfCmd, readBuf_.data(), sizeof(int));
-    memcpy(&sizeOfId, readBuf_.data() + sizeof(int), sizeof(int));
+    memcpy(&sizeOfCmd, readBuf_.constData() + readPos_, sizeof(int));
+    memcpy(&sizeOfId, readBuf_.constData() + readPos_ + sizeof(int), sizeof(int));
 
-    std::string strId(readBuf_.data() + sizeof(int) * 2, sizeOfId);
+    std::string strId(readBuf_.constData() + readPos_ + kHeaderSize, sizeOfId);
 
-    Command *cmd = CommandFactory::makeCommand(strId, readBuf_.data() + sizeof(int) * 2 + sizeOfId, sizeOfCmd);
-    readBuf_.remove(0, sizeof(int) * 2 + sizeOfId + sizeOfCmd);
+    Command *cmd = CommandFactory::makeCommand(strId, readBuf_.data() + readPos_ + kHeaderSize + sizeOfId, sizeOfCmd);
+    readPos_ += kHeaderSize + sizeOfId + sizeOfCmd;
     return cmd;
 }
 
+// drops the consumed commands: always when everything is consumed (no copy), otherwise only when the consumed part
+// is big and is more than a half of the buffer, so every byte is moved at most a few times
+void Connection::compactReadBuf()
+{
+    if (readPos_ == readBuf_.size())
+    {
+        readBuf_.clear();
+        readPos_ = 0;
+    }
+    else if (readPos_ > kCompactThreshold && readPos_ > readBuf_.size() / 2)
+    {
+        readBuf_.remove(0, readPos_);
+        readPos_ = 0;
+    }
+}
+
 void Connection::safeDeleteSocket()
 {
     if (localSocket_)
@@ -38,12 +38,17 @@ private slots:
 private:
     QLocalSocket *localSocket_;
 
-    QByteArray writeBuf_;
+    // readBuf_ is consumed from readPos_, the consumed part is dropped only from time to time
     QByteArray readBuf_;
+    int readPos_;
     qint64 bytesWrittingInProgress_;
 
+    static constexpr int kHeaderSize = sizeof(int) * 2;
+    static constexpr int kCompactThreshold = 64 * 1024;
+
     bool canReadCommand();
     Command *readCommand();
+    void compactReadBuf();
 
     void safeDeleteSocket();
 };
@@ -0,0 +1,131 @@
+#include "connection.test.h"
+
+#include <QElapsedTimer>
+#include <QLocalSocket>
+
+#include "clicommands.h"
+
+void TestIpcConnection::initTestCase()
+{
+    const QString name = QString("ws_ipc_test_%1").arg(QCoreApplication::applicationPid());
+    QLocalServer::removeServer(name);
+    QVERIFY(server_.listen(name));
+
+    QLocalSocket *clientSocket = new QLocalSocket;
+    clientSocket->connectToServer(name);
+    QVERIFY(clientSocket->waitForConnected(5000));
+    QVERIFY(server_.waitForNewConnection(5000));
+
+    client_ = new IPC::Connection(clientSocket);
+    serverSide_ = new IPC::Connection(server_.nextPendingConnection());
+    connect(serverSide_, &IPC::Connection::newCommand, this, [this](IPC::Command *cmd, IPC::Connection *) {
+        received_ << cmd;
+    });
+}
+
+void TestIpcConnection::cleanupTestCase()
+{
+    qDeleteAll(received_);
+    delete client_;
+    delete serverSide_;
+    server_.close();
+}
+
+void TestIpcConnection::testRoundTrip()
+{
+    qDeleteAll(received_);
+    received_.clear();
+
+    IPC::CliCommands::Connect connectCmd;
+    connectCmd.location_ = "Toronto";
+    connectCmd.protocol_ = "wireguard";
+    IPC::CliCommands::LocationsList listCmd;
+    listCmd.locations_ = makeLocations(1000, 1);
+    IPC::CliCommands::Disconnect disconnectCmd;
+
+    client_->sendCommand(connectCmd);
+    client_->sendCommand(listCmd);
+    client_->sendCommand(disconnectCmd);
+
+    QTRY_COMPARE_WITH_TIMEOUT(received_.count(), 3, 5000);
+    auto *c = dynamic_cast<IPC::CliCommands::Connect *>(received_[0]);
+    QVERIFY(c != nullptr);
+    QCOMPARE(c->location_, connectCmd.location_);
+    QCOMPARE(c->protocol_, connectCmd.protocol_);
+    auto *l = dynamic_cast<IPC::CliCommands::LocationsList *>(received_[1]);
+    QVERIFY(l != nullptr);
+    QCOMPARE(l->locations_, listCmd.locations_);
+    QVERIFY(dynamic_cast<IPC::CliCommands::Disconnect *>(received_[2]) != nullptr);
+}
+
+// many commands arrive in one read, so most of them are parsed from the middle of the read buffer
+void TestIpcConnection::testManySmallCommands()
+{
+    qDeleteAll(received_);
+    received_.clear();
+
+    const int kCount = 5000;
+    for (int i = 0; i < kCount; ++i)
+    {
+        IPC::CliCommands::Connect cmd;
+        cmd.location_ = QString::number(i);
+        client_->sendCommand(cmd);
+    }
+
+    QTRY_COMPARE_WITH_TIMEOUT(received_.count(), kCount, 30000);
+    for (int i = 0; i < kCount; ++i)
+    {
+        auto *c = dynamic_cast<IPC::CliCommands::Connect *>(received_[i]);
+        QVERIFY(c != nullptr);
+        QCOMPARE(c->location_, QString::number(i));
+    }
+}
+
+void TestIpcConnection::benchmarkLocationsList()
+{
+    qDeleteAll(received_);
+    received_.clear();
+
+    int count = qEnvironmentVariableIntValue("WS_IPC_BENCHMARK_COMMANDS");
+    if (count <= 0)
+    {
+        count = 200;
+    }
+
+    IPC::CliCommands::LocationsList cmd;
+    cmd.locations_ = makeLocations(5000, 2);
+    QByteArray body;
+    {
+        QDataStream ds(&body, QIODevice::WriteOnly);
+        cmd.writeData(ds);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < count; ++i)
+    {
+        client_->sendCommand(cmd);
+    }
+    QTRY_COMPARE_WITH_TIMEOUT(received_.count(), count, 120000);
+    const double seconds = timer.nsecsElapsed() / 1e9;
+
+    auto *l = dynamic_cast<IPC::CliCommands::LocationsList *>(received_.last());
+    QVERIFY(l != nullptr);
+    QCOMPARE(l->locations_, cmd.locations_);
+
+    const double megabytes = (double)body.size() * count / (1024 * 1024);
+    qInfo("%d LocationsList commands of %lld KB: %.3f s, %.0f MB/s", count, (long long)body.size() / 1024, seconds, megabytes / seconds);
+}
+
+QStringList TestIpcConnection::makeLocations(int count, int seed)
+{
+    QStringList locations;
+    locations.reserve(count);
+    for (int i = 0; i < count; ++i)
+    {
+        locations << QString("Location %1 - City %2 (%3)").arg(seed).arg(i).arg(i * 7919 % 1000);
+    }
+    return locations;
+}
+
+QTEST_MAIN(TestIpcConnection)
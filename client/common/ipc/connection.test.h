@@ -0,0 +1,30 @@
+#pragma once
+
+#include <QLocalServer>
+#include <QObject>
+#include <QTest>
+
+#include "connection.h"
+
+// tests of the command framing of IPC::Connection and a benchmark sending big LocationsList commands over a local socket
+// the number of commands for the benchmark can be set with the WS_IPC_BENCHMARK_COMMANDS environment variable (200 by default)
+class TestIpcConnection : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testRoundTrip();
+    void testManySmallCommands();
+    void benchmarkLocationsList();
+
+private:
+    QLocalServer server_;
+    IPC::Connection *client_ = nullptr;
+    IPC::Connection *serverSide_ = nullptr;
+    QList<IPC::Command *> received_;
+
+    static QStringList makeLocations(int count, int seed);
+};
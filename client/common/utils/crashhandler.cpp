@@ -337,6 +337,11 @@ void CrashHandler::handleException(ExceptionInfo info)
     if (info.file)
         CRASH_LOG(" file = %ls@%u", info.file, info.line);
 
+#if !defined(WINDSCRIBE_SERVICE)
+    // the lines logged just before the crash are still queued, and they are the ones needed to debug it
+    Logger::instance().flushOnCrash();
+#endif
+
     CrashDump minidump;
     const std::wstring filename = getCrashDumpFilename();
     if (minidump.writeToFile(GetOutputLocation() + filename, info.exceptionThreadId,
@@ -34,7 +34,10 @@ const QString WS_USE_PQ_ALGORITHMS = WS_PREFIX + "use-post-quantum-algorithms";
 
 const QString WS_STEALTH_EXTRA_TLS_PADDING = WS_PREFIX + "stealth-extra-tls-padding";
 const QString WS_API_EXTRA_TLS_PADDING = WS_PREFIX + "api-extra-tls-padding";
+const QString WS_API_CONNECTION_REUSE = WS_PREFIX + "api-connection-reuse";
+const QString WS_API_FAILOVER_RACING = WS_PREFIX + "api-failover-racing";
 const QString WS_WG_UDP_STUFFING = WS_PREFIX + "wireguard-udp-stuffing";
+const QString WS_CONNECTION_TRACE = WS_PREFIX + "connection-trace";
 
 const QString WS_SERVERLIST_COUNTRY_OVERRIDE = WS_PREFIX + "serverlist-country-override";
 
@@ -276,11 +279,26 @@ bool ExtraConfig::getAPIExtraTLSPadding()
     return getFlagFromExtraConfigLines(WS_API_EXTRA_TLS_PADDING);
 }
 
+bool ExtraConfig::getAPIConnectionReuse()
+{
+    return getFlagFromExtraConfigLines(WS_API_CONNECTION_REUSE);
+}
+
+bool ExtraConfig::getAPIFailoverRacing()
+{
+    return getFlagFromExtraConfigLines(WS_API_FAILOVER_RACING);
+}
+
 bool ExtraConfig::getWireGuardUdpStuffing()
 {
     return getFlagFromExtraConfigLines(WS_WG_UDP_STUFFING);
 }
 
+bool ExtraConfig::getConnectionTrace()
+{
+    return getFlagFromExtraConfigLines(WS_CONNECTION_TRACE);
+}
+
 std::optional<QString> ExtraConfig::serverlistCountryOverride()
 {
     auto value = getValue(WS_SERVERLIST_COUNTRY_OVERRIDE);
@@ -54,9 +54,12 @@ public:
     bool getUsePQAlgorithms();
     bool getStealthExtraTLSPadding();
     bool getAPIExtraTLSPadding();
+    bool getAPIConnectionReuse();
+    bool getAPIFailoverRacing();
 
     bool getWireGuardVerboseLogging();
     bool getWireGuardUdpStuffing();
+    bool getConnectionTrace();
 
     std::optional<QString> serverlistCountryOverride();
     bool serverListIgnoreCountryOverride();
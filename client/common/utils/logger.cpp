@@ -8,15 +8,34 @@
 #include <QStandardPaths>
 #include <QString>
 
+#if defined(Q_OS_WIN)
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
 QFile *Logger::file_ = NULL;
 QMutex Logger::mutex_;
-QString Logger::strLog_;
 QString Logger::logPath_;
 QString Logger::prevLogPath_;
 bool Logger::consoleOutput_;
 QtMessageHandler Logger::prevMessageHandler_ = NULL;
 bool Logger::connectionMode_ = false;
 QLoggingCategory* Logger::connectionModeLoggingCategory_ = nullptr;
+MpscRingBuffer<Logger::LogMessage> *Logger::queue_ = nullptr;
+int Logger::queueCapacity_ = Logger::DEFAULT_QUEUE_CAPACITY;
+std::atomic<quint64> Logger::droppedMessages_ = 0;
+quint64 Logger::reportedDroppedMessages_ = 0;
+std::thread *Logger::writerThread_ = nullptr;
+std::mutex Logger::writerWaitMutex_;
+std::condition_variable Logger::writerCondition_;
+bool Logger::isWriterFinish_ = false;
+std::timed_mutex Logger::writeMutex_;
+std::mutex Logger::memoryLogMutex_;
+std::deque<QString> Logger::memoryLog_;
+int Logger::memoryLogSize_ = 0;
+int Logger::memoryLogMaxSize_ = Logger::DEFAULT_MEMORY_LOG_MAX_SIZE;
+std::atomic<quint64> Logger::evictedMemoryLogLines_ = 0;
 
 #define WS_LOGGING_CATEGORY(name, ...) \
 const QLoggingCategory &name() \
@@ -67,6 +86,18 @@ Q_LOGGING_CATEGORY(LOG_LOCATION_LIST, "loclist");
 Q_LOGGING_CATEGORY(LOG_PREFERENCES, "prefs")
 
 
+void Logger::setQueueCapacity(int messagesCount)
+{
+    Q_ASSERT(queue_ == nullptr);
+    queueCapacity_ = messagesCount;
+}
+
+void Logger::setMemoryLogMaxSize(int charactersCount)
+{
+    std::lock_guard<std::mutex> locker(memoryLogMutex_);
+    memoryLogMaxSize_ = charactersCount;
+}
+
 void Logger::install(const QString &name, bool consoleOutput, bool recoveryMode)
 {
     QLoggingCategory::setFilterRules("qt.tlsbackend.ossl=false\nqt.network.ssl=false");
@@ -91,6 +122,8 @@ void Logger::install(const QString &name, bool consoleOutput, bool recoveryMode)
     file_ = new QFile(logFilePath);
     file_->open(openModeFlag);
     consoleOutput_ = consoleOutput;
+    queue_ = new MpscRingBuffer<LogMessage>(queueCapacity_);
+    writerThread_ = new std::thread(writerThreadFunc);
     prevMessageHandler_ = qInstallMessageHandler(myMessageHandler);
 }
 
@@ -100,11 +133,25 @@ Logger::Logger()
 
 Logger::~Logger()
 {
+    if (writerThread_)
+    {
+        {
+            std::lock_guard<std::mutex> locker(writerWaitMutex_);
+            isWriterFinish_ = true;
+        }
+        writerCondition_.notify_all();
+        writerThread_->join();
+        delete writerThread_;
+        writerThread_ = nullptr;
+    }
+
     QMutexLocker lock(&mutex_);
+    std::lock_guard<std::timed_mutex> writeLocker(writeMutex_);
     if (file_)
     {
         file_->close();
         delete file_;
+        file_ = nullptr;
     }
 
     if (connectionModeLoggingCategory_)
@@ -122,20 +169,16 @@ void Logger::copyToPrevLog()
 
 void Logger::myMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &s)
 {
+    if (queue_)
     {
-        QMutexLocker lock(&mutex_);
+        // the time is formatted in the writer thread
+        LogMessage msg { qFormatLogMessage(type, context, s), QDateTime::currentMSecsSinceEpoch() };
+        if (!queue_->tryPush(std::move(msg)))
+            droppedMessages_++;
 
-        if (file_)
-        {
-            QString str = qFormatLogMessage(type, context, s);
-            QString strDateTime = QDateTime::currentDateTimeUtc().toString("ddMMyy hh:mm:ss:zzz");
-            str.replace("{gmt_time}", strDateTime);
-
-            file_->write(str.toLocal8Bit());
-            file_->write("\r\n");
-            file_->flush();
-            strLog_ += str + "\n";
-        }
+        // the process is going to abort, write everything we have
+        if (type == QtFatalMsg)
+            instance().flush();
     }
     if (consoleOutput_)
     {
@@ -143,8 +186,117 @@ void Logger::myMessageHandler(QtMsgType type, const QMessageLogContext &context,
     }
 }
 
+void Logger::writerThreadFunc()
+{
+    qint64 lastSyncTime = QDateTime::currentMSecsSinceEpoch();
+    for (;;)
+    {
+        bool isFinish;
+        {
+            std::unique_lock<std::mutex> locker(writerWaitMutex_);
+            writerCondition_.wait_for(locker, std::chrono::milliseconds(WRITE_INTERVAL_MS), [] { return isWriterFinish_; });
+            isFinish = isWriterFinish_;
+        }
+
+        qint64 now = QDateTime::currentMSecsSinceEpoch();
+        bool isSync = isFinish || (now - lastSyncTime) >= SYNC_INTERVAL_MS;
+        writeQueued(isSync);
+        if (isSync)
+            lastSyncTime = now;
+        if (isFinish)
+            break;
+    }
+}
+
+void Logger::writeQueued(bool isSync)
+{
+    std::lock_guard<std::timed_mutex> locker(writeMutex_);
+    writeQueuedLocked(isSync);
+}
+
+void Logger::writeQueuedLocked(bool isSync)
+{
+    if (!queue_ || !file_)
+        return;
+
+    QByteArray batch;
+    LogMessage msg;
+    while (queue_->tryPop(msg))
+    {
+        QString strDateTime = QDateTime::fromMSecsSinceEpoch(msg.timeMs, Qt::UTC).toString("ddMMyy hh:mm:ss:zzz");
+        msg.str.replace("{gmt_time}", strDateTime);
+        batch += msg.str.toLocal8Bit();
+        batch += "\r\n";
+        appendToMemoryLog(msg.str);
+    }
+
+    quint64 dropped = droppedMessages_;
+    if (dropped != reportedDroppedMessages_)
+    {
+        QString str = QString("Logger: %1 messages dropped because the queue was full (%2 in total)").arg(dropped - reportedDroppedMessages_).arg(dropped);
+        batch += str.toLocal8Bit();
+        batch += "\r\n";
+        appendToMemoryLog(str);
+        reportedDroppedMessages_ = dropped;
+    }
+
+    if (!batch.isEmpty())
+    {
+        file_->write(batch);
+        file_->flush();
+    }
+    if (isSync)
+    {
+#if defined(Q_OS_WIN)
+        _commit(file_->handle());
+#else
+        fsync(file_->handle());
+#endif
+    }
+}
+
+void Logger::flush()
+{
+    writeQueued(true);
+}
+
+void Logger::flushOnCrash()
+{
+    std::unique_lock<std::timed_mutex> locker(writeMutex_, std::chrono::milliseconds(CRASH_FLUSH_TIMEOUT_MS));
+    if (locker.owns_lock())
+        writeQueuedLocked(true);
+}
+
+void Logger::appendToMemoryLog(const QString &str)
+{
+    std::lock_guard<std::mutex> locker(memoryLogMutex_);
+    memoryLog_.push_back(str);
+    memoryLogSize_ += str.size() + 1;
+    while (memoryLogSize_ > memoryLogMaxSize_ && memoryLog_.size() > 1)
+    {
+        memoryLogSize_ -= memoryLog_.front().size() + 1;
+        memoryLog_.pop_front();
+        evictedMemoryLogLines_++;
+    }
+}
+
+QString Logger::memoryLogStr()
+{
+    std::lock_guard<std::mutex> locker(memoryLogMutex_);
+    QString ret;
+    ret.reserve(memoryLogSize_);
+    for (const auto &line : memoryLog_)
+    {
+        ret += line;
+        ret += "\n";
+    }
+    return ret;
+}
+
 QString Logger::getLogStr()
 {
+    // make the queued lines visible in the memory log
+    flush();
     QMutexLocker lock(&mutex_);
     QString ret;
     QFile prevFileLog(prevLogPath_);
@@ -154,14 +306,14 @@ QString Logger::getLogStr()
         ret += "----------------------------------------------------------------\n";
         prevFileLog.close();
     }
-    ret += strLog_;
+    ret += memoryLogStr();
     return ret;
 }
 
 QString Logger::getCurrentLogStr()
 {
-    QMutexLocker lock(&mutex_);
-    return strLog_;
+    flush();
+    return memoryLogStr();
 }
 
 void Logger::startConnectionMode()
@@ -3,9 +3,15 @@
 #include <QFile>
 #include <QMutex>
 #include <QLoggingCategory>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 #include "clean_sensitive_info.h"
 #include "multiline_message_logger.h"
+#include "mpscringbuffer.h"
 
 // log categories
 Q_DECLARE_LOGGING_CATEGORY(LOG_BASIC)
@@ -45,6 +51,9 @@ Q_DECLARE_LOGGING_CATEGORY(LOG_LOCATION_LIST)
 Q_DECLARE_LOGGING_CATEGORY(LOG_PREFERENCES)
 
 
+// Log lines are put into a lock-free bounded queue by the calling threads and written to the file in batches by a background thread.
+// The file is fsync'ed every SYNC_INTERVAL_MS, on qFatal, on a crash (Windows, see CrashHandler) and on exit. If the queue is full, the line is dropped and counted.
+// The in-memory copy of the log (getCurrentLogStr) is a ring that keeps only the last memoryLogMaxSize characters.
 class Logger
 {
 public:
@@ -54,11 +63,24 @@ public:
         return l;
     }
 
+    // must be called before install()
+    void setQueueCapacity(int messagesCount);
+    void setMemoryLogMaxSize(int charactersCount);
+
     void install(const QString &name, bool consoleOutput, bool recoveryMode);
     void setConsoleOutput(bool on);
     QString getLogStr();
     QString getCurrentLogStr();
 
+    // writes all queued lines to the file and syncs it to disk, can be called from any thread
+    void flush();
+    // flush() for the crash handler, which gives up if the writer stays busy: the crash may be in the writer itself
+    void flushOnCrash();
+
+    // overflow counters
+    quint64 droppedMessagesCount() const { return droppedMessages_; }
+    quint64 evictedMemoryLogLinesCount() const { return evictedMemoryLogLines_; }
+
     void startConnectionMode();
     void endConnectionMode();
     static bool connectionMode() { return connectionMode_; }
@@ -72,11 +94,22 @@ private:
     static void myMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &s);
 
 private:
+    static constexpr int DEFAULT_QUEUE_CAPACITY = 8192;
+    static constexpr int DEFAULT_MEMORY_LOG_MAX_SIZE = 2 * 1024 * 1024;
+    static constexpr int WRITE_INTERVAL_MS = 100;
+    static constexpr int SYNC_INTERVAL_MS = 2000;
+    static constexpr int CRASH_FLUSH_TIMEOUT_MS = 1000;
+
+    struct LogMessage
+    {
+        QString str;
+        qint64 timeMs;
+    };
+
     static QtMessageHandler prevMessageHandler_;
 
     static QFile *file_;
     static QMutex mutex_;
-    static QString strLog_;
     static QString logPath_;
     static QString prevLogPath_;
     static bool consoleOutput_;
@@ -87,5 +120,31 @@ private:
     static bool connectionMode_;
     static QLoggingCategory *connectionModeLoggingCategory_;
 
+    static MpscRingBuffer<LogMessage> *queue_;
+    static int queueCapacity_;
+    static std::atomic<quint64> droppedMessages_;
+    static quint64 reportedDroppedMessages_;
+
+    // the writer thread
+    static std::thread *writerThread_;
+    static std::mutex writerWaitMutex_;
+    static std::condition_variable writerCondition_;
+    static bool isWriterFinish_;
+    // serializes the queue consumers: the writer thread and flush()
+    static std::timed_mutex writeMutex_;
+
+    // in-memory ring of the last lines
+    static std::mutex memoryLogMutex_;
+    static std::deque<QString> memoryLog_;
+    static int memoryLogSize_;
+    static int memoryLogMaxSize_;
+    static std::atomic<quint64> evictedMemoryLogLines_;
+
     static void copyToPrevLog();
+    static void writerThreadFunc();
+    static void writeQueued(bool isSync);
+    // writeMutex_ must be locked
+    static void writeQueuedLocked(bool isSync);
+    static void appendToMemoryLog(const QString &str);
+    static QString memoryLogStr();
 };
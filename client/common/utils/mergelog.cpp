@@ -1,49 +1,163 @@
 #include "mergelog.h"
 
 #include <QCoreApplication>
+#include <QDate>
 #include <QFile>
-#include <QFileInfo>
 #include <QStandardPaths>
-#include <QTextStream>
 
-#include <future>
+#include <cstring>
+#include <memory>
+#include <queue>
+#include <vector>
 
 namespace
 {
-bool isYearInDatePresent(const std::string &dateline)
+
+constexpr qint64 kMsecsPerDay = 86400000;
+
+// days since 1970-01-01 for a date of the proleptic Gregorian calendar (H. Hinnant's days_from_civil)
+qint64 daysFromCivil(int y, int m, int d)
+{
+    y -= m <= 2;
+    const qint64 era = (y >= 0 ? y : y - 399) / 400;
+    const int yoe = y - era * 400;
+    const int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+inline bool parseDigits(const char *p, int count, int &out)
 {
-    const int scan = qMin(6, (int)dateline.size());
-    for (int i = 0; i < scan; ++i)
-        if (dateline[i] == ' ')
+    out = 0;
+    for (int i = 0; i < count; ++i) {
+        if (p[i] < '0' || p[i] > '9')
             return false;
+        out = out * 10 + (p[i] - '0');
+    }
     return true;
 }
 
-// parse date from string "ddMMyy hh:mm:ss:zzz"
-QDateTime parseDateTimeFormat1(const std::string &datestr)
+// parse "hh:mm:ss:zzz" to msecs since the start of the day
+inline bool parseTime(const char *p, qint64 &out)
 {
-    int dd,MM,yy;
     int hh, mm, ss, zzz;
-    if (sscanf(datestr.c_str(),"%02d%02d%02d %02d:%02d:%02d:%03d", &dd, &MM, &yy, &hh, &mm, &ss, &zzz) == 7)
-    {
-        return QDateTime(QDate(yy + 1900, MM, dd), QTime(hh, mm, ss, zzz));
+    if (!parseDigits(p, 2, hh) || p[2] != ':' || !parseDigits(p + 3, 2, mm) || p[5] != ':' ||
+        !parseDigits(p + 6, 2, ss) || p[8] != ':' || !parseDigits(p + 9, 3, zzz))
+        return false;
+    if (hh > 23 || mm > 59 || ss > 59)
+        return false;
+    out = ((hh * 60 + mm) * 60 + ss) * 1000 + zzz;
+    return true;
+}
+
+// Parses the timestamp of a log line "[ddMMyy hh:mm:ss:zzz ..." or "[ddMM hh:mm:ss:zzz ...".
+// Returns msecs of the local (wall clock) time, only suitable for comparing the lines with each other.
+// The line must be at least 20 characters long.
+bool parseTimestamp(const char *line, int currentYear, qint64 &out)
+{
+    const char *p = line + 1;
+    // the format with a year does not contain spaces in the first 6 characters
+    const bool isYearPresent = std::memchr(p, ' ', 6) == nullptr;
+
+    int dd, MM, yy;
+    if (!parseDigits(p, 2, dd) || !parseDigits(p + 2, 2, MM))
+        return false;
+    if (isYearPresent) {
+        if (!parseDigits(p + 4, 2, yy) || p[6] != ' ')
+            return false;
+        yy += 2000;
+        p += 7;
+    } else {
+        if (p[4] != ' ')
+            return false;
+        yy = currentYear;
+        p += 5;
     }
+    if (MM < 1 || MM > 12 || dd < 1 || dd > 31)
+        return false;
 
-    return QDateTime();
+    qint64 msecs;
+    if (!parseTime(p, msecs))
+        return false;
+    out = daysFromCivil(yy, MM, dd) * kMsecsPerDay + msecs;
+    return true;
 }
 
-// parse date from string "ddMM hh:mm:ss:zzz"
-QDateTime parseDateTimeFormat2(const std::string &datestr)
+struct LineRef
 {
-    int dd,MM;
-    int hh, mm, ss, zzz;
-    if (sscanf(datestr.c_str(),"%02d%02d %02d:%02d:%02d:%03d", &dd, &MM, &hh, &mm, &ss, &zzz) == 6)
+    const char *data;
+    int len;
+    int source;
+};
+
+// Reads the log lines with a timestamp from a memory-mapped file
+class LogFileReader
+{
+public:
+    LogFileReader(const QString &filename, qint64 maxTailSize, int source, int fileIndex) : file_(filename), source_(source), fileIndex_(fileIndex)
     {
-        return QDateTime(QDate(1900, MM, dd), QTime(hh, mm, ss, zzz));
+        if (filename.isEmpty() || !file_.open(QIODevice::ReadOnly))
+            return;
+        const qint64 size = file_.size();
+        const qint64 offset = size > maxTailSize ? size - maxTailSize : 0;
+        if (size - offset <= 0)
+            return;
+        uchar *data = file_.map(offset, size - offset);
+        if (!data)
+            return;
+        cur_ = reinterpret_cast<const char *>(data);
+        end_ = cur_ + (size - offset);
+        // skip the partial first line
+        if (offset > 0) {
+            const char *nl = static_cast<const char *>(std::memchr(cur_, '\n', end_ - cur_));
+            cur_ = nl ? nl + 1 : end_;
+        }
     }
 
-    return QDateTime();
-}
+    int source() const { return source_; }
+    int fileIndex() const { return fileIndex_; }
+
+    // moves to the next line starting with a timestamp, returns false at the end of the file
+    bool next(int currentYear, LineRef &line, qint64 &timestamp)
+    {
+        while (cur_ < end_) {
+            const char *nl = static_cast<const char *>(std::memchr(cur_, '\n', end_ - cur_));
+            const char *lineEnd = nl ? nl : end_;
+            const char *lineBegin = cur_;
+            cur_ = nl ? nl + 1 : end_;
+
+            int len = (int)(lineEnd - lineBegin);
+            if (len > 0 && lineBegin[len - 1] == '\r')
+                len--;
+            if (len < 20 || lineBegin[0] != '[')
+                continue;
+
+            // the lines with an unparsable timestamp go first, as before
+            if (!parseTimestamp(lineBegin, currentYear, timestamp))
+                timestamp = 0;
+            line = LineRef { lineBegin, len, source_ };
+            return true;
+        }
+        return false;
+    }
+
+private:
+    QFile file_;
+    const char *cur_ = nullptr;
+    const char *end_ = nullptr;
+    int source_;
+    int fileIndex_;
+};
+
+struct MergeCursor
+{
+    LogFileReader *reader;
+    LineRef line;
+    qint64 timestamp;
+    bool useMinMax;
+    qint64 min;
+    qint64 max;
+};
 
 }  // namespace
 
@@ -69,72 +183,6 @@ QString MergeLog::mergePrevLogs(bool doMergePerLine)
                  wgPrevServiceLogFilename, installerPrevLogFilename, doMergePerLine);
 }
 
-int MergeLog::mergeTask(QMutex *mutex, QMultiMap<quint64, QPair<LineSource, QString>> *lines, const QString *filename, LineSource source, bool useMinMax, QDateTime min, QDateTime max)
-{
-    int datasize = 0;
-    const int kCurrentYearOffset = QDateTime::currentDateTime().date().year() - 1900;
-    QDateTime prevDateTime;
-
-    QFile file(*filename);
-    if (!file.open(QIODevice::ReadOnly)) {
-        return 0;
-    }
-
-    int timestamp = 0;
-    QTextStream textStream(&file);
-    // If file is larger than 10MiB, just take the last 10MiB
-    int64_t filelen = file.size();
-    if (filelen > 10000000) {
-        file.seek(filelen - 10000000);
-    }
-
-    while (!textStream.atEnd())
-    {
-        QString line = textStream.readLine();
-
-        if (line[0] != '[' || line.length() < 20)
-            continue;
-
-        const auto datestr = line.sliced(1, 19).toStdString();
-        const auto datetime = isYearInDatePresent(datestr)
-                                  ? parseDateTimeFormat1(datestr)
-                                        .addYears(100)
-                                  : parseDateTimeFormat2(datestr)
-                                        .addYears(kCurrentYearOffset);
-
-        if (useMinMax && (datetime < min || datetime > max))
-            continue;
-
-        // Installer on Mac can have inconsistency in times because of native mac api.
-        // In the example below we have the same timestamp but different time since start.
-        // [110124 20:16:15:449      0.002] CPU architecture: arm64)
-        // [110124 20:16:15:449      0.003] MacOS version: Version 14.1 (Build 23B74)
-        // It is necessary to calculate time there to increase timestamp var by 1 for each line.
-        // It is acceptable as times of installer do not intersect other times.
-        if (prevDateTime != datetime && source != LineSource::INSTALLER) {
-            prevDateTime = datetime;
-            timestamp = 0;
-        }
-
-        // In QMultiMap, elements with the same key will be placed in a reverse order.
-        // https://doc.qt.io/qt-5/qmap-iterator.html#details
-        // To deal with the issue, we create a compound key: 44 bits for a timestamp, 2 bits
-        // for the source, and 18 additional lower bits for a "timestamp" (line serial
-        // number). We assume the maximum number of lines with unique timestamp never
-        // exceeds 262143, which is quite reasonable (it looks infeasible to output 250k+
-        // lines to a log file within 1 ms).
-        const auto key = (static_cast<quint64>(datetime.toMSecsSinceEpoch()) << 20)
-                       | (static_cast<quint64>(source) << 18) | qMin(timestamp++, 0x3ffff);
-
-        {
-            QMutexLocker locker(mutex);
-            lines->insert(key, qMakePair(source, line));
-        }
-        datasize += line.length() + 3;
-    }
-    return datasize;
-}
-
 const QString MergeLog::guiLogLocation()
 {
     QString path = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
@@ -228,42 +276,103 @@ QString MergeLog::merge(const QString &guiLogFilename, const QString &serviceLog
                         const QString &servicePrevLogFilename, const QString &wireguardServiceLogFilename,
                         const QString &installerLogFilename, bool doMergePerLine)
 {
-    QMutex mutex;
-    QMultiMap<quint64, QPair<LineSource, QString>> lines;
-    int estimatedLogSize = 0;
-
-    auto futureGuiLog = std::async(MergeLog::mergeTask, &mutex, &lines, &guiLogFilename, LineSource::GUI, false, QDateTime(), QDateTime());
-    estimatedLogSize += futureGuiLog.get();
-
-    QDateTime minDate, maxDate;
+    const int currentYear = QDate::currentDate().year();
+
+    // the files stay mapped until the result is built
+    std::vector<std::unique_ptr<LogFileReader>> readers;
+    readers.push_back(std::make_unique<LogFileReader>(guiLogFilename, MAX_FILE_TAIL_SIZE, (int)LineSource::GUI, 0));
+    readers.push_back(std::make_unique<LogFileReader>(serviceLogFilename, MAX_FILE_TAIL_SIZE, (int)LineSource::SERVICE, 1));
+    readers.push_back(std::make_unique<LogFileReader>(servicePrevLogFilename, MAX_FILE_TAIL_SIZE, (int)LineSource::SERVICE, 2));
+    readers.push_back(std::make_unique<LogFileReader>(wireguardServiceLogFilename, MAX_FILE_TAIL_SIZE, (int)LineSource::WIREGUARD_SERVICE, 3));
+    if (!installerLogFilename.isEmpty())
+        readers.push_back(std::make_unique<LogFileReader>(installerLogFilename, MAX_FILE_TAIL_SIZE, (int)LineSource::INSTALLER, 4));
+
+    // the lines of the other logs are taken only within the time range of the GUI log
+    qint64 minDate = 0, maxDate = 0;
     bool isUseMinMaxDate = false;
-    if (lines.count() > 1)
     {
-        minDate = QDateTime::fromMSecsSinceEpoch(lines.firstKey() >> 20); // Strip source and timestamp.
-        maxDate = QDateTime::fromMSecsSinceEpoch(lines.lastKey() >> 20);
-        isUseMinMaxDate = true;
+        LogFileReader guiScan(guiLogFilename, MAX_FILE_TAIL_SIZE, (int)LineSource::GUI, 0);
+        LineRef line;
+        qint64 timestamp;
+        int count = 0;
+        while (guiScan.next(currentYear, line, timestamp)) {
+            if (count == 0 || timestamp < minDate) minDate = timestamp;
+            if (count == 0 || timestamp > maxDate) maxDate = timestamp;
+            count++;
+        }
+        isUseMinMaxDate = count > 1;
     }
 
-    auto futureService = std::async(MergeLog::mergeTask, &mutex, &lines, &serviceLogFilename, LineSource::SERVICE, isUseMinMaxDate, minDate, maxDate);
-    auto futureServicePrev = std::async(MergeLog::mergeTask, &mutex, &lines, &servicePrevLogFilename, LineSource::SERVICE, isUseMinMaxDate, minDate, maxDate);
-    estimatedLogSize += futureService.get() + futureServicePrev.get();
+    auto cursorGreater = [](const MergeCursor &l, const MergeCursor &r) {
+        if (l.timestamp != r.timestamp) return l.timestamp > r.timestamp;
+        if (l.line.source != r.line.source) return l.line.source > r.line.source;
+        return l.reader->fileIndex() > r.reader->fileIndex();
+    };
+    std::priority_queue<MergeCursor, std::vector<MergeCursor>, decltype(cursorGreater)> heap(cursorGreater);
 
-    auto futureWGService = std::async(MergeLog::mergeTask, &mutex, &lines, &wireguardServiceLogFilename, LineSource::WIREGUARD_SERVICE, isUseMinMaxDate, minDate, maxDate);
-    estimatedLogSize += futureWGService.get();
+    auto advance = [currentYear](MergeCursor &cursor) {
+        while (cursor.reader->next(currentYear, cursor.line, cursor.timestamp)) {
+            if (!cursor.useMinMax || (cursor.timestamp >= cursor.min && cursor.timestamp <= cursor.max))
+                return true;
+        }
+        return false;
+    };
 
-    if (!installerLogFilename.isEmpty()) {
-        const auto installerMinDate = minDate.addDays(-7);
-        auto futureInstaller = std::async(MergeLog::mergeTask, &mutex, &lines, &installerLogFilename, LineSource::INSTALLER, isUseMinMaxDate, installerMinDate, maxDate);
-        estimatedLogSize += futureInstaller.get();
+    for (auto &reader : readers) {
+        MergeCursor cursor { reader.get(), LineRef(), 0, false, minDate, maxDate };
+        if (reader->source() != (int)LineSource::GUI)
+            cursor.useMinMax = isUseMinMaxDate;
+        if (reader->source() == (int)LineSource::INSTALLER)
+            cursor.min = minDate - 7 * kMsecsPerDay;
+        if (advance(cursor))
+            heap.push(cursor);
     }
 
+    // cut out the part of the log if the count of lines exceeds MAX_COUNT_OF_LINES (keep 10% begin and 90% end of log)
+    const int headCount = MAX_COUNT_OF_LINES / 10;
+    const int tailCount = MAX_COUNT_OF_LINES - headCount;
+    std::vector<LineRef> head;
+    head.reserve(headCount);
+    std::vector<LineRef> tail(tailCount);   // ring
+    qint64 tailPos = 0;
+    qint64 totalCount = 0;
+    int sourceCount[static_cast<int>(LineSource::INSTALLER) + 1] = {};
+
+    while (!heap.empty()) {
+        MergeCursor cursor = heap.top();
+        heap.pop();
+
+        if ((int)head.size() < headCount)
+            head.push_back(cursor.line);
+        else
+            tail[tailPos++ % tailCount] = cursor.line;
+        totalCount++;
+        sourceCount[cursor.line.source]++;
+
+        if (advance(cursor))
+            heap.push(cursor);
+    }
+
+    // the kept lines in order
+    const qint64 keptTailCount = qMin<qint64>(tailPos, tailCount);
+    auto keptLine = [&](qint64 ind) -> const LineRef & {
+        if (ind < (qint64)head.size())
+            return head[ind];
+        ind -= head.size();
+        return tail[(tailPos - keptTailCount + ind) % tailCount];
+    };
+    const qint64 keptCount = (qint64)head.size() + keptTailCount;
+
+    qint64 estimatedLogSize = 0;
+    for (qint64 i = 0; i < keptCount; ++i)
+        estimatedLogSize += keptLine(i).len + 3;
     if (!doMergePerLine)
-        estimatedLogSize += 400;  // Account for log separation lines.
+        estimatedLogSize += 800;  // Account for log separation lines.
 
-    QString result;
+    QByteArray result;
     result.reserve(estimatedLogSize);
-    auto logAppendFun = [&result](const QPair<LineSource, QString> &data) {
-        switch (data.first) {
+    auto logAppendFun = [&result](const LineRef &line) {
+        switch (static_cast<LineSource>(line.source)) {
         case LineSource::GUI:
             result.append("G ");
             break;
@@ -280,62 +389,29 @@ QString MergeLog::merge(const QString &guiLogFilename, const QString &serviceLog
             break;
         }
 
-        result.append(data.second);
-        result.append("\n");
+        result.append(line.data, line.len);
+        result.append('\n');
     };
 
-    // cut out the part of the log if the count of lines  exceeds MAX_COUNT_OF_LINES (keep 10% begin and 90% end of log)
-    int cutCount = 0;
-    int cutBeginInd = 0;
-    int cutEndInd = lines.count();
-    if (lines.count() > MAX_COUNT_OF_LINES)
-    {
-        cutCount = lines.count() - MAX_COUNT_OF_LINES;
-        cutBeginInd = MAX_COUNT_OF_LINES / 10;
-        cutEndInd = lines.count() - MAX_COUNT_OF_LINES * 0.9;
-    }
-
     if (doMergePerLine) {
-        int ind = 0;
-        for (auto it = lines.constBegin(); it != lines.constEnd(); ++it)
-        {
-            // cut out middle
-            if (cutCount == 0 || ind < cutBeginInd || ind > cutEndInd)
-            {
-                logAppendFun(it.value());
-            }
-            ind++;
-        }
+        for (qint64 i = 0; i < keptCount; ++i)
+            logAppendFun(keptLine(i));
     } else {
         const char *separators[] = { nullptr, "Engine", "Service" };
         for (int i = 0; i < static_cast<int>(LineSource::NUM_LINE_SOURCES); ++i) {
-            const auto current_source = static_cast<LineSource>(i);
-            bool is_first_line = true;
-            int ind = 0;
-            for (auto it = lines.constBegin(); it != lines.constEnd(); ++it) {
-                if (it.value().first != current_source)
-                {
-                    ind++;
-                    continue;
-                }
-                if (is_first_line) {
-                    is_first_line = false;
-                    if (separators[i]) {
-                        result.append("---");
-                        result.append(separators[i]);
-                        result.append(QString().fill('-',189));
-                        result.append("\n");
-                    }
-                }
-                // cut out middle
-                if (cutCount == 0 || ind < cutBeginInd || ind > cutEndInd)
-                {
-                    logAppendFun(it.value());
-                }
-                ind++;
+            if (sourceCount[i] == 0)
+                continue;
+            if (separators[i]) {
+                result.append("---");
+                result.append(separators[i]);
+                result.append(QByteArray(189, '-'));
+                result.append('\n');
+            }
+            for (qint64 ind = 0; ind < keptCount; ++ind) {
+                if (keptLine(ind).source == i)
+                    logAppendFun(keptLine(ind));
             }
         }
     }
-    return result;
+    return QString::fromUtf8(result);
 }
-
@@ -1,24 +1,26 @@
 #pragma once
 
-#include <QDateTime>
-#include <QMutex>
 #include <QString>
 
 // merge logs files log_gui.txt, windscribeservice.log, and WireguardServiceLog.txt (Windows only) to one,
 // cutting out the middle of the log if the count of lines exceeds MAX_COUNT_OF_LINES
+// The files are memory-mapped and merged by timestamp as sorted streams (k-way merge), only the kept lines are referenced in memory.
 class MergeLog
 {
+    friend class TestMergeLog;
+
 public:
     static QString mergeLogs(bool doMergePerLine);
     static QString mergePrevLogs(bool doMergePerLine);
 
 private:
     static constexpr int MAX_COUNT_OF_LINES = 100000;
+    // if a file is larger, only its last part is taken
+    static constexpr qint64 MAX_FILE_TAIL_SIZE = 10000000;
     static QString merge(const QString &guiLogFilename, const QString &serviceLogFilename, const QString &servicePrevLogFilename,
                          const QString &wireguardServiceLogFilename, const QString &installerLogFilename, bool doMergePerLine);
 
     enum class LineSource { GUI, SERVICE, WIREGUARD_SERVICE, NUM_LINE_SOURCES, INSTALLER };
-    static int mergeTask(QMutex *mutex, QMultiMap<quint64, QPair<LineSource, QString>> *lines, const QString *filename, LineSource source, bool useMinMax, QDateTime min, QDateTime max);
 
     static const QString guiLogLocation();
     static const QString serviceLogLocation();
@@ -0,0 +1,105 @@
+#include <QtTest>
+#include "mergelog.test.h"
+#include "mergelog.h"
+
+bool TestMergeLog::generateLog(const QString &filename, int startMs, int stepMs, qint64 linesCount, qint64 sizeBytes)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    const QByteArray message = " Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore\r\n";
+    QByteArray buf;
+    qint64 written = 0;
+    qint64 ms = startMs;
+    for (qint64 i = 0; i < linesCount && written < sizeBytes; ++i) {
+        const qint64 dayMs = ms % 86400000;
+        const QByteArray line = QByteArray("[150324 ") +
+                                QByteArray::number(dayMs / 3600000).rightJustified(2, '0') + ":" +
+                                QByteArray::number(dayMs / 60000 % 60).rightJustified(2, '0') + ":" +
+                                QByteArray::number(dayMs / 1000 % 60).rightJustified(2, '0') + ":" +
+                                QByteArray::number(dayMs % 1000).rightJustified(3, '0') + "      0.001]" + message;
+        buf += line;
+        written += line.size();
+        // the timestamps are capped within the day to keep the lines sorted
+        if (ms + stepMs < 86400000)
+            ms += stepMs;
+        if (buf.size() > 4 * 1024 * 1024) {
+            file.write(buf);
+            buf.clear();
+        }
+    }
+    file.write(buf);
+    return true;
+}
+
+void TestMergeLog::initTestCase()
+{
+    QVERIFY(dir_.isValid());
+}
+
+void TestMergeLog::testOrderAndCut()
+{
+    const QString gui = dir_.filePath("order_gui.txt");
+    const QString service = dir_.filePath("order_service.txt");
+    QVERIFY(generateLog(gui, 0, 100, 60000, LLONG_MAX));
+    QVERIFY(generateLog(service, 50, 100, 60000, LLONG_MAX));
+
+    const QString log = MergeLog::merge(gui, service, dir_.filePath("none1.txt"), dir_.filePath("none2.txt"), QString(), true);
+    const QStringList lines = log.split('\n', Qt::SkipEmptyParts);
+    QCOMPARE(lines.size(), MergeLog::MAX_COUNT_OF_LINES);
+
+    // the first lines of the log are kept, then the end of the log after the cut
+    QVERIFY(lines.first().startsWith("G [150324 00:00:00:000"));
+    QVERIFY(lines[1].startsWith("S [150324 00:00:00:050"));
+    // the last service line is beyond the GUI time range
+    QVERIFY(lines.last().startsWith("G [150324 01:39:59:900"));
+
+    QString prevTime;
+    for (const auto &line : lines) {
+        const QString time = line.mid(10, 12);
+        QVERIFY(prevTime <= time);
+        prevTime = time;
+    }
+}
+
+void TestMergeLog::testSeparateSources()
+{
+    const QString gui = dir_.filePath("sep_gui.txt");
+    const QString service = dir_.filePath("sep_service.txt");
+    QVERIFY(generateLog(gui, 1000, 10, 100, LLONG_MAX));
+    QVERIFY(generateLog(service, 1005, 10, 100, LLONG_MAX));
+
+    const QString log = MergeLog::merge(gui, service, dir_.filePath("none1.txt"), dir_.filePath("none2.txt"), QString(), false);
+    const QStringList lines = log.split('\n', Qt::SkipEmptyParts);
+    // 100 GUI lines (1000..1990 ms), the separator of the service lines (labelled "Engine") and 99 service lines:
+    // the last service line (1995 ms) is beyond the GUI time range and dropped
+    QCOMPARE(lines.size(), 200);
+    QVERIFY(lines[0].startsWith("G "));
+    QVERIFY(lines[100].startsWith("---Engine"));
+    QVERIFY(lines[101].startsWith("S "));
+    QVERIFY(lines[199].startsWith("S "));
+}
+
+void TestMergeLog::benchmarkMerge()
+{
+    // the merge reads only the tail of each file, anything before it would only slow down the generation
+    const qint64 fileSize = MergeLog::MAX_FILE_TAIL_SIZE;
+
+    const QString gui = dir_.filePath("bench_gui.txt");
+    const QString service = dir_.filePath("bench_service.txt");
+    const QString servicePrev = dir_.filePath("bench_service_prev.txt");
+    const QString wireguard = dir_.filePath("bench_wireguard.txt");
+    QVERIFY(generateLog(gui, 0, 1, LLONG_MAX, fileSize));
+    QVERIFY(generateLog(service, 0, 2, LLONG_MAX, fileSize));
+    QVERIFY(generateLog(servicePrev, 0, 3, LLONG_MAX, fileSize));
+    QVERIFY(generateLog(wireguard, 0, 5, LLONG_MAX, fileSize));
+
+    QString log;
+    QBENCHMARK {
+        log = MergeLog::merge(gui, service, servicePrev, wireguard, QString(), true);
+    }
+    QVERIFY(!log.isEmpty());
+}
+
+QTEST_MAIN(TestMergeLog)
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+// tests and benchmark for MergeLog
+// the synthetic logs for the benchmark are of the size of the tail which the merge reads from each file
+class TestMergeLog : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void testOrderAndCut();
+    void testSeparateSources();
+    void benchmarkMerge();
+
+private:
+    QTemporaryDir dir_;
+
+    // writes lines with timestamps from startMs (msecs of the day) with the step stepMs until the file reaches sizeBytes or linesCount lines
+    static bool generateLog(const QString &filename, int startMs, int stepMs, qint64 linesCount, qint64 sizeBytes);
+};
@@ -5,12 +5,16 @@
 #include <QDateTime>
 #include <QUdpSocket>
 #include <QRandomGenerator>
+#include <QSaveFile>
 
 #include "isleepevents.h"
+#include "connectiontracer.h"
 #include "openvpnconnection.h"
 #include "engine/crossplatformobjectfactory.h"
 #include "testvpntunnel.h"
 #include "engine/wireguardconfig/getwireguardconfig.h"
+#include "engine/wireguardconfig/wireguardconfigprefetcher.h"
+#include "engine/locationsmodel/mutablelocationinfo.h"
 
 #include "utils/ws_assert.h"
 #include "utils/utils.h"
@@ -84,6 +88,8 @@ ConnectionManager::ConnectionManager(QObject *parent, IHelper *helper, INetworkD
     testVPNTunnel_ = new TestVPNTunnel(this);
     connect(testVPNTunnel_, &TestVPNTunnel::testsFinished, this, &ConnectionManager::onTunnelTestsFinished);
 
+    wireGuardConfigPrefetcher_ = new WireGuardConfigPrefetcher(this);
+
     makeOVPNFile_ = new MakeOVPNFile();
     makeOVPNFileFromCustom_ = new MakeOVPNFileFromCustom();
 
@@ -114,6 +120,7 @@ ConnectionManager::~ConnectionManager()
     SAFE_DELETE(makeOVPNFileFromCustom_);
     SAFE_DELETE(sleepEvents_);
     SAFE_DELETE(getWireGuardConfig_);
+    SAFE_DELETE(wireGuardConfigPrefetcher_);
 }
 
 QString ConnectionManager::udpStuffingWithNtp(const QString &ip, const quint16 port)
@@ -166,6 +173,18 @@ void ConnectionManager::clickConnect(const QString &ovpnConfig,
     isAntiCensorship_ = isAntiCensorship;
     bli_ = bli;
 
+    // the config requests of the connection must not race with the background ones, they share the stored key-pair
+    wireGuardConfigPrefetcher_->stop();
+    // the node is chosen randomly, prefer the one whose config has already been fetched
+    QSharedPointer<locationsmodel::MutableLocationInfo> mli = qSharedPointerDynamicCast<locationsmodel::MutableLocationInfo>(bli);
+    if (mli) {
+        const QStringList hostnames = wireGuardConfigPrefetcher_->cachedHostnames();
+        for (const auto &hostname : hostnames) {
+            if (mli->selectNodeByHostname(hostname))
+                break;
+        }
+    }
+
     bWasSuccessfullyConnectionAttempt_ = false;
 
     usernameForCustomOvpn_.clear();
@@ -184,7 +203,8 @@ void ConnectionManager::clickConnect(const QString &ovpnConfig,
     updateConnectionSettingsPolicy(connectionSettings, portMap, proxySettings);
 
     connSettingsPolicy_->debugLocationInfoToLog();
-    doConnect();
+    isCheckingReachability_ = true;
+    connSettingsPolicy_->checkReachability();
 }
 
 void ConnectionManager::clickDisconnect()
@@ -196,11 +216,13 @@ void ConnectionManager::clickDisconnect()
     timerWaitNetworkConnectivity_.stop();
     connectTimer_.stop();
     connectingTimer_.stop();
+    stopReachabilityCheck();
 
     if (state_ != STATE_DISCONNECTING_FROM_USER_CLICK)
     {
         state_ = STATE_DISCONNECTING_FROM_USER_CLICK;
         qCDebug(LOG_CONNECTION) << "ConnectionManager::clickDisconnect()";
+        finishConnectionTrace(false);
         if (connector_)
         {
             connector_->startDisconnect();
@@ -372,6 +394,12 @@ void ConnectionManager::onConnectionConnected(const AdapterGatewayInfo &connecti
     timerReconnection_.stop();
     connectingTimer_.stop();
     state_ = STATE_CONNECTED;
+    if (!connSettingsPolicy_.isNull()) {
+        connSettingsPolicy_->putSuccessfulConnection();
+    }
+    ConnectionTracer::instance().endSpan("tunnelConnect");
+    // firewall, DNS and routes are set up by the engine until it starts the tunnel tests
+    ConnectionTracer::instance().beginSpan("postConnectSetup");
     emit connected();
 }
 
@@ -452,6 +480,7 @@ void ConnectionManager::onConnectionReconnecting()
     qCDebug(LOG_CONNECTION) << "ConnectionManager::onConnectionReconnecting(), state_ =" << state_;
 
     testVPNTunnel_->stopTests();
+    finishConnectionTrace(false);
 
     // bIgnoreConnectionErrorsForOpenVpn_ need to prevent handle multiple error messages from openvpn
     if (bIgnoreConnectionErrorsForOpenVpn_)
@@ -556,6 +585,7 @@ void ConnectionManager::onConnectionError(CONNECT_ERROR err)
 
     qCDebug(LOG_CONNECTION) << "ConnectionManager::onConnectionError(), state_ =" << state_ << ", error =" << (int)err;
     testVPNTunnel_->stopTests();
+    finishConnectionTrace(false);
 
     if ((err == CONNECT_ERROR::AUTH_ERROR && bEmitAuthError_)
             || err == CONNECT_ERROR::NO_OPENVPN_SOCKET
@@ -692,6 +722,7 @@ void ConnectionManager::onSleepMode()
 
     timerReconnection_.stop();
     connectTimer_.stop();
+    stopReachabilityCheck();
     bWakeSignalReceived_ = false;
 
     switch (state_)
@@ -854,6 +885,7 @@ void ConnectionManager::onTimerReconnection()
 
 void ConnectionManager::onWstunnelStarted()
 {
+    ConnectionTracer::instance().endSpan("startTunnelProxy");
     doConnectPart3();
 }
 
@@ -886,9 +918,11 @@ void ConnectionManager::doConnect()
     qCDebug(LOG_CONNECTION) << "Default adapter and gateway:" << defaultAdapterInfo_.makeLogString();
     connectTimer_.stop();
 
+    const CurrentConnectionDescr settings = connSettingsPolicy_->getCurrentConnectionSettings();
+    ConnectionTracer::instance().beginAttempt(settings.protocol.toLongString());
+
     connectingTimer_.setSingleShot(true);
     if (connSettingsPolicy_->isAutomaticMode()) {
-        CurrentConnectionDescr settings = connSettingsPolicy_->getCurrentConnectionSettings();
         if (settings.protocol == types::Protocol::WIREGUARD) {
             connectingTimer_.setInterval(kConnectingTimeoutWireGuard);
         } else {
@@ -897,11 +931,13 @@ void ConnectionManager::doConnect()
         connectingTimer_.start();
     }
 
+    ConnectionTracer::instance().beginSpan("resolveHostnames");
     connSettingsPolicy_->resolveHostnames();
 }
 
 void ConnectionManager::doConnectPart2()
 {
+    ConnectionTracer::Scope prepareSpan("prepareConnection");
     bIgnoreConnectionErrorsForOpenVpn_ = false;
 
     currentConnectionDescr_ = connSettingsPolicy_->getCurrentConnectionSettings();
@@ -1008,6 +1044,11 @@ void ConnectionManager::doConnectPart2()
                 return;
             }
 
+            if (currentConnectionDescr_.protocol.isStunnelOrWStunnelProtocol()) {
+                prepareSpan.end();
+                ConnectionTracer::instance().beginSpan("startTunnelProxy");
+            }
+
             if (currentConnectionDescr_.protocol == types::Protocol::STUNNEL) {
                 if (!stunnelManager_->runProcess(currentConnectionDescr_.ip, currentConnectionDescr_.port,
                                                  ExtraConfig::instance().getStealthExtraTLSPadding() || isAntiCensorship_)) {
@@ -1041,8 +1082,15 @@ void ConnectionManager::doConnectPart2()
         }
         else if (currentConnectionDescr_.protocol.isWireGuardProtocol())
         {
-            qCDebug(LOG_CONNECTION) << "Requesting WireGuard config for hostname =" << currentConnectionDescr_.hostname;
             QString deviceId = (isStaticIpsLocation() ? GetDeviceId::instance().getDeviceId() : QString());
+            prepareSpan.end();
+            if (deviceId.isEmpty() && wireGuardConfigPrefetcher_->take(currentConnectionDescr_.hostname, wireGuardConfig_)) {
+                qCDebug(LOG_CONNECTION) << "Using the prefetched WireGuard config for hostname =" << currentConnectionDescr_.hostname;
+                ConnectionTracer::instance().addInstant("prefetchedWireGuardConfig");
+                doConnectPart3();
+                return;
+            }
+            qCDebug(LOG_CONNECTION) << "Requesting WireGuard config for hostname =" << currentConnectionDescr_.hostname;
             getWireGuardConfig(currentConnectionDescr_.hostname, false, deviceId);
             return;
         }
@@ -1078,11 +1126,14 @@ void ConnectionManager::doConnectPart2()
         WS_ASSERT(false);
     }
 
+    prepareSpan.end();
     doConnectPart3();
 }
 
 void ConnectionManager::doConnectPart3()
 {
+    ConnectionTracer::instance().beginSpan("tunnelConnect");
+
     if (currentConnectionDescr_.protocol.isWireGuardProtocol())
     {
         WireGuardConfig* pConfig = (currentConnectionDescr_.connectionNodeType == CONNECTION_NODE_CUSTOM_CONFIG ? currentConnectionDescr_.wgCustomConfig.get() : &wireGuardConfig_);
@@ -1299,6 +1350,8 @@ void ConnectionManager::restoreConnectionAfterWakeUp()
 
 void ConnectionManager::onTunnelTestsFinished(bool bSuccess, const QString &ipAddress)
 {
+    finishConnectionTrace(bSuccess);
+
     bool hasAttempts = false;
     int attempts = ExtraConfig::instance().getTunnelTestAttempts(hasAttempts);
     bool noError = ExtraConfig::instance().getIsTunnelTestNoError();
@@ -1366,9 +1419,32 @@ void ConnectionManager::onTimerWaitNetworkConnectivity()
 
 void ConnectionManager::onHostnamesResolved()
 {
+    ConnectionTracer::instance().endSpan("resolveHostnames");
     doConnectPart2();
 }
 
+void ConnectionManager::onReachabilityChecked()
+{
+    const bool isChecking = isCheckingReachability_;
+    isCheckingReachability_ = false;
+
+    // disconnected while the check was in progress
+    if (!isChecking || state_ != STATE_CONNECTING_FROM_USER_CLICK) {
+        return;
+    }
+    doConnect();
+}
+
+void ConnectionManager::stopReachabilityCheck()
+{
+    if (isCheckingReachability_) {
+        isCheckingReachability_ = false;
+        if (!connSettingsPolicy_.isNull()) {
+            connSettingsPolicy_->stopReachabilityCheck();
+        }
+    }
+}
+
 void ConnectionManager::onGetWireGuardConfigAnswer(WireGuardConfigRetCode retCode, const WireGuardConfig &config)
 {
     // if we got an answer after we've timed out or disconnected, ignore this event
@@ -1379,6 +1455,8 @@ void ConnectionManager::onGetWireGuardConfigAnswer(WireGuardConfigRetCode retCod
         return;
     }
 
+    ConnectionTracer::instance().endSpan("getWireGuardConfig", retCode == WireGuardConfigRetCode::kSuccess);
+
     if (retCode == WireGuardConfigRetCode::kKeyLimit)
     {
         // Do not timeout while waiting for user input
@@ -1441,6 +1519,8 @@ void ConnectionManager::onWireGuardKeyLimitUserResponse(bool deleteOldestKey)
 {
     if (deleteOldestKey)
     {
+        // a key is freed, so the prefetching stopped at the key limit can resume
+        wireGuardConfigPrefetcher_->clear();
         QString deviceId = (isStaticIpsLocation() ? GetDeviceId::instance().getDeviceId() : QString());
         getWireGuardConfig(currentConnectionDescr_.hostname, true, deviceId);
         // restart connecting timeout
@@ -1452,6 +1532,33 @@ void ConnectionManager::onWireGuardKeyLimitUserResponse(bool deleteOldestKey)
     }
 }
 
+void ConnectionManager::prefetchWireGuardConfigs(const QVector<QSharedPointer<locationsmodel::BaseLocationInfo>> &locations)
+{
+    if (state_ != STATE_DISCONNECTED)
+        return;
+
+    QStringList hostnames;
+    const QStringList cachedHostnames = wireGuardConfigPrefetcher_->cachedHostnames();
+    for (const auto &bli : locations) {
+        // static IP configs are bound to the device id, custom configs do not need a request
+        QSharedPointer<locationsmodel::MutableLocationInfo> mli = qSharedPointerDynamicCast<locationsmodel::MutableLocationInfo>(bli);
+        if (!mli || mli->locationId().isStaticIpsLocation() || !mli->isExistSelectedNode())
+            continue;
+        // keep the node whose config is already fetched, clickConnect() prefers it as well
+        for (const auto &hostname : cachedHostnames) {
+            if (mli->selectNodeByHostname(hostname))
+                break;
+        }
+        hostnames << mli->getHostnameForSelectedNode();
+    }
+    wireGuardConfigPrefetcher_->prefetch(hostnames);
+}
+
+void ConnectionManager::clearPrefetchedWireGuardConfigs()
+{
+    wireGuardConfigPrefetcher_->clear();
+}
+
 void ConnectionManager::setPacketSize(types::PacketSize ps)
 {
     packetSize_ = ps;
@@ -1459,6 +1566,7 @@ void ConnectionManager::setPacketSize(types::PacketSize ps)
 
 void ConnectionManager::startTunnelTests()
 {
+    ConnectionTracer::instance().endSpan("postConnectSetup");
     testVPNTunnel_->startTests(currentConnectionDescr_.protocol);
 }
 
@@ -1485,6 +1593,12 @@ void ConnectionManager::updateConnectionSettings(const types::ConnectionSettings
 
     updateConnectionSettingsPolicy(connectionSettings, portMap, proxySettings);
 
+    // the check was done by the previous policy, the protocols may be different now
+    if (isCheckingReachability_) {
+        connSettingsPolicy_->checkReachability();
+        return;
+    }
+
     if (connector_ == nullptr) {
         return;
     }
@@ -1527,17 +1641,23 @@ void ConnectionManager::updateConnectionSettingsPolicy(const types::ConnectionSe
     if (bli_->locationId().isCustomConfigsLocation()) {
         connSettingsPolicy_.reset(new CustomConfigConnSettingsPolicy(bli_));
     } else if (connectionSettings.isAutomatic()) {
+        types::NetworkInterface networkInterface;
+        networkDetectionManager_->getCurrentNetworkInterface(networkInterface);
 #ifdef Q_OS_MACOS
-        connSettingsPolicy_.reset(new AutoConnSettingsPolicy(bli_, portMap, proxySettings.isProxyEnabled(), lastKnownGoodProtocol_, MacUtils::isLockdownMode()));
+        connSettingsPolicy_.reset(new AutoConnSettingsPolicy(bli_, portMap, proxySettings.isProxyEnabled(), lastKnownGoodProtocol_, MacUtils::isLockdownMode(),
+                                                             networkInterface.networkOrSsid));
 #else
-        connSettingsPolicy_.reset(new AutoConnSettingsPolicy(bli_, portMap, proxySettings.isProxyEnabled(), lastKnownGoodProtocol_, false));
+        connSettingsPolicy_.reset(new AutoConnSettingsPolicy(bli_, portMap, proxySettings.isProxyEnabled(), lastKnownGoodProtocol_, false,
+                                                             networkInterface.networkOrSsid));
 #endif
     } else {
         connSettingsPolicy_.reset(new ManualConnSettingsPolicy(bli_, connectionSettings, portMap));
     }
     connSettingsPolicy_->start();
     connect(connSettingsPolicy_.data(), &BaseConnSettingsPolicy::hostnamesResolved, this, &ConnectionManager::onHostnamesResolved);
+    connect(connSettingsPolicy_.data(), &BaseConnSettingsPolicy::reachabilityChecked, this, &ConnectionManager::onReachabilityChecked);
     connect(connSettingsPolicy_.data(), &BaseConnSettingsPolicy::protocolStatusChanged, this, &ConnectionManager::protocolStatusChanged);
+    connect(connSettingsPolicy_.data(), &BaseConnSettingsPolicy::reachabilityIpsChanged, this, &ConnectionManager::reachabilityIpsChanged);
 }
 
 void ConnectionManager::connectOrStartConnectTimer()
@@ -1554,6 +1674,7 @@ void ConnectionManager::connectOrStartConnectTimer()
 void ConnectionManager::getWireGuardConfig(const QString &serverName, bool deleteOldestKey, const QString &deviceId)
 {
     SAFE_DELETE(getWireGuardConfig_);
+    ConnectionTracer::instance().beginSpan("getWireGuardConfig");
     getWireGuardConfig_ = new GetWireGuardConfig(this);
     connect(getWireGuardConfig_, &GetWireGuardConfig::getWireGuardConfigAnswer, this, &ConnectionManager::onGetWireGuardConfigAnswer);
     getWireGuardConfig_->getWireGuardConfig(serverName, deleteOldestKey, deviceId);
@@ -1576,10 +1697,12 @@ QString ConnectionManager::dnsServersFromConnectedDnsInfo() const
 
 void ConnectionManager::disconnect()
 {
+    finishConnectionTrace(false);
     Logger::instance().endConnectionMode();
     timerReconnection_.stop();
     connectTimer_.stop();
     connectingTimer_.stop();
+    stopReachabilityCheck();
     state_ = STATE_DISCONNECTED;
 }
 
@@ -1595,8 +1718,26 @@ void ConnectionManager::setLastKnownGoodProtocol(const types::Protocol protocol)
 void ConnectionManager::onConnectingTimeout()
 {
     qCDebug(LOG_CONNECTION) << "Connection timed out";
+    finishConnectionTrace(false);
     state_ = STATE_RECONNECTING;
     emit reconnecting();
     startReconnectionTimer();
     onConnectionReconnecting();
 }
+
+void ConnectionManager::finishConnectionTrace(bool isSuccess)
+{
+    ConnectionTracer &tracer = ConnectionTracer::instance();
+    if (!tracer.endAttempt(isSuccess))
+        return;
+
+    qCDebug(LOG_CONNECTION) << "Connection trace:" << tracer.lastAttemptSummary();
+    if (isSuccess)
+        qCDebug(LOG_CONNECTION).noquote() << "Connection phases of the recent attempts:\n" + tracer.summary();
+
+    if (ExtraConfig::instance().getConnectionTrace()) {
+        QSaveFile file(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/connection_trace.json");
+        if (!file.open(QIODevice::WriteOnly) || file.write(tracer.toChromeTrace()) < 0 || !file.commit())
+            qCDebug(LOG_CONNECTION) << "Failed to write the connection trace:" << file.errorString();
+    }
+}
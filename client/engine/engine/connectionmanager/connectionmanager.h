@@ -31,6 +31,7 @@ class IKEv2Connection;
 class TestVPNTunnel;
 enum class WireGuardConfigRetCode;
 class GetWireGuardConfig;
+class WireGuardConfigPrefetcher;
 
 // manage openvpn connection, reconnects, sleep mode, network change, automatic/manual connection mode
 
@@ -77,6 +78,11 @@ public:
 
     void onWireGuardKeyLimitUserResponse(bool deleteOldestKey);
 
+    // fetches the WireGuard configs of the selected nodes of these locations in the background, in the order of priority;
+    // a following connect to one of them skips the config requests. Does nothing unless disconnected.
+    void prefetchWireGuardConfigs(const QVector<QSharedPointer<locationsmodel::BaseLocationInfo>> &locations);
+    void clearPrefetchedWireGuardConfigs();
+
     void setMss(int mss);
     void setPacketSize(types::PacketSize ps);
 
@@ -106,6 +112,8 @@ signals:
     void protocolPortChanged(const types::Protocol &protocol, const uint port);
     void wireGuardAtKeyLimit();
     void protocolStatusChanged(const QVector<types::ProtocolStatus> &status);
+    // see BaseConnSettingsPolicy::reachabilityIpsChanged()
+    void reachabilityIpsChanged(const QStringList &ips);
 
     void requestUsername(const QString &pathCustomOvpnConfig);
     void requestPassword(const QString &pathCustomOvpnConfig);
@@ -138,6 +146,7 @@ private slots:
     void onTimerWaitNetworkConnectivity();
 
     void onHostnamesResolved();
+    void onReachabilityChecked();
 
     void onGetWireGuardConfigAnswer(WireGuardConfigRetCode retCode, const WireGuardConfig &config);
 
@@ -161,6 +170,8 @@ private:
 #endif
 
     QScopedPointer<BaseConnSettingsPolicy> connSettingsPolicy_;
+    // the policy is checking the reachability of the protocols before the first attempt of a user click
+    bool isCheckingReachability_ = false;
 
     QString lastIp_;
 
@@ -210,6 +221,7 @@ private:
 
     WireGuardConfig wireGuardConfig_;
     GetWireGuardConfig *getWireGuardConfig_ = nullptr;
+    WireGuardConfigPrefetcher *wireGuardConfigPrefetcher_ = nullptr;
 
     AdapterGatewayInfo defaultAdapterInfo_;
     AdapterGatewayInfo vpnAdapterInfo_;
@@ -238,6 +250,10 @@ private:
     void getWireGuardConfig(const QString &serverName, bool deleteOldestKey, const QString &deviceId);
     bool connectedDnsTypeAuto() const;
     QString dnsServersFromConnectedDnsInfo() const;
+    // ends the traced connection attempt, logs its phases and, with ws-connection-trace, dumps the trace to a file
+    void finishConnectionTrace(bool isSuccess);
+    // stops the reachability check of a user click, after a disconnect or when going to sleep
+    void stopReachabilityCheck();
 
     void disconnect();
 };
@@ -0,0 +1,312 @@
+#include "connectiontracer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QPair>
+#include <QStringList>
+
+namespace {
+
+// upper bounds of the histogram buckets, the last bucket holds everything above
+const qint64 kBucketBoundsMs[] = { 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000 };
+const int kBucketCount = sizeof(kBucketBoundsMs) / sizeof(kBucketBoundsMs[0]) + 1;
+
+QString bucketLabel(int bucket)
+{
+    auto format = [](qint64 ms) {
+        return ms >= 1000 ? QString::number(ms / 1000) + "s" : QString::number(ms) + "ms";
+    };
+    if (bucket == kBucketCount - 1)
+        return ">=" + format(kBucketBoundsMs[kBucketCount - 2]);
+    return "<" + format(kBucketBoundsMs[bucket]);
+}
+
+qint64 toMs(qint64 ns)
+{
+    return ns / 1000000;
+}
+
+} // namespace
+
+ConnectionTracer::Scope::Scope(const char *name) : name_(name)
+{
+    ConnectionTracer::instance().beginSpan(name_);
+}
+
+ConnectionTracer::Scope::~Scope()
+{
+    end();
+}
+
+void ConnectionTracer::Scope::end()
+{
+    if (!isEnded_) {
+        isEnded_ = true;
+        ConnectionTracer::instance().endSpan(name_, isOk_);
+    }
+}
+
+ConnectionTracer &ConnectionTracer::instance()
+{
+    static ConnectionTracer tracer;
+    return tracer;
+}
+
+ConnectionTracer::ConnectionTracer(int capacity, std::function<qint64()> nowNs) : nowNs_(nowNs)
+{
+    clock_.start();
+    if (!nowNs_)
+        nowNs_ = [this]() { return clock_.nsecsElapsed(); };
+    ring_.resize(qMax(1, capacity));
+}
+
+void ConnectionTracer::beginAttempt(const QString &protocol)
+{
+    QMutexLocker locker(&mutex_);
+    const qint64 now = nowNs_();
+    if (isAttemptInProgress_)
+        endAttemptLocked(false, now);
+
+    attemptId_++;
+    isAttemptInProgress_ = true;
+    protocol_ = protocol;
+    attemptStartNs_ = now;
+}
+
+bool ConnectionTracer::endAttempt(bool isOk)
+{
+    QMutexLocker locker(&mutex_);
+    if (!isAttemptInProgress_)
+        return false;
+    endAttemptLocked(isOk, nowNs_());
+    return true;
+}
+
+bool ConnectionTracer::isAttemptInProgress() const
+{
+    QMutexLocker locker(&mutex_);
+    return isAttemptInProgress_;
+}
+
+void ConnectionTracer::beginSpan(const char *name)
+{
+    QMutexLocker locker(&mutex_);
+    if (!isAttemptInProgress_)
+        return;
+
+    const qint64 now = nowNs_();
+    for (auto &span : openSpans_) {
+        if (strcmp(span.name, name) == 0) {
+            // started again without being ended, e.g. a retried request: the previous one failed
+            record(span.name, span.startNs, now - span.startNs, false, false);
+            span.startNs = now;
+            return;
+        }
+    }
+    openSpans_.append(OpenSpan{ name, now });
+}
+
+void ConnectionTracer::endSpan(const char *name, bool isOk)
+{
+    QMutexLocker locker(&mutex_);
+    for (int i = 0; i < openSpans_.size(); ++i) {
+        if (strcmp(openSpans_[i].name, name) == 0) {
+            record(openSpans_[i].name, openSpans_[i].startNs, nowNs_() - openSpans_[i].startNs, isOk, false);
+            openSpans_.remove(i);
+            return;
+        }
+    }
+}
+
+void ConnectionTracer::addInstant(const char *name)
+{
+    QMutexLocker locker(&mutex_);
+    if (isAttemptInProgress_)
+        record(name, nowNs_(), 0, true, true);
+}
+
+QVector<ConnectionTracer::Span> ConnectionTracer::spans() const
+{
+    QMutexLocker locker(&mutex_);
+    return spansLocked();
+}
+
+void ConnectionTracer::clear()
+{
+    QMutexLocker locker(&mutex_);
+    head_ = 0;
+    count_ = 0;
+    for (auto &span : ring_)
+        span = Span();
+}
+
+QByteArray ConnectionTracer::toChromeTrace() const
+{
+    const QVector<Span> spans = this->spans();
+
+    // one row per attempt, named after it
+    QJsonArray events;
+    quint32 lastNamedAttempt = 0;
+    for (const auto &span : spans) {
+        if (span.attemptId != lastNamedAttempt) {
+            lastNamedAttempt = span.attemptId;
+            QJsonObject meta;
+            meta["name"] = "thread_name";
+            meta["ph"] = "M";
+            meta["pid"] = 1;
+            meta["tid"] = static_cast<qint64>(span.attemptId);
+            meta["args"] = QJsonObject{ { "name", QString("attempt %1 (%2)").arg(span.attemptId).arg(span.protocol) } };
+            events.append(meta);
+        }
+
+        QJsonObject event;
+        event["name"] = QString::fromLatin1(span.name);
+        event["cat"] = span.protocol;
+        event["pid"] = 1;
+        event["tid"] = static_cast<qint64>(span.attemptId);
+        event["ts"] = span.startNs / 1000.0;
+        if (span.isInstant) {
+            event["ph"] = "i";
+            event["s"] = "t";
+        } else {
+            event["ph"] = "X";
+            event["dur"] = span.durationNs / 1000.0;
+            event["args"] = QJsonObject{ { "ok", span.isOk } };
+        }
+        events.append(event);
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = events;
+    root["displayTimeUnit"] = "ms";
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+QString ConnectionTracer::summary() const
+{
+    struct Phase
+    {
+        QString protocol;
+        const char *name;
+        bool isInstant;
+        int failed = 0;
+        QVector<qint64> durationsMs;
+        int buckets[kBucketCount] = {};
+    };
+
+    QVector<Phase> phases;
+    for (const auto &span : spans()) {
+        auto it = std::find_if(phases.begin(), phases.end(), [&span](const Phase &phase) {
+            return phase.protocol == span.protocol && strcmp(phase.name, span.name) == 0;
+        });
+        if (it == phases.end()) {
+            phases.append(Phase{ span.protocol, span.name, span.isInstant });
+            it = phases.end() - 1;
+        }
+
+        const qint64 ms = toMs(span.durationNs);
+        it->durationsMs << ms;
+        if (!span.isOk)
+            it->failed++;
+        it->buckets[std::upper_bound(std::begin(kBucketBoundsMs), std::end(kBucketBoundsMs), ms) - std::begin(kBucketBoundsMs)]++;
+    }
+
+    QStringList lines;
+    for (auto &phase : phases) {
+        QString line = QString("%1 [%2]: n=%3").arg(QLatin1String(phase.name), phase.protocol).arg(phase.durationsMs.size());
+        if (!phase.isInstant) {
+            std::sort(phase.durationsMs.begin(), phase.durationsMs.end());
+            auto percentile = [&phase](int p) {
+                return phase.durationsMs[(phase.durationsMs.size() - 1) * p / 100];
+            };
+            line += QString(" failed=%1 min=%2 p50=%3 p90=%4 max=%5 ms;")
+                        .arg(phase.failed).arg(phase.durationsMs.first()).arg(percentile(50)).arg(percentile(90)).arg(phase.durationsMs.last());
+            for (int i = 0; i < kBucketCount; ++i) {
+                if (phase.buckets[i] > 0)
+                    line += QString(" %1:%2").arg(bucketLabel(i)).arg(phase.buckets[i]);
+            }
+        }
+        lines << line;
+    }
+    return lines.join('\n');
+}
+
+QString ConnectionTracer::lastAttemptSummary() const
+{
+    QMutexLocker locker(&mutex_);
+    if (lastFinishedAttemptId_ == 0)
+        return QString();
+
+    QString result;
+    QStringList phases;
+    QVector<QPair<const char *, int>> instants;
+    for (const auto &span : spansLocked()) {
+        if (span.attemptId != lastFinishedAttemptId_)
+            continue;
+        if (span.isInstant) {
+            auto it = std::find_if(instants.begin(), instants.end(), [&span](const QPair<const char *, int> &instant) {
+                return strcmp(instant.first, span.name) == 0;
+            });
+            if (it == instants.end())
+                instants.append(qMakePair(span.name, 1));
+            else
+                it->second++;
+        } else if (strcmp(span.name, kAttemptSpan) == 0) {
+            result = QString("attempt %1 (%2) %3 in %4 ms").arg(span.attemptId).arg(span.protocol)
+                         .arg(span.isOk ? QString("ok") : QString("failed")).arg(toMs(span.durationNs));
+        } else {
+            phases << QString("%1 %2 ms%3").arg(QLatin1String(span.name)).arg(toMs(span.durationNs)).arg(span.isOk ? QString() : QString(" (failed)"));
+        }
+    }
+    for (const auto &instant : instants)
+        phases << QString("%1 x%2").arg(QLatin1String(instant.first)).arg(instant.second);
+
+    if (result.isEmpty())
+        return QString();   // the attempt was already pushed out of the ring
+    if (!phases.isEmpty())
+        result += ": " + phases.join(", ");
+    return result;
+}
+
+void ConnectionTracer::endAttemptLocked(bool isOk, qint64 now)
+{
+    // the phases cut short by the end of the attempt did not complete
+    for (const auto &span : openSpans_)
+        record(span.name, span.startNs, now - span.startNs, false, false);
+    openSpans_.clear();
+
+    record(kAttemptSpan, attemptStartNs_, now - attemptStartNs_, isOk, false);
+    isAttemptInProgress_ = false;
+    lastFinishedAttemptId_ = attemptId_;
+}
+
+void ConnectionTracer::record(const char *name, qint64 startNs, qint64 durationNs, bool isOk, bool isInstant)
+{
+    Span &span = ring_[head_];
+    span.attemptId = attemptId_;
+    span.protocol = protocol_;
+    span.name = name;
+    span.startNs = startNs;
+    span.durationNs = durationNs;
+    span.isOk = isOk;
+    span.isInstant = isInstant;
+
+    head_ = (head_ + 1) % ring_.size();
+    if (count_ < ring_.size())
+        count_++;
+}
+
+QVector<ConnectionTracer::Span> ConnectionTracer::spansLocked() const
+{
+    QVector<Span> result;
+    result.reserve(count_);
+    const int first = (head_ - count_ + ring_.size()) % ring_.size();
+    for (int i = 0; i < count_; ++i)
+        result << ring_[(first + i) % ring_.size()];
+    return result;
+}
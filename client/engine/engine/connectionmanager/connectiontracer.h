@@ -0,0 +1,99 @@
+#pragma once
+
+#include <functional>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+// Records the phases of connection attempts (resolving hostnames, fetching the WireGuard config, helper commands,
+// the tunnel tests, ...) as spans with monotonic timestamps, so that it is visible which phase dominates the time to
+// connect on each protocol. The last kDefaultCapacity spans are kept in a ring and can be exported as a Chrome trace
+// (chrome://tracing, ui.perfetto.dev) or summarized as per-phase duration histograms.
+// Spans are identified by their name within the current attempt, so a phase cannot be nested in itself.
+// Names must be string literals, they are stored as pointers. Thread-safe.
+class ConnectionTracer
+{
+public:
+    struct Span
+    {
+        quint32 attemptId = 0;
+        QString protocol;
+        const char *name = nullptr;
+        qint64 startNs = 0;
+        qint64 durationNs = 0;
+        bool isOk = true;
+        bool isInstant = false;     // a point event, e.g. a retry
+    };
+
+    // ends the span on destruction, unless it was ended before
+    class Scope
+    {
+    public:
+        explicit Scope(const char *name);
+        ~Scope();
+        void setFailed() { isOk_ = false; }
+        void end();
+
+    private:
+        const char *name_;
+        bool isOk_ = true;
+        bool isEnded_ = false;
+    };
+
+    static constexpr int kDefaultCapacity = 1024;
+    static constexpr const char *kAttemptSpan = "attempt";
+
+    static ConnectionTracer &instance();
+
+    // nowNs returns the monotonic time in nanoseconds, by default of a QElapsedTimer
+    explicit ConnectionTracer(int capacity = kDefaultCapacity, std::function<qint64()> nowNs = nullptr);
+
+    // starts a new attempt; an unfinished previous attempt and its open spans are recorded as failed
+    void beginAttempt(const QString &protocol);
+    // records the "attempt" span and closes the spans left open; returns false if there was no attempt in progress
+    bool endAttempt(bool isOk);
+    bool isAttemptInProgress() const;
+
+    void beginSpan(const char *name);
+    // does nothing if the span was not started in the current attempt
+    void endSpan(const char *name, bool isOk = true);
+    void addInstant(const char *name);
+
+    // oldest first
+    QVector<Span> spans() const;
+    void clear();
+
+    QByteArray toChromeTrace() const;
+    // one line per phase and protocol: count, failures, percentiles and a histogram of the durations
+    QString summary() const;
+    // the phases of the last finished attempt in a single line, e.g. "attempt 3 (WireGuard) ok in 812 ms: ..."
+    QString lastAttemptSummary() const;
+
+private:
+    struct OpenSpan
+    {
+        const char *name;
+        qint64 startNs;
+    };
+
+    mutable QMutex mutex_;
+    QElapsedTimer clock_;
+    std::function<qint64()> nowNs_;
+
+    QVector<Span> ring_;
+    int head_ = 0;      // the next slot to write
+    int count_ = 0;
+
+    quint32 attemptId_ = 0;
+    bool isAttemptInProgress_ = false;
+    QString protocol_;
+    qint64 attemptStartNs_ = 0;
+    QVector<OpenSpan> openSpans_;
+    quint32 lastFinishedAttemptId_ = 0;
+
+    void endAttemptLocked(bool isOk, qint64 now);
+    void record(const char *name, qint64 startNs, qint64 durationNs, bool isOk, bool isInstant);
+    QVector<Span> spansLocked() const;
+};
@@ -0,0 +1,217 @@
+#include "connectiontracer.test.h"
+
+#include <cstring>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include "connectiontracer.h"
+
+namespace {
+
+const qint64 kMs = 1000000;
+
+} // namespace
+
+void TestConnectionTracer::testSpans()
+{
+    qint64 now = 0;
+    ConnectionTracer tracer(16, [&now]() { return now; });
+
+    // nothing is recorded outside of an attempt
+    tracer.beginSpan("resolveHostnames");
+    tracer.addInstant("retry");
+    QVERIFY(!tracer.endAttempt(true));
+    QVERIFY(tracer.spans().isEmpty());
+
+    tracer.beginAttempt("WireGuard");
+    QVERIFY(tracer.isAttemptInProgress());
+    tracer.beginSpan("resolveHostnames");
+    now = 5 * kMs;
+    tracer.endSpan("resolveHostnames");
+    tracer.beginSpan("getWireGuardConfig");
+    now = 10 * kMs;
+    tracer.addInstant("retry");
+    now = 30 * kMs;
+    tracer.endSpan("getWireGuardConfig", false);
+    tracer.endSpan("notStarted");
+    now = 50 * kMs;
+    QVERIFY(tracer.endAttempt(true));
+    QVERIFY(!tracer.isAttemptInProgress());
+
+    const auto spans = tracer.spans();
+    QCOMPARE(spans.size(), 4);
+    QCOMPARE(spans[0].name, "resolveHostnames");
+    QCOMPARE(spans[0].startNs, qint64(0));
+    QCOMPARE(spans[0].durationNs, 5 * kMs);
+    QVERIFY(spans[0].isOk);
+    QCOMPARE(spans[1].name, "retry");
+    QVERIFY(spans[1].isInstant);
+    QCOMPARE(spans[1].startNs, 10 * kMs);
+    QCOMPARE(spans[2].name, "getWireGuardConfig");
+    QCOMPARE(spans[2].startNs, 5 * kMs);
+    QCOMPARE(spans[2].durationNs, 25 * kMs);
+    QVERIFY(!spans[2].isOk);
+    QCOMPARE(spans[3].name, ConnectionTracer::kAttemptSpan);
+    QCOMPARE(spans[3].durationNs, 50 * kMs);
+    QVERIFY(spans[3].isOk);
+    for (const auto &span : spans) {
+        QCOMPARE(span.attemptId, 1u);
+        QCOMPARE(span.protocol, QString("WireGuard"));
+    }
+}
+
+void TestConnectionTracer::testUnfinishedSpans()
+{
+    qint64 now = 0;
+    ConnectionTracer tracer(16, [&now]() { return now; });
+
+    tracer.beginAttempt("UDP");
+    tracer.beginSpan("tunnelConnect");
+    now = 10 * kMs;
+    // started again: the first one is recorded as failed
+    tracer.beginSpan("tunnelConnect");
+    now = 20 * kMs;
+    // a new attempt closes the previous one and its open spans as failed
+    tracer.beginAttempt("TCP");
+    now = 25 * kMs;
+    tracer.endSpan("tunnelConnect");
+    QVERIFY(tracer.endAttempt(false));
+
+    const auto spans = tracer.spans();
+    QCOMPARE(spans.size(), 4);
+    QCOMPARE(spans[0].name, "tunnelConnect");
+    QCOMPARE(spans[0].durationNs, 10 * kMs);
+    QVERIFY(!spans[0].isOk);
+    QCOMPARE(spans[1].name, "tunnelConnect");
+    QCOMPARE(spans[1].startNs, 10 * kMs);
+    QCOMPARE(spans[1].durationNs, 10 * kMs);
+    QVERIFY(!spans[1].isOk);
+    QCOMPARE(spans[2].name, ConnectionTracer::kAttemptSpan);
+    QCOMPARE(spans[2].attemptId, 1u);
+    QVERIFY(!spans[2].isOk);
+    QCOMPARE(spans[3].name, ConnectionTracer::kAttemptSpan);
+    QCOMPARE(spans[3].attemptId, 2u);
+    QCOMPARE(spans[3].protocol, QString("TCP"));
+    QCOMPARE(spans[3].durationNs, 5 * kMs);
+}
+
+void TestConnectionTracer::testRing()
+{
+    qint64 now = 0;
+    ConnectionTracer tracer(4, [&now]() { return now; });
+
+    tracer.beginAttempt("UDP");
+    for (int i = 0; i < 10; ++i) {
+        now = i * kMs;
+        tracer.addInstant("retry");
+    }
+    auto spans = tracer.spans();
+    QCOMPARE(spans.size(), 4);
+    for (int i = 0; i < 4; ++i)
+        QCOMPARE(spans[i].startNs, (6 + i) * kMs);
+
+    tracer.clear();
+    QVERIFY(tracer.spans().isEmpty());
+    tracer.addInstant("retry");
+    QCOMPARE(tracer.spans().size(), 1);
+}
+
+void TestConnectionTracer::testChromeTrace()
+{
+    qint64 now = 0;
+    ConnectionTracer tracer(16, [&now]() { return now; });
+
+    tracer.beginAttempt("IKEv2");
+    tracer.beginSpan("tunnelConnect");
+    now = 1500000;
+    tracer.addInstant("retry");
+    now = 2 * kMs;
+    tracer.endSpan("tunnelConnect");
+    tracer.endAttempt(true);
+
+    QJsonParseError error;
+    const QJsonDocument doc = QJsonDocument::fromJson(tracer.toChromeTrace(), &error);
+    QCOMPARE(error.error, QJsonParseError::NoError);
+    const QJsonArray events = doc.object()["traceEvents"].toArray();
+    QCOMPARE(events.size(), 4);
+
+    QCOMPARE(events[0].toObject()["ph"].toString(), QString("M"));
+    QCOMPARE(events[0].toObject()["args"].toObject()["name"].toString(), QString("attempt 1 (IKEv2)"));
+
+    const QJsonObject instant = events[1].toObject();
+    QCOMPARE(instant["name"].toString(), QString("retry"));
+    QCOMPARE(instant["ph"].toString(), QString("i"));
+    QCOMPARE(instant["ts"].toDouble(), 1500.0);
+
+    const QJsonObject span = events[2].toObject();
+    QCOMPARE(span["name"].toString(), QString("tunnelConnect"));
+    QCOMPARE(span["ph"].toString(), QString("X"));
+    QCOMPARE(span["cat"].toString(), QString("IKEv2"));
+    QCOMPARE(span["tid"].toInt(), 1);
+    QCOMPARE(span["ts"].toDouble(), 0.0);
+    QCOMPARE(span["dur"].toDouble(), 2000.0);
+    QVERIFY(span["args"].toObject()["ok"].toBool());
+
+    QCOMPARE(events[3].toObject()["name"].toString(), QString(ConnectionTracer::kAttemptSpan));
+}
+
+void TestConnectionTracer::testSummary()
+{
+    qint64 now = 0;
+    ConnectionTracer tracer(64, [&now]() { return now; });
+
+    // 10 attempts with the config request taking 10, 20, ..., 100 ms
+    for (int i = 1; i <= 10; ++i) {
+        tracer.beginAttempt("WireGuard");
+        tracer.beginSpan("getWireGuardConfig");
+        now += i * 10 * kMs;
+        tracer.endSpan("getWireGuardConfig", i != 10);
+        if (i % 2 == 0)
+            tracer.addInstant("retry");
+        tracer.endAttempt(i != 10);
+    }
+    tracer.beginAttempt("UDP");
+    tracer.beginSpan("tunnelConnect");
+    now += 25000 * kMs;
+    tracer.endSpan("tunnelConnect");
+    tracer.endAttempt(true);
+
+    const QStringList lines = tracer.summary().split('\n');
+    QCOMPARE(lines.size(), 5);
+    QCOMPARE(lines[0], QString("getWireGuardConfig [WireGuard]: n=10 failed=1 min=10 p50=50 p90=90 max=100 ms; <20ms:1 <50ms:3 <100ms:5 <200ms:1"));
+    QVERIFY(lines[1].startsWith("attempt [WireGuard]: n=10 failed=1 "));
+    QCOMPARE(lines[2], QString("retry [WireGuard]: n=5"));
+    QCOMPARE(lines[3], QString("tunnelConnect [UDP]: n=1 failed=0 min=25000 p50=25000 p90=25000 max=25000 ms; >=20s:1"));
+    QVERIFY(lines[4].startsWith("attempt [UDP]: n=1 "));
+}
+
+void TestConnectionTracer::testLastAttemptSummary()
+{
+    qint64 now = 0;
+    ConnectionTracer tracer(16, [&now]() { return now; });
+    QVERIFY(tracer.lastAttemptSummary().isEmpty());
+
+    tracer.beginAttempt("UDP");
+    now = 100 * kMs;
+    tracer.endAttempt(false);
+
+    tracer.beginAttempt("WireGuard");
+    tracer.beginSpan("resolveHostnames");
+    now += 3 * kMs;
+    tracer.endSpan("resolveHostnames");
+    tracer.beginSpan("tunnelTest");
+    tracer.addInstant("tunnelTestRetry");
+    tracer.addInstant("tunnelTestRetry");
+    now += 700 * kMs;
+    tracer.endSpan("tunnelTest");
+    tracer.beginSpan("postConnectSetup");
+    tracer.endAttempt(true);
+    // an attempt in progress does not change it
+    tracer.beginAttempt("TCP");
+
+    QCOMPARE(tracer.lastAttemptSummary(),
+             QString("attempt 2 (WireGuard) ok in 703 ms: resolveHostnames 3 ms, tunnelTest 700 ms, postConnectSetup 0 ms (failed), tunnelTestRetry x2"));
+}
+
+QTEST_MAIN(TestConnectionTracer)
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <QObject>
+#include <QTest>
+
+class TestConnectionTracer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testSpans();
+    void testUnfinishedSpans();
+    void testRing();
+    void testChromeTrace();
+    void testSummary();
+    void testLastAttemptSummary();
+};
@@ -1,21 +1,112 @@
 #include "autoconnsettingspolicy.h"
 
 #include <QDataStream>
+#include <QDateTime>
+#include <QIODevice>
+#include <QMap>
 #include <QSettings>
+#include "engine/wireguardconfig/getwireguardconfig.h"
+#include "types/global_consts.h"
 #include "utils/extraconfig.h"
 #include "utils/ipvalidation.h"
 #include "utils/logger.h"
+#include "utils/simplecrypt.h"
 #include "utils/ws_assert.h"
 
+namespace {
+
+// the protocols which did not answer the reachability race, per network
+struct NetworkReachability
+{
+    qint64 time = 0;    // msecs since epoch
+    QVector<types::Protocol> unreachableProtocols;
+};
+
+const QString kReachabilitySettingsKey = "reachabilityRaceResults";
+constexpr quint32 kReachabilityMagic = 0x52A7C913;
+constexpr quint32 kReachabilityVersionForSerialization = 1;  // should increment the version if the data format is changed
+
+QMap<QString, NetworkReachability> loadReachability()
+{
+    QMap<QString, NetworkReachability> results;
+
+    QSettings settings;
+    if (!settings.contains(kReachabilitySettingsKey)) {
+        return results;
+    }
+
+    SimpleCrypt simpleCrypt(SIMPLE_CRYPT_KEY);
+    QByteArray arr = simpleCrypt.decryptToByteArray(settings.value(kReachabilitySettingsKey).toString());
+
+    QDataStream ds(&arr, QIODevice::ReadOnly);
+    quint32 magic, version;
+    ds >> magic;
+    if (magic != kReachabilityMagic) {
+        return results;
+    }
+    ds >> version;
+    if (version != kReachabilityVersionForSerialization) {
+        return results;
+    }
+
+    qsizetype count;
+    ds >> count;
+    for (qsizetype i = 0; i < count && ds.status() == QDataStream::Ok; ++i) {
+        QString networkOrSsid;
+        NetworkReachability nr;
+        ds >> networkOrSsid >> nr.time >> nr.unreachableProtocols;
+        results[networkOrSsid] = nr;
+    }
+
+    if (ds.status() != QDataStream::Ok) {
+        results.clear();
+    }
+    return results;
+}
+
+void saveReachability(const QMap<QString, NetworkReachability> &results)
+{
+    QByteArray arr;
+    {
+        QDataStream ds(&arr, QIODevice::WriteOnly);
+        ds << kReachabilityMagic;
+        ds << kReachabilityVersionForSerialization;
+        ds << results.size();
+        for (auto it = results.cbegin(); it != results.cend(); ++it) {
+            ds << it.key() << it.value().time << it.value().unreachableProtocols;
+        }
+    }
+
+    QSettings settings;
+    SimpleCrypt simpleCrypt(SIMPLE_CRYPT_KEY);
+    settings.setValue(kReachabilitySettingsKey, simpleCrypt.encryptToString(arr));
+}
+
+QString reachabilityResultToString(ReachabilityRace::Result result)
+{
+    switch (result) {
+    case ReachabilityRace::Result::kAnswered:
+        return "answered";
+    case ReachabilityRace::Result::kFailed:
+        return "failed";
+    default:
+        return "unknown";
+    }
+}
+
+} // namespace
+
 types::Protocol AutoConnSettingsPolicy::lastKnownGoodProtocol_;
 
 AutoConnSettingsPolicy::AutoConnSettingsPolicy(QSharedPointer<locationsmodel::BaseLocationInfo> bli,
                                                const api_responses::PortMap &portMap, bool isProxyEnabled,
-                                               const types::Protocol protocol, bool isLockdownMode)
+                                               const types::Protocol protocol, bool isLockdownMode, const QString &networkOrSsid)
 {
     attempts_.clear();
     curAttempt_ = 0;
     bIsAllFailed_ = false;
+    isProxyEnabled_ = isProxyEnabled;
+    networkOrSsid_ = networkOrSsid;
     portMap_ = portMap;
     locationInfo_ = qSharedPointerDynamicCast<locationsmodel::MutableLocationInfo>(bli);
     WS_ASSERT(!locationInfo_.isNull());
@@ -100,6 +191,21 @@ void AutoConnSettingsPolicy::putFailedConnection()
     }
 }
 
+void AutoConnSettingsPolicy::putSuccessfulConnection()
+{
+    if (!bStarted_ || networkOrSsid_.isEmpty()) {
+        return;
+    }
+
+    const types::Protocol protocol = attempts_[curAttempt_].protocol;
+    QMap<QString, NetworkReachability> saved = loadReachability();
+    auto it = saved.find(networkOrSsid_);
+    if (it != saved.end() && it->unreachableProtocols.removeAll(protocol) > 0) {
+        qCDebug(LOG_CONNECTION) << "Connected with" << protocol.toLongString() << ", it is not unreachable on this network anymore";
+        saveReachability(saved);
+    }
+}
+
 bool AutoConnSettingsPolicy::isFailed() const
 {
     if (!bStarted_) {
@@ -198,3 +304,140 @@ bool AutoConnSettingsPolicy::hasProtocolChanged()
 {
     return (curAttempt_ % 2 == 0);
 }
+
+void AutoConnSettingsPolicy::checkReachability()
+{
+    stopReachabilityCheck();
+
+    // the probes go straight to the node: not through the proxy, and not to the endpoints of static IPs or the remote override
+    if (isProxyEnabled_ || locationInfo_->locationId().isStaticIpsLocation() ||
+        !ExtraConfig::instance().getRemoteIpFromExtraConfig().isEmpty() || attempts_.size() <= 2) {
+        emit reachabilityChecked();
+        return;
+    }
+
+    if (!networkOrSsid_.isEmpty()) {
+        const QMap<QString, NetworkReachability> results = loadReachability();
+        const auto it = results.constFind(networkOrSsid_);
+        if (it != results.cend() && QDateTime::currentMSecsSinceEpoch() - it->time < kReachabilityLifetimeMs) {
+            // an older result does not outweigh a connection made since, the last known good protocol stays first
+            QVector<types::Protocol> unreachableProtocols = it->unreachableProtocols;
+            unreachableProtocols.removeAll(lastKnownGoodProtocol_);
+            qCDebug(LOG_CONNECTION) << "Using the reachability of the protocols checked before on this network, unreachable:"
+                                    << unreachableProtocols.size();
+            moveProtocolsToEnd(unreachableProtocols);
+            emit reachabilityChecked();
+            return;
+        }
+    }
+
+    if (!reachabilityRace_) {
+        reachabilityRace_ = new ReachabilityRace(this);
+        connect(reachabilityRace_, &ReachabilityRace::finished, this, &AutoConnSettingsPolicy::onReachabilityRaceFinished);
+    }
+    const QVector<ReachabilityRace::Probe> probes = reachabilityProbes();
+    QStringList ips;
+    for (const auto &probe : probes) {
+        if (!ips.contains(probe.ip))
+            ips << probe.ip;
+    }
+    // the firewall may be on already, the probes must not be blocked by it
+    emit reachabilityIpsChanged(ips);
+    qCDebug(LOG_CONNECTION) << "Checking the reachability of the protocols";
+    reachabilityRace_->start(probes, kReachabilityRaceTimeoutMs);
+}
+
+void AutoConnSettingsPolicy::stopReachabilityCheck()
+{
+    if (reachabilityRace_ && reachabilityRace_->isRunning()) {
+        reachabilityRace_->stop();
+        emit reachabilityIpsChanged(QStringList());
+    }
+}
+
+void AutoConnSettingsPolicy::onReachabilityRaceFinished(const QVector<ReachabilityRace::ProbeResult> &results)
+{
+    emit reachabilityIpsChanged(QStringList());
+
+    QVector<types::Protocol> unreachableProtocols;
+    bool isAnyAnswered = false;
+    QStringList log;
+    for (const auto &r : results) {
+        QString str = r.protocol.toLongString() + " " + reachabilityResultToString(r.result);
+        if (r.result == ReachabilityRace::Result::kAnswered) {
+            str += " in " + QString::number(r.answerTimeMs) + " ms";
+            isAnyAnswered = true;
+        } else if (r.result == ReachabilityRace::Result::kFailed) {
+            unreachableProtocols << r.protocol;
+        }
+        log << str;
+    }
+    qCDebug(LOG_CONNECTION) << "Reachability race:" << log.join(", ");
+
+    // nothing answered: the node itself or the whole network is down, which says nothing about the protocols
+    if (!isAnyAnswered) {
+        qCDebug(LOG_CONNECTION) << "No protocol answered the reachability race, the order of the protocols is kept";
+        emit reachabilityChecked();
+        return;
+    }
+
+    moveProtocolsToEnd(unreachableProtocols);
+
+    if (!networkOrSsid_.isEmpty()) {
+        QMap<QString, NetworkReachability> saved = loadReachability();
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        for (auto it = saved.begin(); it != saved.end(); ) {
+            if (now - it->time >= kReachabilityLifetimeMs)
+                it = saved.erase(it);
+            else
+                ++it;
+        }
+        NetworkReachability nr;
+        nr.time = now;
+        nr.unreachableProtocols = unreachableProtocols;
+        saved[networkOrSsid_] = nr;
+        saveReachability(saved);
+    }
+
+    emit reachabilityChecked();
+}
+
+QVector<ReachabilityRace::Probe> AutoConnSettingsPolicy::reachabilityProbes() const
+{
+    QString publicKey, privateKey;
+    GetWireGuardConfig getWireGuardConfig(nullptr);
+    getWireGuardConfig.getWireGuardKeyPair(publicKey, privateKey);
+
+    QVector<ReachabilityRace::Probe> probes;
+    // even indices are the first attempt of each protocol
+    for (int i = 0; i < attempts_.size(); i += 2) {
+        ReachabilityRace::Probe probe;
+        probe.protocol = attempts_[i].protocol;
+        probe.ip = locationInfo_->getIpForSelectedNode(portMap_.getUseIpInd(probe.protocol));
+        probe.port = portMap_.const_items()[attempts_[i].portMapInd].ports[0];
+        probe.hostname = locationInfo_->getHostnameForSelectedNode();
+        if (probe.protocol == types::Protocol::WIREGUARD) {
+            probe.wgPrivateKey = QByteArray::fromBase64(privateKey.toLatin1());
+            probe.wgPeerPublicKey = QByteArray::fromBase64(locationInfo_->getWgPubKeyForSelectedNode().toLatin1());
+        }
+        probes << probe;
+    }
+    return probes;
+}
+
+void AutoConnSettingsPolicy::moveProtocolsToEnd(const QVector<types::Protocol> &protocols)
+{
+    if (protocols.isEmpty()) {
+        return;
+    }
+
+    QVector<AttemptInfo> reachable;
+    QVector<AttemptInfo> unreachable;
+    for (const auto &attempt : qAsConst(attempts_)) {
+        if (protocols.contains(attempt.protocol))
+            unreachable << attempt;
+        else
+            reachable << attempt;
+    }
+    attempts_ = reachable + unreachable;
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "baseconnsettingspolicy.h"
+#include "engine/connectionmanager/reachabilityrace.h"
 #include "engine/locationsmodel/mutablelocationinfo.h"
 #include "api_responses/portmap.h"
 
@@ -10,17 +11,26 @@ class AutoConnSettingsPolicy : public BaseConnSettingsPolicy
     Q_OBJECT
 public:
     AutoConnSettingsPolicy(QSharedPointer<locationsmodel::BaseLocationInfo> bli, const api_responses::PortMap &portMap, bool isProxyEnabled,
-                           const types::Protocol protocol, bool isLockdownMode);
+                           const types::Protocol protocol, bool isLockdownMode, const QString &networkOrSsid);
 
     void reset() override;
     void debugLocationInfoToLog() const override;
     void putFailedConnection() override;
+    // the protocol is reachable on this network again, whatever the race found before
+    void putSuccessfulConnection() override;
     bool isFailed() const override;
     CurrentConnectionDescr getCurrentConnectionSettings() const override;
     bool isAutomaticMode() override;
     bool isCustomConfig() override;
     void resolveHostnames() override;
     bool hasProtocolChanged() override;
+    // races the protocols to the selected node and moves the ones which did not answer to the end;
+    // the result is kept per network for kReachabilityLifetimeMs
+    void checkReachability() override;
+    void stopReachabilityCheck() override;
+
+private slots:
+    void onReachabilityRaceFinished(const QVector<ReachabilityRace::ProbeResult> &results);
 
 private:
     struct AttemptInfo
@@ -36,9 +46,18 @@ private:
     QSharedPointer<locationsmodel::MutableLocationInfo> locationInfo_;
     api_responses::PortMap portMap_;
     bool bIsAllFailed_;
+    bool isProxyEnabled_;
+    QString networkOrSsid_;
+    ReachabilityRace *reachabilityRace_ = nullptr;
 
     static types::Protocol lastKnownGoodProtocol_;
     static uint lastKnownGoodPort_;
 
+    static constexpr int kReachabilityRaceTimeoutMs = 2000;
+    static constexpr qint64 kReachabilityLifetimeMs = 24 * 60 * 60 * 1000;
+
     QVector<types::ProtocolStatus> protocolStatus();
+    QVector<ReachabilityRace::Probe> reachabilityProbes() const;
+    // keeps the order otherwise, and the two attempts of a protocol together
+    void moveProtocolsToEnd(const QVector<types::Protocol> &protocols);
 };
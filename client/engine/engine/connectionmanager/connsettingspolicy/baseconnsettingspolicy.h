@@ -1,5 +1,6 @@
 #pragma once
 
+#include <QStringList>
 #include <QVector>
 #include "api_responses/staticips.h"
 #include "types/protocolstatus.h"
@@ -62,16 +63,25 @@ public:
     virtual void reset() = 0;
     virtual void debugLocationInfoToLog() const = 0;
     virtual void putFailedConnection() = 0;
+    // the current attempt has connected
+    virtual void putSuccessfulConnection() = 0;
     virtual bool isFailed() const = 0;
     virtual CurrentConnectionDescr getCurrentConnectionSettings() const = 0;
     virtual bool isAutomaticMode() = 0;
     virtual bool isCustomConfig() = 0;
     virtual void resolveHostnames() = 0;
     virtual bool hasProtocolChanged() = 0;
+    // called once before the first attempt, may reorder the attempts
+    virtual void checkReachability() = 0;
+    // stops a check in progress, reachabilityChecked() is not emitted for it
+    virtual void stopReachabilityCheck() = 0;
 
 signals:
     void protocolStatusChanged(const QVector<types::ProtocolStatus> &status);
     void hostnamesResolved();
+    void reachabilityChecked();
+    // the IPs probed by the reachability check, which the firewall has to allow while it runs; empty when it is over
+    void reachabilityIpsChanged(const QStringList &ips);
 
 protected:
     bool bStarted_;
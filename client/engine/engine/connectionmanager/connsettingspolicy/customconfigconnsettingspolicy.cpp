@@ -30,6 +30,11 @@ void CustomConfigConnSettingsPolicy::putFailedConnection()
     locationInfo_->selectNextNode();
 }
 
+void CustomConfigConnSettingsPolicy::putSuccessfulConnection()
+{
+    // nothing todo
+}
+
 bool CustomConfigConnSettingsPolicy::isFailed() const
 {
     return false;
@@ -79,4 +84,15 @@ void CustomConfigConnSettingsPolicy::onHostnamesResolved()
 bool CustomConfigConnSettingsPolicy::hasProtocolChanged()
 {
     return false;
-}
\ No newline at end of file
+}
+
+void CustomConfigConnSettingsPolicy::checkReachability()
+{
+    // the remotes of a custom config are tried by the connection itself
+    emit reachabilityChecked();
+}
+
+void CustomConfigConnSettingsPolicy::stopReachabilityCheck()
+{
+    // nothing todo, the check is done right away
+}
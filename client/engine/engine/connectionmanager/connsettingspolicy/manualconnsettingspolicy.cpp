@@ -51,6 +51,11 @@ void ManualConnSettingsPolicy::putFailedConnection()
     }
 }
 
+void ManualConnSettingsPolicy::putSuccessfulConnection()
+{
+    // nothing todo
+}
+
 bool ManualConnSettingsPolicy::isFailed() const
 {
     return false;
@@ -108,3 +113,14 @@ bool ManualConnSettingsPolicy::hasProtocolChanged()
 {
     return false;
 }
+
+void ManualConnSettingsPolicy::checkReachability()
+{
+    // nothing todo, there is only one protocol
+    emit reachabilityChecked();
+}
+
+void ManualConnSettingsPolicy::stopReachabilityCheck()
+{
+    // nothing todo, the check is done right away
+}
@@ -17,12 +17,15 @@ public:
     void reset() override;
     void debugLocationInfoToLog() const override;
     void putFailedConnection() override;
+    void putSuccessfulConnection() override;
     bool isFailed() const override;
     CurrentConnectionDescr getCurrentConnectionSettings() const override;
     bool isAutomaticMode() override;
     bool isCustomConfig() override;
     void resolveHostnames() override;
     bool hasProtocolChanged() override;
+    void checkReachability() override;
+    void stopReachabilityCheck() override;
 
 private:
     QSharedPointer<locationsmodel::MutableLocationInfo> locationInfo_;
@@ -1,6 +1,7 @@
 #include <QStringRef>
 
 #include "openvpnconnection.h"
+#include "connectiontracer.h"
 #include "utils/ws_assert.h"
 #include "utils/crashhandler.h"
 #include "utils/logger.h"
@@ -157,7 +158,11 @@ IHelper::ExecuteError OpenVPNConnection::runOpenVPN(unsigned int port, const typ
 
     qCDebug(LOG_CONNECTION) << "OpenVPN version:" << OpenVpnVersionController::instance().getOpenVpnVersion();
 
-    return helper_->executeOpenVPN(config_, port, httpProxy, httpPort, socksProxy, socksPort, outCmdId, isCustomConfig);
+    ConnectionTracer::Scope span("helper.executeOpenVPN");
+    IHelper::ExecuteError err = helper_->executeOpenVPN(config_, port, httpProxy, httpPort, socksProxy, socksPort, outCmdId, isCustomConfig);
+    if (err != IHelper::EXECUTE_SUCCESS)
+        span.setFailed();
+    return err;
 }
 
 void OpenVPNConnection::run()
@@ -228,6 +233,7 @@ void OpenVPNConnection::funcRunOpenVPN()
     }
 
     qCDebug(LOG_CONNECTION) << "openvpn process runned: " << stateVariables_.openVpnPort;
+    ConnectionTracer::instance().beginSpan("openvpnSocketConnect");
 
     boost::asio::ip::tcp::endpoint endpoint;
     endpoint.port(stateVariables_.openVpnPort);
@@ -242,6 +248,7 @@ void OpenVPNConnection::funcConnectToOpenVPN(const boost::system::error_code& er
     if (err.value() == 0)
     {
         qCDebug(LOG_CONNECTION) << "Program connected to openvpn socket";
+        ConnectionTracer::instance().endSpan("openvpnSocketConnect");
         helper_->suspendUnblockingCmd(stateVariables_.lastCmdId);
         setCurrentState(STATUS_CONNECTED_TO_SOCKET);
         stateVariables_.buffer.reset(new boost::asio::streambuf());
@@ -263,6 +270,7 @@ void OpenVPNConnection::funcConnectToOpenVPN(const boost::system::error_code& er
         {
             qCDebug(LOG_CONNECTION) << "Can't connect to openvpn socket during"
                                     << (MAX_WAIT_OPENVPN_ON_START/1000) << "secs";
+            ConnectionTracer::instance().endSpan("openvpnSocketConnect", false);
             helper_->clearUnblockingCmd(stateVariables_.lastCmdId);
             setCurrentStateAndEmitError(STATUS_DISCONNECTED, CONNECT_ERROR::NO_OPENVPN_SOCKET);
             return;
@@ -277,6 +285,7 @@ void OpenVPNConnection::funcConnectToOpenVPN(const boost::system::error_code& er
         {
             qCDebug(LOG_CONNECTION) << "openvpn process finished before connected to openvpn socket";
             qCDebug(LOG_CONNECTION) << "answer from openvpn process, answer =" << logStr;
+            ConnectionTracer::instance().endSpan("openvpnSocketConnect", false);
 
             if (bStopThread_)
             {
@@ -300,6 +309,7 @@ void OpenVPNConnection::funcConnectToOpenVPN(const boost::system::error_code& er
             }
         }
 
+        ConnectionTracer::instance().addInstant("openvpnSocketConnectRetry");
         boost::asio::ip::tcp::endpoint endpoint;
         endpoint.port(stateVariables_.openVpnPort);
         endpoint.address(boost::asio::ip::address_v4::from_string("127.0.0.1"));
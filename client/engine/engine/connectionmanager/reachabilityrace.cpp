@@ -0,0 +1,422 @@
+#include "reachabilityrace.h"
+
+#include <QDateTime>
+#include <QHostAddress>
+#include <QRandomGenerator>
+#include <QTcpSocket>
+#include <QUdpSocket>
+#include <QtEndian>
+#include <openssl/core_names.h>
+#include <openssl/rand.h>
+
+#include "utils/openssl_utils.h"
+
+namespace {
+
+// the primitives of the WireGuard handshake, see the "Protocol & Cryptography" section of the WireGuard paper
+const int kWgKeyLen = 32;
+const int kWgMacLen = 16;
+const int kAeadTagLen = 16;
+
+QByteArray blake2s(const QByteArray &data)
+{
+    unsigned char out[EVP_MAX_MD_SIZE];
+    unsigned int outLen = 0;
+    if (EVP_Digest(data.constData(), data.size(), out, &outLen, EVP_blake2s256(), nullptr) != 1)
+        return QByteArray();
+    return QByteArray((const char *)out, outLen);
+}
+
+// HMAC-BLAKE2s for the KDF (isHmac), otherwise keyed BLAKE2s with a 16 byte output for mac1
+QByteArray mac(bool isHmac, const QByteArray &key, const QByteArray &data)
+{
+    EVP_MAC *evpMac = EVP_MAC_fetch(nullptr, isHmac ? "HMAC" : "BLAKE2SMAC", nullptr);
+    if (!evpMac)
+        return QByteArray();
+    EVP_MAC_CTX *ctx = EVP_MAC_CTX_new(evpMac);
+
+    size_t size = kWgMacLen;
+    char digest[] = "BLAKE2S-256";
+    OSSL_PARAM params[2];
+    params[0] = isHmac ? OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest, 0)
+                       : OSSL_PARAM_construct_size_t(OSSL_MAC_PARAM_SIZE, &size);
+    params[1] = OSSL_PARAM_construct_end();
+
+    unsigned char out[EVP_MAX_MD_SIZE];
+    size_t outLen = 0;
+    bool isOk = ctx && EVP_MAC_init(ctx, (const unsigned char *)key.constData(), key.size(), params) == 1 &&
+                EVP_MAC_update(ctx, (const unsigned char *)data.constData(), data.size()) == 1 &&
+                EVP_MAC_final(ctx, out, &outLen, sizeof(out)) == 1;
+
+    EVP_MAC_CTX_free(ctx);
+    EVP_MAC_free(evpMac);
+    return isOk ? QByteArray((const char *)out, outLen) : QByteArray();
+}
+
+// KDF_n: HKDF with HMAC-BLAKE2s, returns n keys
+QVector<QByteArray> kdf(const QByteArray &key, const QByteArray &input, int n)
+{
+    QVector<QByteArray> keys;
+    const QByteArray prk = mac(true, key, input);
+    QByteArray prev;
+    for (int i = 1; i <= n; ++i) {
+        prev = mac(true, prk, prev + char(i));
+        keys << prev;
+    }
+    return keys;
+}
+
+QByteArray x25519PublicKey(const QByteArray &privateKey)
+{
+    wsl::EvpPkey key;
+    *key.ppkey() = EVP_PKEY_new_raw_private_key(EVP_PKEY_X25519, nullptr, (const unsigned char *)privateKey.constData(), privateKey.size());
+    unsigned char out[kWgKeyLen];
+    size_t outLen = sizeof(out);
+    if (!key.isValid() || EVP_PKEY_get_raw_public_key(key.pkey(), out, &outLen) != 1)
+        return QByteArray();
+    return QByteArray((const char *)out, outLen);
+}
+
+QByteArray x25519(const QByteArray &privateKey, const QByteArray &publicKey)
+{
+    wsl::EvpPkey key, peerKey;
+    *key.ppkey() = EVP_PKEY_new_raw_private_key(EVP_PKEY_X25519, nullptr, (const unsigned char *)privateKey.constData(), privateKey.size());
+    *peerKey.ppkey() = EVP_PKEY_new_raw_public_key(EVP_PKEY_X25519, nullptr, (const unsigned char *)publicKey.constData(), publicKey.size());
+    if (!key.isValid() || !peerKey.isValid())
+        return QByteArray();
+
+    wsl::EvpPkeyCtx ctx(EVP_PKEY_CTX_new(key.pkey(), nullptr));
+    unsigned char out[kWgKeyLen];
+    size_t outLen = sizeof(out);
+    if (!ctx.isValid() || EVP_PKEY_derive_init(ctx.context()) != 1 || EVP_PKEY_derive_set_peer(ctx.context(), peerKey.pkey()) != 1 ||
+        EVP_PKEY_derive(ctx.context(), out, &outLen) != 1) {
+        return QByteArray();
+    }
+    return QByteArray((const char *)out, outLen);
+}
+
+// ChaCha20-Poly1305 with the nonce counter 0, the only one used by the initiation
+QByteArray aead(const QByteArray &key, const QByteArray &plaintext, const QByteArray &authData)
+{
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    const unsigned char nonce[12] = {};
+    QByteArray out(plaintext.size() + kAeadTagLen, 0);
+    unsigned char *outData = (unsigned char *)out.data();
+    int len = 0, finalLen = 0;
+    bool isOk = ctx && EVP_EncryptInit_ex(ctx, EVP_chacha20_poly1305(), nullptr, (const unsigned char *)key.constData(), nonce) == 1 &&
+                EVP_EncryptUpdate(ctx, nullptr, &len, (const unsigned char *)authData.constData(), authData.size()) == 1 &&
+                EVP_EncryptUpdate(ctx, outData, &len, (const unsigned char *)plaintext.constData(), plaintext.size()) == 1 &&
+                EVP_EncryptFinal_ex(ctx, outData + len, &finalLen) == 1 &&
+                EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, kAeadTagLen, outData + plaintext.size()) == 1;
+    EVP_CIPHER_CTX_free(ctx);
+    return isOk ? out : QByteArray();
+}
+
+QByteArray tai64n()
+{
+    const qint64 ms = QDateTime::currentMSecsSinceEpoch();
+    QByteArray out(12, 0);
+    qToBigEndian<quint64>(0x400000000000000aULL + ms / 1000, out.data());
+    qToBigEndian<quint32>((ms % 1000) * 1000000, out.data() + 8);
+    return out;
+}
+
+void appendUint16(QByteArray &arr, quint16 value)
+{
+    arr.append(char(value >> 8));
+    arr.append(char(value & 0xFF));
+}
+
+// prepends the length of the data in 2 or 3 bytes, as used in the TLS structures
+QByteArray withLength(const QByteArray &data, int lengthBytes = 2)
+{
+    QByteArray out;
+    if (lengthBytes == 3)
+        out.append(char((data.size() >> 16) & 0xFF));
+    appendUint16(out, data.size());
+    return out + data;
+}
+
+QByteArray randomBytes(int count)
+{
+    QByteArray out(count, 0);
+    QRandomGenerator::system()->fillRange((quint32 *)out.data(), count / sizeof(quint32));
+    return out;
+}
+
+} // namespace
+
+ReachabilityRace::ReachabilityRace(QObject *parent) : QObject(parent)
+{
+    timer_.setSingleShot(true);
+    graceTimer_.setSingleShot(true);
+    connect(&timer_, &QTimer::timeout, this, &ReachabilityRace::onTimeout);
+    connect(&graceTimer_, &QTimer::timeout, this, &ReachabilityRace::onGraceTimeout);
+}
+
+ReachabilityRace::~ReachabilityRace()
+{
+    closeSockets();
+}
+
+void ReachabilityRace::start(const QVector<Probe> &probes, int timeoutMs)
+{
+    stop();
+    elapsed_.start();
+
+    probes_.resize(probes.size());
+    for (int i = 0; i < probes.size(); ++i)
+        probes_[i].result.protocol = probes[i].protocol;
+
+    // a socket can fail right away, the results are checked after all the probes have started
+    isStarting_ = true;
+    for (int i = 0; i < probes.size(); ++i)
+        startProbe(i, probes[i]);
+    isStarting_ = false;
+
+    timer_.start(timeoutMs);
+    finishIfDone();
+}
+
+void ReachabilityRace::stop()
+{
+    timer_.stop();
+    graceTimer_.stop();
+    closeSockets();
+    probes_.clear();
+}
+
+bool ReachabilityRace::isRunning() const
+{
+    return !probes_.isEmpty();
+}
+
+QByteArray ReachabilityRace::makeWireGuardInitiation(const QByteArray &privateKey, const QByteArray &peerPublicKey, quint32 senderIndex)
+{
+    if (privateKey.size() != kWgKeyLen || peerPublicKey.size() != kWgKeyLen)
+        return QByteArray();
+
+    const QByteArray publicKey = x25519PublicKey(privateKey);
+    QByteArray ephemeralPrivateKey(kWgKeyLen, 0);
+    if (RAND_bytes((unsigned char *)ephemeralPrivateKey.data(), ephemeralPrivateKey.size()) != 1)
+        return QByteArray();
+    const QByteArray ephemeralPublicKey = x25519PublicKey(ephemeralPrivateKey);
+    const QByteArray dhEphemeralStatic = x25519(ephemeralPrivateKey, peerPublicKey);
+    const QByteArray dhStaticStatic = x25519(privateKey, peerPublicKey);
+    if (publicKey.isEmpty() || ephemeralPublicKey.isEmpty() || dhEphemeralStatic.isEmpty() || dhStaticStatic.isEmpty())
+        return QByteArray();
+
+    QByteArray chainingKey = blake2s("Noise_IKpsk2_25519_ChaChaPoly_BLAKE2s");
+    QByteArray hash = blake2s(blake2s(chainingKey + "WireGuard v1 zx2c4 Jason@zx2c4.com") + peerPublicKey);
+
+    chainingKey = kdf(chainingKey, ephemeralPublicKey, 1)[0];
+    hash = blake2s(hash + ephemeralPublicKey);
+
+    QVector<QByteArray> keys = kdf(chainingKey, dhEphemeralStatic, 2);
+    chainingKey = keys[0];
+    const QByteArray encryptedStatic = aead(keys[1], publicKey, hash);
+    hash = blake2s(hash + encryptedStatic);
+
+    keys = kdf(chainingKey, dhStaticStatic, 2);
+    const QByteArray encryptedTimestamp = aead(keys[1], tai64n(), hash);
+    if (encryptedStatic.isEmpty() || encryptedTimestamp.isEmpty())
+        return QByteArray();
+
+    QByteArray packet(8, 0);
+    packet[0] = 1;      // the message type, then 3 reserved bytes
+    qToLittleEndian<quint32>(senderIndex, packet.data() + 4);
+    packet += ephemeralPublicKey + encryptedStatic + encryptedTimestamp;
+    const QByteArray mac1 = mac(false, blake2s("mac1----" + peerPublicKey), packet);
+    if (mac1.size() != kWgMacLen)
+        return QByteArray();
+    packet += mac1;
+    packet += QByteArray(kWgMacLen, 0);    // mac2, there is no cookie
+    return packet;
+}
+
+QByteArray ReachabilityRace::makeTlsClientHello(const QString &serverName)
+{
+    // a TLS 1.2 ClientHello with the usual cipher suites and extensions, so that it looks like the one of a real client
+    static const quint16 kCipherSuites[] = { 0xc02b, 0xc02f, 0xc02c, 0xc030, 0xcca9, 0xcca8, 0xc013, 0xc014, 0x009c, 0x009d, 0x002f, 0x0035 };
+    static const quint16 kGroups[] = { 0x001d, 0x0017, 0x0018 };
+    static const quint16 kSignatureAlgorithms[] = { 0x0403, 0x0804, 0x0401, 0x0503, 0x0805, 0x0501, 0x0806, 0x0601 };
+
+    QByteArray cipherSuites, groups, signatureAlgorithms;
+    for (quint16 suite : kCipherSuites)
+        appendUint16(cipherSuites, suite);
+    for (quint16 group : kGroups)
+        appendUint16(groups, group);
+    for (quint16 algorithm : kSignatureAlgorithms)
+        appendUint16(signatureAlgorithms, algorithm);
+
+    QByteArray extensions;
+    const QByteArray name = serverName.toLatin1();
+    if (!name.isEmpty()) {
+        appendUint16(extensions, 0x0000);   // server_name
+        extensions += withLength(withLength(char(0) + withLength(name)));
+    }
+    appendUint16(extensions, 0x000a);       // supported_groups
+    extensions += withLength(withLength(groups));
+    appendUint16(extensions, 0x000b);       // ec_point_formats: uncompressed
+    extensions += withLength(QByteArray::fromHex("0100"));
+    appendUint16(extensions, 0x000d);       // signature_algorithms
+    extensions += withLength(withLength(signatureAlgorithms));
+    appendUint16(extensions, 0xff01);       // renegotiation_info
+    extensions += withLength(QByteArray(1, 0));
+
+    QByteArray hello = QByteArray::fromHex("0303");     // the client version, TLS 1.2
+    hello += randomBytes(32);
+    hello += char(32) + randomBytes(32);                // the session id
+    hello += withLength(cipherSuites);
+    hello += QByteArray::fromHex("0100");               // the compression methods: none
+    hello += withLength(extensions);
+
+    const QByteArray handshake = char(1) + withLength(hello, 3);    // client_hello
+    return QByteArray::fromHex("160301") + withLength(handshake);
+}
+
+void ReachabilityRace::onTimeout()
+{
+    finish(true);
+}
+
+void ReachabilityRace::onGraceTimeout()
+{
+    finish(true);
+}
+
+void ReachabilityRace::startProbe(int ind, const Probe &probe)
+{
+    RunningProbe &rp = probes_[ind];
+
+    if (probe.protocol == types::Protocol::WIREGUARD) {
+        rp.wgSenderIndex = QRandomGenerator::global()->generate();
+        const QByteArray packet = makeWireGuardInitiation(probe.wgPrivateKey, probe.wgPeerPublicKey, rp.wgSenderIndex);
+        if (packet.isEmpty()) {
+            rp.isDone = true;
+            return;
+        }
+        QUdpSocket *socket = new QUdpSocket(this);
+        rp.socket = socket;
+        connect(socket, &QUdpSocket::connected, this, [socket, packet]() { socket->write(packet); });
+        connect(socket, &QUdpSocket::readyRead, this, [this, ind]() { onWireGuardAnswer(ind); });
+        // e.g. an ICMP port unreachable
+        connect(socket, &QUdpSocket::errorOccurred, this, [this, ind]() { setResult(ind, Result::kFailed); });
+    } else if (probe.protocol == types::Protocol::OPENVPN_TCP) {
+        QTcpSocket *socket = new QTcpSocket(this);
+        rp.socket = socket;
+        connect(socket, &QTcpSocket::connected, this, [this, ind]() { setResult(ind, Result::kAnswered); });
+        connect(socket, &QTcpSocket::errorOccurred, this, [this, ind]() { setResult(ind, Result::kFailed); });
+    } else if (probe.protocol.isStunnelOrWStunnelProtocol()) {
+        QTcpSocket *socket = new QTcpSocket(this);
+        rp.socket = socket;
+        const QByteArray clientHello = makeTlsClientHello(probe.hostname);
+        connect(socket, &QTcpSocket::connected, this, [socket, clientHello]() { socket->write(clientHello); });
+        connect(socket, &QTcpSocket::readyRead, this, [this, ind]() { onTlsAnswer(ind); });
+        // a reset right after the ClientHello is the usual way the server name is blocked
+        connect(socket, &QTcpSocket::errorOccurred, this, [this, ind]() { setResult(ind, Result::kFailed); });
+    } else {
+        // OpenVPN UDP and IKEv2 servers do not answer a packet that can be made without a real handshake
+        rp.isDone = true;
+        return;
+    }
+
+    rp.socket->connectToHost(QHostAddress(probe.ip), probe.port);
+}
+
+void ReachabilityRace::onWireGuardAnswer(int ind)
+{
+    QUdpSocket *socket = static_cast<QUdpSocket *>(probes_[ind].socket);
+    while (socket->hasPendingDatagrams()) {
+        QByteArray datagram(qMax<qint64>(socket->pendingDatagramSize(), 0), 0);
+        socket->readDatagram(datagram.data(), datagram.size());
+        if (datagram.size() < 12 || datagram[1] != 0 || datagram[2] != 0 || datagram[3] != 0)
+            continue;
+        // a handshake response (type 2) has our index after its own, a cookie reply (type 3) right after the type
+        const char type = datagram[0];
+        const int indexOffset = (type == 2) ? 8 : (type == 3 ? 4 : -1);
+        if (indexOffset > 0 && qFromLittleEndian<quint32>(datagram.constData() + indexOffset) == probes_[ind].wgSenderIndex) {
+            setResult(ind, Result::kAnswered);
+            return;
+        }
+    }
+}
+
+void ReachabilityRace::onTlsAnswer(int ind)
+{
+    char contentType = 0;
+    if (probes_[ind].socket->peek(&contentType, 1) != 1)
+        return;
+    // a handshake (ServerHello) or an alert record; anything else is not the TLS server we expect
+    setResult(ind, (contentType == 0x16 || contentType == 0x15) ? Result::kAnswered : Result::kFailed);
+}
+
+void ReachabilityRace::setResult(int ind, Result result)
+{
+    if (ind >= probes_.size() || probes_[ind].isDone)
+        return;
+
+    RunningProbe &rp = probes_[ind];
+    rp.isDone = true;
+    rp.result.result = result;
+    if (result == Result::kAnswered)
+        rp.result.answerTimeMs = elapsed_.elapsed();
+    if (rp.socket)
+        rp.socket->abort();
+
+    finishIfDone();
+}
+
+void ReachabilityRace::finishIfDone()
+{
+    if (isStarting_ || probes_.isEmpty())
+        return;
+
+    bool isAllDone = true;
+    qint64 firstAnswerMs = -1;
+    for (const auto &rp : qAsConst(probes_)) {
+        if (!rp.isDone)
+            isAllDone = false;
+        if (rp.result.result == Result::kAnswered && (firstAnswerMs < 0 || rp.result.answerTimeMs < firstAnswerMs))
+            firstAnswerMs = rp.result.answerTimeMs;
+    }
+
+    // when the preferred protocol answered, the results of the others would not change which one is tried first
+    if (isAllDone || probes_[0].result.result == Result::kAnswered) {
+        finish(false);
+    } else if (firstAnswerMs >= 0 && !graceTimer_.isActive()) {
+        graceTimer_.start(qMax<qint64>(kMinGraceMs, 2 * firstAnswerMs));
+    }
+}
+
+void ReachabilityRace::finish(bool isPendingFailed)
+{
+    bool isAnyAnswered = false;
+    for (const auto &rp : qAsConst(probes_))
+        isAnyAnswered |= (rp.result.result == Result::kAnswered);
+
+    QVector<ProbeResult> results;
+    for (const auto &rp : qAsConst(probes_)) {
+        ProbeResult result = rp.result;
+        // without any answer the server itself may be down; the handshakes of unknown keys are dropped silently,
+        // so no answer from WireGuard means nothing
+        if (!rp.isDone && isPendingFailed && isAnyAnswered && result.protocol != types::Protocol::WIREGUARD)
+            result.result = Result::kFailed;
+        results << result;
+    }
+
+    stop();
+    emit finished(results);
+}
+
+void ReachabilityRace::closeSockets()
+{
+    for (auto &rp : probes_) {
+        if (rp.socket) {
+            rp.socket->disconnect(this);
+            rp.socket->abort();
+            rp.socket->deleteLater();
+            rp.socket = nullptr;
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <QAbstractSocket>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+#include "types/protocol.h"
+
+// Checks in parallel which protocols can reach a server before the first connection attempt, so that the automatic
+// mode does not have to wait out the connecting timeout of each blocked protocol in turn. The probes do not make a tunnel:
+//  - WireGuard: a handshake initiation made with the stored key-pair, answered by a handshake response or a cookie reply;
+//  - OpenVPN TCP: a TCP connect;
+//  - Stunnel and WStunnel: a TLS ClientHello, answered by any TLS record (a ServerHello or an alert).
+// A TCP or TLS probe without an answer has failed. A WireGuard probe without an answer is inconclusive, as the server
+// silently drops the handshakes of keys it does not know.
+// The race ends when every probe has a result, when the first probe (the preferred protocol) answers, or some time after
+// the first answer, since a probe slower than a few round trips of the others is most likely dropped by the network.
+class ReachabilityRace : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Result { kUnknown, kAnswered, kFailed };
+
+    struct Probe
+    {
+        types::Protocol protocol;
+        QString ip;
+        uint port = 0;
+        QString hostname;               // the server name of the TLS ClientHello
+        QByteArray wgPrivateKey;        // raw keys, for WireGuard
+        QByteArray wgPeerPublicKey;
+    };
+
+    struct ProbeResult
+    {
+        types::Protocol protocol;
+        Result result = Result::kUnknown;
+        qint64 answerTimeMs = -1;
+    };
+
+    explicit ReachabilityRace(QObject *parent);
+    ~ReachabilityRace() override;
+
+    // the probes in the order of preference; finished() is emitted once, unless stopped
+    void start(const QVector<Probe> &probes, int timeoutMs);
+    void stop();
+    bool isRunning() const;
+
+    // returns an empty array if the keys are invalid
+    static QByteArray makeWireGuardInitiation(const QByteArray &privateKey, const QByteArray &peerPublicKey, quint32 senderIndex);
+    static QByteArray makeTlsClientHello(const QString &serverName);
+
+signals:
+    void finished(const QVector<ReachabilityRace::ProbeResult> &results);
+
+private slots:
+    void onTimeout();
+    void onGraceTimeout();
+
+private:
+    struct RunningProbe
+    {
+        ProbeResult result;
+        QAbstractSocket *socket = nullptr;
+        bool isDone = false;
+        quint32 wgSenderIndex = 0;
+    };
+
+    static constexpr int kMinGraceMs = 300;
+
+    QVector<RunningProbe> probes_;
+    QTimer timer_;
+    QTimer graceTimer_;
+    QElapsedTimer elapsed_;
+    bool isStarting_ = false;
+
+    void startProbe(int ind, const Probe &probe);
+    void onWireGuardAnswer(int ind);
+    void onTlsAnswer(int ind);
+    void setResult(int ind, Result result);
+    void finishIfDone();
+    // isPendingFailed: the probes without a result yet are given up on, rather than no longer needed
+    void finish(bool isPendingFailed);
+    void closeSockets();
+};
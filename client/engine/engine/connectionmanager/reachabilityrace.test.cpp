@@ -0,0 +1,210 @@
+#include "reachabilityrace.test.h"
+
+#include <QElapsedTimer>
+#include <QSignalSpy>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUdpSocket>
+#include <QtEndian>
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+#include "reachabilityrace.h"
+
+namespace {
+
+QByteArray randomKey()
+{
+    QByteArray key(32, 0);
+    RAND_bytes((unsigned char *)key.data(), key.size());
+    return key;
+}
+
+QByteArray publicKey(const QByteArray &privateKey)
+{
+    EVP_PKEY *pkey = EVP_PKEY_new_raw_private_key(EVP_PKEY_X25519, nullptr, (const unsigned char *)privateKey.constData(), privateKey.size());
+    QByteArray key(32, 0);
+    size_t len = key.size();
+    EVP_PKEY_get_raw_public_key(pkey, (unsigned char *)key.data(), &len);
+    EVP_PKEY_free(pkey);
+    return key;
+}
+
+QByteArray blake2s(const QByteArray &data, int size = 32, const QByteArray &key = QByteArray())
+{
+    if (key.isEmpty()) {
+        unsigned char out[EVP_MAX_MD_SIZE];
+        unsigned int outLen = 0;
+        EVP_Digest(data.constData(), data.size(), out, &outLen, EVP_blake2s256(), nullptr);
+        return QByteArray((const char *)out, outLen);
+    }
+
+    EVP_MAC *mac = EVP_MAC_fetch(nullptr, "BLAKE2SMAC", nullptr);
+    EVP_MAC_CTX *ctx = EVP_MAC_CTX_new(mac);
+    size_t outSize = size;
+    OSSL_PARAM params[] = { OSSL_PARAM_construct_size_t(OSSL_MAC_PARAM_SIZE, &outSize), OSSL_PARAM_construct_end() };
+    QByteArray out(size, 0);
+    size_t outLen = 0;
+    EVP_MAC_init(ctx, (const unsigned char *)key.constData(), key.size(), params);
+    EVP_MAC_update(ctx, (const unsigned char *)data.constData(), data.size());
+    EVP_MAC_final(ctx, (unsigned char *)out.data(), &outLen, out.size());
+    EVP_MAC_CTX_free(ctx);
+    EVP_MAC_free(mac);
+    return out;
+}
+
+ReachabilityRace::Probe probe(types::Protocol protocol, quint16 port)
+{
+    ReachabilityRace::Probe p;
+    p.protocol = protocol;
+    p.ip = "127.0.0.1";
+    p.port = port;
+    p.hostname = "example.com";
+    return p;
+}
+
+// a port nothing listens on
+quint16 closedPort()
+{
+    QTcpServer server;
+    server.listen(QHostAddress::LocalHost);
+    return server.serverPort();
+}
+
+QVector<ReachabilityRace::ProbeResult> runRace(const QVector<ReachabilityRace::Probe> &probes, int timeoutMs)
+{
+    ReachabilityRace race(nullptr);
+    QSignalSpy spy(&race, &ReachabilityRace::finished);
+    race.start(probes, timeoutMs);
+    if (spy.isEmpty() && !spy.wait(timeoutMs + 1000))
+        return QVector<ReachabilityRace::ProbeResult>();
+    return spy.first().first().value<QVector<ReachabilityRace::ProbeResult>>();
+}
+
+} // namespace
+
+void TestReachabilityRace::testWireGuardInitiation()
+{
+    const QByteArray privateKey = randomKey();
+    const QByteArray peerPublicKey = publicKey(randomKey());
+
+    const QByteArray packet = ReachabilityRace::makeWireGuardInitiation(privateKey, peerPublicKey, 0x11223344);
+    QCOMPARE(packet.size(), 148);
+    QCOMPARE(packet.left(4), QByteArray::fromHex("01000000"));
+    QCOMPARE(qFromLittleEndian<quint32>(packet.constData() + 4), 0x11223344u);
+    // mac1 over the message up to it, keyed with the hash of the responder public key
+    QCOMPARE(packet.mid(116, 16), blake2s(packet.left(116), 16, blake2s("mac1----" + peerPublicKey)));
+    QCOMPARE(packet.right(16), QByteArray(16, 0));
+
+    // a new ephemeral key each time
+    QVERIFY(ReachabilityRace::makeWireGuardInitiation(privateKey, peerPublicKey, 0x11223344).mid(8, 32) != packet.mid(8, 32));
+    QVERIFY(ReachabilityRace::makeWireGuardInitiation(QByteArray(), peerPublicKey, 1).isEmpty());
+    QVERIFY(ReachabilityRace::makeWireGuardInitiation(privateKey, peerPublicKey.left(16), 1).isEmpty());
+}
+
+void TestReachabilityRace::testTlsClientHello()
+{
+    const QByteArray hello = ReachabilityRace::makeTlsClientHello("node.example.com");
+    QCOMPARE(hello.left(3), QByteArray::fromHex("160301"));
+    QCOMPARE(int(qFromBigEndian<quint16>(hello.constData() + 3)), hello.size() - 5);
+    QCOMPARE(int(hello[5]), 1);
+    QCOMPARE(int(qFromBigEndian<quint32>(hello.constData() + 5) & 0xffffff), hello.size() - 9);
+    QVERIFY(hello.contains(QByteArray("\x00\x10node.example.com", 18)));
+
+    QVERIFY(!ReachabilityRace::makeTlsClientHello(QString()).contains("example"));
+}
+
+void TestReachabilityRace::testTcpRace()
+{
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    auto results = runRace({ probe(types::Protocol::OPENVPN_TCP, closedPort()), probe(types::Protocol::OPENVPN_TCP, server.serverPort()),
+                             probe(types::Protocol::IKEV2, 500) }, 5000);
+    QCOMPARE(results.size(), 3);
+    QCOMPARE(results[0].result, ReachabilityRace::Result::kFailed);
+    QCOMPARE(results[1].result, ReachabilityRace::Result::kAnswered);
+    QVERIFY(results[1].answerTimeMs >= 0);
+    QCOMPARE(results[2].result, ReachabilityRace::Result::kUnknown);
+    QCOMPARE(results[2].protocol, types::Protocol(types::Protocol::IKEV2));
+}
+
+void TestReachabilityRace::testTlsRace()
+{
+    // answers with an alert, like a server which does not know the server name
+    QTcpServer alertServer;
+    QVERIFY(alertServer.listen(QHostAddress::LocalHost));
+    connect(&alertServer, &QTcpServer::newConnection, &alertServer, [&alertServer]() {
+        QTcpSocket *socket = alertServer.nextPendingConnection();
+        connect(socket, &QTcpSocket::readyRead, socket, [socket]() { socket->write(QByteArray::fromHex("15030300020228")); });
+    });
+    // accepts and never answers
+    QTcpServer silentServer;
+    QVERIFY(silentServer.listen(QHostAddress::LocalHost));
+    // not a TLS server
+    QTcpServer httpServer;
+    QVERIFY(httpServer.listen(QHostAddress::LocalHost));
+    connect(&httpServer, &QTcpServer::newConnection, &httpServer, [&httpServer]() {
+        httpServer.nextPendingConnection()->write("HTTP/1.1 400 Bad Request\r\n\r\n");
+    });
+
+    // the preferred protocol answered, the others are not waited for
+    auto results = runRace({ probe(types::Protocol::STUNNEL, alertServer.serverPort()), probe(types::Protocol::WSTUNNEL, silentServer.serverPort()) }, 5000);
+    QCOMPARE(results.size(), 2);
+    QCOMPARE(results[0].result, ReachabilityRace::Result::kAnswered);
+    QCOMPARE(results[1].result, ReachabilityRace::Result::kUnknown);
+
+    // the silent one is given up on some time after another one answered, well before the timeout
+    QElapsedTimer elapsed;
+    elapsed.start();
+    results = runRace({ probe(types::Protocol::WSTUNNEL, silentServer.serverPort()), probe(types::Protocol::STUNNEL, httpServer.serverPort()),
+                        probe(types::Protocol::STUNNEL, alertServer.serverPort()) }, 10000);
+    QVERIFY(elapsed.elapsed() < 5000);
+    QCOMPARE(results.size(), 3);
+    QCOMPARE(results[0].result, ReachabilityRace::Result::kFailed);
+    QCOMPARE(results[1].result, ReachabilityRace::Result::kFailed);
+    QCOMPARE(results[2].result, ReachabilityRace::Result::kAnswered);
+}
+
+void TestReachabilityRace::testWireGuardRace()
+{
+    // answers the initiation with a handshake response to the sender index
+    QUdpSocket server;
+    QVERIFY(server.bind(QHostAddress::LocalHost, 0));
+    connect(&server, &QUdpSocket::readyRead, &server, [&server]() {
+        while (server.hasPendingDatagrams()) {
+            QByteArray datagram(server.pendingDatagramSize(), 0);
+            QHostAddress address;
+            quint16 port;
+            server.readDatagram(datagram.data(), datagram.size(), &address, &port);
+            QByteArray response(92, 0);
+            response[0] = 2;
+            qToLittleEndian<quint32>(qFromLittleEndian<quint32>(datagram.constData() + 4), response.data() + 8);
+            server.writeDatagram(response, address, port);
+        }
+    });
+    // drops everything, like a server which does not know the key
+    QUdpSocket silentServer;
+    QVERIFY(silentServer.bind(QHostAddress::LocalHost, 0));
+
+    ReachabilityRace::Probe answering = probe(types::Protocol::WIREGUARD, server.localPort());
+    answering.wgPrivateKey = randomKey();
+    answering.wgPeerPublicKey = publicKey(randomKey());
+    ReachabilityRace::Probe silent = answering;
+    silent.port = silentServer.localPort();
+    QTcpServer tcpServer;
+    QVERIFY(tcpServer.listen(QHostAddress::LocalHost));
+
+    auto results = runRace({ answering }, 5000);
+    QCOMPARE(results.size(), 1);
+    QCOMPARE(results[0].result, ReachabilityRace::Result::kAnswered);
+
+    // no answer from WireGuard is inconclusive even when another protocol answered
+    results = runRace({ silent, probe(types::Protocol::OPENVPN_TCP, tcpServer.serverPort()) }, 5000);
+    QCOMPARE(results.size(), 2);
+    QCOMPARE(results[0].result, ReachabilityRace::Result::kUnknown);
+    QCOMPARE(results[1].result, ReachabilityRace::Result::kAnswered);
+}
+
+QTEST_MAIN(TestReachabilityRace)
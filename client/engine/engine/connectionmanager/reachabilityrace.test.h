@@ -0,0 +1,16 @@
+#pragma once
+
+#include <QObject>
+#include <QTest>
+
+class TestReachabilityRace : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testWireGuardInitiation();
+    void testTlsClientHello();
+    void testTcpRace();
+    void testTlsRace();
+    void testWireGuardRace();
+};
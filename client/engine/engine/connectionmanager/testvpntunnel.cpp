@@ -1,4 +1,5 @@
 #include "testvpntunnel.h"
+#include "connectiontracer.h"
 #include "utils/logger.h"
 #include "utils/ipvalidation.h"
 #include "utils/extraconfig.h"
@@ -32,6 +33,7 @@ void TestVPNTunnel::startTests(const types::Protocol &protocol)
     if (advParamExists)
     {
         qCDebug(LOG_CONNECTION) << "Delaying tunnel test start for" << delay << "ms";
+        ConnectionTracer::instance().beginSpan("tunnelTestStartDelay");
         QTimer::singleShot(delay, this, &TestVPNTunnel::startTestImpl);
     }
     else {
@@ -41,6 +43,7 @@ void TestVPNTunnel::startTests(const types::Protocol &protocol)
 
 void TestVPNTunnel::startTestImpl()
 {
+    ConnectionTracer::instance().endSpan("tunnelTestStartDelay");
     timeouts_.clear();
 
     doCustomTunnelTest_ = false;
@@ -93,6 +96,7 @@ void TestVPNTunnel::startTestImpl()
 
     // start first test
     qCDebug(LOG_CONNECTION) << "Doing tunnel test 1";
+    ConnectionTracer::instance().beginSpan("tunnelTest");
     bRunning_ = true;
     curTest_ = 1;
     elapsed_.start();
@@ -111,6 +115,7 @@ void TestVPNTunnel::stopTests()
             curRequest_->cancel();
             curRequest_.reset();
         }
+        ConnectionTracer::instance().endSpan("tunnelTest", false);
         qCDebug(LOG_CONNECTION) << "Tunnel tests stopped";
     }
 }
@@ -125,6 +130,7 @@ void TestVPNTunnel::onPingTestAnswer(wsnet::ServerApiRetCode serverApiRetCode, c
         if (serverApiRetCode == ServerApiRetCode::kSuccess && IpValidation::isIp(trimmedData)) {
             qCDebug(LOG_CONNECTION) << "Tunnel test " << QString::number(curTest_) << "successfully finished with IP:" << trimmedData << ", total test time =" << elapsedOverallTimer_.elapsed();
             bRunning_ = false;
+            ConnectionTracer::instance().endSpan("tunnelTest");
             emit testsFinished(true, trimmedData);
         } else {
             if (doCustomTunnelTest_) {
@@ -132,9 +138,11 @@ void TestVPNTunnel::onPingTestAnswer(wsnet::ServerApiRetCode serverApiRetCode, c
 
                 if (curTest_ < timeouts_.size()) {
                     curTest_++;
+                    ConnectionTracer::instance().addInstant("tunnelTestRetry");
                     QTimer::singleShot(testRetryDelay_, this, &TestVPNTunnel::doNextPingTest);
                 } else {
                     bRunning_ = false;
+                    ConnectionTracer::instance().endSpan("tunnelTest", false);
                     emit testsFinished(false, "");
                 }
             } else {
@@ -146,10 +154,12 @@ void TestVPNTunnel::onPingTestAnswer(wsnet::ServerApiRetCode serverApiRetCode, c
 
                     if (curTest_ < timeouts_.size()) {
                         curTest_++;
+                        ConnectionTracer::instance().addInstant("tunnelTestRetry");
                         elapsed_.start();
                         doNextPingTest();
                     } else {
                         bRunning_ = false;
+                        ConnectionTracer::instance().endSpan("tunnelTest", false);
                         emit testsFinished(false, "");
                     }
                 }
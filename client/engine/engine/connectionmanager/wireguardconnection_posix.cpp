@@ -1,4 +1,5 @@
 #include "wireguardconnection_posix.h"
+#include "connectiontracer.h"
 #include "utils/ws_assert.h"
 #include "utils/crashhandler.h"
 #include "utils/logger.h"
@@ -21,6 +22,9 @@ public:
     void configure();
     void disconnect();
     bool getStatus(types::WireGuardStatus *status);
+    bool subscribeStatus(bool isSubscribe);
+    bool waitForStatus(types::WireGuardStatus *status, unsigned long timeoutMs);
+    void cancelWaitForStatus();
     bool stopWireGuard();
 
     QString getAdapterName() const { return adapterName_; }
@@ -53,6 +57,7 @@ void WireGuardConnectionImpl::setConfig(const WireGuardConfig *wireGuardConfig,
 void WireGuardConnectionImpl::connect()
 {
     if (!isStarted_) {
+        ConnectionTracer::Scope span("helper.startWireGuard");
         int retry = 0;
         IHelper::ExecuteError err;
 
@@ -61,6 +66,7 @@ void WireGuardConnectionImpl::connect()
             if (retry >= 2)
             {
                 qCDebug(LOG_WIREGUARD) << "Can't start WireGuard after" << retry << "retries";
+                span.setFailed();
                 host_->setError(WIREGUARD_CONNECTION_ERROR);
                 return;
             }
@@ -77,8 +83,10 @@ void WireGuardConnectionImpl::configure()
     WS_ASSERT(isStarted_);
 
     // Configure the client and the peer.
+    ConnectionTracer::Scope span("helper.configureWireGuard");
     if (!host_->helper_->configureWireGuard(config_)) {
         qCDebug(LOG_WIREGUARD) << "Failed to configure WireGuard";
+        span.setFailed();
         host_->setError(WIREGUARD_CONNECTION_ERROR);
     }
 }
@@ -95,6 +103,31 @@ bool WireGuardConnectionImpl::getStatus(types::WireGuardStatus *status)
     return isStarted_ && host_->helper_->getWireGuardStatus(status);
 }
 
+// On Linux the helper pushes the status when it changes, the Mac helper is polled with getStatus().
+bool WireGuardConnectionImpl::subscribeStatus(bool isSubscribe)
+{
+#ifdef Q_OS_LINUX
+    Helper_linux *helper_linux = dynamic_cast<Helper_linux *>(host_->helper_);
+    return isStarted_ && helper_linux &&
+           helper_linux->subscribeWireGuardStatus(isSubscribe ? WireGuardConnection::kStatisticsIntervalMs : 0);
+#else
+    Q_UNUSED(isSubscribe);
+    return false;
+#endif
+}
+
+bool WireGuardConnectionImpl::waitForStatus(types::WireGuardStatus *status, unsigned long timeoutMs)
+{
+    Helper_posix *helper_posix = dynamic_cast<Helper_posix *>(host_->helper_);
+    return helper_posix->waitForWireGuardStatus(status, timeoutMs);
+}
+
+void WireGuardConnectionImpl::cancelWaitForStatus()
+{
+    Helper_posix *helper_posix = dynamic_cast<Helper_posix *>(host_->helper_);
+    helper_posix->cancelWaitForWireGuardStatus();
+}
+
 bool WireGuardConnectionImpl::stopWireGuard()
 {
     if (isStarted_) {
@@ -147,6 +180,7 @@ void WireGuardConnection::startConnect(const QString &configPathOrUrl, const QSt
     qCDebug(LOG_CONNECTION) << "Connecting WireGuard:" << pimpl_->getAdapterName();
 
     do_stop_thread_ = true;
+    pimpl_->cancelWaitForStatus();
     wait();
     do_stop_thread_ = false;
 
@@ -185,6 +219,7 @@ void WireGuardConnection::startDisconnect()
 
     adapterGatewayInfo_.clear();
     do_stop_thread_ = true;
+    pimpl_->cancelWaitForStatus();
 }
 
 bool WireGuardConnection::isDisconnected() const
@@ -215,65 +250,82 @@ void WireGuardConnection::run()
 
     BIND_CRASH_HANDLER_FOR_THREAD();
 
-    for (pimpl_->connect();;) {
+    pimpl_->connect();
+    const bool is_status_pushed = pimpl_->subscribeStatus(true);
+
+    for (;;) {
         if (do_stop_thread_) {
             pimpl_->disconnect();
             break;
         }
         const auto current_state = getCurrentState();
         unsigned int next_status_check_ms = 100u;
+        bool has_status = true;
         if (current_state != ConnectionState::DISCONNECTED) {
 
             if (current_state == ConnectionState::CONNECTED)
                 elapsedTimer.invalidate();
 
-            if (!pimpl_->getStatus(&status)) {
+            if (is_status_pushed) {
+                // wake up in time for the timeout of the automatic connection mode
+                unsigned long timeout_ms = kStatusWaitTimeoutMs;
+                if (isAutomaticConnectionMode_ && elapsedTimer.isValid())
+                    timeout_ms = qBound<qint64>(1, kTimeoutForAutomatic - elapsedTimer.elapsed(), kStatusWaitTimeoutMs);
+                has_status = pimpl_->waitForStatus(&status, timeout_ms);
+                if (!has_status && helper_->currentState() != IHelper::STATE_CONNECTED) {
+                    qCDebug(LOG_WIREGUARD) << "Failed to get WireGuard status";
+                    pimpl_->disconnect();
+                    break;
+                }
+            } else if (!pimpl_->getStatus(&status)) {
                 qCDebug(LOG_WIREGUARD) << "Failed to get WireGuard status";
                 pimpl_->disconnect();
                 break;
             }
-            switch (status.state) {
-            case types::WireGuardState::NONE:
-                // Not initialized.
-                break;
-            case types::WireGuardState::FAILURE:
-                // Error state.
-                qCDebug(LOG_WIREGUARD) << "WireGuard daemon error";
-                do_stop_thread_ = true;
-                break;
-            case types::WireGuardState::STARTING:
-                // Daemon is warming up, we have no other option that wait.
-                break;
-            case types::WireGuardState::LISTENING:
-                // Accepting configuration.
-                if (!is_configured) {
-                    qCDebug(LOG_WIREGUARD) << "Configuring WireGuard...";
-                    is_configured = true;
-                    pimpl_->configure();
-                    emit interfaceUpdated(pimpl_->getAdapterName());
+            if (has_status) {
+                switch (status.state) {
+                case types::WireGuardState::NONE:
+                    // Not initialized.
+                    break;
+                case types::WireGuardState::FAILURE:
+                    // Error state.
+                    qCDebug(LOG_WIREGUARD) << "WireGuard daemon error";
+                    do_stop_thread_ = true;
+                    break;
+                case types::WireGuardState::STARTING:
+                    // Daemon is warming up, we have no other option that wait.
+                    break;
+                case types::WireGuardState::LISTENING:
+                    // Accepting configuration.
+                    if (!is_configured) {
+                        qCDebug(LOG_WIREGUARD) << "Configuring WireGuard...";
+                        is_configured = true;
+                        pimpl_->configure();
+                        emit interfaceUpdated(pimpl_->getAdapterName());
+                    }
+                    break;
+                case types::WireGuardState::CONNECTING:
+                    // Connecting (waiting for a handshake).
+                    next_status_check_ms = 250u;
+                    break;
+                case types::WireGuardState::ACTIVE:
+                {
+                    if (!is_connected) {
+                        qCDebug(LOG_WIREGUARD) << "WireGuard daemon reported successful handshake";
+                        is_connected = true;
+                        setCurrentStateAndEmitSignal(WireGuardConnection::ConnectionState::CONNECTED);
+                    }
+                    const auto newBytesReceived = status.bytesReceived - bytesReceived;
+                    const auto newBytesTransmitted = status.bytesTransmitted - bytesTransmitted;
+                    if (newBytesReceived || newBytesTransmitted) {
+                        bytesReceived = status.bytesReceived;
+                        bytesTransmitted = status.bytesTransmitted;
+                        emit statisticsUpdated(newBytesReceived, newBytesTransmitted, false);
+                    }
+                    next_status_check_ms = 500u;
+                    break;
                 }
-                break;
-            case types::WireGuardState::CONNECTING:
-                // Connecting (waiting for a handshake).
-                next_status_check_ms = 250u;
-                break;
-            case types::WireGuardState::ACTIVE:
-            {
-                if (!is_connected) {
-                    qCDebug(LOG_WIREGUARD) << "WireGuard daemon reported successful handshake";
-                    is_connected = true;
-                    setCurrentStateAndEmitSignal(WireGuardConnection::ConnectionState::CONNECTED);
-                }
-                const auto newBytesReceived = status.bytesReceived - bytesReceived;
-                const auto newBytesTransmitted = status.bytesTransmitted - bytesTransmitted;
-                if (newBytesReceived || newBytesTransmitted) {
-                    bytesReceived = status.bytesReceived;
-                    bytesTransmitted = status.bytesTransmitted;
-                    emit statisticsUpdated(newBytesReceived, newBytesTransmitted, false);
                 }
-                next_status_check_ms = 500u;
-                break;
-            }
             }
         }
 
@@ -281,8 +333,12 @@ void WireGuardConnection::run()
             setError(STATE_TIMEOUT_FOR_AUTOMATIC);
         }
 
-        QThread::msleep(next_status_check_ms);
+        if (!is_status_pushed)
+            QThread::msleep(next_status_check_ms);
     }
+
+    if (is_status_pushed)
+        pimpl_->subscribeStatus(false);
 }
 
 void WireGuardConnection::onProcessKillTimeout()
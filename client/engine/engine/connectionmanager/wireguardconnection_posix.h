@@ -42,6 +42,9 @@ private:
     enum class ConnectionState { DISCONNECTED, CONNECTING, CONNECTED };
     static constexpr int PROCESS_KILL_TIMEOUT = 10000;
     static constexpr int kTimeoutForAutomatic = 20000;  // 20 secs timeout for the automatic connection mode
+    static constexpr unsigned int kStatisticsIntervalMs = 500;
+    // the pushed status only needs a timeout as a safeguard, stopping and helper disconnects wake the wait
+    static constexpr unsigned long kStatusWaitTimeoutMs = 10000;
 
     ConnectionState getCurrentState() const;
     void setCurrentState(ConnectionState state);
@@ -8,6 +8,7 @@
 #include <sstream>
 
 #include "adapterutils_win.h"
+#include "connectiontracer.h"
 #include "engine/wireguardconfig/wireguardconfig.h"
 #include "types/wireguardtypes.h"
 #include "utils/crashhandler.h"
@@ -125,10 +126,13 @@ void WireGuardConnection::run()
     qCDebug(LOG_CONNECTION) << "Starting WireGuardService";
 
     // Installing the wireguard service requires admin privilege.
+    ConnectionTracer::Scope startSpan("helper.startWireGuard");
     IHelper::ExecuteError err = helper_->startWireGuard();
     if (err != IHelper::EXECUTE_SUCCESS)
     {
         qCDebug(LOG_CONNECTION) << "Windscribe service could not install the WireGuard service";
+        startSpan.setFailed();
+        startSpan.end();
         emit error(CONNECT_ERROR::WIREGUARD_CONNECTION_ERROR);
         emit disconnected();
         return;
@@ -138,7 +142,12 @@ void WireGuardConnection::run()
         helper_->stopWireGuard();
     });
 
-    helper_->configureWireGuard(wireGuardConfig_);
+    startSpan.end();
+    {
+        ConnectionTracer::Scope configureSpan("helper.configureWireGuard");
+        if (!helper_->configureWireGuard(wireGuardConfig_))
+            configureSpan.setFailed();
+    }
 
     resetLogReader();
 
@@ -2,6 +2,7 @@
 
 #include <QCoreApplication>
 #include <QCryptographicHash>
+#include <QStandardPaths>
 #include <wsnet/WSNet.h>
 #include "utils/ws_assert.h"
 #include "utils/utils.h"
@@ -121,13 +122,21 @@ Engine::Engine() : QObject(nullptr),
     }
 
     QSettings settings;
+    // wsnetSettings is the format of the previous versions, it is migrated to the wsnet directory on the first start
+    // and taken again after a failed save (see saveWsnetSettings()). The key is kept for a downgrade, so this string
+    // (up to several hundred KB) is still read on every start, even when wsnet uses the directory and ignores it.
+    // wsnetSettingsDirStale is set if the last save to the directory failed, then the files are not trusted
+    // even if wsnet could not mark them as incomplete
     std::string wsnetSettings = settings.value("wsnetSettings").toString().toStdString();
+    std::string wsnetSettingsDir = (QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/wsnet").toStdString();
+    bool isWsnetSettingsDirStale = settings.value("wsnetSettingsDirStale", false).toBool();
     bool bWsnetSuccess = WSNet::initialize(Utils::getBasePlatformName().toStdString(), Utils::getPlatformNameSafe().toStdString(),
                                            AppVersion::instance().semanticVersionString().toStdString(),
                                            GetDeviceId::instance().getDeviceId().toStdString(),
                                            OpenVpnVersionController::instance().getOpenVpnVersion().toStdString(),
                                            "3", // must supply session_type_id where 3 = DESKTOP
-                                           AppVersion::instance().isStaging(), LanguagesUtil::systemLanguage().toStdString(), wsnetSettings);
+                                           AppVersion::instance().isStaging(), LanguagesUtil::systemLanguage().toStdString(), wsnetSettings, wsnetSettingsDir,
+                                           isWsnetSettingsDirStale);
     WS_ASSERT(bWsnetSuccess);
 
     WSNet::instance()->apiResourcersManager()->setCallback([this](ApiResourcesManagerNotification notification, LoginResult loginResult, const std::string &errorMessage) {
@@ -503,6 +512,15 @@ void Engine::applicationActivated()
         if (isLoggedIn_ && WSNet::isValid()) {
             WSNet::instance()->apiResourcersManager()->fetchSession();
         }
+        updateWireGuardConfigPrefetch();
+    }, Qt::QueuedConnection);
+}
+
+void Engine::setFavoriteLocations(const QVector<LocationID> &locations)
+{
+    QMetaObject::invokeMethod(this, [this, locations]() {
+        favoriteLocations_ = locations;
+        updateWireGuardConfigPrefetch();
     }, Qt::QueuedConnection);
 }
 
@@ -698,6 +716,7 @@ void Engine::initPart2()
     connect(connectionManager_, &ConnectionManager::testTunnelResult, this, &Engine::onConnectionManagerTestTunnelResult);
     connect(connectionManager_, &ConnectionManager::connectingToHostname, this, &Engine::onConnectionManagerConnectingToHostname);
     connect(connectionManager_, &ConnectionManager::protocolPortChanged, this, &Engine::onConnectionManagerProtocolPortChanged);
+    connect(connectionManager_, &ConnectionManager::reachabilityIpsChanged, this, &Engine::onConnectionManagerReachabilityIpsChanged);
     connect(connectionManager_, &ConnectionManager::internetConnectivityChanged, this, &Engine::onConnectionManagerInternetConnectivityChanged);
     connect(connectionManager_, &ConnectionManager::wireGuardAtKeyLimit, this, &Engine::onConnectionManagerWireGuardAtKeyLimit);
     connect(connectionManager_, &ConnectionManager::requestUsername, this, &Engine::onConnectionManagerRequestUsername);
@@ -707,6 +726,8 @@ void Engine::initPart2()
 
     locationsModel_ = new locationsmodel::LocationsModel(this, connectStateController_, networkDetectionManager_);
     connect(locationsModel_, &locationsmodel::LocationsModel::whitelistLocationsIpsChanged, this, &Engine::onLocationsModelWhitelistIpsChanged);
+    connect(locationsModel_, &locationsmodel::LocationsModel::locationsUpdated, this, &Engine::onLocationsModelLocationsUpdated);
+    connect(locationsModel_, &locationsmodel::LocationsModel::bestLocationUpdated, this, &Engine::onLocationsModelBestLocationUpdated);
     connect(locationsModel_, &locationsmodel::LocationsModel::whitelistCustomConfigsIpsChanged, this, &Engine::onLocationsModelWhitelistCustomConfigIpsChanged);
 
     vpnShareController_ = new VpnShareController(this, helper_);
@@ -1092,6 +1113,8 @@ void Engine::logoutImpl(bool keepFirewallOn)
 void Engine::logoutImplAfterDisconnect(bool keepFirewallOn)
 {
     locationsModel_->clear();
+    bestLocation_ = LocationID();
+    connectionManager_->clearPrefetchedWireGuardConfigs();
 
 #if defined(Q_OS_MACOS) || defined(Q_OS_LINUX)
     firewallController_->setFirewallOnBoot(false);
@@ -1155,9 +1178,8 @@ void Engine::continueWithPrivKeyPasswordImpl(const QString &password, bool bSave
 
 void Engine::gotoCustomOvpnConfigModeImpl()
 {
-    api_responses::ServerList serverLocations(WSNet::instance()->apiResourcersManager()->locations());
     api_responses::StaticIps staticIps(WSNet::instance()->apiResourcersManager()->staticIps());
-    updateServerLocations(serverLocations, staticIps);
+    updateServerLocations(currentServerList(), staticIps);
     myIpManager_->getIP(1);
     doCheckUpdate();
     emit gotoCustomOvpnConfigModeFinished();
@@ -1541,6 +1563,7 @@ void Engine::onConnectionManagerDisconnected(DISCONNECT_REASON reason)
     connectionSettingsOverride_ = types::ConnectionSettings(types::Protocol(types::Protocol::TYPE::UNINITIALIZED), 0, true);
 
     connectStateController_->setDisconnectedState(reason, CONNECT_ERROR::NO_CONNECT_ERROR);
+    updateWireGuardConfigPrefetch();
 }
 
 void Engine::onConnectionManagerReconnecting()
@@ -1686,6 +1709,21 @@ void Engine::onConnectionManagerProtocolPortChanged(const types::Protocol &proto
     emit protocolPortChanged(protocol, port);
 }
 
+void Engine::onConnectionManagerReachabilityIpsChanged(const QStringList &ips)
+{
+    if (!ips.isEmpty())
+    {
+        qCDebug(LOG_CONNECTION) << "Whitelist reachability race ips:" << ips << ", firewall on:" << firewallController_->firewallActualState();
+    }
+
+    bool bChanged = false;
+    firewallExceptions_.setReachabilityIps(ips, bChanged);
+    if (bChanged)
+    {
+        updateFirewallSettings();
+    }
+}
+
 void Engine::onConnectionManagerTestTunnelResult(bool success, const QString &ipAddress)
 {
     emit testTunnelResult(success); // stops protocol/port flashing
@@ -1818,6 +1856,8 @@ void Engine::updateAdvancedParamsImpl()
     // send some parameters to wsnet
     WSNet::instance()->advancedParameters()->setAPIExtraTLSPadding(ExtraConfig::instance().getAPIExtraTLSPadding() || engineSettings_.isAntiCensorship());
     WSNet::instance()->advancedParameters()->setLogApiResponce(ExtraConfig::instance().getLogAPIResponse());
+    WSNet::instance()->advancedParameters()->setAPIConnectionReuse(ExtraConfig::instance().getAPIConnectionReuse());
+    WSNet::instance()->advancedParameters()->setAPIFailoverRacing(ExtraConfig::instance().getAPIFailoverRacing());
     std::optional<QString> countryOverride = ExtraConfig::instance().serverlistCountryOverride();
     WSNet::instance()->advancedParameters()->setCountryOverrideValue(countryOverride.has_value() ? countryOverride->toStdString() : "");
     WSNet::instance()->advancedParameters()->setIgnoreCountryOverride(ExtraConfig::instance().serverListIgnoreCountryOverride());
@@ -2047,9 +2087,8 @@ void Engine::syncRobert()
 void Engine::onCustomConfigsChanged()
 {
     qCDebug(LOG_BASIC) << "Custom configs changed";
-    api_responses::ServerList serverLocations(WSNet::instance()->apiResourcersManager()->locations());
     api_responses::StaticIps staticIps(WSNet::instance()->apiResourcersManager()->staticIps());
-    updateServerLocations(serverLocations, staticIps);
+    updateServerLocations(currentServerList(), staticIps);
 }
 
 void Engine::onLocationsModelWhitelistIpsChanged(const QStringList &ips)
@@ -2064,6 +2103,20 @@ void Engine::onLocationsModelWhitelistCustomConfigIpsChanged(const QStringList &
     updateFirewallSettings();
 }
 
+void Engine::onLocationsModelLocationsUpdated(const LocationID &bestLocation, const QString &staticIpDeviceName, QSharedPointer<QVector<types::Location> > locations)
+{
+    Q_UNUSED(staticIpDeviceName);
+    Q_UNUSED(locations);
+    bestLocation_ = bestLocation;
+    updateWireGuardConfigPrefetch();
+}
+
+void Engine::onLocationsModelBestLocationUpdated(const LocationID &bestLocation)
+{
+    bestLocation_ = bestLocation;
+    updateWireGuardConfigPrefetch();
+}
+
 void Engine::onNetworkOnlineStateChange(bool isOnline)
 {
     if (!isOnline && runningPacketDetection_)
@@ -2343,7 +2396,7 @@ void Engine::onApiResourcesManagerLoginFailed(LoginResult loginResult, const QSt
 
 void Engine::onApiResourcesManagerLocationsUpdated()
 {
-    api_responses::ServerList serverLocations(WSNet::instance()->apiResourcersManager()->locations());
+    const api_responses::ServerList &serverLocations = currentServerList();
     api_responses::StaticIps staticIps(WSNet::instance()->apiResourcersManager()->staticIps());
     updateServerLocations(serverLocations, staticIps);
 
@@ -2378,6 +2431,16 @@ void Engine::updateServerLocations(const api_responses::ServerList &serverLocati
     checkForceDisconnectNode(serverLocations.forceDisconnectNodes());
 }
 
+const api_responses::ServerList &Engine::currentServerList()
+{
+    auto serverList = WSNet::instance()->apiResourcersManager()->serverList();
+    if (serverList != wsnetServerList_) {
+        wsnetServerList_ = serverList;
+        serverList_ = serverList ? api_responses::ServerList(*serverList) : api_responses::ServerList();
+    }
+    return serverList_;
+}
+
 void Engine::updateFirewallSettings()
 {
     if (firewallController_->firewallActualState()) {
@@ -2501,6 +2564,47 @@ void Engine::doConnect(bool bEmitAuthError)
     }
 }
 
+void Engine::updateWireGuardConfigPrefetch()
+{
+    if (!isLoggedIn_ || connectStateController_->currentState() != CONNECT_STATE_DISCONNECTED || !connectionManager_->isDisconnected())
+        return;
+
+    // the first protocol the connection will try: the configured one, or in automatic mode the last known good one,
+    // otherwise the first one of the port map
+    types::NetworkInterface networkInterface;
+    networkDetectionManager_->getCurrentNetworkInterface(networkInterface);
+    const types::ConnectionSettings connectionSettings = engineSettings_.connectionSettingsForNetworkInterface(networkInterface.networkOrSsid);
+    types::Protocol protocol = connectionSettings.protocol();
+    if (connectionSettings.isAutomatic()) {
+        protocol = engineSettings_.networkLastKnownGoodProtocol(networkInterface.networkOrSsid);
+        if (!protocol.isValid()) {
+            api_responses::PortMap portMap(WSNet::instance()->apiResourcersManager()->portMap());
+            if (!portMap.const_items().isEmpty())
+                protocol = portMap.const_items().first().protocol;
+        }
+    }
+    if (!protocol.isWireGuardProtocol())
+        return;
+
+    QVector<LocationID> locationIds;
+    if (bestLocation_.isValid())
+        locationIds << bestLocation_;
+    if (locationId_.isValid() && !locationIds.contains(locationId_))
+        locationIds << locationId_;
+    for (const auto &lid : qAsConst(favoriteLocations_)) {
+        if (!locationIds.contains(lid))
+            locationIds << lid;
+    }
+
+    QVector<QSharedPointer<locationsmodel::BaseLocationInfo>> locations;
+    for (const auto &lid : qAsConst(locationIds)) {
+        QSharedPointer<locationsmodel::BaseLocationInfo> bli = locationsModel_->getMutableLocationInfoById(lid);
+        if (!bli.isNull())
+            locations << bli;
+    }
+    connectionManager_->prefetchWireGuardConfigs(locations);
+}
+
 void Engine::doDisconnectRestoreStuff()
 {
     vpnShareController_->onDisconnectedFromVPNEvent();
@@ -2519,6 +2623,7 @@ void Engine::doDisconnectRestoreStuff()
     bool bChanged;
     firewallExceptions_.setConnectingIp("", bChanged);
     firewallExceptions_.setDNSServers(QStringList(), bChanged);
+    firewallExceptions_.setReachabilityIps(QStringList(), bChanged);
 
     if (firewallController_->firewallActualState()) {
         firewallController_->firewallOn(
@@ -2558,9 +2663,18 @@ void Engine::updateSessionStatus(const std::string &json)
 
 void Engine::saveWsnetSettings()
 {
-    QString wsnetSettings = QString::fromStdString(WSNet::instance()->currentPersistentSettings());
+    // only the changed values are written, fall back to the single string in QSettings if the directory is not writable;
+    // after a failed save wsnet takes this string on the next start and rewrites the files. The string is not removed
+    // after a successful save, the previous versions read it on a downgrade
     QSettings settings;
-    settings.setValue("wsnetSettings", wsnetSettings);
+    if (!WSNet::instance()->savePersistentSettings()) {
+        qCDebug(LOG_BASIC) << "Failed to save the wsnet settings to the directory, keep them in QSettings";
+        QString wsnetSettings = QString::fromStdString(WSNet::instance()->currentPersistentSettings());
+        settings.setValue("wsnetSettings", wsnetSettings);
+        settings.setValue("wsnetSettingsDirStale", true);
+    } else {
+        settings.remove("wsnetSettingsDirStale");
+    }
 
     // To correctly downgrade keep authHash in QSettings
     QString authHash = QString::fromStdString(WSNet::instance()->apiResourcersManager()->authHash());
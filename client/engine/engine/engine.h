@@ -110,6 +110,8 @@ public:
     QString getSharingCaption();
 
     void applicationActivated();
+    // the favorite locations of the GUI, the WireGuard configs of these are prefetched
+    void setFavoriteLocations(const QVector<LocationID> &locations);
 
     void detectAppropriatePacketSize();
     void setSettingsMacAddressSpoofing(const types::MacAddrSpoofing &macAddrSpoofing);
@@ -252,6 +254,7 @@ private slots:
     void onConnectionManagerInterfaceUpdated(const QString &interfaceName);
     void onConnectionManagerConnectingToHostname(const QString &hostname, const QString &ip, const QStringList &dnsServers);
     void onConnectionManagerProtocolPortChanged(const types::Protocol &protocol, const uint port);
+    void onConnectionManagerReachabilityIpsChanged(const QStringList &ips);
     void onConnectionManagerTestTunnelResult(bool success, const QString & ipAddress);
     void onConnectionManagerWireGuardAtKeyLimit();
 
@@ -283,6 +286,8 @@ private slots:
     void onCustomConfigsChanged();
 
     void onLocationsModelWhitelistIpsChanged(const QStringList &ips);
+    void onLocationsModelLocationsUpdated(const LocationID &bestLocation, const QString &staticIpDeviceName, QSharedPointer<QVector<types::Location> > locations);
+    void onLocationsModelBestLocationUpdated(const LocationID &bestLocation);
     void onLocationsModelWhitelistCustomConfigIpsChanged(const QStringList &ips);
 
     void onNetworkOnlineStateChange(bool isOnline);
@@ -359,6 +364,8 @@ private:
 
     LocationID locationId_;
     QString locationName_;
+    LocationID bestLocation_;
+    QVector<LocationID> favoriteLocations_;
 
     QString lastConnectingHostname_;
     types::Protocol lastConnectingProtocol_;
@@ -374,11 +381,14 @@ private:
     void doCheckUpdate();
     void loginImpl(bool isUseAuthHash, const QString &username, const QString &password, const QString &code2fa);
     void updateServerLocations(const api_responses::ServerList &serverLocations, const api_responses::StaticIps &staticIps);
+    const api_responses::ServerList &currentServerList();
     void updateFirewallSettings();
 
     void addCustomRemoteIpToFirewallIfNeed();
     void doConnect(bool bEmitAuthError);
     void doDisconnectRestoreStuff();
+    // prefetches the WireGuard configs for the best, last and favorite locations if the next connection is likely WireGuard
+    void updateWireGuardConfigPrefetch();
 
     void stopFetchingServerCredentials();
 
@@ -399,6 +409,10 @@ private:
 
     bool checkAutoEnableAntiCensorship_ = false;
 
+    // the server list of wsnet and its conversion, converted again only when wsnet has a new list
+    std::shared_ptr<wsnet::WSNetServerList> wsnetServerList_;
+    api_responses::ServerList serverList_;
+
     bool isLoggedIn_ = false;
     bool isFetchingServerCredentials_ = false;
     bool tryLoginNextConnectOrDisconnect_ = false;
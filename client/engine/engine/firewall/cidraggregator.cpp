@@ -0,0 +1,113 @@
+#include "cidraggregator.h"
+
+namespace {
+
+bool parseIpv4(QStringView str, quint32 &ip)
+{
+    const auto parts = str.split(u'.');
+    if (parts.size() != 4)
+        return false;
+
+    ip = 0;
+    for (const auto &part : parts) {
+        bool ok;
+        const uint octet = part.toUInt(&ok);
+        if (!ok || octet > 255 || part.isEmpty() || part.size() > 3)
+            return false;
+        ip = (ip << 8) | octet;
+    }
+    return true;
+}
+
+quint32 prefixMask(int prefixLength)
+{
+    return prefixLength == 0 ? 0 : ~quint32(0) << (32 - prefixLength);
+}
+
+} // namespace
+
+CidrAggregator::CidrAggregator()
+{
+    nodes_.append(Node());
+}
+
+bool CidrAggregator::add(const QString &ipOrPrefix)
+{
+    QStringView str(ipOrPrefix);
+    int prefixLength = 32;
+    const qsizetype slash = str.indexOf(u'/');
+    if (slash >= 0) {
+        bool ok;
+        prefixLength = str.mid(slash + 1).toInt(&ok);
+        if (!ok || prefixLength < 0 || prefixLength > 32)
+            return false;
+        str = str.left(slash);
+    }
+
+    quint32 ip;
+    if (!parseIpv4(str.trimmed(), ip))
+        return false;
+    add(ip, prefixLength);
+    return true;
+}
+
+void CidrAggregator::add(quint32 ip, int prefixLength)
+{
+    ip &= prefixMask(prefixLength);
+
+    int path[32];
+    int node = 0;
+    for (int depth = 0; depth < prefixLength; ++depth) {
+        if (nodes_[node].isFull)
+            return;     // already covered by a shorter prefix
+        path[depth] = node;
+        const int bit = (ip >> (31 - depth)) & 1;
+        if (nodes_[node].child[bit] < 0) {
+            nodes_[node].child[bit] = nodes_.size();
+            nodes_.append(Node());
+        }
+        node = nodes_[node].child[bit];
+    }
+
+    if (nodes_[node].isFull)
+        return;
+    nodes_[node].isFull = true;
+    nodes_[node].child[0] = nodes_[node].child[1] = -1;
+
+    // merge the full siblings upwards
+    for (int depth = prefixLength - 1; depth >= 0; --depth) {
+        Node &parent = nodes_[path[depth]];
+        if (parent.child[0] < 0 || parent.child[1] < 0 || !nodes_[parent.child[0]].isFull || !nodes_[parent.child[1]].isFull)
+            break;
+        parent.isFull = true;
+        parent.child[0] = parent.child[1] = -1;
+    }
+}
+
+QStringList CidrAggregator::prefixes() const
+{
+    QStringList out;
+    collect(0, 0, 0, out);
+    return out;
+}
+
+QStringList CidrAggregator::aggregate(const QSet<QString> &ips)
+{
+    CidrAggregator aggregator;
+    for (const auto &ip : ips)
+        aggregator.add(ip);
+    return aggregator.prefixes();
+}
+
+void CidrAggregator::collect(int node, quint32 prefix, int prefixLength, QStringList &out) const
+{
+    const Node &n = nodes_[node];
+    if (n.isFull) {
+        out << QString("%1.%2.%3.%4/%5").arg(prefix >> 24).arg((prefix >> 16) & 0xFF).arg((prefix >> 8) & 0xFF).arg(prefix & 0xFF).arg(prefixLength);
+        return;
+    }
+    for (int bit = 0; bit < 2; ++bit) {
+        if (n.child[bit] >= 0)
+            collect(n.child[bit], prefix | (quint32(bit) << (31 - prefixLength)), prefixLength + 1, out);
+    }
+}
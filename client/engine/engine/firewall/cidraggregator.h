@@ -0,0 +1,35 @@
+#pragma once
+
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+// Coalesces IPv4 addresses and prefixes into the minimal list of CIDR prefixes that covers exactly the same addresses.
+// The addresses are kept in a binary radix trie: a node is marked full when its whole prefix is covered, a prefix under
+// a full node is ignored, and two full siblings are merged into their parent.
+class CidrAggregator
+{
+public:
+    CidrAggregator();
+
+    // accepts "a.b.c.d" and "a.b.c.d/n", returns false for anything else (IPv6 addresses and hostnames are not supported)
+    bool add(const QString &ipOrPrefix);
+    void add(quint32 ip, int prefixLength);
+
+    // sorted by address, in the "a.b.c.d/n" format (single addresses as /32)
+    QStringList prefixes() const;
+
+    static QStringList aggregate(const QSet<QString> &ips);
+
+private:
+    struct Node
+    {
+        qint32 child[2] = { -1, -1 };
+        bool isFull = false;
+    };
+
+    // nodes_[0] is the root (0.0.0.0/0); the subtrees of merged nodes are not reclaimed, the aggregator is short-lived
+    QVector<Node> nodes_;
+
+    void collect(int node, quint32 prefix, int prefixLength, QStringList &out) const;
+};
@@ -0,0 +1,227 @@
+#include "cidraggregator.test.h"
+
+#include <QElapsedTimer>
+#include <QProcess>
+#include <QRandomGenerator>
+#include <unistd.h>
+#include <vector>
+
+#include "cidraggregator.h"
+
+namespace {
+
+QString ipToString(quint32 ip)
+{
+    return QString("%1.%2.%3.%4").arg(ip >> 24).arg((ip >> 16) & 0xFF).arg((ip >> 8) & 0xFF).arg(ip & 0xFF);
+}
+
+// server addresses are not uniform, they come in clusters of the hosting providers
+QSet<QString> randomWhitelist(int count, quint32 seed)
+{
+    QRandomGenerator rng(seed);
+    QVector<quint32> networks;
+    for (int i = 0; i < qMax(1, count / 200); ++i)
+        networks << (rng.generate() & 0xFFFF0000);
+
+    QSet<QString> ips;
+    while (ips.size() < count)
+        ips << ipToString(networks[rng.bounded(networks.size())] | rng.bounded(0x10000));
+    return ips;
+}
+
+bool runTool(const QString &program, const QStringList &args, const QByteArray &input = QByteArray())
+{
+    QProcess process;
+    process.start(program, args);
+    if (!process.waitForStarted())
+        return false;
+    process.write(input);
+    process.closeWriteChannel();
+    return process.waitForFinished(-1) && process.exitStatus() == QProcess::NormalExit && process.exitCode() == 0;
+}
+
+} // namespace
+
+void TestCidrAggregator::testSingleAddresses()
+{
+    CidrAggregator aggregator;
+    QVERIFY(aggregator.add("10.0.0.5"));
+    QVERIFY(aggregator.add("8.8.8.8"));
+    QVERIFY(aggregator.add("10.0.0.5"));
+    QCOMPARE(aggregator.prefixes(), QStringList({ "8.8.8.8/32", "10.0.0.5/32" }));
+}
+
+void TestCidrAggregator::testMergeSiblings()
+{
+    // 4 addresses of one /30 merge into it, the next address is not its sibling and stays apart
+    CidrAggregator aggregator;
+    for (const auto &ip : { "192.168.1.4", "192.168.1.5", "192.168.1.6", "192.168.1.7", "192.168.1.8" })
+        QVERIFY(aggregator.add(ip));
+    QCOMPARE(aggregator.prefixes(), QStringList({ "192.168.1.4/30", "192.168.1.8/32" }));
+
+    // .2 and .3 are siblings, but .3 and .4 are not
+    CidrAggregator aggregator2;
+    for (const auto &ip : { "1.1.1.3", "1.1.1.4" })
+        QVERIFY(aggregator2.add(ip));
+    QCOMPARE(aggregator2.prefixes(), QStringList({ "1.1.1.3/32", "1.1.1.4/32" }));
+
+    // the whole address space
+    CidrAggregator aggregator3;
+    QVERIFY(aggregator3.add("0.0.0.0/1"));
+    QVERIFY(aggregator3.add("128.0.0.0/1"));
+    QCOMPARE(aggregator3.prefixes(), QStringList({ "0.0.0.0/0" }));
+}
+
+void TestCidrAggregator::testCoveredPrefixes()
+{
+    CidrAggregator aggregator;
+    QVERIFY(aggregator.add("10.1.2.3"));
+    QVERIFY(aggregator.add("10.1.0.0/16"));
+    QVERIFY(aggregator.add("10.1.200.1"));
+    // the host bits of a prefix are ignored
+    QVERIFY(aggregator.add("10.2.3.4/24"));
+    QCOMPARE(aggregator.prefixes(), QStringList({ "10.1.0.0/16", "10.2.3.0/24" }));
+}
+
+void TestCidrAggregator::testInvalidInput()
+{
+    CidrAggregator aggregator;
+    QVERIFY(!aggregator.add(""));
+    QVERIFY(!aggregator.add("1.2.3"));
+    QVERIFY(!aggregator.add("1.2.3.4.5"));
+    QVERIFY(!aggregator.add("1.2.3.256"));
+    QVERIFY(!aggregator.add("1.2.3.4/33"));
+    QVERIFY(!aggregator.add("1.2.3.4/"));
+    QVERIFY(!aggregator.add("::1"));
+    QVERIFY(!aggregator.add("api.windscribe.com"));
+    QVERIFY(aggregator.prefixes().isEmpty());
+
+    QCOMPARE(CidrAggregator::aggregate({ "2001:db8::1", "1.2.3.4" }), QStringList({ "1.2.3.4/32" }));
+}
+
+void TestCidrAggregator::testRandomAgainstBruteForce()
+{
+    // random subsets of a /20, the result must cover exactly the same addresses with the minimal number of prefixes
+    const quint32 base = 0x0A140000;   // 10.20.0.0/20
+    const int size = 4096;
+    QRandomGenerator rng(12345);
+    for (int iteration = 0; iteration < 50; ++iteration) {
+        std::vector<bool> expected(size, false);
+        CidrAggregator aggregator;
+        const int count = rng.bounded(1, size);
+        for (int i = 0; i < count; ++i) {
+            // mostly addresses, sometimes short prefixes
+            const int prefixLength = rng.bounded(10) == 0 ? rng.bounded(24, 32) : 32;
+            const quint32 blockSize = 1u << (32 - prefixLength);
+            const quint32 offset = rng.bounded(size) & ~(blockSize - 1);
+            aggregator.add(base + offset, prefixLength);
+            for (quint32 k = 0; k < blockSize; ++k)
+                expected[offset + k] = true;
+        }
+
+        std::vector<bool> covered(size, false);
+        QSet<QPair<quint32, int>> prefixes;
+        for (const auto &prefix : aggregator.prefixes()) {
+            const auto parts = prefix.split('/');
+            const auto octets = parts[0].split('.');
+            const quint32 ip = (octets[0].toUInt() << 24) | (octets[1].toUInt() << 16) | (octets[2].toUInt() << 8) | octets[3].toUInt();
+            const int prefixLength = parts[1].toInt();
+            QVERIFY(prefixLength >= 20 && (ip & ~(0xFFFFFFFFu << (32 - prefixLength))) == 0);
+            for (quint32 k = 0; k < (1u << (32 - prefixLength)); ++k) {
+                QVERIFY(!covered[ip - base + k]);   // no overlaps
+                covered[ip - base + k] = true;
+            }
+            prefixes.insert(qMakePair(ip, prefixLength));
+        }
+        QVERIFY(covered == expected);
+
+        // minimal: no two prefixes could be merged into their parent
+        for (const auto &p : prefixes) {
+            const quint32 sibling = p.first ^ (1u << (32 - p.second));
+            QVERIFY(!prefixes.contains(qMakePair(sibling, p.second)));
+        }
+    }
+}
+
+void TestCidrAggregator::benchmarkAggregate_data()
+{
+    QTest::addColumn<int>("count");
+    for (int count : { 1000, 5000, 20000, 100000 })
+        QTest::newRow(qPrintable(QString::number(count))) << count;
+}
+
+void TestCidrAggregator::benchmarkAggregate()
+{
+    QFETCH(int, count);
+    const QSet<QString> ips = randomWhitelist(count, count);
+
+    QStringList prefixes;
+    QBENCHMARK {
+        prefixes = CidrAggregator::aggregate(ips);
+    }
+    qInfo("%d addresses -> %lld prefixes", count, static_cast<long long>(prefixes.size()));
+    QVERIFY(prefixes.size() <= count);
+}
+
+void TestCidrAggregator::benchmarkApply_data()
+{
+    benchmarkAggregate_data();
+}
+
+void TestCidrAggregator::benchmarkApply()
+{
+    if (geteuid() != 0 || !qEnvironmentVariableIsSet("WS_FIREWALL_BENCHMARK_APPLY"))
+        QSKIP("requires root and WS_FIREWALL_BENCHMARK_APPLY");
+
+    QFETCH(int, count);
+    const QSet<QString> ips = randomWhitelist(count, count);
+    const QStringList prefixes = CidrAggregator::aggregate(ips);
+    const QString chain = "ws_bench_whitelist";
+    const QString set = "ws_bench_whitelist";
+
+    // the previous way: the whole chain with two rules per address, rewritten on every change
+    QByteArray rules = "*filter\n:" + chain.toLatin1() + " - [0:0]\n";
+    for (const auto &ip : ips) {
+        rules += "-A " + chain.toLatin1() + " -s " + ip.toLatin1() + "/32 -j ACCEPT\n";
+        rules += "-A " + chain.toLatin1() + " -d " + ip.toLatin1() + "/32 -j ACCEPT\n";
+    }
+    rules += "COMMIT\n";
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY(runTool("iptables-restore", { "-n" }, rules));
+    const qint64 rulesMs = timer.elapsed();
+    runTool("iptables-restore", { "-n" }, "*filter\n-F " + chain.toLatin1() + "\n-X " + chain.toLatin1() + "\nCOMMIT\n");
+
+    // the set: filled once, then only the difference is applied (1% of the addresses replaced)
+    QVERIFY(runTool("ipset", { "create", set, "hash:net", "family", "inet", "-exist" }));
+    QByteArray fill;
+    for (const auto &prefix : prefixes)
+        fill += "add " + set.toLatin1() + " " + prefix.toLatin1() + "\n";
+    timer.restart();
+    QVERIFY(runTool("ipset", { "-exist", "restore" }, fill));
+    const qint64 fillMs = timer.elapsed();
+
+    QSet<QString> changedIps = ips;
+    const QSet<QString> extraIps = randomWhitelist(qMax(1, count / 100), count + 1);
+    int removed = 0;
+    for (auto it = changedIps.begin(); it != changedIps.end() && removed < extraIps.size(); ++removed)
+        it = changedIps.erase(it);
+    changedIps.unite(extraIps);
+    const QStringList changedPrefixes = CidrAggregator::aggregate(changedIps);
+    const QSet<QString> oldSet(prefixes.begin(), prefixes.end());
+    const QSet<QString> newSet(changedPrefixes.begin(), changedPrefixes.end());
+    QByteArray diff;
+    for (const auto &prefix : newSet - oldSet)
+        diff += "add " + set.toLatin1() + " " + prefix.toLatin1() + "\n";
+    for (const auto &prefix : oldSet - newSet)
+        diff += "del " + set.toLatin1() + " " + prefix.toLatin1() + "\n";
+    timer.restart();
+    QVERIFY(runTool("ipset", { "-exist", "restore" }, diff));
+    const qint64 diffMs = timer.elapsed();
+    runTool("ipset", { "destroy", set });
+
+    qInfo("%d addresses: %d rules applied in %lld ms; %lld set entries filled in %lld ms, 1%% change applied in %lld ms",
+          count, 2 * count, rulesMs, static_cast<long long>(prefixes.size()), fillMs, diffMs);
+}
+
+QTEST_MAIN(TestCidrAggregator)
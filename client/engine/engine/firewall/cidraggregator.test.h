@@ -0,0 +1,23 @@
+#pragma once
+
+#include <QObject>
+#include <QTest>
+
+// tests of CidrAggregator and benchmarks of the firewall whitelist versus its size: the aggregation itself, and
+// (as root, with the WS_FIREWALL_BENCHMARK_APPLY environment variable set) the time to apply the whitelist as a rule
+// per address with iptables-restore versus as an ipset, in a temporary chain and set that are removed afterwards
+class TestCidrAggregator : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testSingleAddresses();
+    void testMergeSiblings();
+    void testCoveredPrefixes();
+    void testInvalidInput();
+    void testRandomAgainstBruteForce();
+    void benchmarkAggregate_data();
+    void benchmarkAggregate();
+    void benchmarkApply_data();
+    void benchmarkApply();
+};
@@ -5,9 +5,11 @@
 #include <QDir>
 #include <QRegularExpression>
 #include "engine/helper/ihelper.h"
+#include "cidraggregator.h"
+#include "../../../../backend/posix_common/helper_commands.h"
 
 FirewallController_linux::FirewallController_linux(QObject *parent, IHelper *helper) :
-    FirewallController(parent), forceUpdateInterfaceToSkip_(false), comment_("Windscribe client rule")
+    FirewallController(parent), forceUpdateInterfaceToSkip_(false), comment_("Windscribe client rule"), isWhitelistIpSet_(false)
 {
     helper_ = dynamic_cast<Helper_linux *>(helper);
 }
@@ -19,8 +21,18 @@ FirewallController_linux::~FirewallController_linux()
 bool FirewallController_linux::firewallOn(const QString &connectingIp, const QSet<QString> &ips, bool bAllowLanTraffic, bool bIsCustomConfig)
 {
     QMutexLocker locker(&mutex_);
+    const bool isOnlyIpsChanged = bInitialized_ && latestEnabledState_ && latestConnectingIp_ == connectingIp &&
+                                  latestAllowLanTraffic_ == bAllowLanTraffic && latestIsCustomConfig_ == bIsCustomConfig;
     FirewallController::firewallOn(connectingIp, ips, bAllowLanTraffic, bIsCustomConfig);
-    if (isStateChanged()) {
+    if (isStateChanged() && isOnlyIpsChanged && isWhitelistIpSet_ && !forceUpdateInterfaceToSkip_) {
+        // the rules are the same, only the added and removed prefixes are applied to the set
+        if (updateWhitelist(CidrAggregator::aggregate(ips))) {
+            qCDebug(LOG_FIREWALL_CONTROLLER) << "firewall whitelist updated with ips count:" << ips.count();
+            return true;
+        }
+        qCDebug(LOG_FIREWALL_CONTROLLER) << "firewall whitelist update failed, reapply the rules";
+        return firewallOnImpl(connectingIp, ips, bAllowLanTraffic, bIsCustomConfig, latestStaticIpPorts_);
+    } else if (isStateChanged()) {
         qCDebug(LOG_FIREWALL_CONTROLLER) << "firewall enabled with ips count:" << ips.count() + 1;
         return firewallOnImpl(connectingIp, ips, bAllowLanTraffic, bIsCustomConfig, latestStaticIpPorts_);
     } else if (forceUpdateInterfaceToSkip_) {
@@ -99,6 +111,10 @@ bool FirewallController_linux::firewallOnImpl(const QString &connectingIp, const
     forceUpdateInterfaceToSkip_ = false;
     bool bExists = firewallActualState();
 
+    // the set is filled before the rules which reference it are applied
+    const QStringList whitelist = CidrAggregator::aggregate(ips);
+    updateWhitelist(whitelist);
+
     // rules for IPv4
     {
         QStringList rules;
@@ -165,9 +181,14 @@ bool FirewallController_linux::firewallOnImpl(const QString &connectingIp, const
             rules << "-A windscribe_output -d " + connectingIp + "/32 -j ACCEPT -m mark --mark 51820 -m comment --comment \"" + comment_ + "\"\n";
         }
 
-        for (const auto &i : ips) {
-            rules << "-A windscribe_input -s " + i + "/32 -j ACCEPT -m comment --comment \"" + comment_ + "\"\n";
-            rules << "-A windscribe_output -d " + i + "/32 -j ACCEPT -m comment --comment \"" + comment_ + "\"\n";
+        if (isWhitelistIpSet_) {
+            rules << "-A windscribe_input -m set --match-set " HELPER_FIREWALL_WHITELIST_IPSET " src -j ACCEPT -m comment --comment \"" + comment_ + "\"\n";
+            rules << "-A windscribe_output -m set --match-set " HELPER_FIREWALL_WHITELIST_IPSET " dst -j ACCEPT -m comment --comment \"" + comment_ + "\"\n";
+        } else {
+            for (const auto &prefix : whitelist) {
+                rules << "-A windscribe_input -s " + prefix + " -j ACCEPT -m comment --comment \"" + comment_ + "\"\n";
+                rules << "-A windscribe_output -d " + prefix + " -j ACCEPT -m comment --comment \"" + comment_ + "\"\n";
+            }
         }
 
         // drop filter for the hotspot adapter in the disconnected state
@@ -241,6 +262,12 @@ bool FirewallController_linux::firewallOnImpl(const QString &connectingIp, const
     return true;
 }
 
+bool FirewallController_linux::updateWhitelist(const QStringList &prefixes)
+{
+    isWhitelistIpSet_ = helper_->setFirewallWhitelist(prefixes);
+    return isWhitelistIpSet_;
+}
+
 // Extract rules from iptables with comment.If modifyForDelete == true, then replace commands for delete.
 QStringList FirewallController_linux::getWindscribeRules(const QString &comment, bool modifyForDelete, bool isIPv6)
 {
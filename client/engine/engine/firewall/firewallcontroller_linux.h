@@ -28,6 +28,10 @@ private:
     QRecursiveMutex mutex_;
     QString pathToTempTable_;
     QString comment_;
+    // true if the whitelisted ips are in the helper ipset, then the rules only reference the set
+    bool isWhitelistIpSet_;
+
+    bool updateWhitelist(const QStringList &prefixes);
 
     bool firewallOnImpl(const QString &connectingIp, const QSet<QString> &ips, bool bAllowLanTraffic, bool bIsCustomConfig, const api_responses::StaticIpPortsVector &ports);
     QStringList getWindscribeRules(const QString &comment, bool modifyForDelete, bool isIPv6);
@@ -52,6 +52,16 @@ void FirewallExceptions::setDNSServers(const QStringList &ips, bool &bChanged)
     }
 }
 
+void FirewallExceptions::setReachabilityIps(const QStringList &ips, bool &bChanged)
+{
+    if (reachabilityIps_ != ips) {
+        reachabilityIps_ = ips;
+        bChanged = true;
+    } else {
+        bChanged = false;
+    }
+}
+
 void FirewallExceptions::setDnsPolicy(DNS_POLICY_TYPE dnsPolicy)
 {
     dnsPolicyType_ = dnsPolicy;
@@ -121,6 +131,12 @@ QSet<QString> FirewallExceptions::getIPAddressesForFirewall() const
     for (const QString &s : dnsIps_)
             ipList.add(s);
 
+    for (const QString &s : reachabilityIps_) {
+        if (!s.isEmpty()) {
+            ipList.add(s);
+        }
+    }
+
     for (const QString &sl : locationsPingIPs_) {
         if (!sl.isEmpty()) {
             ipList.add(sl);
@@ -14,6 +14,8 @@ public:
     void setCustomRemoteIp(const QString &remoteIP, bool &bChanged);
     void setConnectingIp(const QString &connectingIp, bool &bChanged);
     void setDNSServers(const QStringList &ips, bool &bChanged);
+    // the nodes probed by the reachability race before the first connection attempt
+    void setReachabilityIps(const QStringList &ips, bool &bChanged);
 
     void setDnsPolicy(DNS_POLICY_TYPE dnsPolicy);
 
@@ -33,6 +35,7 @@ private:
     QStringList customConfigsPingIPs_;
     QString connectingIp_;
     QStringList dnsIps_;
+    QStringList reachabilityIps_;
     DNS_POLICY_TYPE dnsPolicyType_;
 
 };
@@ -45,8 +45,6 @@ std::optional<bool> Helper_linux::installUpdate(const QString &package) const
 
 bool Helper_linux::setDnsLeakProtectEnabled(bool bEnabled)
 {
-    QMutexLocker locker(&mutex_);
-
     CMD_ANSWER answer;
     CMD_SET_DNS_LEAK_PROTECT_ENABLED cmd;
     cmd.enabled = bEnabled;
@@ -60,8 +58,6 @@ bool Helper_linux::setDnsLeakProtectEnabled(bool bEnabled)
 
 bool Helper_linux::resetMacAddresses(const QString &ignoreNetwork)
 {
-    QMutexLocker locker(&mutex_);
-
     CMD_ANSWER answer;
     CMD_RESET_MAC_ADDRESSES cmd;
     cmd.ignoreNetwork = ignoreNetwork.toStdString();
@@ -73,3 +69,38 @@ bool Helper_linux::resetMacAddresses(const QString &ignoreNetwork)
     return runCommand(HELPER_CMD_RESET_MAC_ADDRESSES, stream.str(), answer) && answer.executed;
 }
 
+bool Helper_linux::subscribeWireGuardStatus(unsigned int statsIntervalMs)
+{
+    {
+        // the helper sends the current status on subscription, drop the one left from the previous connection
+        QMutexLocker locker(&wireGuardStatusMutex_);
+        isWireGuardStatusUpdated_ = false;
+        isWireGuardStatusWaitCancelled_ = false;
+    }
+
+    CMD_ANSWER answer;
+    CMD_SUBSCRIBE_WIREGUARD_STATUS cmd;
+    cmd.statsIntervalMs = statsIntervalMs;
+
+    std::stringstream stream;
+    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
+    oa << cmd;
+
+    return runCommand(HELPER_CMD_SUBSCRIBE_WIREGUARD_STATUS, stream.str(), answer) && answer.executed;
+}
+
+bool Helper_linux::setFirewallWhitelist(const QStringList &entries)
+{
+    CMD_ANSWER answer;
+    CMD_SET_FIREWALL_WHITELIST cmd;
+    cmd.entries.reserve(entries.size());
+    for (const QString &entry : entries)
+        cmd.entries.push_back(entry.toStdString());
+
+    std::stringstream stream;
+    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
+    oa << cmd;
+
+    return runCommand(HELPER_CMD_SET_FIREWALL_WHITELIST, stream.str(), answer) && answer.executed && answer.exitCode == 1;
+}
+
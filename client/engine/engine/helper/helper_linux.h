@@ -18,4 +18,8 @@ public:
     std::optional<bool> installUpdate(const QString& package) const;
     bool setDnsLeakProtectEnabled(bool bEnabled);
     bool resetMacAddresses(const QString &ignoreNetwork = "");
+    // the helper pushes the WireGuard status on change, read it with waitForWireGuardStatus(); 0 unsubscribes
+    bool subscribeWireGuardStatus(unsigned int statsIntervalMs);
+    // returns true if the helper keeps the entries in the HELPER_FIREWALL_WHITELIST_IPSET set
+    bool setFirewallWhitelist(const QStringList &entries);
 };
@@ -76,7 +76,6 @@ bool Helper_mac::reinstallHelper()
 
 QString Helper_mac::getHelperVersion()
 {
-    QMutexLocker locker(&mutex_);
     CMD_ANSWER answer;
     if (runCommand(HELPER_CMD_HELPER_VERSION, std::string(), answer))
         return QString::fromStdString(answer.body);
@@ -86,8 +85,6 @@ QString Helper_mac::getHelperVersion()
 
 QString Helper_mac::getInterfaceSsid(const QString &interfaceName)
 {
-    QMutexLocker locker(&mutex_);
-
     CMD_GET_INTERFACE_SSID cmd;
     CMD_ANSWER answer;
     cmd.interface = interfaceName.toStdString();
@@ -105,8 +102,6 @@ QString Helper_mac::getInterfaceSsid(const QString &interfaceName)
 
 bool Helper_mac::enableMacSpoofingOnBoot(bool bEnabled, const QString &interface, const QString &macAddress)
 {
-    QMutexLocker locker(&mutex_);
-
     CMD_SET_MAC_SPOOFING_ON_BOOT cmd;
     CMD_ANSWER answer;
     cmd.enabled = bEnabled;
@@ -122,8 +117,6 @@ bool Helper_mac::enableMacSpoofingOnBoot(bool bEnabled, const QString &interface
 
 bool Helper_mac::setDnsOfDynamicStoreEntry(const QString &ipAddress, const QString &entry)
 {
-    QMutexLocker locker(&mutex_);
-
     CMD_APPLY_CUSTOM_DNS cmd;
     cmd.ipAddress = ipAddress.toStdString();
     cmd.networkService = entry.toStdString();
@@ -145,8 +138,6 @@ bool Helper_mac::setDnsOfDynamicStoreEntry(const QString &ipAddress, const QStri
 
 bool Helper_mac::setIpv6Enabled(bool bEnabled)
 {
-    QMutexLocker locker(&mutex_);
-
     CMD_ANSWER answer;
     CMD_SET_IPV6_ENABLED cmd;
     cmd.enabled = bEnabled;
@@ -165,6 +156,9 @@ void Helper_mac::doDisconnectAndReconnect()
 
 bool Helper_mac::runCommand(int cmdId, const std::string &data, CMD_ANSWER &answer)
 {
+    // the XPC helper handles one request at a time, so the commands of all the engine threads are serialized here
+    QMutexLocker locker(&mutex_);
+
     xpc_object_t message = xpc_dictionary_create(NULL, NULL, 0);
     xpc_dictionary_set_int64(message, "cmdId", cmdId);
     xpc_dictionary_set_data(message, "data", data.c_str(), data.size());
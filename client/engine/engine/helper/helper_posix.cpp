@@ -29,8 +29,13 @@ using namespace boost::asio;
 
 Helper_posix *g_this_ = NULL;
 
-Helper_posix::Helper_posix(QObject *parent) : IHelper(parent), bIPV6State_(true), cmdId_(0), lastOpenVPNCmdId_(0)
-  , ep_(SOCK_PATH), bHelperConnectedEmitted_(false)
+Helper_posix::Helper_posix(QObject *parent) : Helper_posix(parent, SOCK_PATH)
+{
+}
+
+Helper_posix::Helper_posix(QObject *parent, const std::string &socketPath) : IHelper(parent), bIPV6State_(true), cmdId_(0), nextRequestId_(0), connectionId_(0),
+    isWireGuardStatusUpdated_(false), isWireGuardStatusWaitCancelled_(false), lastOpenVPNCmdId_(0)
+  , ep_(socketPath), bHelperConnectedEmitted_(false)
   , curState_(STATE_INIT), bNeedFinish_(false), firstConnectToHelperErrorReported_(false)
 {
     WS_ASSERT(g_this_ == NULL);
@@ -42,6 +47,7 @@ Helper_posix::~Helper_posix()
     io_service_.stop();
     setNeedFinish();
     wait();
+    failPendingRequests();
     g_this_ = NULL;
 }
 
@@ -57,9 +63,20 @@ void Helper_posix::setNeedFinish()
 
 void Helper_posix::getUnblockingCmdStatus(unsigned long cmdId, QString &outLog, bool &outFinished)
 {
-    QMutexLocker locker(&mutex_);
-
     outFinished = false;
+
+    // finished commands are pushed by the helper
+    {
+        QMutexLocker locker(&finishedCmdsMutex_);
+        auto it = finishedCmds_.find(cmdId);
+        if (it != finishedCmds_.end()) {
+            outFinished = true;
+            outLog = it.value();
+            finishedCmds_.erase(it);
+            return;
+        }
+    }
+
     if (curState_ != STATE_CONNECTED)
     {
         return;
@@ -86,7 +103,10 @@ void Helper_posix::clearUnblockingCmd(unsigned long cmdId)
 {
     Q_UNUSED(cmdId);
 
-    QMutexLocker locker(&mutex_);
+    {
+        QMutexLocker locker(&finishedCmdsMutex_);
+        finishedCmds_.clear();
+    }
 
     if (curState_ != STATE_CONNECTED) {
         return;
@@ -114,8 +134,6 @@ bool Helper_posix::setSplitTunnelingSettings(bool isActive, bool isExclude,
                                            bool isAllowLanTraffic, const QStringList &files,
                                            const QStringList &ips, const QStringList &hosts)
 {
-    QMutexLocker locker(&mutex_);
-
     if (curState_ != STATE_CONNECTED) {
         return false;
     }
@@ -155,8 +173,6 @@ bool Helper_posix::sendConnectStatus(bool isConnected, bool isTerminateSocket, b
 {
     Q_UNUSED(isTerminateSocket);
     Q_UNUSED(isKeepLocalSocket);
-    QMutexLocker locker(&mutex_);
-
     if (curState_ != STATE_CONNECTED) {
         return false;
     }
@@ -216,8 +232,6 @@ bool Helper_posix::sendConnectStatus(bool isConnected, bool isTerminateSocket, b
 
 bool Helper_posix::changeMtu(const QString &adapter, int mtu)
 {
-    QMutexLocker locker(&mutex_);
-
     CMD_ANSWER answer;
     CMD_CHANGE_MTU cmd;
     cmd.mtu = mtu;
@@ -232,8 +246,6 @@ bool Helper_posix::changeMtu(const QString &adapter, int mtu)
 
 bool Helper_posix::deleteRoute(const QString &range, int mask, const QString &gateway)
 {
-    QMutexLocker locker(&mutex_);
-
     CMD_ANSWER answer;
     CMD_DELETE_ROUTE cmd;
     cmd.range = range.toStdString();
@@ -249,8 +261,6 @@ bool Helper_posix::deleteRoute(const QString &range, int mask, const QString &ga
 
 IHelper::ExecuteError Helper_posix::startWireGuard()
 {
-    QMutexLocker locker(&mutex_);
-
     if (curState_ != STATE_CONNECTED) {
         return IHelper::EXECUTE_ERROR;
     }
@@ -267,8 +277,6 @@ IHelper::ExecuteError Helper_posix::startWireGuard()
 bool Helper_posix::stopWireGuard()
 {
     if (curState_ == STATE_CONNECTED) {
-        QMutexLocker locker(&mutex_);
-
         CMD_ANSWER answer;
         if (!runCommand(HELPER_CMD_STOP_WIREGUARD, "", answer)) {
             doDisconnectAndReconnect();
@@ -283,8 +291,6 @@ bool Helper_posix::stopWireGuard()
 
 bool Helper_posix::configureWireGuard(const WireGuardConfig &config)
 {
-    QMutexLocker locker(&mutex_);
-
     if (curState_ != STATE_CONNECTED)
         return false;
 
@@ -330,8 +336,6 @@ bool Helper_posix::configureWireGuard(const WireGuardConfig &config)
 
 bool Helper_posix::getWireGuardStatus(types::WireGuardStatus *status)
 {
-    QMutexLocker locker(&mutex_);
-
     if (status) {
         status->state = types::WireGuardState::NONE;
         status->errorCode = 0;
@@ -350,14 +354,51 @@ bool Helper_posix::getWireGuardStatus(types::WireGuardStatus *status)
         return false;
     }
 
-    switch (answer.cmdId) {
+    if (answer.cmdId == kWgStateError) {
+        toWireGuardStatus(answer.cmdId, answer.customInfoValue[0], 0, 0, status);
+    } else {
+        toWireGuardStatus(answer.cmdId, 0, answer.customInfoValue[0], answer.customInfoValue[1], status);
+    }
+    return true;
+}
+
+bool Helper_posix::waitForWireGuardStatus(types::WireGuardStatus *status, unsigned long timeoutMs)
+{
+    QMutexLocker locker(&wireGuardStatusMutex_);
+    if (!isWireGuardStatusUpdated_ && !isWireGuardStatusWaitCancelled_ && curState_ == STATE_CONNECTED) {
+        wireGuardStatusCondition_.wait(&wireGuardStatusMutex_, timeoutMs);
+    }
+    isWireGuardStatusWaitCancelled_ = false;
+    if (!isWireGuardStatusUpdated_) {
+        return false;
+    }
+    isWireGuardStatusUpdated_ = false;
+    *status = wireGuardStatus_;
+    return true;
+}
+
+void Helper_posix::cancelWaitForWireGuardStatus()
+{
+    QMutexLocker locker(&wireGuardStatusMutex_);
+    isWireGuardStatusWaitCancelled_ = true;
+    wireGuardStatusCondition_.wakeAll();
+}
+
+// static
+void Helper_posix::toWireGuardStatus(unsigned long state, unsigned int errorCode, quint64 bytesReceived,
+                                     quint64 bytesTransmitted, types::WireGuardStatus *status)
+{
+    status->errorCode = 0;
+    status->bytesReceived = status->bytesTransmitted = 0;
+
+    switch (state) {
     default:
     case kWgStateNone:
         status->state = types::WireGuardState::NONE;
         break;
     case kWgStateError:
         status->state = types::WireGuardState::FAILURE;
-        status->errorCode = answer.customInfoValue[0];
+        status->errorCode = errorCode;
         break;
     case kWgStateStarting:
         status->state = types::WireGuardState::STARTING;
@@ -370,17 +411,14 @@ bool Helper_posix::getWireGuardStatus(types::WireGuardStatus *status)
         break;
     case kWgStateActive:
         status->state = types::WireGuardState::ACTIVE;
-        status->bytesReceived = answer.customInfoValue[0];
-        status->bytesTransmitted = answer.customInfoValue[1];
+        status->bytesReceived = bytesReceived;
+        status->bytesTransmitted = bytesTransmitted;
         break;
     }
-    return true;
 }
 
 bool Helper_posix::startCtrld(const QString &upstream1, const QString &upstream2, const QStringList &domains, bool isCreateLog)
 {
-    QMutexLocker locker(&mutex_);
-
     if (curState_ != STATE_CONNECTED) {
         return false;
     }
@@ -419,8 +457,6 @@ IHelper::ExecuteError Helper_posix::executeOpenVPN(const QString &config, unsign
                                                    const QString &socksProxy, unsigned int socksPort, unsigned long &outCmdId, bool isCustomConfig)
 
 {
-    QMutexLocker locker(&mutex_);
-
     if (curState_ != STATE_CONNECTED) {
         return IHelper::EXECUTE_ERROR;
     }
@@ -465,8 +501,6 @@ IHelper::ExecuteError Helper_posix::executeOpenVPN(const QString &config, unsign
 
 bool Helper_posix::executeTaskKill(CmdKillTarget target)
 {
-    QMutexLocker locker(&mutex_);
-
     CMD_TASK_KILL cmd;
     CMD_ANSWER answer;
     cmd.target = target;
@@ -480,8 +514,6 @@ bool Helper_posix::executeTaskKill(CmdKillTarget target)
 
 bool Helper_posix::setDnsScriptEnabled(bool bEnabled)
 {
-    QMutexLocker locker(&mutex_);
-
     CMD_SET_DNS_SCRIPT_ENABLED cmd;
     CMD_ANSWER answer;
     cmd.enabled = bEnabled;
@@ -495,8 +527,6 @@ bool Helper_posix::setDnsScriptEnabled(bool bEnabled)
 
 bool Helper_posix::checkFirewallState(const QString &tag)
 {
-    QMutexLocker locker(&mutex_);
-
     CMD_CHECK_FIREWALL_STATE cmd;
     CMD_ANSWER answer;
     cmd.tag = tag.toStdString();
@@ -513,8 +543,6 @@ bool Helper_posix::checkFirewallState(const QString &tag)
 
 bool Helper_posix::clearFirewallRules(bool isKeepPfEnabled)
 {
-    QMutexLocker locker(&mutex_);
-
     CMD_CLEAR_FIREWALL_RULES cmd;
     CMD_ANSWER answer;
     cmd.isKeepPfEnabled = isKeepPfEnabled;
@@ -528,8 +556,6 @@ bool Helper_posix::clearFirewallRules(bool isKeepPfEnabled)
 
 bool Helper_posix::setFirewallRules(CmdIpVersion version, const QString &table, const QString &group, const QString &rules)
 {
-    QMutexLocker locker(&mutex_);
-
     CMD_SET_FIREWALL_RULES cmd;
     CMD_ANSWER answer;
     cmd.ipVersion = version;
@@ -546,8 +572,6 @@ bool Helper_posix::setFirewallRules(CmdIpVersion version, const QString &table,
 
 bool Helper_posix::getFirewallRules(CmdIpVersion version, const QString &table, const QString &group, QString &rules)
 {
-    QMutexLocker locker(&mutex_);
-
     CMD_GET_FIREWALL_RULES cmd;
     CMD_ANSWER answer;
     cmd.ipVersion = version;
@@ -567,8 +591,6 @@ bool Helper_posix::getFirewallRules(CmdIpVersion version, const QString &table,
 
 bool Helper_posix::setFirewallOnBoot(bool enabled, const QSet<QString> &ipTable, bool allowLanTraffic)
 {
-    QMutexLocker locker(&mutex_);
-
     CMD_SET_FIREWALL_ON_BOOT cmd;
     CMD_ANSWER answer;
     cmd.enabled = enabled;
@@ -591,8 +613,6 @@ bool Helper_posix::setFirewallOnBoot(bool enabled, const QSet<QString> &ipTable,
 
 bool Helper_posix::setMacAddress(const QString &interface, const QString &macAddress, const QString &network, bool isWifi)
 {
-    QMutexLocker locker(&mutex_);
-
     CMD_SET_MAC_ADDRESS cmd;
     CMD_ANSWER answer;
     cmd.interface = interface.toStdString();
@@ -609,8 +629,6 @@ bool Helper_posix::setMacAddress(const QString &interface, const QString &macAdd
 
 bool Helper_posix::startStunnel(const QString &hostname, unsigned int port, unsigned int localPort, bool extraPadding)
 {
-    QMutexLocker locker(&mutex_);
-
     CMD_START_STUNNEL cmd;
     cmd.hostname = hostname.toStdString();
     cmd.port = port;
@@ -632,8 +650,6 @@ bool Helper_posix::startStunnel(const QString &hostname, unsigned int port, unsi
 
 bool Helper_posix::startWstunnel(const QString &hostname, unsigned int port, unsigned int localPort)
 {
-    QMutexLocker locker(&mutex_);
-
     CMD_START_WSTUNNEL cmd;
     cmd.hostname = hostname.toStdString();
     cmd.port = port;
@@ -666,13 +682,19 @@ void Helper_posix::run()
 void Helper_posix::connectHandler(const boost::system::error_code &ec)
 {
     if (!ec) {
-        // we connected
-        g_this_->curState_ = STATE_CONNECTED;
+        // we connected; the messages queued for the previous connection are not sent on this one
+        g_this_->writeQueue_.clear();
+        {
+            std::lock_guard<std::mutex> locker(g_this_->pendingMutex_);
+            ++g_this_->connectionId_;
+            g_this_->curState_ = STATE_CONNECTED;
+        }
         //emit signal only once on first run
         if (!g_this_->bHelperConnectedEmitted_) {
             g_this_->bHelperConnectedEmitted_ = true;
         }
         qCDebug(LOG_BASIC) << "connected to helper socket";
+        g_this_->startRead();
     } else {
         // only report the first error while connecting to helper in order to prevent log bloat
         // we want to see first error in case it is different than all following errors
@@ -684,6 +706,7 @@ void Helper_posix::connectHandler(const boost::system::error_code &ec)
         if (g_this_->reconnectElapsedTimer_.elapsed() > MAX_WAIT_HELPER) {
             if (!g_this_->bHelperConnectedEmitted_) {
                 qCDebug(LOG_BASIC) << "Error while connecting to helper: " << ec.value();
+                std::lock_guard<std::mutex> locker(g_this_->pendingMutex_);
                 g_this_->curState_ = STATE_FAILED_CONNECT;
             } else {
                 emit g_this_->lostConnectionToHelper();
@@ -701,76 +724,210 @@ void Helper_posix::connectHandler(const boost::system::error_code &ec)
 
 void Helper_posix::doDisconnectAndReconnect()
 {
+    QMutexLocker locker(&mutex_);
     if (!isRunning())
     {
         qCDebug(LOG_BASIC) << "Disconnected from helper socket, try reconnect";
-        g_this_->curState_ = STATE_INIT;
+        {
+            std::lock_guard<std::mutex> pendingLocker(pendingMutex_);
+            g_this_->curState_ = STATE_INIT;
+        }
         start(QThread::LowPriority);
     }
 }
 
 bool Helper_posix::runCommand(int cmdId, const std::string &data, CMD_ANSWER &answer)
 {
-    bool ret = sendCmdToHelper(cmdId, data);
-    if (!ret) {
-        return ret;
+    auto request = std::make_shared<PendingRequest>();
+    std::future<bool> future = request->promise.get_future();
+    quint32 requestId;
+    {
+        std::lock_guard<std::mutex> locker(pendingMutex_);
+        if (curState_ != STATE_CONNECTED) {
+            return false;
+        }
+
+        requestId = ++nextRequestId_;
+        if (requestId == 0) {
+            requestId = ++nextRequestId_;
+        }
+        pendingRequests_[requestId] = request;
+
+        auto message = std::make_shared<std::string>(HelperProtocol::makeMessage(HelperProtocol::kRequest, requestId, cmdId, getpid(), data));
+        const quint32 connectionId = connectionId_;
+        io_service_.post([this, message, connectionId]() {
+            // the connection was lost since the request was made, its pending request has been failed already
+            {
+                std::lock_guard<std::mutex> locker(pendingMutex_);
+                if (curState_ != STATE_CONNECTED || connectionId_ != connectionId) {
+                    return;
+                }
+            }
+            writeQueue_.push_back(message);
+            if (writeQueue_.size() == 1) {
+                startWrite();
+            }
+        });
     }
 
-    return readAnswer(answer);
+    if (future.wait_for(std::chrono::milliseconds(MAX_WAIT_COMMAND)) != std::future_status::ready) {
+        std::lock_guard<std::mutex> locker(pendingMutex_);
+        // if it is not pending anymore, the answer is being delivered right now
+        if (pendingRequests_.erase(requestId) != 0) {
+            qCDebug(LOG_BASIC) << "Helper command timed out:" << cmdId;
+            return false;
+        }
+    }
+    if (!future.get()) {
+        return false;
+    }
+
+    std::istringstream stream(request->answer);
+    boost::archive::text_iarchive ia(stream, boost::archive::no_header);
+    ia >> answer;
+    return true;
 }
 
-bool Helper_posix::readAnswer(CMD_ANSWER &outAnswer)
+void Helper_posix::startWrite()
 {
-    boost::system::error_code ec;
-    int length;
-    boost::asio::read(*socket_, boost::asio::buffer(&length, sizeof(length)),
-                      boost::asio::transfer_exactly(sizeof(length)), ec);
-    if (ec) {
-        return false;
-    } else {
-        std::vector<char> buff(length);
-        boost::asio::read(*socket_, boost::asio::buffer(&buff[0], length),
-                          boost::asio::transfer_exactly(length), ec);
+    std::shared_ptr<std::string> message = writeQueue_.front();
+    boost::asio::async_write(*socket_, boost::asio::buffer(*message),
+                             [this, message](const boost::system::error_code &ec, std::size_t) {
         if (ec) {
-            return false;
+            // the messages left are for a connection which is gone, so nothing is waiting for this write anymore
+            writeQueue_.clear();
+            onConnectionLost();
+            return;
+        }
+        writeQueue_.pop_front();
+        if (!writeQueue_.empty()) {
+            startWrite();
         }
+    });
+}
 
-        std::string str(buff.begin(), buff.end());
-        std::istringstream stream(str);
-        boost::archive::text_iarchive ia(stream, boost::archive::no_header);
-        ia >> outAnswer;
+void Helper_posix::startRead()
+{
+    boost::asio::async_read(*socket_, boost::asio::buffer(&readHeader_, sizeof(readHeader_)),
+                            [this](const boost::system::error_code &ec, std::size_t) {
+        onHeaderRead(ec);
+    });
+}
+
+void Helper_posix::onHeaderRead(const boost::system::error_code &ec)
+{
+    if (ec) {
+        onConnectionLost();
+        return;
+    }
+    if (!HelperProtocol::isValidHeader(readHeader_)) {
+        qCDebug(LOG_BASIC) << "Invalid message from the helper, version:" << readHeader_.version;
+        onConnectionLost();
+        return;
     }
 
-    return true;
+    readBody_.resize(readHeader_.length);
+    if (readBody_.empty()) {
+        onBodyRead(boost::system::error_code());
+        return;
+    }
+    boost::asio::async_read(*socket_, boost::asio::buffer(&readBody_[0], readBody_.size()),
+                            [this](const boost::system::error_code &ec, std::size_t) {
+        onBodyRead(ec);
+    });
 }
 
-bool Helper_posix::sendCmdToHelper(int cmdId, const std::string &data)
+void Helper_posix::onBodyRead(const boost::system::error_code &ec)
 {
-    int length = data.size();
-    boost::system::error_code ec;
-
-    // first 4 bytes - cmdId
-    boost::asio::write(*socket_, boost::asio::buffer(&cmdId, sizeof(cmdId)), boost::asio::transfer_exactly(sizeof(cmdId)), ec);
     if (ec) {
-        return false;
+        onConnectionLost();
+        return;
     }
-    // second 4 bytes - pid
-    const auto pid = getpid();
-    boost::asio::write(*socket_, boost::asio::buffer(&pid, sizeof(pid)), boost::asio::transfer_exactly(sizeof(pid)), ec);
-    if (ec) {
-        return false;
+
+    if (readHeader_.type == HelperProtocol::kAnswer) {
+        std::shared_ptr<PendingRequest> request;
+        {
+            std::lock_guard<std::mutex> locker(pendingMutex_);
+            auto it = pendingRequests_.find(readHeader_.requestId);
+            if (it != pendingRequests_.end()) {
+                request = it->second;
+                pendingRequests_.erase(it);
+            }
+        }
+        if (request) {
+            request->answer.swap(readBody_);
+            request->promise.set_value(true);
+        }
+    } else if (readHeader_.type == HelperProtocol::kEvent) {
+        handleEvent(readHeader_.id, readBody_);
     }
-    // third 4 bytes - size of buffer
-    boost::asio::write(*socket_, boost::asio::buffer(&length, sizeof(length)), boost::asio::transfer_exactly(sizeof(length)), ec);
-    if (ec) {
-        return false;
+
+    startRead();
+}
+
+void Helper_posix::handleEvent(int eventId, const std::string &data)
+{
+    if (eventId == HELPER_EVENT_CMD_FINISHED) {
+        EVENT_CMD_FINISHED event;
+        std::istringstream stream(data);
+        boost::archive::text_iarchive ia(stream, boost::archive::no_header);
+        ia >> event;
+
+        QMutexLocker locker(&finishedCmdsMutex_);
+        finishedCmds_[event.cmdId] = QString::fromStdString(event.log);
+    } else if (eventId == HELPER_EVENT_WIREGUARD_STATUS) {
+        EVENT_WIREGUARD_STATUS event;
+        std::istringstream stream(data);
+        boost::archive::text_iarchive ia(stream, boost::archive::no_header);
+        ia >> event;
+
+        QMutexLocker locker(&wireGuardStatusMutex_);
+        // an error without a code is reported as -1, the same as in the answer to HELPER_CMD_GET_WIREGUARD_STATUS
+        toWireGuardStatus(event.state, event.errorCode != 0 ? event.errorCode : (unsigned int)-1,
+                          event.bytesReceived, event.bytesTransmitted, &wireGuardStatus_);
+        isWireGuardStatusUpdated_ = true;
+        wireGuardStatusCondition_.wakeAll();
     }
-    // body of message
-    boost::asio::write(*socket_, boost::asio::buffer(data.data(), length), boost::asio::transfer_exactly(length), ec);
-    if (ec) {
-        doDisconnectAndReconnect();
-        return false;
+}
+
+void Helper_posix::onConnectionLost()
+{
+    {
+        std::lock_guard<std::mutex> locker(pendingMutex_);
+        if (curState_ != STATE_CONNECTED) {
+            return;
+        }
+        curState_ = STATE_INIT;
     }
 
-    return true;
+    qCDebug(LOG_BASIC) << "Disconnected from helper socket, try reconnect";
+    failPendingRequests();
+    writeQueue_.clear();
+    {
+        QMutexLocker locker(&wireGuardStatusMutex_);
+        wireGuardStatusCondition_.wakeAll();
+    }
+
+    boost::system::error_code ec;
+    socket_->close(ec);
+    if (isNeedFinish()) {
+        return;
+    }
+
+    reconnectElapsedTimer_.start();
+    QMutexLocker locker(&mutexSocket_);
+    socket_.reset(new boost::asio::local::stream_protocol::socket(io_service_));
+    socket_->async_connect(ep_, connectHandler);
+}
+
+void Helper_posix::failPendingRequests()
+{
+    std::map<quint32, std::shared_ptr<PendingRequest>> requests;
+    {
+        std::lock_guard<std::mutex> locker(pendingMutex_);
+        requests.swap(pendingRequests_);
+    }
+    for (auto &it : requests) {
+        it.second->promise.set_value(false);
+    }
 }
@@ -1,12 +1,21 @@
 #pragma once
 
 #include <QElapsedTimer>
+#include <QMap>
 #include <QThread>
 #include <QWaitCondition>
 #include <QMutex>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
 #include "ihelper.h"
+#include "types/wireguardtypes.h"
 #include "utils/boost_includes.h"
 #include "../../../../backend/posix_common/helper_commands.h"
+#include "../../../../backend/posix_common/helper_protocol.h"
 
 // common base helper for Linux/Mac
 class Helper_posix : public IHelper
@@ -40,6 +49,10 @@ public:
     bool stopWireGuard() override;
     bool configureWireGuard(const WireGuardConfig &config) override;
     bool getWireGuardStatus(types::WireGuardStatus *status) override;
+    // waits until the helper pushes a new WireGuard status, see Helper_linux::subscribeWireGuardStatus();
+    // returns false on timeout, after cancelWaitForWireGuardStatus() or when the connection to the helper is lost
+    bool waitForWireGuardStatus(types::WireGuardStatus *status, unsigned long timeoutMs);
+    void cancelWaitForWireGuardStatus();
 
     // ctrld functions
     bool startCtrld(const QString &upstream1, const QString &upstream2, const QStringList &domains, bool isCreateLog) override;
@@ -58,6 +71,9 @@ public:
     bool setMacAddress(const QString &interface, const QString &macAddress, const QString &network = "", bool isWifi = false);
 
 protected:
+    // connects to the helper socket at socketPath instead of the one of the installed helper
+    Helper_posix(QObject *parent, const std::string &socketPath);
+
     void run() override;
 
 protected:
@@ -80,6 +96,8 @@ protected:
     } WAITING_DATA;
 
     enum { MAX_WAIT_HELPER = 5000 };
+    // the longest helper commands run scripts, an answer which takes longer than this is not coming
+    enum { MAX_WAIT_COMMAND = 60000 };
 
     QString interfaceToSkip_;
     bool bIPV6State_;
@@ -92,6 +110,35 @@ protected:
     QMutex mutex_;
     unsigned long cmdId_;
 
+    // Requests are pipelined over one connection and matched to the answers by request id,
+    // so the commands of several engine threads can be in flight at the same time.
+    struct PendingRequest
+    {
+        std::promise<bool> promise;
+        std::string answer;
+    };
+    std::mutex pendingMutex_;
+    std::map<quint32, std::shared_ptr<PendingRequest>> pendingRequests_;
+    quint32 nextRequestId_;
+    // incremented on each connect, so that a request posted before a reconnect is not written to the new connection
+    quint32 connectionId_;
+
+    // accessed from the io_service thread only
+    std::deque<std::shared_ptr<std::string>> writeQueue_;
+    HelperProtocol::Header readHeader_;
+    std::string readBody_;
+
+    // results of the unblocking commands pushed by the helper, to answer getUnblockingCmdStatus() without a request
+    QMutex finishedCmdsMutex_;
+    QMap<unsigned long, QString> finishedCmds_;
+
+    // the latest WireGuard status pushed by the helper
+    QMutex wireGuardStatusMutex_;
+    QWaitCondition wireGuardStatusCondition_;
+    types::WireGuardStatus wireGuardStatus_;
+    bool isWireGuardStatusUpdated_;
+    bool isWireGuardStatusWaitCancelled_;
+
     std::atomic<unsigned long> lastOpenVPNCmdId_;
 
     boost::asio::io_service io_service_;
@@ -115,10 +162,18 @@ protected:
     static void connectHandler(const boost::system::error_code &ec);
     virtual void doDisconnectAndReconnect();
 
-    bool readAnswer(CMD_ANSWER &outAnswer);
-    bool sendCmdToHelper(int cmdId, const std::string &data);
     virtual bool runCommand(int cmdId, const std::string &data, CMD_ANSWER &answer);
 
+    void startRead();
+    void onHeaderRead(const boost::system::error_code &ec);
+    void onBodyRead(const boost::system::error_code &ec);
+    void startWrite();
+    void onConnectionLost();
+    void failPendingRequests();
+    void handleEvent(int eventId, const std::string &data);
+    static void toWireGuardStatus(unsigned long state, unsigned int errorCode, quint64 bytesReceived,
+                                  quint64 bytesTransmitted, types::WireGuardStatus *status);
+
 private:
     bool firstConnectToHelperErrorReported_;
 };
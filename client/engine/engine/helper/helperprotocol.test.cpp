@@ -0,0 +1,484 @@
+#include "helperprotocol.test.h"
+
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QThread>
+#include <atomic>
+#include <cstring>
+#include <future>
+#include <mutex>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "helper_posix.h"
+#include "types/wireguardtypes.h"
+#include "../../../../backend/linux/helper/ipc/command_server.h"
+#include "../../../../backend/posix_common/helper_commands_serialize.h"
+
+namespace {
+
+template<typename T>
+std::string serialize(const T &value)
+{
+    std::stringstream stream;
+    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
+    oa << value;
+    return stream.str();
+}
+
+template<typename T>
+T deserialize(const std::string &data)
+{
+    T value;
+    std::istringstream stream(data);
+    boost::archive::text_iarchive ia(stream, boost::archive::no_header);
+    ia >> value;
+    return value;
+}
+
+// the answer to CMD_GET_CMD_STATUS, with the id of the command in the log so each caller can check it got its own
+CMD_ANSWER getCmdStatusAnswer(const std::string &packet)
+{
+    CMD_GET_CMD_STATUS cmd = deserialize<CMD_GET_CMD_STATUS>(packet);
+    CMD_ANSWER answer;
+    answer.cmdId = cmd.cmdId;
+    answer.executed = 1;
+    answer.body = "status " + std::to_string(cmd.cmdId);
+    return answer;
+}
+
+template<typename Condition>
+bool waitFor(Condition condition, int timeoutMs = 5000)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!condition()) {
+        if (timer.elapsed() > timeoutMs)
+            return false;
+        QThread::msleep(1);
+    }
+    return true;
+}
+
+std::string socketPath(const QTemporaryDir &dir)
+{
+    return dir.filePath("helper.sock").toStdString();
+}
+
+// the helper side: the CommandServer of the helper accepting on the socket of the test, the commands are run by
+// the handler set by the test
+class TestServer
+{
+public:
+    explicit TestServer(const std::string &socketPath)
+        : acceptor_(service_, boost::asio::local::stream_protocol::endpoint(socketPath)),
+          commandServer_(service_, [this](int cmdId, const std::string &packet) { return handleCommand(cmdId, packet); },
+                         [](socket_ptr) { return true; }),
+          handler_([](int cmdId, const std::string &packet) {
+              if (cmdId == HELPER_CMD_GET_CMD_STATUS)
+                  return getCmdStatusAnswer(packet);
+              CMD_ANSWER answer;
+              answer.executed = 1;
+              return answer;
+          })
+    {
+        commandServer_.start();
+        startAccept();
+        thread_ = std::thread([this]() { service_.run(); });
+    }
+
+    ~TestServer()
+    {
+        service_.stop();
+        thread_.join();
+        commandServer_.stop();
+    }
+
+    void setHandler(CommandServer::CommandHandler handler)
+    {
+        std::lock_guard<std::mutex> locker(mutex_);
+        handler_ = handler;
+    }
+
+    void broadcastEvent(int eventId, const std::string &payload)
+    {
+        commandServer_.broadcastEvent(eventId, payload);
+    }
+
+    // closes the connections of the engine, as when the helper restarts
+    void closeConnections()
+    {
+        service_.post([this]() {
+            for (auto &sock : sockets_) {
+                boost::system::error_code ec;
+                sock->close(ec);
+            }
+            sockets_.clear();
+        });
+    }
+
+private:
+    CMD_ANSWER handleCommand(int cmdId, const std::string &packet)
+    {
+        CommandServer::CommandHandler handler;
+        {
+            std::lock_guard<std::mutex> locker(mutex_);
+            handler = handler_;
+        }
+        return handler(cmdId, packet);
+    }
+
+    void startAccept()
+    {
+        socket_ptr sock(new boost::asio::local::stream_protocol::socket(service_));
+        acceptor_.async_accept(*sock, [this, sock](const boost::system::error_code &ec) {
+            if (!ec) {
+                sockets_.push_back(sock);
+                commandServer_.addConnection(sock);
+            }
+            startAccept();
+        });
+    }
+
+    boost::asio::io_service service_;
+    boost::asio::local::stream_protocol::acceptor acceptor_;
+    CommandServer commandServer_;
+    std::mutex mutex_;
+    CommandServer::CommandHandler handler_;
+    std::vector<socket_ptr> sockets_;   // accessed from the socket thread only
+    std::thread thread_;
+};
+
+// the engine side, Helper_posix connected to the socket of the test
+class TestHelper : public Helper_posix
+{
+public:
+    explicit TestHelper(const std::string &socketPath) : Helper_posix(nullptr, socketPath) {}
+
+    void startInstallHelper() override { start(QThread::LowPriority); }
+    bool reinstallHelper() override { return false; }
+    QString getHelperVersion() override { return QString(); }
+
+    bool waitForConnected()
+    {
+        return waitFor([this]() { return currentState() == STATE_CONNECTED; });
+    }
+};
+
+bool writeExactly(int fd, const void *data, size_t size)
+{
+    const char *ptr = static_cast<const char *>(data);
+    while (size > 0) {
+        ssize_t n = write(fd, ptr, size);
+        if (n <= 0)
+            return false;
+        ptr += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool readExactly(int fd, void *data, size_t size)
+{
+    char *ptr = static_cast<char *>(data);
+    while (size > 0) {
+        ssize_t n = read(fd, ptr, size);
+        if (n <= 0)
+            return false;
+        ptr += n;
+        size -= n;
+    }
+    return true;
+}
+
+// the client path of the legacy framing: three writes for the header, one for the body, then a blocking read of the answer
+bool legacyRoundTrip(int fd, unsigned long cmdId, CMD_ANSWER &answer)
+{
+    CMD_GET_CMD_STATUS cmd;
+    cmd.cmdId = cmdId;
+    std::string data = serialize(cmd);
+
+    int id = HELPER_CMD_GET_CMD_STATUS;
+    pid_t pid = getpid();
+    int length = (int)data.size();
+    if (!writeExactly(fd, &id, sizeof(id)) || !writeExactly(fd, &pid, sizeof(pid)) ||
+        !writeExactly(fd, &length, sizeof(length)) || !writeExactly(fd, data.data(), data.size()))
+        return false;
+
+    if (!readExactly(fd, &length, sizeof(length)))
+        return false;
+    std::string str(length, '\0');
+    if (!readExactly(fd, &str[0], str.size()))
+        return false;
+    answer = deserialize<CMD_ANSWER>(str);
+    return true;
+}
+
+int connectUnixSocket(const std::string &path)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+        return -1;
+    }
+    return fd;
+}
+
+} // namespace
+
+int TestHelperProtocol::requestsCount()
+{
+    int count = qEnvironmentVariableIntValue("WS_HELPER_BENCHMARK_REQUESTS");
+    return count > 0 ? count : 20000;
+}
+
+void TestHelperProtocol::testOutOfOrderAnswers()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    TestServer server(socketPath(dir));
+
+    // a slow command blocks the worker of the helper until it is released
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::atomic<bool> isMtuStarted(false);
+    server.setHandler([&](int cmdId, const std::string &packet) {
+        if (cmdId == HELPER_CMD_CHANGE_MTU) {
+            isMtuStarted = true;
+            released.wait();
+            CMD_ANSWER answer;
+            answer.executed = 1;
+            return answer;
+        }
+        return getCmdStatusAnswer(packet);
+    });
+
+    TestHelper helper(socketPath(dir));
+    helper.startInstallHelper();
+    QVERIFY(helper.waitForConnected());
+
+    std::atomic<bool> isMtuChanged(false);
+    std::thread mtu([&]() { isMtuChanged = helper.changeMtu("eth0", 1400); });
+    if (!waitFor([&]() { return isMtuStarted.load(); })) {
+        release.set_value();
+        mtu.join();
+        QFAIL("the helper did not receive the command");
+    }
+
+    // the status requests of several threads are answered while the slow command still runs, so they pass its answer;
+    // each caller must get the answer to its own request
+    const int kThreads = 8;
+    const int kRequests = 50;
+    std::atomic<int> mismatches(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < kRequests; ++i) {
+                unsigned long cmdId = t * 1000 + i;
+                QString log;
+                bool finished = false;
+                helper.getUnblockingCmdStatus(cmdId, log, finished);
+                if (!finished || log != QString("status %1").arg(cmdId))
+                    mismatches++;
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    const bool isMtuChangedEarly = isMtuChanged;
+
+    release.set_value();
+    mtu.join();
+    QCOMPARE(mismatches.load(), 0);
+    QVERIFY(!isMtuChangedEarly);
+    QVERIFY(isMtuChanged);
+}
+
+void TestHelperProtocol::testEvents()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    TestServer server(socketPath(dir));
+    std::atomic<int> statusRequests(0);
+    server.setHandler([&](int cmdId, const std::string &packet) {
+        if (cmdId == HELPER_CMD_GET_CMD_STATUS)
+            statusRequests++;
+        return getCmdStatusAnswer(packet);
+    });
+
+    TestHelper helper(socketPath(dir));
+    helper.startInstallHelper();
+    QVERIFY(helper.waitForConnected());
+
+    // the helper sends the events to the connections which made a framed request
+    QString log;
+    bool finished = false;
+    helper.getUnblockingCmdStatus(1, log, finished);
+    QVERIFY(finished);
+    QCOMPARE(statusRequests.load(), 1);
+
+    EVENT_CMD_FINISHED finishedEvent;
+    finishedEvent.cmdId = 7;
+    finishedEvent.success = true;
+    finishedEvent.log = "openvpn exited";
+    server.broadcastEvent(HELPER_EVENT_CMD_FINISHED, serialize(finishedEvent));
+
+    EVENT_WIREGUARD_STATUS statusEvent;
+    statusEvent.state = kWgStateActive;
+    statusEvent.errorCode = 0;
+    statusEvent.bytesReceived = 1000;
+    statusEvent.bytesTransmitted = 2000;
+    server.broadcastEvent(HELPER_EVENT_WIREGUARD_STATUS, serialize(statusEvent));
+
+    types::WireGuardStatus status;
+    QVERIFY(helper.waitForWireGuardStatus(&status, 5000));
+    QCOMPARE(status.state, types::WireGuardState::ACTIVE);
+    QCOMPARE(status.bytesReceived, (quint64)1000);
+    QCOMPARE(status.bytesTransmitted, (quint64)2000);
+
+    // the events are handled in order, so the finished command is known now without asking the helper
+    helper.getUnblockingCmdStatus(7, log, finished);
+    QVERIFY(finished);
+    QCOMPARE(log, QString("openvpn exited"));
+    QCOMPARE(statusRequests.load(), 1);
+}
+
+void TestHelperProtocol::testConnectionLost()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    TestServer server(socketPath(dir));
+
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::atomic<bool> isMtuStarted(false);
+    server.setHandler([&](int cmdId, const std::string &packet) {
+        if (cmdId == HELPER_CMD_CHANGE_MTU) {
+            isMtuStarted = true;
+            released.wait();
+            CMD_ANSWER answer;
+            answer.executed = 1;
+            return answer;
+        }
+        return getCmdStatusAnswer(packet);
+    });
+
+    TestHelper helper(socketPath(dir));
+    helper.startInstallHelper();
+    QVERIFY(helper.waitForConnected());
+
+    std::atomic<bool> isMtuDone(false);
+    std::atomic<bool> isMtuChanged(false);
+    std::thread mtu([&]() {
+        isMtuChanged = helper.changeMtu("eth0", 1400);
+        isMtuDone = true;
+    });
+    const bool isStarted = waitFor([&]() { return isMtuStarted.load(); });
+
+    // the pending request fails when the connection is lost, instead of waiting for an answer which never comes
+    server.closeConnections();
+    const bool isFailed = waitFor([&]() { return isMtuDone.load(); });
+    release.set_value();
+    mtu.join();
+    QVERIFY(isStarted);
+    QVERIFY(isFailed);
+    QVERIFY(!isMtuChanged);
+
+    // the engine reconnects and the requests work again
+    QVERIFY(helper.waitForConnected());
+    QString log;
+    bool finished = false;
+    helper.getUnblockingCmdStatus(5, log, finished);
+    QVERIFY(finished);
+    QCOMPARE(log, QString("status 5"));
+}
+
+void TestHelperProtocol::benchmarkLegacyRoundTrip()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    TestServer server(socketPath(dir));
+    int fd = connectUnixSocket(socketPath(dir));
+    QVERIFY(fd >= 0);
+
+    const int count = requestsCount();
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < count; ++i) {
+        CMD_ANSWER answer;
+        QVERIFY(legacyRoundTrip(fd, i, answer));
+        QCOMPARE(answer.cmdId, (unsigned long)i);
+    }
+    const qint64 ns = timer.nsecsElapsed();
+    qInfo("legacy framing: %d sequential requests, %.2f us per round trip, %.0f requests/s",
+          count, ns / 1000.0 / count, count * 1e9 / ns);
+
+    close(fd);
+}
+
+void TestHelperProtocol::benchmarkFramedRoundTrip()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    TestServer server(socketPath(dir));
+    TestHelper helper(socketPath(dir));
+    helper.startInstallHelper();
+    QVERIFY(helper.waitForConnected());
+
+    const int count = requestsCount();
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < count; ++i) {
+        QString log;
+        bool finished = false;
+        helper.getUnblockingCmdStatus(i, log, finished);
+        QVERIFY(finished);
+    }
+    const qint64 ns = timer.nsecsElapsed();
+    qInfo("framed protocol: %d sequential requests, %.2f us per round trip, %.0f requests/s",
+          count, ns / 1000.0 / count, count * 1e9 / ns);
+}
+
+void TestHelperProtocol::benchmarkFramedPipelined()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    TestServer server(socketPath(dir));
+    TestHelper helper(socketPath(dir));
+    helper.startInstallHelper();
+    QVERIFY(helper.waitForConnected());
+
+    // several engine threads call the helper at once, so up to kThreads requests are in flight
+    const int count = requestsCount();
+    const int kThreads = 16;
+    std::atomic<int> failed(0);
+    std::vector<std::thread> threads;
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = t; i < count; i += kThreads) {
+                QString log;
+                bool finished = false;
+                helper.getUnblockingCmdStatus(i, log, finished);
+                if (!finished)
+                    failed++;
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    const qint64 ns = timer.nsecsElapsed();
+    QCOMPARE(failed.load(), 0);
+    qInfo("framed protocol: %d pipelined requests (%d threads), %.2f us per request, %.0f requests/s",
+          count, kThreads, ns / 1000.0 / count, count * 1e9 / ns);
+}
+
+QTEST_MAIN(TestHelperProtocol)
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <QObject>
+#include <QTest>
+
+// tests of the framed helper protocol and a benchmark against the legacy framing; the engine side is Helper_posix
+// and the helper side is the CommandServer of the helper, connected over a unix socket in a temporary directory,
+// only the commands themselves are replaced by a handler of the test
+// the number of requests for the benchmarks can be set with the WS_HELPER_BENCHMARK_REQUESTS environment variable (20000 by default)
+class TestHelperProtocol : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testOutOfOrderAnswers();
+    void testEvents();
+    void testConnectionLost();
+    void benchmarkLegacyRoundTrip();
+    void benchmarkFramedRoundTrip();
+    void benchmarkFramedPipelined();
+
+private:
+    static int requestsCount();
+};
@@ -108,6 +108,17 @@ void MutableLocationInfo::selectNodeByIp(const QString &addr)
     qCDebug(LOG_BASIC) << "Could not find node for IP: " << addr;
 }
 
+bool MutableLocationInfo::selectNodeByHostname(const QString &hostname)
+{
+    for (int i = 0; i < nodes_.count(); i++) {
+        if (nodes_[i]->getHostname() == hostname) {
+            selectedNode_ = i;
+            return true;
+        }
+    }
+    return false;
+}
+
 QString MutableLocationInfo::getIpForSelectedNode(int indIp) const
 {
     WS_ASSERT(indIp >= 0 && indIp <= 3);
@@ -30,6 +30,8 @@ public:
 
     void selectNextNode();
     void selectNodeByIp(const QString &addr);
+    // returns false and keeps the current selection if there is no such node
+    bool selectNodeByHostname(const QString &hostname);
 
     QString getIpForSelectedNode(int indIp) const;
     QString getHostnameForSelectedNode() const;
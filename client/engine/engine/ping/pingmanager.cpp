@@ -16,6 +16,12 @@ PingManager::PingManager(QObject *parent, IConnectStateController *stateControll
     connect(&pingTimer_, &QTimer::timeout, this, &PingManager::onPingTimer);
 }
 
+PingManager::~PingManager()
+{
+    for (const auto &batch : qAsConst(activeBatches_))
+        batch->cancel();
+}
+
 void PingManager::updateIps(const QVector<PingIpInfo> &ips)
 {
     pingLog_.addLog("PingIpsController::updateIps", "update ips:" + QString::number(ips.count()));
@@ -74,7 +80,6 @@ PingTime PingManager::getPing(const QString &ip) const
 
 void PingManager::onPingTimer()
 {
-    using namespace std::placeholders;
     // We don't attempt to issue a ping request when state is CONNECT_STATE_CONNECTING, as the firewall will block it.
     if (!networkDetectionManager_->isOnline() || connectStateController_->currentState() != CONNECT_STATE_DISCONNECTED)
         return;
@@ -99,6 +104,9 @@ void PingManager::onPingTimer()
             pingLog_.addLog("PingIpsController::onPingTimer", "Re-ping all nodes by network change");
     }
 
+    auto wsnetPingManager = WSNet::instance()->pingManager();
+    std::vector<std::shared_ptr<wsnet::WSNetPingTarget>> targets;
+
     for (auto it = ips_.begin(); it != ips_.end(); ++it) {
         PingIpState &pni = it.value();
 
@@ -114,25 +122,41 @@ void PingManager::onPingTimer()
         if (pni.iterationTime != pingStorage_.currentIterationTime()) {
             pingLog_.addLog("PingNodesController::onPingTimer", QString::fromLatin1("ping new node: %1 (%2 - %3)").arg(pni.ipInfo.ip, pni.ipInfo.city, pni.ipInfo.nick));
             pni.nowPinging = true;
-            WSNet::instance()->pingManager()->ping(pni.ipInfo.ip.toStdString(), pni.ipInfo.hostname.toStdString(), pingType,
-                        [this](const std::string &ip, bool isSuccess, std::int32_t timeMs, bool isFromDisconnectedVpnState) {
-                            QMetaObject::invokeMethod(this, [this, ip, isSuccess, timeMs, isFromDisconnectedVpnState] {
-                                onPingFinished(ip, isSuccess, timeMs, isFromDisconnectedVpnState);
-                        });
-            });
+            targets.push_back(wsnetPingManager->createPingTarget(pni.ipInfo.ip.toStdString(), pni.ipInfo.hostname.toStdString(), pingType));
         } else if (pni.latestPingFailed) {
             if (pni.nextTimeForFailedPing == 0 || QDateTime::currentMSecsSinceEpoch() >= pni.nextTimeForFailedPing) {
                 pni.nowPinging = true;
                 pingLog_.addLog("PingNodesController::onPingTimer", "start ping because latest ping failed: " + it.key());
-                WSNet::instance()->pingManager()->ping(pni.ipInfo.ip.toStdString(), pni.ipInfo.hostname.toStdString(), pingType,
-                   [this](const std::string &ip, bool isSuccess, std::int32_t timeMs, bool isFromDisconnectedVpnState) {
-                       QMetaObject::invokeMethod(this, [this, ip, isSuccess, timeMs, isFromDisconnectedVpnState] {
-                           onPingFinished(ip, isSuccess, timeMs, isFromDisconnectedVpnState);
-                    });
-                });
+                targets.push_back(wsnetPingManager->createPingTarget(pni.ipInfo.ip.toStdString(), pni.ipInfo.hostname.toStdString(), pingType));
             }
         }
     }
+
+    if (targets.empty())
+        return;
+
+    // One batch per timer tick, the results come back in a few coalesced chunks instead of one cross-thread call per ip
+    auto options = wsnetPingManager->createPingBatchOptions();
+    options->setCoalesceIntervalMs(BATCH_COALESCE_INTERVAL_MS);
+    options->setMaxProbesPerSecond(BATCH_MAX_PROBES_PER_SECOND);
+    options->setJitterMs(BATCH_JITTER_MS);
+
+    quint64 batchId = curBatchId_++;
+    activeBatches_[batchId] = wsnetPingManager->pingBatch(targets, options,
+        [this, batchId](const std::vector<std::shared_ptr<wsnet::WSNetPingResult>> &results, bool isFinished) {
+            QMetaObject::invokeMethod(this, [this, batchId, results, isFinished] {
+                onBatchResults(batchId, results, isFinished);
+            });
+        });
+}
+
+void PingManager::onBatchResults(quint64 batchId, const std::vector<std::shared_ptr<wsnet::WSNetPingResult>> &results, bool isFinished)
+{
+    for (const auto &result : results)
+        onPingFinished(result->ip(), result->isSuccess(), result->timeMs(), result->isFromDisconnectedVpnState());
+
+    if (isFinished)
+        activeBatches_.remove(batchId);
 }
 
 void PingManager::onPingFinished(const std::string &ip, bool isSuccess, int32_t timeMs, bool isFromDisconnectedVpnState)
@@ -30,6 +30,7 @@ class PingManager : public QObject
 public:
     explicit PingManager(QObject *parent, IConnectStateController *stateController, INetworkDetectionManager *networkDetectionManager,
                          const QString &storageSettingName, const QString &log_filename);
+    ~PingManager();
 
     void updateIps(const QVector<PingIpInfo> &ips);
     void clearIps();
@@ -48,6 +49,10 @@ private:
     static constexpr int MAX_FAILED_PING_IN_ROW = 3;
     static constexpr int MIN_DELAY_FOR_FAILED_IN_ROW_PINGS = 1;
     static constexpr int NEXT_PERIOD_SECS = 2*60*60*24;   //  How many secs to wait until the next ping (48 hours)
+    // the results of a batch are delivered to this thread in chunks no more often than this interval
+    static constexpr int BATCH_COALESCE_INTERVAL_MS = 250;
+    static constexpr int BATCH_MAX_PROBES_PER_SECOND = 100;
+    static constexpr int BATCH_JITTER_MS = 5;
 
     IConnectStateController* const connectStateController_;
     INetworkDetectionManager* const networkDetectionManager_;
@@ -95,6 +100,10 @@ private:
     QHash<QString, PingIpState> ips_;
     QTimer pingTimer_;
 
+    quint64 curBatchId_ = 0;
+    QHash<quint64, std::shared_ptr<wsnet::WSNetCancelableCallback>> activeBatches_;
+
+    void onBatchResults(quint64 batchId, const std::vector<std::shared_ptr<wsnet::WSNetPingResult>> &results, bool isFinished);
     void onPingFinished(const std::string &ip, bool isSuccess, std::int32_t timeMs, bool isFromDisconnectedVpnState);
 
 
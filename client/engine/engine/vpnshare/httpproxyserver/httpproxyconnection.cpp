@@ -3,13 +3,14 @@
 #include <QHostAddress>
 #include "utils/ws_assert.h"
 #include "utils/logger.h"
+#include "../socketutils/fastrelay.h"
+#include "../socketutils/socketrelay.h"
 
 namespace HttpProxyServer {
 
 
-HttpProxyConnection::HttpProxyConnection(qintptr socketDescriptor, const QString &hostname, QObject *parent) : QObject(parent),
-    socket_(nullptr), socketExternal_(nullptr), socketDescriptor_(socketDescriptor),
-    hostname_(hostname), state_(READ_CLIENT_REQUEST), writeAllSocket_(nullptr),
+HttpProxyConnection::HttpProxyConnection(qintptr socketDescriptor, const QString &hostname, QObject *parent) : ProxyConnection(socketDescriptor, hostname, parent),
+    socket_(nullptr), socketExternal_(nullptr), connector_(nullptr), state_(READ_CLIENT_REQUEST), writeAllSocket_(nullptr),
     writeAllSocketExternal_(nullptr), httpError_(), bAlreadyClosedAndEmitFinished_(false)
 {
     httpError_.status = HttpProxyReply::ok;
@@ -44,6 +45,13 @@ void HttpProxyConnection::onSocketDisconnected()
 
 void HttpProxyConnection::onSocketReadyRead()
 {
+    touch();
+    if (state_ == RELAY_BETWEEN_CLIENT_SERVER || state_ == READ_HEADERS_FROM_WEBSERVER)
+    {
+        SocketRelay::relay(socket_, socketExternal_);
+        return;
+    }
+
     QByteArray arr = socket_->readAll();
 
     if (state_ == READ_CLIENT_REQUEST)
@@ -61,17 +69,12 @@ void HttpProxyConnection::onSocketReadyRead()
 
             if (requestParser_.getRequest().extractHostAndPort())
             {
-                socketExternal_ = new QTcpSocket(this);
-
-                connect(socketExternal_, &QTcpSocket::connected, this, &HttpProxyConnection::onExternalSocketConnected);
-                connect(socketExternal_, &QTcpSocket::disconnected, this, &HttpProxyConnection::onExternalSocketDisconnected);
-                connect(socketExternal_, &QTcpSocket::readyRead, this, &HttpProxyConnection::onExternalSocketReadyRead);
-                connect(socketExternal_, &QTcpSocket::errorOccurred, this, &HttpProxyConnection::onExternalSocketError);
-
-                writeAllSocketExternal_ = new SocketWriteAll(this, socketExternal_);
+                connector_ = new ProxyServerCore::OutboundConnector(this);
+                connect(connector_, &ProxyServerCore::OutboundConnector::connected, this, &HttpProxyConnection::onExternalSocketConnected);
+                connect(connector_, &ProxyServerCore::OutboundConnector::failed, this, &HttpProxyConnection::onExternalSocketError);
 
                 state_ = CONNECTING_TO_EXTERNAL_SERVER;
-                socketExternal_->connectToHost(QString::fromStdString(requestParser_.getRequest().host), requestParser_.getRequest().port);
+                connector_->connectToHost(QString::fromStdString(requestParser_.getRequest().host), requestParser_.getRequest().port);
             }
             else
             {
@@ -97,10 +100,6 @@ void HttpProxyConnection::onSocketReadyRead()
     {
         extraContent_.append(arr);
     }
-    else if (state_ == RELAY_BETWEEN_CLIENT_SERVER  || state_ == READ_HEADERS_FROM_WEBSERVER)
-    {
-        writeAllSocketExternal_->write(arr);
-    }
     else
     {
         WS_ASSERT(false);
@@ -117,6 +116,12 @@ void HttpProxyConnection::onExternalSocketConnected()
 {
     if (state_ == CONNECTING_TO_EXTERNAL_SERVER)
     {
+        socketExternal_ = connector_->takeSocket(this);
+        connect(socketExternal_, &QTcpSocket::disconnected, this, &HttpProxyConnection::onExternalSocketDisconnected);
+        connect(socketExternal_, &QTcpSocket::readyRead, this, &HttpProxyConnection::onExternalSocketReadyRead);
+        connect(socketExternal_, &QTcpSocket::errorOccurred, this, &HttpProxyConnection::onExternalSocketError);
+        writeAllSocketExternal_ = new SocketWriteAll(this, socketExternal_);
+
         if (requestParser_.getRequest().isConnectMethod())
         {
             writeAllSocket_->write(QByteArray(reply_established_, strlen(reply_established_)));
@@ -126,6 +131,7 @@ void HttpProxyConnection::onExternalSocketConnected()
                 extraContent_.clear();
             }
             state_ = RELAY_BETWEEN_CLIENT_SERVER;
+            startRelay();
         }
         else
         {
@@ -151,6 +157,9 @@ void HttpProxyConnection::onExternalSocketConnected()
             //}
 
             state_ = READ_HEADERS_FROM_WEBSERVER;
+            // the client may send the request body while the headers of the answer are awaited
+            SocketRelay::setup(socket_);
+            connect(socketExternal_, &QTcpSocket::bytesWritten, this, &HttpProxyConnection::onRelayBytesWritten, Qt::UniqueConnection);
         }
     }
     else
@@ -178,13 +187,14 @@ void HttpProxyConnection::onExternalSocketDisconnected()
 
 void HttpProxyConnection::onExternalSocketReadyRead()
 {
-    QByteArray arr = socketExternal_->readAll();
+    touch();
     if (state_ == RELAY_BETWEEN_CLIENT_SERVER)
     {
-        writeAllSocket_->write(arr);
+        SocketRelay::relay(socketExternal_, socket_);
     }
     else if (state_ == READ_HEADERS_FROM_WEBSERVER)
     {
+        QByteArray arr = socketExternal_->readAll();
         quint32 parsed;
         TRI_BOOL ret;
         ret = webAnswerParser_.parse(arr, parsed);
@@ -201,6 +211,7 @@ void HttpProxyConnection::onExternalSocketReadyRead()
                 writeAllSocket_->write(QByteArray(arr.data() + parsed, remainingData));
             }
             state_ = RELAY_BETWEEN_CLIENT_SERVER;
+            startRelay();
         }
         else if (ret == TRI_FALSE)
         {
@@ -228,15 +239,64 @@ void HttpProxyConnection::onExternalSocketError(QAbstractSocket::SocketError soc
     }
 }
 
+void HttpProxyConnection::startRelay()
+{
+    SocketRelay::setup(socket_);
+    SocketRelay::setup(socketExternal_);
+    connect(socket_, &QTcpSocket::bytesWritten, this, &HttpProxyConnection::onRelayBytesWritten, Qt::UniqueConnection);
+    connect(socketExternal_, &QTcpSocket::bytesWritten, this, &HttpProxyConnection::onRelayBytesWritten, Qt::UniqueConnection);
+    startFastRelay();
+}
+
+// resumes the directions stopped because the receiving socket had too much data queued
+void HttpProxyConnection::onRelayBytesWritten()
+{
+    if (state_ == RELAY_BETWEEN_CLIENT_SERVER)
+    {
+        SocketRelay::relay(socketExternal_, socket_);
+    }
+    if (state_ == RELAY_BETWEEN_CLIENT_SERVER || state_ == READ_HEADERS_FROM_WEBSERVER)
+    {
+        SocketRelay::relay(socket_, socketExternal_);
+    }
+}
+
+// hands the established connection over to the fast relay once Qt has written everything queued for it
+void HttpProxyConnection::startFastRelay()
+{
+    if (!FastRelay::isSupported() || state_ != RELAY_BETWEEN_CLIENT_SERVER || fastRelayId_ != 0)
+    {
+        return;
+    }
+    if (!FastRelay::canHandOver(socket_, socketExternal_))
+    {
+        connect(socket_, &QTcpSocket::bytesWritten, this, &HttpProxyConnection::startFastRelay, Qt::UniqueConnection);
+        connect(socketExternal_, &QTcpSocket::bytesWritten, this, &HttpProxyConnection::startFastRelay, Qt::UniqueConnection);
+        return;
+    }
+    fastRelayId_ = FastRelay::handOver(socket_, socketExternal_, [this]() {
+        QMetaObject::invokeMethod(this, [this]() { closeSocketsAndEmitFinished(); }, Qt::QueuedConnection);
+    });
+}
+
 void HttpProxyConnection::closeSocketsAndEmitFinished()
 {
     if (!bAlreadyClosedAndEmitFinished_)
     {
         bAlreadyClosedAndEmitFinished_ = true;
+        if (fastRelayId_)
+        {
+            FastRelay::close(fastRelayId_);
+            fastRelayId_ = 0;
+        }
         if (socket_)
         {
             socket_->close();
         }
+        if (connector_)
+        {
+            connector_->abort();
+        }
         if (socketExternal_)
         {
             socketExternal_->close();
@@ -2,6 +2,8 @@
 
 #include <QObject>
 #include <QTcpSocket>
+#include "../proxyservercore/outboundconnector.h"
+#include "../proxyservercore/proxyconnection.h"
 #include "httpproxyrequestparser.h"
 #include "httpproxywebanswerparser.h"
 #include "httpproxyreply.h"
@@ -9,20 +11,15 @@
 
 namespace HttpProxyServer {
 
-class HttpProxyConnection : public QObject
+class HttpProxyConnection : public ProxyServerCore::ProxyConnection
 {
     Q_OBJECT
 public:
     explicit HttpProxyConnection(qintptr socketDescriptor, const QString &hostname, QObject *parent = nullptr);
 
-    bool start(qintptr socketDescriptor);
-
 public slots:
-    void start();
-    void forceClose();
-
-signals:
-    void finished(const QString &hostname);
+    void start() override;
+    void forceClose() override;
 
 private slots:
     void onSocketDisconnected();
@@ -35,11 +32,13 @@ private slots:
     void onExternalSocketReadyRead();
     void onExternalSocketError(QAbstractSocket::SocketError socketError);
 
+    void onRelayBytesWritten();
+    void startFastRelay();
+
 private:
     QTcpSocket *socket_;
     QTcpSocket *socketExternal_;
-    qintptr socketDescriptor_;
-    QString hostname_;
+    ProxyServerCore::OutboundConnector *connector_;
 
     const char *reply_established_ = "HTTP/1.0 200 Connection established\r\nProxy-agent: Windscribe\r\n\r\n";
 
@@ -56,6 +55,7 @@ private:
 
     bool bAlreadyClosedAndEmitFinished_;
     void closeSocketsAndEmitFinished();
+    void startRelay();
 };
 
 } // namespace HttpProxyServer
@@ -1,14 +1,17 @@
 #include "httpproxyserver.h"
+#include "httpproxyconnection.h"
 #include "utils/ws_assert.h"
 #include "utils/logger.h"
 
 namespace HttpProxyServer {
 
-HttpProxyServer::HttpProxyServer(QObject *parent) : QTcpServer(parent)
+HttpProxyServer::HttpProxyServer(QObject *parent) : QObject(parent)
 {
     usersCounter_ = new ConnectedUsersCounter(this);
     connect(usersCounter_, &ConnectedUsersCounter::usersCountChanged, this, &HttpProxyServer::usersCountChanged);
-    connectionManager_ = new HttpProxyConnectionManager(this, 4, usersCounter_);
+    core_ = new ProxyServerCore::ProxyServerCore(this, [](qintptr socketDescriptor, const QString &hostname) {
+        return new HttpProxyConnection(socketDescriptor, hostname);
+    }, usersCounter_, LOG_HTTP_SERVER);
 }
 
 HttpProxyServer::~HttpProxyServer()
@@ -18,9 +21,9 @@ HttpProxyServer::~HttpProxyServer()
 
 bool HttpProxyServer::startServer(quint16 port)
 {
-    WS_ASSERT(!isListening());
+    WS_ASSERT(!core_->isListening());
 
-    if (listen(QHostAddress::AnyIPv4, port))
+    if (core_->listen(port))
     {
         qCDebug(LOG_HTTP_SERVER) << "Http proxy server started on port" << serverPort();
         return true;
@@ -34,29 +37,28 @@ bool HttpProxyServer::startServer(quint16 port)
 
 void HttpProxyServer::stopServer()
 {
-    if (isListening())
+    if (core_->isListening())
     {
         qCDebug(LOG_HTTP_SERVER) << "Http proxy server stopped on port" << serverPort();
-        close();
     }
-    connectionManager_->stop();
+    // also drops the connections accepted by the sharded listeners if the main listener failed to start
+    core_->close();
     usersCounter_->reset();
 }
 
-int HttpProxyServer::getConnectedUsersCount()
+quint16 HttpProxyServer::serverPort() const
 {
-    return usersCounter_->getConnectedUsersCount();
+    return core_->serverPort();
 }
 
-void HttpProxyServer::closeActiveConnections()
+int HttpProxyServer::getConnectedUsersCount()
 {
-    connectionManager_->closeAllConnections();
+    return usersCounter_->getConnectedUsersCount();
 }
 
-void HttpProxyServer::incomingConnection(qintptr socketDescriptor)
+void HttpProxyServer::closeActiveConnections()
 {
-    connectionManager_->newConnection(socketDescriptor);
+    core_->closeAllConnections();
 }
 
-
 } // namespace HttpProxyServer
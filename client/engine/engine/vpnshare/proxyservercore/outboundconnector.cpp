@@ -0,0 +1,160 @@
+#include "outboundconnector.h"
+
+#include "proxydnscache.h"
+
+namespace ProxyServerCore {
+
+OutboundConnector::OutboundConnector(QObject *parent) : QObject(parent),
+    nextAddress_(0), port_(0), socket_(nullptr), dnsLookupId_(0), isAborted_(false)
+{
+    attemptTimer_.setSingleShot(true);
+    connect(&attemptTimer_, &QTimer::timeout, this, &OutboundConnector::startNextAttempt);
+}
+
+OutboundConnector::~OutboundConnector()
+{
+    // the cache must not post the result to a deleted object
+    if (dnsLookupId_)
+    {
+        ProxyDnsCache::instance().cancel(dnsLookupId_);
+    }
+}
+
+void OutboundConnector::connectToHost(const QString &hostname, quint16 port)
+{
+    QHostAddress address;
+    if (address.setAddress(hostname))
+    {
+        connectToHost(address, port);
+        return;
+    }
+
+    port_ = port;
+    dnsLookupId_ = ProxyDnsCache::instance().lookup(hostname, this, [this](const QStringList &ips) {
+        dnsLookupId_ = 0;
+        onResolved(ips);
+    });
+}
+
+void OutboundConnector::connectToHost(const QHostAddress &address, quint16 port)
+{
+    port_ = port;
+    addresses_ << address;
+    startNextAttempt();
+}
+
+void OutboundConnector::abort()
+{
+    isAborted_ = true;
+    attemptTimer_.stop();
+    if (dnsLookupId_)
+    {
+        ProxyDnsCache::instance().cancel(dnsLookupId_);
+        dnsLookupId_ = 0;
+    }
+    const QList<QTcpSocket *> attempts = attempts_;
+    for (QTcpSocket *attempt : attempts)
+    {
+        removeAttempt(attempt);
+    }
+}
+
+QTcpSocket *OutboundConnector::takeSocket(QObject *parent)
+{
+    QTcpSocket *socket = socket_;
+    socket_ = nullptr;
+    if (socket)
+    {
+        socket->disconnect(this);
+        socket->setParent(parent);
+    }
+    return socket;
+}
+
+void OutboundConnector::onResolved(const QStringList &ips)
+{
+    if (isAborted_)
+    {
+        return;
+    }
+    for (const QString &ip : ips)
+    {
+        addresses_ << QHostAddress(ip);
+    }
+    if (addresses_.isEmpty())
+    {
+        emit failed(QAbstractSocket::HostNotFoundError);
+        return;
+    }
+    startNextAttempt();
+}
+
+void OutboundConnector::startNextAttempt()
+{
+    if (isAborted_ || socket_ || nextAddress_ >= addresses_.count())
+    {
+        return;
+    }
+
+    QTcpSocket *attempt = new QTcpSocket(this);
+    connect(attempt, &QTcpSocket::connected, this, &OutboundConnector::onAttemptConnected);
+    connect(attempt, &QTcpSocket::errorOccurred, this, &OutboundConnector::onAttemptError);
+    attempts_ << attempt;
+    attempt->connectToHost(addresses_[nextAddress_++], port_);
+
+    if (nextAddress_ < addresses_.count())
+    {
+        attemptTimer_.start(kAttemptDelayMs);
+    }
+}
+
+void OutboundConnector::onAttemptConnected()
+{
+    QTcpSocket *attempt = static_cast<QTcpSocket *>(sender());
+    if (isAborted_ || socket_)
+    {
+        return;
+    }
+    attemptTimer_.stop();
+    attempts_.removeOne(attempt);
+    socket_ = attempt;
+    socket_->disconnect(this);
+
+    const QList<QTcpSocket *> attempts = attempts_;
+    for (QTcpSocket *other : attempts)
+    {
+        removeAttempt(other);
+    }
+    emit connected();
+}
+
+void OutboundConnector::onAttemptError(QAbstractSocket::SocketError socketError)
+{
+    QTcpSocket *attempt = static_cast<QTcpSocket *>(sender());
+    if (isAborted_ || socket_ || !attempts_.contains(attempt))
+    {
+        return;
+    }
+    removeAttempt(attempt);
+
+    // a failed attempt does not wait for the delay to pass
+    if (nextAddress_ < addresses_.count())
+    {
+        attemptTimer_.stop();
+        startNextAttempt();
+    }
+    else if (attempts_.isEmpty())
+    {
+        emit failed(socketError);
+    }
+}
+
+void OutboundConnector::removeAttempt(QTcpSocket *attempt)
+{
+    attempts_.removeOne(attempt);
+    attempt->disconnect(this);
+    attempt->abort();
+    attempt->deleteLater();
+}
+
+} // namespace ProxyServerCore
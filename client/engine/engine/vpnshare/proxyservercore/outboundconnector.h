@@ -0,0 +1,55 @@
+#pragma once
+
+#include <QHostAddress>
+#include <QList>
+#include <QObject>
+#include <QTcpSocket>
+#include <QTimer>
+
+namespace ProxyServerCore {
+
+// Opens the connection of a proxy connection to the destination server.
+// Hostnames are resolved through ProxyDnsCache. The addresses are tried Happy Eyeballs style (RFC 8305):
+// the next attempt starts if the previous one has not connected within kAttemptDelayMs or has failed,
+// the first connected attempt wins and the others are aborted.
+class OutboundConnector : public QObject
+{
+    Q_OBJECT
+public:
+    explicit OutboundConnector(QObject *parent);
+    ~OutboundConnector() override;
+
+    void connectToHost(const QString &hostname, quint16 port);
+    void connectToHost(const QHostAddress &address, quint16 port);
+    // stops all attempts, no signals are emitted afterwards
+    void abort();
+
+    // the connected socket, reparented to parent; valid after connected()
+    QTcpSocket *takeSocket(QObject *parent);
+
+signals:
+    void connected();
+    void failed(QAbstractSocket::SocketError socketError);
+
+private slots:
+    void startNextAttempt();
+    void onAttemptConnected();
+    void onAttemptError(QAbstractSocket::SocketError socketError);
+
+private:
+    static constexpr int kAttemptDelayMs = 250;
+
+    QList<QHostAddress> addresses_;
+    int nextAddress_;
+    quint16 port_;
+    QList<QTcpSocket *> attempts_;
+    QTcpSocket *socket_;
+    QTimer attemptTimer_;
+    quint64 dnsLookupId_;
+    bool isAborted_;
+
+    void onResolved(const QStringList &ips);
+    void removeAttempt(QTcpSocket *attempt);
+};
+
+} // namespace ProxyServerCore
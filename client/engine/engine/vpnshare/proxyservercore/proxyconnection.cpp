@@ -0,0 +1,40 @@
+#include "proxyconnection.h"
+
+#include "../socketutils/fastrelay.h"
+
+namespace ProxyServerCore {
+
+ProxyConnection::ProxyConnection(qintptr socketDescriptor, const QString &hostname, QObject *parent) : QObject(parent),
+    socketDescriptor_(socketDescriptor), hostname_(hostname), fastRelayId_(0)
+{
+    lastActivity_.start();
+}
+
+ProxyConnection::~ProxyConnection()
+{
+    // the relay callback refers to this object
+    if (fastRelayId_)
+    {
+        FastRelay::close(fastRelayId_);
+    }
+}
+
+qint64 ProxyConnection::idleTime() const
+{
+    if (fastRelayId_)
+    {
+        const qint64 relayIdleTime = FastRelay::idleTime(fastRelayId_);
+        if (relayIdleTime >= 0)
+        {
+            return relayIdleTime;
+        }
+    }
+    return lastActivity_.elapsed();
+}
+
+void ProxyConnection::touch()
+{
+    lastActivity_.start();
+}
+
+} // namespace ProxyServerCore
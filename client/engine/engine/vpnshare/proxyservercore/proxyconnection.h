@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <functional>
+
+namespace ProxyServerCore {
+
+// Base of the HTTP and SOCKS proxy connections run by ProxyEventLoop.
+// A connection is created in the thread of its event loop and stays there, the loop deletes it after finished().
+class ProxyConnection : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ProxyConnection(qintptr socketDescriptor, const QString &hostname, QObject *parent = nullptr);
+    ~ProxyConnection() override;
+
+    const QString &hostname() const { return hostname_; }
+
+    // milliseconds since the connection last moved data in either direction
+    qint64 idleTime() const;
+
+public slots:
+    virtual void start() = 0;
+    virtual void forceClose() = 0;
+
+signals:
+    void finished(const QString &hostname);
+
+protected:
+    qintptr socketDescriptor_;
+    QString hostname_;
+    // id of the relay once the connection is handed over to FastRelay, the relay then tracks the activity
+    quint64 fastRelayId_;
+
+    void touch();
+
+private:
+    QElapsedTimer lastActivity_;
+};
+
+typedef std::function<ProxyConnection *(qintptr socketDescriptor, const QString &hostname)> ConnectionFactory;
+
+} // namespace ProxyServerCore
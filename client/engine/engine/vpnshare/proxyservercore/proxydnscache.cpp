@@ -0,0 +1,123 @@
+#include "proxydnscache.h"
+
+namespace ProxyServerCore {
+
+ProxyDnsCache::ProxyDnsCache() : nextId_(0)
+{
+}
+
+quint64 ProxyDnsCache::lookup(const QString &hostname, QObject *context, Callback callback)
+{
+    QMutexLocker locker(&mutex_);
+
+    auto it = cache_.constFind(hostname);
+    if (it != cache_.constEnd() && !it->expireTime.hasExpired())
+    {
+        const QStringList ips = it->ips;
+        locker.unlock();
+        callback(ips);
+        return 0;
+    }
+
+    const quint64 id = ++nextId_;
+    waiters_.insert(id, Waiter{ hostname, context, callback });
+    auto inFlightIt = inFlight_.find(hostname);
+    if (inFlightIt != inFlight_.end())
+    {
+        inFlightIt->append(id);
+        return id;
+    }
+    inFlight_.insert(hostname, QList<quint64>() << id);
+    locker.unlock();
+
+    // the lookup is never cancelled in the resolver, so the cache gets the result even if all the waiters are gone
+    WSNet::instance()->dnsResolver()->lookup(hostname.toStdString(), 0,
+        [this](std::uint64_t requestId, const std::string &hostname, std::shared_ptr<wsnet::WSNetDnsRequestResult> result)
+    {
+        Q_UNUSED(requestId);
+        onResolved(QString::fromStdString(hostname), result);
+    });
+    return id;
+}
+
+void ProxyDnsCache::cancel(quint64 id)
+{
+    QMutexLocker locker(&mutex_);
+    auto it = waiters_.find(id);
+    if (it != waiters_.end())
+    {
+        auto inFlightIt = inFlight_.find(it->hostname);
+        if (inFlightIt != inFlight_.end())
+        {
+            inFlightIt->removeOne(id);
+        }
+        waiters_.erase(it);
+    }
+}
+
+void ProxyDnsCache::clear()
+{
+    QMutexLocker locker(&mutex_);
+    cache_.clear();
+}
+
+void ProxyDnsCache::onResolved(const QString &hostname, std::shared_ptr<wsnet::WSNetDnsRequestResult> result)
+{
+    QStringList ips;
+    int ttlSec = kNegativeTtlSec;
+    if (!result->isError())
+    {
+        for (const auto &ip : result->ips())
+        {
+            ips << QString::fromStdString(ip);
+        }
+        ttlSec = qBound(kMinTtlSec, (int)qMin<quint32>(result->ttl(), kMaxTtlSec), kMaxTtlSec);
+    }
+    // the hostnames requested by the proxy users are not logged
+    if (ips.isEmpty())
+    {
+        ttlSec = kNegativeTtlSec;
+    }
+
+    QMutexLocker locker(&mutex_);
+    if (cache_.count() >= kMaxEntries)
+    {
+        removeExpired();
+        if (cache_.count() >= kMaxEntries)
+        {
+            cache_.clear();
+        }
+    }
+    cache_.insert(hostname, CacheEntry{ ips, QDeadlineTimer(ttlSec * 1000) });
+
+    // the waiters are still registered here, so their contexts are alive while the calls are posted
+    const QList<quint64> ids = inFlight_.take(hostname);
+    for (quint64 id : ids)
+    {
+        auto it = waiters_.find(id);
+        if (it == waiters_.end())
+        {
+            continue;
+        }
+        Callback callback = it->callback;
+        QMetaObject::invokeMethod(it->context, [callback, ips]() { callback(ips); }, Qt::QueuedConnection);
+        waiters_.erase(it);
+    }
+}
+
+void ProxyDnsCache::removeExpired()
+{
+    for (auto it = cache_.begin(); it != cache_.end(); )
+    {
+        if (it->expireTime.hasExpired())
+        {
+            it = cache_.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+} // namespace ProxyServerCore
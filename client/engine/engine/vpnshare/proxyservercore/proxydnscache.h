@@ -0,0 +1,67 @@
+#pragma once
+
+#include <QDeadlineTimer>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+#include <functional>
+#include <wsnet/WSNet.h>
+
+namespace ProxyServerCore {
+
+// DNS cache shared by all connections of the VPN-share proxies, resolves through WSNetDnsResolver.
+// Entries live for the TTL of the records (clamped to [kMinTtlSec, kMaxTtlSec]), failures are cached for kNegativeTtlSec.
+// Concurrent lookups of the same hostname wait for one DNS request.
+// Thread safe, the callbacks are called in the thread of their context object.
+class ProxyDnsCache
+{
+public:
+    // empty ips on failure
+    typedef std::function<void(const QStringList &ips)> Callback;
+
+    static ProxyDnsCache &instance()
+    {
+        static ProxyDnsCache pdc;
+        return pdc;
+    }
+
+    // Calls the callback right away if the hostname is cached and returns 0. Otherwise returns the lookup id and
+    // calls the callback later; the lookup must be cancelled before the context is deleted.
+    quint64 lookup(const QString &hostname, QObject *context, Callback callback);
+    void cancel(quint64 id);
+
+    void clear();
+
+private:
+    ProxyDnsCache();
+
+    static constexpr int kMinTtlSec = 30;
+    static constexpr int kMaxTtlSec = 3600;
+    static constexpr int kNegativeTtlSec = 5;
+    static constexpr int kMaxEntries = 1024;
+
+    struct CacheEntry
+    {
+        QStringList ips;
+        QDeadlineTimer expireTime;
+    };
+
+    struct Waiter
+    {
+        QString hostname;
+        QObject *context;
+        Callback callback;
+    };
+
+    QMutex mutex_;
+    QHash<QString, CacheEntry> cache_;
+    QHash<QString, QList<quint64>> inFlight_;   // hostname -> ids of the waiters
+    QHash<quint64, Waiter> waiters_;
+    quint64 nextId_;
+
+    void onResolved(const QString &hostname, std::shared_ptr<wsnet::WSNetDnsRequestResult> result);
+    void removeExpired();
+};
+
+} // namespace ProxyServerCore
@@ -0,0 +1,139 @@
+#include "proxyeventloop.h"
+
+#ifdef Q_OS_WIN
+    #include <winsock2.h>
+#else
+    #include <arpa/inet.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+#endif
+#include "utils/ws_assert.h"
+
+namespace ProxyServerCore {
+
+ProxyEventLoop::ProxyEventLoop(const ConnectionFactory &connectionFactory, QAtomicInt *connectionsCount, int maxConnections,
+                               int idleTimeoutMs, LogCategory logCategory) : QObject(nullptr),
+    connectionFactory_(connectionFactory), connectionsCount_(connectionsCount), maxConnections_(maxConnections),
+    idleTimeoutMs_(idleTimeoutMs), logCategory_(logCategory), listener_(nullptr), idleTimer_(nullptr), count_(0)
+{
+}
+
+void ProxyEventLoop::listen(qintptr listenSocket)
+{
+    WS_ASSERT(listener_ == nullptr);
+    listener_ = new ProxyListener(this);
+    connect(listener_, &ProxyListener::socketAccepted, this, &ProxyEventLoop::addConnection);
+    if (!listener_->setSocketDescriptor(listenSocket))
+    {
+        qCDebug(logCategory_) << "Can't accept on the listening socket:" << listener_->errorString();
+        closeSocket(listenSocket);
+    }
+}
+
+void ProxyEventLoop::addConnection(qintptr socketDescriptor)
+{
+    // the limit is shared by all loops of the server
+    if (connectionsCount_->fetchAndAddRelaxed(1) >= maxConnections_)
+    {
+        connectionsCount_->fetchAndAddRelaxed(-1);
+        closeSocket(socketDescriptor);
+        qCDebug(logCategory_) << "Connection rejected, the limit of" << maxConnections_ << "connections is reached";
+        return;
+    }
+
+    if (idleTimer_ == nullptr)
+    {
+        idleTimer_ = new QTimer(this);
+        connect(idleTimer_, &QTimer::timeout, this, &ProxyEventLoop::onIdleTimer);
+        idleTimer_->start(kIdleCheckIntervalMs);
+    }
+
+    const QString hostname = peerAddress(socketDescriptor);
+    ProxyConnection *connection = connectionFactory_(socketDescriptor, hostname);
+    connect(connection, &ProxyConnection::finished, this, &ProxyEventLoop::onConnectionFinished);
+    connections_.insert(connection);
+    count_.fetchAndAddRelaxed(1);
+    emit userConnected(hostname);
+    connection->start();
+}
+
+void ProxyEventLoop::closeAllConnections()
+{
+    // forceClose() emits finished(), which changes connections_
+    const QSet<ProxyConnection *> connections = connections_;
+    for (ProxyConnection *connection : connections)
+    {
+        connection->forceClose();
+    }
+}
+
+void ProxyEventLoop::stop()
+{
+    if (listener_)
+    {
+        listener_->close();
+        delete listener_;
+        listener_ = nullptr;
+    }
+    for (ProxyConnection *connection : qAsConst(connections_))
+    {
+        connection->disconnect(this);
+        delete connection;
+    }
+    connectionsCount_->fetchAndAddRelaxed(-connections_.count());
+    connections_.clear();
+    count_.storeRelaxed(0);
+}
+
+void ProxyEventLoop::onConnectionFinished(const QString &hostname)
+{
+    ProxyConnection *connection = static_cast<ProxyConnection *>(sender());
+    if (connections_.remove(connection))
+    {
+        connectionsCount_->fetchAndAddRelaxed(-1);
+        count_.fetchAndAddRelaxed(-1);
+        connection->deleteLater();
+        emit userDisconnected(hostname);
+    }
+}
+
+void ProxyEventLoop::onIdleTimer()
+{
+    QList<ProxyConnection *> idleConnections;
+    for (ProxyConnection *connection : qAsConst(connections_))
+    {
+        if (connection->idleTime() > idleTimeoutMs_)
+        {
+            idleConnections << connection;
+        }
+    }
+    for (ProxyConnection *connection : qAsConst(idleConnections))
+    {
+        qCDebug(logCategory_) << "Closing idle connection from" << connection->hostname();
+        connection->forceClose();
+    }
+}
+
+QString ProxyEventLoop::peerAddress(qintptr socketDescriptor)
+{
+#ifdef Q_OS_WIN
+    SOCKADDR_IN addr = {0};
+    int addr_len = sizeof(addr);
+#else
+    sockaddr_in addr = {};
+    socklen_t addr_len = sizeof(addr);
+#endif
+    getpeername(socketDescriptor, (sockaddr*)&addr, &addr_len);
+    return QString(inet_ntoa(addr.sin_addr));
+}
+
+void ProxyEventLoop::closeSocket(qintptr socketDescriptor)
+{
+#ifdef Q_OS_WIN
+    closesocket(socketDescriptor);
+#else
+    ::close(socketDescriptor);
+#endif
+}
+
+} // namespace ProxyServerCore
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <QAtomicInt>
+#include <QLoggingCategory>
+#include <QObject>
+#include <QSet>
+#include <QTimer>
+
+#include "proxyconnection.h"
+#include "proxylistener.h"
+
+namespace ProxyServerCore {
+
+// One of the event loops of ProxyServerCore, lives in its own thread together with its connections.
+// On Linux every loop accepts from its own SO_REUSEPORT listening socket, so the kernel spreads the incoming
+// connections over the loops; elsewhere ProxyServerCore accepts and passes the descriptors to the least busy loop.
+class ProxyEventLoop : public QObject
+{
+    Q_OBJECT
+public:
+    typedef const QLoggingCategory &(*LogCategory)();
+
+    ProxyEventLoop(const ConnectionFactory &connectionFactory, QAtomicInt *connectionsCount, int maxConnections,
+                   int idleTimeoutMs, LogCategory logCategory);
+
+    // number of connections of this loop, can be read from any thread
+    int count() const { return count_.loadRelaxed(); }
+
+    // the methods below must be called in the thread of the loop
+    void listen(qintptr listenSocket);
+    void addConnection(qintptr socketDescriptor);
+    void closeAllConnections();
+    // closes the listener and deletes the connections without reporting them
+    void stop();
+
+signals:
+    void userConnected(const QString &hostname);
+    void userDisconnected(const QString &hostname);
+
+private slots:
+    void onConnectionFinished(const QString &hostname);
+    void onIdleTimer();
+
+private:
+    static constexpr int kIdleCheckIntervalMs = 10000;
+
+    ConnectionFactory connectionFactory_;
+    QAtomicInt *connectionsCount_;
+    const int maxConnections_;
+    const int idleTimeoutMs_;
+    LogCategory logCategory_;
+
+    ProxyListener *listener_;
+    QTimer *idleTimer_;
+    QSet<ProxyConnection *> connections_;
+    QAtomicInt count_;
+
+    static QString peerAddress(qintptr socketDescriptor);
+    static void closeSocket(qintptr socketDescriptor);
+};
+
+} // namespace ProxyServerCore
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <QTcpServer>
+
+namespace ProxyServerCore {
+
+// hands the descriptors of accepted connections over to the event loops instead of creating QTcpSockets
+class ProxyListener : public QTcpServer
+{
+    Q_OBJECT
+public:
+    explicit ProxyListener(QObject *parent) : QTcpServer(parent) {}
+
+signals:
+    void socketAccepted(qintptr socketDescriptor);
+
+protected:
+    void incomingConnection(qintptr socketDescriptor) override
+    {
+        emit socketAccepted(socketDescriptor);
+    }
+};
+
+} // namespace ProxyServerCore
@@ -0,0 +1,169 @@
+#include "proxyservercore.h"
+
+#ifdef Q_OS_LINUX
+    #include <errno.h>
+    #include <netinet/in.h>
+    #include <string.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+#endif
+#include <QHostAddress>
+#include "utils/ws_assert.h"
+
+namespace ProxyServerCore {
+
+ProxyServerCore::ProxyServerCore(QObject *parent, const ConnectionFactory &connectionFactory, ConnectedUsersCounter *usersCounter,
+                                 ProxyEventLoop::LogCategory logCategory, const Settings &settings) : QObject(parent),
+    usersCounter_(usersCounter), logCategory_(logCategory), listener_(nullptr), connectionsCount_(0), isListening_(false), port_(0)
+{
+    WS_ASSERT(settings.loopsCount > 0);
+    for (int i = 0; i < settings.loopsCount; ++i)
+    {
+        QThread *thread = new QThread(this);
+        ProxyEventLoop *loop = new ProxyEventLoop(connectionFactory, &connectionsCount_, settings.maxConnections,
+                                                  settings.idleTimeoutMs, logCategory);
+        loop->moveToThread(thread);
+        connect(loop, &ProxyEventLoop::userConnected, this, &ProxyServerCore::onUserConnected);
+        connect(loop, &ProxyEventLoop::userDisconnected, this, &ProxyServerCore::onUserDisconnected);
+        threads_ << thread;
+        loops_ << loop;
+        thread->start(QThread::LowPriority);
+    }
+}
+
+ProxyServerCore::~ProxyServerCore()
+{
+    close();
+    for (QThread *thread : qAsConst(threads_))
+    {
+        thread->exit();
+    }
+    for (QThread *thread : qAsConst(threads_))
+    {
+        thread->wait();
+    }
+    qDeleteAll(loops_);
+}
+
+bool ProxyServerCore::listen(quint16 port)
+{
+    WS_ASSERT(!isListening_);
+
+#ifdef Q_OS_LINUX
+    isListening_ = listenSharded(port);
+#else
+    listener_ = new ProxyListener(this);
+    connect(listener_, &ProxyListener::socketAccepted, this, &ProxyServerCore::onSocketAccepted);
+    isListening_ = listener_->listen(QHostAddress::AnyIPv4, port);
+    if (isListening_)
+    {
+        port_ = listener_->serverPort();
+    }
+    else
+    {
+        qCDebug(logCategory_) << "Can't listen on port" << port << ":" << listener_->errorString();
+        delete listener_;
+        listener_ = nullptr;
+    }
+#endif
+    return isListening_;
+}
+
+void ProxyServerCore::close()
+{
+    if (listener_)
+    {
+        listener_->close();
+        delete listener_;
+        listener_ = nullptr;
+    }
+    // closes the sharded listeners together with the connections
+    for (ProxyEventLoop *loop : qAsConst(loops_))
+    {
+        QMetaObject::invokeMethod(loop, [loop]() { loop->stop(); }, Qt::BlockingQueuedConnection);
+    }
+    isListening_ = false;
+    port_ = 0;
+}
+
+void ProxyServerCore::closeAllConnections()
+{
+    for (ProxyEventLoop *loop : qAsConst(loops_))
+    {
+        QMetaObject::invokeMethod(loop, [loop]() { loop->closeAllConnections(); }, Qt::QueuedConnection);
+    }
+}
+
+void ProxyServerCore::onSocketAccepted(qintptr socketDescriptor)
+{
+    ProxyEventLoop *lessBusyLoop = loops_.first();
+    for (ProxyEventLoop *loop : qAsConst(loops_))
+    {
+        if (loop->count() < lessBusyLoop->count())
+        {
+            lessBusyLoop = loop;
+        }
+    }
+    QMetaObject::invokeMethod(lessBusyLoop, [lessBusyLoop, socketDescriptor]() { lessBusyLoop->addConnection(socketDescriptor); },
+                              Qt::QueuedConnection);
+}
+
+void ProxyServerCore::onUserConnected(const QString &hostname)
+{
+    usersCounter_->newUserConnected(hostname);
+}
+
+void ProxyServerCore::onUserDisconnected(const QString &hostname)
+{
+    usersCounter_->userDiconnected(hostname);
+}
+
+#ifdef Q_OS_LINUX
+// one listening socket per loop on the same port, the kernel balances the incoming connections between them
+bool ProxyServerCore::listenSharded(quint16 port)
+{
+    QVector<int> sockets;
+    for (int i = 0; i < loops_.count(); ++i)
+    {
+        const int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        const int on = 1;
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        // with port 0 the first socket picks the port and the others join it
+        addr.sin_port = htons(i == 0 ? port : port_);
+        socklen_t addrLen = sizeof(addr);
+        if (fd < 0 ||
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) < 0 ||
+            setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) < 0 ||
+            bind(fd, (sockaddr *)&addr, sizeof(addr)) < 0 ||
+            ::listen(fd, SOMAXCONN) < 0 ||
+            getsockname(fd, (sockaddr *)&addr, &addrLen) < 0)
+        {
+            qCDebug(logCategory_) << "Can't listen on port" << port << ":" << strerror(errno);
+            if (fd >= 0)
+            {
+                ::close(fd);
+            }
+            for (int s : qAsConst(sockets))
+            {
+                ::close(s);
+            }
+            port_ = 0;
+            return false;
+        }
+        port_ = ntohs(addr.sin_port);
+        sockets << fd;
+    }
+
+    for (int i = 0; i < loops_.count(); ++i)
+    {
+        ProxyEventLoop *loop = loops_[i];
+        const qintptr fd = sockets[i];
+        QMetaObject::invokeMethod(loop, [loop, fd]() { loop->listen(fd); }, Qt::QueuedConnection);
+    }
+    return true;
+}
+#endif
+
+} // namespace ProxyServerCore
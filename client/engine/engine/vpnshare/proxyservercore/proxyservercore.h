@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QAtomicInt>
+#include <QObject>
+#include <QThread>
+#include <QVector>
+
+#include "proxyconnection.h"
+#include "proxyeventloop.h"
+#include "proxylistener.h"
+#include "../connecteduserscounter.h"
+
+namespace ProxyServerCore {
+
+// Connection handling shared by the HTTP and SOCKS proxy servers: N event loops with their own threads,
+// the connections are created directly in the thread of the loop that accepted them (see ProxyEventLoop).
+// Connections above maxConnections are closed right after accept, connections without traffic for
+// idleTimeoutMs are closed by their loop.
+class ProxyServerCore : public QObject
+{
+    Q_OBJECT
+public:
+    struct Settings
+    {
+        int loopsCount = 4;
+        int maxConnections = 4096;
+        int idleTimeoutMs = 5 * 60 * 1000;
+    };
+
+    ProxyServerCore(QObject *parent, const ConnectionFactory &connectionFactory, ConnectedUsersCounter *usersCounter,
+                    ProxyEventLoop::LogCategory logCategory, const Settings &settings = Settings());
+    ~ProxyServerCore() override;
+
+    bool listen(quint16 port);
+    void close();
+    bool isListening() const { return isListening_; }
+    quint16 serverPort() const { return port_; }
+
+    void closeAllConnections();
+
+private slots:
+    void onSocketAccepted(qintptr socketDescriptor);
+    void onUserConnected(const QString &hostname);
+    void onUserDisconnected(const QString &hostname);
+
+private:
+    ConnectedUsersCounter *usersCounter_;
+    ProxyEventLoop::LogCategory logCategory_;
+    QVector<QThread *> threads_;
+    QVector<ProxyEventLoop *> loops_;
+    ProxyListener *listener_;
+    QAtomicInt connectionsCount_;
+    bool isListening_;
+    quint16 port_;
+
+#ifdef Q_OS_LINUX
+    bool listenSharded(quint16 port);
+#endif
+};
+
+} // namespace ProxyServerCore
@@ -0,0 +1,80 @@
+#include "fastrelay.h"
+
+#ifdef Q_OS_LINUX
+    #include <unistd.h>
+    #include "splicerelay_linux.h"
+#endif
+
+namespace FastRelay {
+
+bool isSupported()
+{
+#ifdef Q_OS_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool canHandOver(QTcpSocket *client, QTcpSocket *server)
+{
+    client->flush();
+    server->flush();
+    return client->bytesToWrite() == 0 && server->bytesToWrite() == 0 &&
+           client->bytesAvailable() == 0 && server->bytesAvailable() == 0;
+}
+
+quint64 handOver(QTcpSocket *client, QTcpSocket *server, std::function<void()> onFinished)
+{
+#ifdef Q_OS_LINUX
+    if (!canHandOver(client, server)) {
+        return 0;
+    }
+
+    // the relay gets its own descriptors, closing the QTcpSockets then only drops Qt's ones
+    const int clientFd = dup(client->socketDescriptor());
+    const int serverFd = dup(server->socketDescriptor());
+    const quint64 id = (clientFd >= 0 && serverFd >= 0) ? SpliceRelay::instance().add(clientFd, serverFd, onFinished) : 0;
+    if (id == 0) {
+        if (clientFd >= 0) {
+            ::close(clientFd);
+        }
+        if (serverFd >= 0) {
+            ::close(serverFd);
+        }
+        return 0;
+    }
+
+    client->disconnect();
+    server->disconnect();
+    client->abort();
+    server->abort();
+    return id;
+#else
+    Q_UNUSED(client);
+    Q_UNUSED(server);
+    Q_UNUSED(onFinished);
+    return 0;
+#endif
+}
+
+void close(quint64 id)
+{
+#ifdef Q_OS_LINUX
+    SpliceRelay::instance().remove(id);
+#else
+    Q_UNUSED(id);
+#endif
+}
+
+qint64 idleTime(quint64 id)
+{
+#ifdef Q_OS_LINUX
+    return SpliceRelay::instance().idleTimeMs(id);
+#else
+    Q_UNUSED(id);
+    return -1;
+#endif
+}
+
+} // namespace FastRelay
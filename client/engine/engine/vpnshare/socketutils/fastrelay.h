@@ -0,0 +1,24 @@
+#pragma once
+
+#include <QTcpSocket>
+#include <functional>
+
+// Moves the relay phase of a proxy connection off the Qt event loop: to SpliceRelay on Linux.
+// On the other platforms isSupported() is false and the connections keep relaying through Qt.
+namespace FastRelay {
+
+bool isSupported();
+
+// true if Qt has no data buffered for the sockets, so they can be handed over without losing or reordering data
+bool canHandOver(QTcpSocket *client, QTcpSocket *server);
+
+// on success the QTcpSockets are closed and the relay owns the connection until onFinished is called
+// (from the relay thread) or close() is called; returns the relay id, or 0 if the sockets stay with Qt
+quint64 handOver(QTcpSocket *client, QTcpSocket *server, std::function<void()> onFinished);
+
+void close(quint64 id);
+
+// milliseconds since the relay last moved data, -1 if the relay is gone
+qint64 idleTime(quint64 id);
+
+} // namespace FastRelay
@@ -0,0 +1,29 @@
+#include "socketrelay.h"
+
+namespace SocketRelay {
+
+void setup(QTcpSocket *socket)
+{
+    socket->setReadBufferSize(kReadBufferSize);
+}
+
+qint64 relay(QTcpSocket *from, QTcpSocket *to)
+{
+    // one buffer per proxy event loop thread, the data never stays in it between calls
+    thread_local char buffer[kReadBufferSize];
+
+    qint64 moved = 0;
+    while (to->bytesToWrite() < kMaxPendingBytes)
+    {
+        const qint64 n = from->read(buffer, sizeof(buffer));
+        if (n <= 0)
+        {
+            break;
+        }
+        to->write(buffer, n);
+        moved += n;
+    }
+    return moved;
+}
+
+} // namespace SocketRelay
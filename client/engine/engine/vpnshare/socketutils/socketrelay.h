@@ -0,0 +1,20 @@
+#pragma once
+
+#include <QTcpSocket>
+
+// Relay phase of the proxy connections through Qt, used where the connection is not handed over to FastRelay.
+// The data goes through a buffer shared by all connections of the thread instead of a QByteArray per read,
+// and a direction stops reading while the receiving socket has kMaxPendingBytes queued, so with the capped read
+// buffers the memory of a connection stays flat however fast the two sides are.
+namespace SocketRelay {
+
+const qint64 kReadBufferSize = 64 * 1024;
+const qint64 kMaxPendingBytes = 256 * 1024;
+
+// caps the read buffer of the socket, call when the connection enters the relay phase
+void setup(QTcpSocket *socket);
+
+// moves the available data from one socket to the other, returns the number of bytes moved
+qint64 relay(QTcpSocket *from, QTcpSocket *to);
+
+} // namespace SocketRelay
@@ -8,20 +8,12 @@ SocketWriteAll::SocketWriteAll(QObject *parent, QTcpSocket *socket) : QObject(pa
 
 void SocketWriteAll::write(const QByteArray &arr)
 {
-    if (arr_.isEmpty())
-    {
-        arr_ = arr;
-        socket_->write(arr_);
-    }
-    else
-    {
-        arr_.append(arr);
-    }
+    socket_->write(arr);
 }
 
 void SocketWriteAll::setEmitAllDataWritten()
 {
-    if (arr_.isEmpty())
+    if (socket_->bytesToWrite() == 0)
     {
         emit allDataWriteFinished();
     }
@@ -30,16 +22,9 @@ void SocketWriteAll::setEmitAllDataWritten()
 
 void SocketWriteAll::onBytesWritten(qint64 bytes)
 {
-    arr_.remove(0, bytes);
-    if (!arr_.isEmpty())
+    Q_UNUSED(bytes);
+    if (bEmitAllDataWritten_ && socket_->bytesToWrite() == 0)
     {
-        socket_->write(arr_);
-    }
-    else
-    {
-        if (bEmitAllDataWritten_)
-        {
-            emit allDataWriteFinished();
-        }
+        emit allDataWriteFinished();
     }
 }
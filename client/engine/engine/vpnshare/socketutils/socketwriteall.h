@@ -3,6 +3,8 @@
 #include <QObject>
 #include <QTcpSocket>
 
+// Queues data on the socket and reports when the socket has written everything out.
+// The data goes straight to the socket's write buffer, so it keeps its order with other writes to the socket.
 class SocketWriteAll : public QObject
 {
     Q_OBJECT
@@ -20,6 +22,5 @@ private slots:
 
 private:
     QTcpSocket *socket_;
-    QByteArray arr_;
     bool bEmitAllDataWritten_;
 };
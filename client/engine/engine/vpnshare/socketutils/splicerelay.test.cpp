@@ -0,0 +1,332 @@
+#include "splicerelay.test.h"
+
+#include <QElapsedTimer>
+#include <arpa/inet.h>
+#include <atomic>
+#include <condition_variable>
+#include <errno.h>
+#include <mutex>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "splicerelay_linux.h"
+
+namespace {
+
+int listenLoopback(quint16 *port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 || listen(fd, 16) < 0 ||
+        getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &len) < 0) {
+        return -1;
+    }
+    *port = ntohs(addr.sin_port);
+    return fd;
+}
+
+int connectLoopback(quint16 port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+        return -1;
+    }
+    return fd;
+}
+
+bool writeAll(int fd, const char *data, size_t size)
+{
+    while (size > 0) {
+        ssize_t n = send(fd, data, size, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+// the pieces of one proxied connection: the client socket, the proxy's two sockets and the server socket
+struct Connection
+{
+    int client = -1;
+    int proxyClient = -1;   // accepted from the client
+    int proxyServer = -1;   // connected to the server
+    int server = -1;
+
+    bool open()
+    {
+        quint16 proxyPort, serverPort;
+        int proxyListener = listenLoopback(&proxyPort);
+        int serverListener = listenLoopback(&serverPort);
+        client = connectLoopback(proxyPort);
+        proxyServer = connectLoopback(serverPort);
+        proxyClient = accept(proxyListener, nullptr, nullptr);
+        server = accept(serverListener, nullptr, nullptr);
+        close(proxyListener);
+        close(serverListener);
+        return client >= 0 && proxyClient >= 0 && proxyServer >= 0 && server >= 0;
+    }
+
+    void closeAll()
+    {
+        for (int *fd : { &client, &proxyClient, &proxyServer, &server }) {
+            if (*fd >= 0) {
+                close(*fd);
+                *fd = -1;
+            }
+        }
+    }
+};
+
+// echoes everything back and closes the connection after EOF
+void echoServer(int fd)
+{
+    std::vector<char> buf(64 * 1024);
+    for (;;) {
+        ssize_t n = read(fd, buf.data(), buf.size());
+        if (n <= 0 || !writeAll(fd, buf.data(), n)) {
+            break;
+        }
+    }
+    shutdown(fd, SHUT_WR);
+}
+
+// the relay of the Qt proxies: every read goes to a newly allocated buffer which is then written out
+void copyRelay(int from, int to)
+{
+    const size_t kReadSize = 64 * 1024;
+    for (;;) {
+        std::vector<char> buf(kReadSize);
+        ssize_t n = read(from, buf.data(), buf.size());
+        if (n <= 0 || !writeAll(to, buf.data(), n)) {
+            break;
+        }
+    }
+    shutdown(to, SHUT_WR);
+}
+
+class FinishedFlag
+{
+public:
+    void set()
+    {
+        std::lock_guard<std::mutex> locker(mutex_);
+        isSet_ = true;
+        condition_.notify_all();
+    }
+    bool wait(int timeoutMs)
+    {
+        std::unique_lock<std::mutex> locker(mutex_);
+        return condition_.wait_for(locker, std::chrono::milliseconds(timeoutMs), [this]() { return isSet_; });
+    }
+private:
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    bool isSet_ = false;
+};
+
+// sends totalSize bytes through the connection to the echo server and returns false if less or other data
+// comes back; the benchmarks do not check the content, so that the relay dominates the time
+bool runEchoTraffic(int client, size_t totalSize, bool isContentChecked = true)
+{
+    std::atomic<bool> isWriterOk(true);
+    std::thread writer([client, totalSize, isContentChecked, &isWriterOk]() {
+        std::vector<char> buf(256 * 1024);
+        size_t sent = 0;
+        while (sent < totalSize) {
+            const size_t size = std::min(buf.size(), totalSize - sent);
+            for (size_t i = 0; i < size && isContentChecked; ++i) {
+                buf[i] = static_cast<char>((sent + i) % 251);
+            }
+            if (!writeAll(client, buf.data(), size)) {
+                isWriterOk = false;
+                break;
+            }
+            sent += size;
+        }
+        shutdown(client, SHUT_WR);
+    });
+
+    std::vector<char> buf(256 * 1024);
+    size_t received = 0;
+    bool isDataOk = true;
+    for (;;) {
+        ssize_t n = read(client, buf.data(), buf.size());
+        if (n <= 0) {
+            break;
+        }
+        for (ssize_t i = 0; i < n && isDataOk && isContentChecked; ++i) {
+            isDataOk = buf[i] == static_cast<char>((received + i) % 251);
+        }
+        received += n;
+    }
+    writer.join();
+    return isWriterOk && isDataOk && received == totalSize;
+}
+
+} // namespace
+
+void TestSpliceRelay::testEcho()
+{
+    Connection c;
+    QVERIFY(c.open());
+    std::thread echo(echoServer, c.server);
+
+    FinishedFlag finished;
+    const uint64_t id = SpliceRelay::instance().add(c.proxyClient, c.proxyServer, [&finished]() { finished.set(); });
+    QVERIFY(id != 0);
+    c.proxyClient = c.proxyServer = -1;     // owned by the relay
+
+    QVERIFY(runEchoTraffic(c.client, 8 * 1024 * 1024 + 123));
+    echo.join();
+    // both sides closed their write ends, so the relay is done
+    QVERIFY(finished.wait(5000));
+    QCOMPARE(SpliceRelay::instance().count(), size_t(0));
+    c.closeAll();
+}
+
+void TestSpliceRelay::testHalfClose()
+{
+    Connection c;
+    QVERIFY(c.open());
+
+    FinishedFlag finished;
+    QVERIFY(SpliceRelay::instance().add(c.proxyClient, c.proxyServer, [&finished]() { finished.set(); }) != 0);
+    c.proxyClient = c.proxyServer = -1;
+
+    // the client sends a request and closes its write end, the server still answers after seeing the EOF
+    const char request[] = "request";
+    QVERIFY(writeAll(c.client, request, sizeof(request)));
+    shutdown(c.client, SHUT_WR);
+
+    char buf[64];
+    size_t received = 0;
+    for (;;) {
+        ssize_t n = read(c.server, buf + received, sizeof(buf) - received);
+        QVERIFY(n >= 0);
+        if (n == 0) {
+            break;
+        }
+        received += n;
+    }
+    QCOMPARE(received, sizeof(request));
+    QVERIFY(!finished.wait(100));   // the server -> client direction is still open
+
+    const char answer[] = "answer";
+    QVERIFY(writeAll(c.server, answer, sizeof(answer)));
+    shutdown(c.server, SHUT_WR);
+
+    received = 0;
+    for (;;) {
+        ssize_t n = read(c.client, buf + received, sizeof(buf) - received);
+        QVERIFY(n >= 0);
+        if (n == 0) {
+            break;
+        }
+        received += n;
+    }
+    QCOMPARE(received, sizeof(answer));
+    QVERIFY(finished.wait(5000));
+    c.closeAll();
+}
+
+void TestSpliceRelay::testBackpressure()
+{
+    Connection c;
+    QVERIFY(c.open());
+    QVERIFY(SpliceRelay::instance().add(c.proxyClient, c.proxyServer, nullptr) != 0);
+    c.proxyClient = c.proxyServer = -1;
+
+    // the server does not read, the client must get blocked once the socket buffers and one pipe are full
+    std::vector<char> buf(64 * 1024, 'x');
+    size_t sent = 0;
+    for (;;) {
+        ssize_t n = send(c.client, buf.data(), buf.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n < 0) {
+            QVERIFY(errno == EAGAIN || errno == EWOULDBLOCK);
+            // give the relay time to move what it can, then check that the client is still blocked
+            pollfd pfd = { c.client, POLLOUT, 0 };
+            if (poll(&pfd, 1, 200) == 0) {
+                break;
+            }
+            continue;
+        }
+        sent += n;
+        QVERIFY(sent < 256 * 1024 * 1024);
+    }
+
+    // everything that was sent arrives once the server reads
+    size_t received = 0;
+    while (received < sent) {
+        ssize_t n = read(c.server, buf.data(), buf.size());
+        QVERIFY(n > 0);
+        received += n;
+    }
+    QCOMPARE(received, sent);
+    qInfo("backpressure: the client was blocked after %zu KB", sent / 1024);
+    c.closeAll();
+}
+
+void TestSpliceRelay::benchmarkCopyRelay()
+{
+    Connection c;
+    QVERIFY(c.open());
+    std::thread echo(echoServer, c.server);
+    std::thread toServer(copyRelay, c.proxyClient, c.proxyServer);
+    std::thread toClient(copyRelay, c.proxyServer, c.proxyClient);
+
+    const size_t size = static_cast<size_t>(benchmarkMegabytes()) * 1024 * 1024;
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY(runEchoTraffic(c.client, size, false));
+    const double seconds = timer.nsecsElapsed() / 1e9;
+    qInfo("copy relay: %d MB each way in %.3f s, %.0f MB/s", benchmarkMegabytes(), seconds, 2 * benchmarkMegabytes() / seconds);
+
+    echo.join();
+    toServer.join();
+    toClient.join();
+    c.closeAll();
+}
+
+void TestSpliceRelay::benchmarkSpliceRelay()
+{
+    Connection c;
+    QVERIFY(c.open());
+    std::thread echo(echoServer, c.server);
+    FinishedFlag finished;
+    QVERIFY(SpliceRelay::instance().add(c.proxyClient, c.proxyServer, [&finished]() { finished.set(); }) != 0);
+    c.proxyClient = c.proxyServer = -1;
+
+    const size_t size = static_cast<size_t>(benchmarkMegabytes()) * 1024 * 1024;
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY(runEchoTraffic(c.client, size, false));
+    const double seconds = timer.nsecsElapsed() / 1e9;
+    qInfo("splice relay: %d MB each way in %.3f s, %.0f MB/s", benchmarkMegabytes(), seconds, 2 * benchmarkMegabytes() / seconds);
+
+    echo.join();
+    QVERIFY(finished.wait(5000));
+    c.closeAll();
+}
+
+int TestSpliceRelay::benchmarkMegabytes()
+{
+    const int megabytes = qEnvironmentVariableIntValue("WS_RELAY_BENCHMARK_MB");
+    return megabytes > 0 ? megabytes : 256;
+}
+
+QTEST_MAIN(TestSpliceRelay)
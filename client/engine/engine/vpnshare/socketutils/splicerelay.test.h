@@ -0,0 +1,23 @@
+#pragma once
+
+#include <QObject>
+#include <QTest>
+
+// tests of SpliceRelay and a throughput benchmark against a user-space copy relay (read into a new buffer and write,
+// as the Qt relay of the proxies does); the traffic goes client -> relay -> local echo server -> relay -> client
+// over loopback TCP; the amount of data for the benchmarks can be set with the WS_RELAY_BENCHMARK_MB environment
+// variable (256 by default)
+class TestSpliceRelay : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testEcho();
+    void testHalfClose();
+    void testBackpressure();
+    void benchmarkCopyRelay();
+    void benchmarkSpliceRelay();
+
+private:
+    static int benchmarkMegabytes();
+};
@@ -0,0 +1,218 @@
+#include "splicerelay_linux.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+SpliceRelay::SpliceRelay() : nextId_(0), isStopping_(false)
+{
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd_ >= 0 && wakeFd_ >= 0) {
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u64 = 0;    // relay ids start from 1
+        epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &ev);
+        thread_.reset(new std::thread(&SpliceRelay::run, this));
+    }
+}
+
+SpliceRelay::~SpliceRelay()
+{
+    isStopping_ = true;
+    if (thread_) {
+        uint64_t value = 1;
+        ssize_t res = write(wakeFd_, &value, sizeof(value));
+        (void)res;
+        thread_->join();
+    }
+
+    std::lock_guard<std::mutex> locker(mutex_);
+    for (auto &it : relays_) {
+        close(it.second.get());
+    }
+    relays_.clear();
+    if (wakeFd_ >= 0)
+        ::close(wakeFd_);
+    if (epollFd_ >= 0)
+        ::close(epollFd_);
+}
+
+uint64_t SpliceRelay::add(int clientFd, int serverFd, FinishedCallback callback)
+{
+    std::unique_ptr<Relay> relay(new Relay);
+    relay->callback = callback;
+    relay->toServer.fromFd = clientFd;
+    relay->toServer.toFd = serverFd;
+    relay->toClient.fromFd = serverFd;
+    relay->toClient.toFd = clientFd;
+
+    if (!thread_ || !openPipe(relay->toServer) || !openPipe(relay->toClient)) {
+        closePipes(relay.get());
+        return 0;
+    }
+    fcntl(clientFd, F_SETFL, fcntl(clientFd, F_GETFL) | O_NONBLOCK);
+    fcntl(serverFd, F_SETFL, fcntl(serverFd, F_GETFL) | O_NONBLOCK);
+
+    std::lock_guard<std::mutex> locker(mutex_);
+    relay->id = ++nextId_;
+
+    // edge-triggered: an event on either socket pumps both directions until they would block,
+    // the events reported right after the registration pick up the data already in the kernel buffers
+    epoll_event ev = {};
+    ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    ev.data.u64 = relay->id;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, clientFd, &ev) < 0) {
+        closePipes(relay.get());
+        return 0;
+    }
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, serverFd, &ev) < 0) {
+        epoll_ctl(epollFd_, EPOLL_CTL_DEL, clientFd, nullptr);
+        closePipes(relay.get());
+        return 0;
+    }
+    relay->clientFd = clientFd;
+    relay->serverFd = serverFd;
+    relay->lastActivity = std::chrono::steady_clock::now();
+
+    const uint64_t id = relay->id;
+    relays_[id] = std::move(relay);
+    return id;
+}
+
+void SpliceRelay::remove(uint64_t id)
+{
+    std::lock_guard<std::mutex> locker(mutex_);
+    auto it = relays_.find(id);
+    if (it != relays_.end()) {
+        close(it->second.get());
+        relays_.erase(it);
+    }
+}
+
+size_t SpliceRelay::count() const
+{
+    std::lock_guard<std::mutex> locker(mutex_);
+    return relays_.size();
+}
+
+int64_t SpliceRelay::idleTimeMs(uint64_t id) const
+{
+    std::lock_guard<std::mutex> locker(mutex_);
+    auto it = relays_.find(id);
+    if (it == relays_.end())
+        return -1;
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - it->second->lastActivity).count();
+}
+
+void SpliceRelay::run()
+{
+    epoll_event events[kMaxEvents];
+    while (!isStopping_) {
+        int n = epoll_wait(epollFd_, events, kMaxEvents, -1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        std::lock_guard<std::mutex> locker(mutex_);
+        const auto now = std::chrono::steady_clock::now();
+        for (int i = 0; i < n; ++i) {
+            // ids are never reused, so the events of a removed relay are simply skipped
+            auto it = relays_.find(events[i].data.u64);
+            if (it == relays_.end())
+                continue;
+
+            Relay *relay = it->second.get();
+            relay->lastActivity = now;
+            const bool isOk = pump(relay->toServer) && pump(relay->toClient);
+            if (!isOk || (relay->toServer.isShutdown && relay->toClient.isShutdown)) {
+                FinishedCallback callback = relay->callback;
+                close(relay);
+                relays_.erase(it);
+                if (callback)
+                    callback();
+            }
+        }
+    }
+}
+
+// moves the data of one direction until it would block, returns false on an error
+bool SpliceRelay::pump(Direction &direction)
+{
+    for (;;) {
+        if (direction.bytesInPipe > 0) {
+            ssize_t n = splice(direction.pipe[0], nullptr, direction.toFd, nullptr, direction.bytesInPipe,
+                               SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                // the receiver is slow, stop reading until it is writable again
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            direction.bytesInPipe -= n;
+            continue;
+        }
+
+        if (!direction.isEof) {
+            // the pipe is empty here, so EAGAIN can only mean there is nothing to read
+            ssize_t n = splice(direction.fromFd, nullptr, direction.pipe[1], nullptr, kPipeSize,
+                               SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            if (n > 0) {
+                direction.bytesInPipe += n;
+                continue;
+            }
+            direction.isEof = true;
+        }
+
+        if (!direction.isShutdown) {
+            shutdown(direction.toFd, SHUT_WR);
+            direction.isShutdown = true;
+        }
+        return true;
+    }
+}
+
+void SpliceRelay::close(Relay *relay)
+{
+    closePipes(relay);
+    // closing the sockets also removes them from the epoll set
+    if (relay->clientFd >= 0) {
+        ::close(relay->clientFd);
+        relay->clientFd = -1;
+    }
+    if (relay->serverFd >= 0) {
+        ::close(relay->serverFd);
+        relay->serverFd = -1;
+    }
+}
+
+void SpliceRelay::closePipes(Relay *relay)
+{
+    for (Direction *direction : { &relay->toServer, &relay->toClient }) {
+        for (int &fd : direction->pipe) {
+            if (fd >= 0) {
+                ::close(fd);
+                fd = -1;
+            }
+        }
+    }
+}
+
+bool SpliceRelay::openPipe(Direction &direction)
+{
+    if (pipe2(direction.pipe, O_NONBLOCK | O_CLOEXEC) < 0)
+        return false;
+    // a bigger pipe means fewer splice() calls per megabyte, the default is 64K
+    fcntl(direction.pipe[1], F_SETPIPE_SZ, kPipeSize);
+    return true;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Linux fast path for the relay phase of the VPN-share proxies.
+// Once the HTTP CONNECT / SOCKS handshake is done, the connection hands both sockets over to the relay,
+// which moves the data between them with splice() through a pipe per direction, so the payload never
+// reaches user space. All relays are driven by one epoll thread.
+// Backpressure: a socket is read only when the pipe of its direction is empty, so a slow receiver stops
+// the reading and the TCP window of the sender closes.
+// Half-close: EOF from one side is forwarded as shutdown(SHUT_WR) to the other side after the pipe is drained,
+// the relay finishes when both directions are closed or on an error.
+class SpliceRelay
+{
+public:
+    // called from the relay thread, must not call back into SpliceRelay
+    typedef std::function<void()> FinishedCallback;
+
+    static SpliceRelay &instance()
+    {
+        static SpliceRelay sr;
+        return sr;
+    }
+
+    // Takes ownership of both descriptors on success and returns the relay id, returns 0 on failure.
+    // The caller must not have any data of the connection buffered, the relay starts from the kernel buffers.
+    uint64_t add(int clientFd, int serverFd, FinishedCallback callback);
+    // closes the relay, the callback is not called after this returns
+    void remove(uint64_t id);
+
+    size_t count() const;
+    // milliseconds since the relay last moved data, -1 if there is no such relay
+    int64_t idleTimeMs(uint64_t id) const;
+
+private:
+    SpliceRelay();
+    ~SpliceRelay();
+
+    static constexpr int kPipeSize = 256 * 1024;
+    static constexpr int kMaxEvents = 64;
+
+    struct Direction
+    {
+        int fromFd = -1;
+        int toFd = -1;
+        int pipe[2] = { -1, -1 };
+        size_t bytesInPipe = 0;
+        bool isEof = false;         // fromFd returned EOF
+        bool isShutdown = false;    // EOF was forwarded to toFd
+    };
+
+    struct Relay
+    {
+        uint64_t id = 0;
+        int clientFd = -1;
+        int serverFd = -1;
+        Direction toServer;
+        Direction toClient;
+        FinishedCallback callback;
+        std::chrono::steady_clock::time_point lastActivity;
+    };
+
+    mutable std::mutex mutex_;
+    std::map<uint64_t, std::unique_ptr<Relay>> relays_;
+    uint64_t nextId_;
+    int epollFd_;
+    int wakeFd_;
+    std::atomic<bool> isStopping_;
+    std::unique_ptr<std::thread> thread_;
+
+    void run();
+    bool pump(Direction &direction);
+    void close(Relay *relay);
+    static void closePipes(Relay *relay);
+    static bool openPipe(Direction &direction);
+};
@@ -3,15 +3,16 @@
 #include <QThread>
 #include "utils/ws_assert.h"
 #include "utils/logger.h"
+#include "../socketutils/fastrelay.h"
+#include "../socketutils/socketrelay.h"
 
 namespace SocksProxyServer {
 
 
 SocksProxyConnection::SocksProxyConnection(qintptr socketDescriptor, const QString &hostname,
                                            QObject *parent)
-    : QObject(parent), socket_(nullptr), socketExternal_(nullptr),
-    socketDescriptor_(socketDescriptor), hostname_(hostname), state_(READ_IDENT_REQ),
-    writeAllSocket_(0), writeAllSocketExternal_(0), bAlreadyClosedAndEmitFinished_(false)
+    : ProxyConnection(socketDescriptor, hostname, parent), socket_(nullptr), socketExternal_(nullptr), connector_(nullptr),
+    state_(READ_IDENT_REQ), writeAllSocket_(0), writeAllSocketExternal_(0), bAlreadyClosedAndEmitFinished_(false)
 {
 }
 
@@ -43,6 +44,13 @@ void SocksProxyConnection::onSocketDisconnected()
 
 void SocksProxyConnection::onSocketReadyRead()
 {
+    touch();
+    if (state_ == RELAY_BETWEEN_CLIENT_SERVER)
+    {
+        SocketRelay::relay(socket_, socketExternal_);
+        return;
+    }
+
     socketReadArr_.append(socket_->readAll());
 
     if (state_ == READ_IDENT_REQ)
@@ -102,15 +110,10 @@ void SocksProxyConnection::onSocketReadyRead()
             // handle command
             if (commandParser_.cmd().Cmd == 0x01)  // connect
             {
-                WS_ASSERT(socketExternal_ == NULL);
-                socketExternal_ = new QTcpSocket(this);
-
-                connect(socketExternal_, &QTcpSocket::connected, this, &SocksProxyConnection::onExternalSocketConnected);
-                connect(socketExternal_, &QTcpSocket::disconnected, this, &SocksProxyConnection::onExternalSocketDisconnected);
-                connect(socketExternal_, &QTcpSocket::readyRead, this, &SocksProxyConnection::onExternalSocketReadyRead);
-                connect(socketExternal_, &QTcpSocket::errorOccurred, this, &SocksProxyConnection::onExternalSocketError);
-
-                writeAllSocketExternal_ = new SocketWriteAll(this, socketExternal_);
+                WS_ASSERT(connector_ == NULL);
+                connector_ = new ProxyServerCore::OutboundConnector(this);
+                connect(connector_, &ProxyServerCore::OutboundConnector::connected, this, &SocksProxyConnection::onExternalSocketConnected);
+                connect(connector_, &ProxyServerCore::OutboundConnector::failed, this, &SocksProxyConnection::onExternalSocketError);
                 state_ = CONNECT_TO_HOST;
 
                 if (commandParser_.cmd().AddrType == 0x01)  // ip4
@@ -118,17 +121,17 @@ void SocksProxyConnection::onSocketReadyRead()
                     quint32 ipv4;
                     WS_ASSERT(sizeof(commandParser_.cmd().DestAddr.IPv4) == sizeof(ipv4));
                     memcpy(&ipv4, &commandParser_.cmd().DestAddr.IPv4, sizeof(quint32));
-                    socketExternal_->connectToHost(QHostAddress(ipv4), commandParser_.cmd().DestPort);
+                    connector_->connectToHost(QHostAddress(ipv4), commandParser_.cmd().DestPort);
                 }
                 else if (commandParser_.cmd().AddrType == 0x04)  // ip6
                 {
                     quint8 *ip6Addr = (quint8 *)&commandParser_.cmd().DestAddr.IPv6;
-                    socketExternal_->connectToHost(QHostAddress(ip6Addr), commandParser_.cmd().DestPort);
+                    connector_->connectToHost(QHostAddress(ip6Addr), commandParser_.cmd().DestPort);
                 }
                 else if (commandParser_.cmd().AddrType == 0x03)  // domain name
                 {
                     std::string hostname(commandParser_.cmd().DestAddr.Domain, commandParser_.cmd().DestAddr.DomainLen);
-                    socketExternal_->connectToHost(QString::fromStdString(hostname), commandParser_.cmd().DestPort);
+                    connector_->connectToHost(QString::fromStdString(hostname), commandParser_.cmd().DestPort);
                 }
             }
             else if (commandParser_.cmd().Cmd == 0x02)  // bind
@@ -157,10 +160,9 @@ void SocksProxyConnection::onSocketReadyRead()
             WS_ASSERT(false);
         }
     }
-    else if (state_ == RELAY_BETWEEN_CLIENT_SERVER)
+    else if (state_ == CONNECT_TO_HOST)
     {
-        writeAllSocketExternal_->write(socketReadArr_);
-        socketReadArr_.clear();
+        // sent to the server once connected
     }
     else
     {
@@ -180,6 +182,12 @@ void SocksProxyConnection::onExternalSocketConnected()
 {
     if (state_ == CONNECT_TO_HOST)
     {
+        socketExternal_ = connector_->takeSocket(this);
+        connect(socketExternal_, &QTcpSocket::disconnected, this, &SocksProxyConnection::onExternalSocketDisconnected);
+        connect(socketExternal_, &QTcpSocket::readyRead, this, &SocksProxyConnection::onExternalSocketReadyRead);
+        connect(socketExternal_, &QTcpSocket::errorOccurred, this, &SocksProxyConnection::onExternalSocketError);
+        writeAllSocketExternal_ = new SocketWriteAll(this, socketExternal_);
+
         socks5_resp resp;
         memcpy(&resp, &commandParser_.cmd(), sizeof(resp));
         resp.Reply = 0x00;
@@ -187,6 +195,17 @@ void SocksProxyConnection::onExternalSocketConnected()
         //memset(&resp.BindAddr.IPv4, 0, sizeof(resp.BindAddr.IPv4));
         writeAllSocket_->write(getByteArrayFromSocks5Resp(resp));
         state_ = RELAY_BETWEEN_CLIENT_SERVER;
+        if (!socketReadArr_.isEmpty())
+        {
+            // data the client sent right after the command
+            writeAllSocketExternal_->write(socketReadArr_);
+            socketReadArr_.clear();
+        }
+        SocketRelay::setup(socket_);
+        SocketRelay::setup(socketExternal_);
+        connect(socket_, &QTcpSocket::bytesWritten, this, &SocksProxyConnection::onRelayBytesWritten);
+        connect(socketExternal_, &QTcpSocket::bytesWritten, this, &SocksProxyConnection::onRelayBytesWritten);
+        startFastRelay();
     }
     else
     {
@@ -210,10 +229,10 @@ void SocksProxyConnection::onExternalSocketDisconnected()
 
 void SocksProxyConnection::onExternalSocketReadyRead()
 {
-    QByteArray arr = socketExternal_->readAll();
+    touch();
     if (state_ == RELAY_BETWEEN_CLIENT_SERVER)
     {
-        writeAllSocket_->write(arr);
+        SocketRelay::relay(socketExternal_, socket_);
     }
     /*else if (state_ == READ_HEADERS_FROM_WEBSERVER)
     {
@@ -263,15 +282,52 @@ void SocksProxyConnection::onExternalSocketError(QAbstractSocket::SocketError so
     }*/
 }
 
+// resumes the directions stopped because the receiving socket had too much data queued
+void SocksProxyConnection::onRelayBytesWritten()
+{
+    if (state_ == RELAY_BETWEEN_CLIENT_SERVER)
+    {
+        SocketRelay::relay(socket_, socketExternal_);
+        SocketRelay::relay(socketExternal_, socket_);
+    }
+}
+
+// hands the established connection over to the fast relay once Qt has written everything queued for it
+void SocksProxyConnection::startFastRelay()
+{
+    if (!FastRelay::isSupported() || state_ != RELAY_BETWEEN_CLIENT_SERVER || fastRelayId_ != 0)
+    {
+        return;
+    }
+    if (!FastRelay::canHandOver(socket_, socketExternal_))
+    {
+        connect(socket_, &QTcpSocket::bytesWritten, this, &SocksProxyConnection::startFastRelay, Qt::UniqueConnection);
+        connect(socketExternal_, &QTcpSocket::bytesWritten, this, &SocksProxyConnection::startFastRelay, Qt::UniqueConnection);
+        return;
+    }
+    fastRelayId_ = FastRelay::handOver(socket_, socketExternal_, [this]() {
+        QMetaObject::invokeMethod(this, "closeSocketsAndEmitFinished", Qt::QueuedConnection);
+    });
+}
+
 void SocksProxyConnection::closeSocketsAndEmitFinished()
 {
     if (!bAlreadyClosedAndEmitFinished_)
     {
         bAlreadyClosedAndEmitFinished_ = true;
+        if (fastRelayId_)
+        {
+            FastRelay::close(fastRelayId_);
+            fastRelayId_ = 0;
+        }
         if (socket_)
         {
             socket_->close();
         }
+        if (connector_)
+        {
+            connector_->abort();
+        }
         if (socketExternal_)
         {
             socketExternal_->close();
@@ -3,6 +3,8 @@
 #include <QObject>
 #include <QTcpSocket>
 
+#include "../proxyservercore/outboundconnector.h"
+#include "../proxyservercore/proxyconnection.h"
 #include "socksstructs.h"
 #include "socksproxyreadexactly.h"
 #include "socksproxyidentreqparser.h"
@@ -11,20 +13,15 @@
 
 namespace SocksProxyServer {
 
-class SocksProxyConnection : public QObject
+class SocksProxyConnection : public ProxyServerCore::ProxyConnection
 {
     Q_OBJECT
 public:
     explicit SocksProxyConnection(qintptr socketDescriptor, const QString &hostname, QObject *parent = nullptr);
 
-    bool start(qintptr socketDescriptor);
-
 public slots:
-    void start();
-    void forceClose();
-
-signals:
-    void finished(const QString &hostname);
+    void start() override;
+    void forceClose() override;
 
 private slots:
     void onSocketDisconnected();
@@ -36,13 +33,14 @@ private slots:
     void onExternalSocketDisconnected();
     void onExternalSocketReadyRead();
     void onExternalSocketError(QAbstractSocket::SocketError socketError);
+    void onRelayBytesWritten();
+    void startFastRelay();
 private slots:
     void closeSocketsAndEmitFinished();
 private:
     QTcpSocket *socket_;
     QTcpSocket *socketExternal_;
-    qintptr socketDescriptor_;
-    QString hostname_;
+    ProxyServerCore::OutboundConnector *connector_;
 
     enum { READ_IDENT_REQ, READ_COMMANDS, CONNECT_TO_HOST, RELAY_BETWEEN_CLIENT_SERVER } state_;
 
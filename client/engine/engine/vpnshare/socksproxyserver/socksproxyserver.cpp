@@ -1,14 +1,17 @@
 #include "socksproxyserver.h"
+#include "socksproxyconnection.h"
 #include "utils/ws_assert.h"
 #include "utils/logger.h"
 
 namespace SocksProxyServer {
 
-SocksProxyServer::SocksProxyServer(QObject *parent) : QTcpServer(parent)
+SocksProxyServer::SocksProxyServer(QObject *parent) : QObject(parent)
 {
     usersCounter_ = new ConnectedUsersCounter(this);
     connect(usersCounter_, &ConnectedUsersCounter::usersCountChanged, this, &SocksProxyServer::usersCountChanged);
-    connectionManager_ = new SocksProxyConnectionManager(this, 4, usersCounter_);
+    core_ = new ProxyServerCore::ProxyServerCore(this, [](qintptr socketDescriptor, const QString &hostname) {
+        return new SocksProxyConnection(socketDescriptor, hostname);
+    }, usersCounter_, LOG_SOCKS_SERVER);
 }
 
 SocksProxyServer::~SocksProxyServer()
@@ -18,9 +21,9 @@ SocksProxyServer::~SocksProxyServer()
 
 bool SocksProxyServer::startServer(quint16 port)
 {
-    WS_ASSERT(!isListening());
+    WS_ASSERT(!core_->isListening());
 
-    if (listen(QHostAddress::AnyIPv4, port))
+    if (core_->listen(port))
     {
         qCDebug(LOG_SOCKS_SERVER) << "Socks proxy server started on port" << serverPort();
         return true;
@@ -34,28 +37,27 @@ bool SocksProxyServer::startServer(quint16 port)
 
 void SocksProxyServer::stopServer()
 {
-    if (isListening())
+    if (core_->isListening())
     {
         qCDebug(LOG_SOCKS_SERVER) << "Socks proxy server stopped on port" << serverPort();
-        close();
     }
-    connectionManager_->stop();
+    // also drops the connections accepted by the sharded listeners if the main listener failed to start
+    core_->close();
 }
 
-int SocksProxyServer::getConnectedUsersCount()
+quint16 SocksProxyServer::serverPort() const
 {
-    return usersCounter_->getConnectedUsersCount();
+    return core_->serverPort();
 }
 
-void SocksProxyServer::closeActiveConnections()
+int SocksProxyServer::getConnectedUsersCount()
 {
-    connectionManager_->closeAllConnections();
+    return usersCounter_->getConnectedUsersCount();
 }
 
-void SocksProxyServer::incomingConnection(qintptr socketDescriptor)
+void SocksProxyServer::closeActiveConnections()
 {
-    connectionManager_->newConnection(socketDescriptor);
+    core_->closeAllConnections();
 }
 
-
 } // namespace SocksProxyServer
@@ -1,13 +1,13 @@
 #pragma once
 
-#include "socksproxyconnectionmanager.h"
 #include "../connecteduserscounter.h"
+#include "../proxyservercore/proxyservercore.h"
 
-#include <QTcpServer>
+#include <QObject>
 
 namespace SocksProxyServer {
 
-class SocksProxyServer : public QTcpServer
+class SocksProxyServer : public QObject
 {
     Q_OBJECT
 public:
@@ -17,6 +17,7 @@ public:
     bool startServer(quint16 port);
     void stopServer();
 
+    quint16 serverPort() const;
     int getConnectedUsersCount();
 
     void closeActiveConnections();
@@ -24,12 +25,8 @@ public:
 signals:
     void usersCountChanged();
 
-protected:
-    virtual void incomingConnection(qintptr socketDescriptor);
-
-
 private:
-    SocksProxyConnectionManager *connectionManager_;
+    ProxyServerCore::ProxyServerCore *core_;
     ConnectedUsersCounter *usersCounter_;
 };
 
@@ -4,6 +4,7 @@
 #include <QSettings>
 
 #include "engine/connectionmanager/availableport.h"
+#include "proxyservercore/proxydnscache.h"
 #include "utils/network_utils/network_utils.h"
 #include "utils/utils.h"
 #include "utils/ws_assert.h"
@@ -38,6 +39,8 @@ void VpnShareController::startProxySharing(PROXY_SHARING_TYPE proxyType, uint po
 
     SAFE_DELETE(httpProxyServer_);
     SAFE_DELETE(socksProxyServer_);
+    // the DNS servers may have changed since the last sharing session
+    ProxyServerCore::ProxyDnsCache::instance().clear();
     if (proxyType == PROXY_SHARING_HTTP)
     {
         httpProxyServer_ = new HttpProxyServer::HttpProxyServer(this);
@@ -4,6 +4,7 @@
 #include "types/global_consts.h"
 #include "api_responses/wgconfigs_connect.h"
 #include "api_responses/wgconfigs_init.h"
+#include "engine/connectionmanager/connectiontracer.h"
 #include "utils/utils.h"
 #include "utils/ws_assert.h"
 
@@ -55,6 +56,7 @@ void GetWireGuardConfig::getWireGuardConfig(const QString &serverName, bool dele
 void GetWireGuardConfig::onWgConfigsInitAnswer(wsnet::ServerApiRetCode serverApiRetCode, const std::string &jsonData)
 {
     request_.reset();
+    ConnectionTracer::instance().endSpan("api.wgConfigsInit", serverApiRetCode == ServerApiRetCode::kSuccess);
 
     if (serverApiRetCode == ServerApiRetCode::kFailoverFailed) {
         emit getWireGuardConfigAnswer(WireGuardConfigRetCode::kFailoverFailed, wireGuardConfig_);
@@ -98,6 +100,7 @@ void GetWireGuardConfig::onWgConfigsInitAnswer(wsnet::ServerApiRetCode serverApi
 void GetWireGuardConfig::onWgConfigsConnectAnswer(ServerApiRetCode serverApiRetCode, const std::string &jsonData)
 {
     request_.reset();
+    ConnectionTracer::instance().endSpan("api.wgConfigsConnect", serverApiRetCode == ServerApiRetCode::kSuccess);
 
     if (serverApiRetCode == ServerApiRetCode::kFailoverFailed) {
         emit getWireGuardConfigAnswer(WireGuardConfigRetCode::kFailoverFailed, wireGuardConfig_);
@@ -142,6 +145,7 @@ void GetWireGuardConfig::onWgConfigsConnectAnswer(ServerApiRetCode serverApiRetC
 void GetWireGuardConfig::submitWireguardConnectRequest()
 {
     WS_ASSERT(request_ == nullptr);
+    ConnectionTracer::instance().beginSpan("api.wgConfigsConnect");
     request_ = WSNet::instance()->serverAPI()->wgConfigsConnect(WSNet::instance()->apiResourcersManager()->authHash(), wireGuardConfig_.clientPublicKey().toStdString(),
                                                                 serverName_.toStdString(), deviceId_.toStdString(), std::string(),
                                                                 [this](ServerApiRetCode serverApiRetCode, const std::string &jsonData)
@@ -164,6 +168,7 @@ void GetWireGuardConfig::submitWireGuardInitRequest(bool generateKeyPair)
         setWireGuardKeyPair(wireGuardConfig_.clientPublicKey(), wireGuardConfig_.clientPrivateKey());
     }
     WS_ASSERT(request_ == nullptr);
+    ConnectionTracer::instance().beginSpan("api.wgConfigsInit");
     request_ = WSNet::instance()->serverAPI()->wgConfigsInit(WSNet::instance()->apiResourcersManager()->authHash(), wireGuardConfig_.clientPublicKey().toStdString(),
                                                                 deleteOldestKey_,
                                                                 [this](ServerApiRetCode serverApiRetCode, const std::string &jsonData)
@@ -174,6 +179,14 @@ void GetWireGuardConfig::submitWireGuardInitRequest(bool generateKeyPair)
                                                                 });
 }
 
+QString GetWireGuardConfig::storedClientPublicKey()
+{
+    QString publicKey, privateKey;
+    if (getWireGuardKeyPair(publicKey, privateKey))
+        return publicKey;
+    return QString();
+}
+
 bool GetWireGuardConfig::getWireGuardKeyPair(QString &publicKey, QString &privateKey)
 {
     WireGuardConfig wgConfig = readWireGuardConfigFromSettings();
@@ -25,6 +25,9 @@ public:
 
     void getWireGuardConfig(const QString &serverName, bool deleteOldestKey, const QString &deviceId);
     static void removeWireGuardSettings();
+    // the public key of the key-pair stored on disk, empty if there is none
+    QString storedClientPublicKey();
+    bool getWireGuardKeyPair(QString &publicKey, QString &privateKey);
 
 signals:
     void getWireGuardConfigAnswer(WireGuardConfigRetCode retCode, const WireGuardConfig &config);
@@ -49,7 +52,6 @@ private:
     void submitWireguardConnectRequest();
     void submitWireGuardInitRequest(bool generateKeyPair);
 
-    bool getWireGuardKeyPair(QString &publicKey, QString &privateKey);
     void setWireGuardKeyPair(const QString &publicKey, const QString &privateKey);
     bool getWireGuardPeerInfo(QString &presharedKey, QString &allowedIPs);
     void setWireGuardPeerInfo(const QString &presharedKey, const QString &allowedIPs);
@@ -0,0 +1,136 @@
+#include "wireguardconfigprefetcher.h"
+
+#include "utils/logger.h"
+
+WireGuardConfigPrefetcher::WireGuardConfigPrefetcher(QObject *parent) : QObject(parent)
+{
+    getWireGuardConfig_ = new GetWireGuardConfig(this);
+    connect(getWireGuardConfig_, &GetWireGuardConfig::getWireGuardConfigAnswer, this, &WireGuardConfigPrefetcher::onGetWireGuardConfigAnswer);
+}
+
+void WireGuardConfigPrefetcher::prefetch(const QStringList &hostnames)
+{
+    QStringList wanted;
+    for (const auto &hostname : hostnames) {
+        if (wanted.size() == kMaxHostnames)
+            break;
+        if (!hostname.isEmpty() && !wanted.contains(hostname))
+            wanted << hostname;
+    }
+
+    for (auto it = cache_.begin(); it != cache_.end(); ) {
+        if (!wanted.contains(it.key()) || !isFresh(it.value()))
+            it = cache_.erase(it);
+        else
+            ++it;
+    }
+
+    if (!currentHostname_.isEmpty() && !wanted.contains(currentHostname_))
+        cancelCurrentRequest();
+
+    queue_.clear();
+    if (isKeyLimit_)
+        return;
+    for (const auto &hostname : qAsConst(wanted)) {
+        if (!cache_.contains(hostname) && hostname != currentHostname_)
+            queue_ << hostname;
+    }
+
+    if (currentHostname_.isEmpty())
+        fetchNext();
+}
+
+void WireGuardConfigPrefetcher::stop()
+{
+    queue_.clear();
+    cancelCurrentRequest();
+}
+
+void WireGuardConfigPrefetcher::clear()
+{
+    stop();
+    cache_.clear();
+    isKeyLimit_ = false;
+}
+
+QStringList WireGuardConfigPrefetcher::cachedHostnames() const
+{
+    QStringList hostnames;
+    for (auto it = cache_.cbegin(); it != cache_.cend(); ++it) {
+        if (isFresh(it.value()))
+            hostnames << it.key();
+    }
+    return hostnames;
+}
+
+bool WireGuardConfigPrefetcher::take(const QString &hostname, WireGuardConfig &config)
+{
+    auto it = cache_.find(hostname);
+    if (it == cache_.end())
+        return false;
+
+    const Entry entry = it.value();
+    cache_.erase(it);
+    if (!isFresh(entry))
+        return false;
+
+    // the keys were regenerated or removed after the config was fetched, the server does not know them
+    if (entry.config.clientPublicKey() != getWireGuardConfig_->storedClientPublicKey()) {
+        qCDebug(LOG_CONNECTION) << "The prefetched WireGuard config for hostname =" << hostname << "is out of date";
+        return false;
+    }
+
+    config = entry.config;
+    return true;
+}
+
+void WireGuardConfigPrefetcher::onGetWireGuardConfigAnswer(WireGuardConfigRetCode retCode, const WireGuardConfig &config)
+{
+    const QString hostname = currentHostname_;
+    currentHostname_.clear();
+
+    if (retCode == WireGuardConfigRetCode::kSuccess) {
+        qCDebug(LOG_CONNECTION) << "Prefetched the WireGuard config for hostname =" << hostname;
+        Entry entry;
+        entry.config = config;
+        entry.fetchTimer.start();
+        cache_.insert(hostname, entry);
+        fetchNext();
+    } else if (retCode == WireGuardConfigRetCode::kKeyLimit) {
+        qCDebug(LOG_CONNECTION) << "WireGuard key limit reached, config prefetching stopped";
+        isKeyLimit_ = true;
+        queue_.clear();
+    } else {
+        // the API is probably not reachable now, try again on the next prefetch()
+        qCDebug(LOG_CONNECTION) << "Failed to prefetch the WireGuard config for hostname =" << hostname;
+        queue_.clear();
+    }
+}
+
+void WireGuardConfigPrefetcher::fetchNext()
+{
+    if (queue_.isEmpty())
+        return;
+
+    currentHostname_ = queue_.takeFirst();
+    qCDebug(LOG_CONNECTION) << "Prefetching the WireGuard config for hostname =" << currentHostname_;
+    getWireGuardConfig_->getWireGuardConfig(currentHostname_, false, QString());
+}
+
+void WireGuardConfigPrefetcher::cancelCurrentRequest()
+{
+    if (currentHostname_.isEmpty())
+        return;
+
+    // GetWireGuardConfig cancels its request when deleted; it may be in the middle of emitting an answer, so delete it later
+    currentHostname_.clear();
+    getWireGuardConfig_->disconnect(this);
+    getWireGuardConfig_->deleteLater();
+    getWireGuardConfig_ = new GetWireGuardConfig(this);
+    connect(getWireGuardConfig_, &GetWireGuardConfig::getWireGuardConfigAnswer, this, &WireGuardConfigPrefetcher::onGetWireGuardConfigAnswer);
+}
+
+bool WireGuardConfigPrefetcher::isFresh(const Entry &entry) const
+{
+    return entry.fetchTimer.isValid() && entry.fetchTimer.elapsed() < kEntryLifetimeMs;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+#include "getwireguardconfig.h"
+
+// Fetches the WireGuard configs of the servers the user is likely to connect to while the app is idle, so that connecting
+// can go straight to starting WireGuard without the wgConfigsInit/wgConfigsConnect round trips to the API.
+// The configs are kept in a small cache keyed by the server hostname. An entry expires after kEntryLifetimeMs, is used
+// at most once, and is dropped if the key-pair stored on disk has changed since it was fetched.
+// Static IP locations are not supported, their configs are bound to the device id.
+class WireGuardConfigPrefetcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit WireGuardConfigPrefetcher(QObject *parent);
+
+    // sets the hostnames to keep configs for, in the order of priority; the entries of other hostnames are dropped
+    void prefetch(const QStringList &hostnames);
+    // cancels the request in progress and the queued ones, keeps the cache
+    void stop();
+    // drops the cache, e.g. on logout
+    void clear();
+
+    // of the entries which have not expired yet
+    QStringList cachedHostnames() const;
+    bool take(const QString &hostname, WireGuardConfig &config);
+
+private slots:
+    void onGetWireGuardConfigAnswer(WireGuardConfigRetCode retCode, const WireGuardConfig &config);
+
+private:
+    struct Entry
+    {
+        WireGuardConfig config;
+        QElapsedTimer fetchTimer;
+    };
+
+    static constexpr int kMaxHostnames = 4;
+    static constexpr qint64 kEntryLifetimeMs = 15 * 60 * 1000;
+
+    GetWireGuardConfig *getWireGuardConfig_ = nullptr;
+    QHash<QString, Entry> cache_;
+    QStringList queue_;
+    QString currentHostname_;   // of the request in progress
+    // the user has to decide which key to delete, this is not done in the background
+    bool isKeyLimit_ = false;
+
+    void fetchNext();
+    void cancelCurrentRequest();
+    bool isFresh(const Entry &entry) const;
+};
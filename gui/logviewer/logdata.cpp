@@ -1,40 +1,103 @@
 #include "logdata.h"
 
+#include <algorithm>
+#include <set>
+#include <QDateTime>
 #include <QFile>
-#include <QTextStream>
+#include <QtConcurrent>
 #include "utils/ws_assert.h"
 
 namespace
 {
-bool isYearInDatePresent(const QString &dateline)
+// Timestamps are the wall clock time of the log taken as UTC, so they are compared to the current time the same way.
+qint64 currentLogTime()
 {
-    const int scan = qMin(7, dateline.length());
-    for (int i = 1; i < scan; ++i)
-        if (dateline[i] == ' ')
-            return false;
-    return true;
+    const QDateTime now = QDateTime::currentDateTime();
+    return QDateTime(now.date(), now.time(), Qt::UTC).toMSecsSinceEpoch();
 }
 
-int getLogDataEntryStringSize(const LogDataEntry &entry)
+bool hasTypeMarker(const QByteArray &line)
 {
-    return entry.label.length() + entry.text.length();
+    return line.size() >= 3 && line[1] == ' ' && line[2] == '['
+        && (line[0] == 'G' || line[0] == 'E' || line[0] == 'S');
 }
 }  // namespace
 
-LogData::LogData() : timestampCounter_(0)
+LogData::LogData() : typeCounts_(), maxLineLength_(0)
 {
 }
 
-QPair<int, int> LogData::getDataSizeForType(LogDataType type) const
+LogData::~LogData()
 {
-    WS_ASSERT(type < NUM_LOG_TYPES || type == LOG_TYPE_MIXED);
-    if (type < NUM_LOG_TYPES)
-        return typeInfo_[type];
-    QPair<int, int> result;
-    for (auto it = typeInfo_.begin(); it != typeInfo_.end(); ++it) {
-        result.first += it.value().first;
-        result.second += it.value().second;
+}
+
+int LogData::numTypes() const
+{
+    int result = 0;
+    for (int i = 0; i < NUM_LOG_TYPES; ++i)
+        if (typeCounts_[i] > 0)
+            ++result;
+    return result;
+}
+
+LogDataEntry LogData::entry(int index) const
+{
+    WS_ASSERT(index >= 0 && index < rows_.size());
+    const LogRow &row = rows_[index];
+    const QByteArray line = lineBytes(row);
+
+    LogDataEntry entry;
+    entry.type = static_cast<LogDataType>(row.type);
+    entry.timestamp = QDateTime::fromMSecsSinceEpoch(row.time, Qt::UTC).toString("dd.MM.yy hh:mm:ss:zzz");
+    if (row.type == LOG_TYPE_AUX) {
+        entry.text = QString::fromUtf8(line);
+    } else {
+        int labelBegin, labelEnd, textBegin;
+        splitLogLine(line.constData(), line.size(), &labelBegin, &labelEnd, &textBegin);
+        entry.label = QString::fromUtf8(line.constData() + labelBegin, labelEnd - labelBegin).trimmed();
+        entry.text = QString::fromUtf8(line.constData() + textBegin, line.size() - textBegin);
     }
+    return entry;
+}
+
+int LogData::findRowByTime(qint64 time) const
+{
+    const auto it = std::lower_bound(rows_.cbegin(), rows_.cend(), time,
+        [](const LogRow &row, qint64 value) { return row.time < value; });
+    return static_cast<int>(it - rows_.cbegin());
+}
+
+QVector<int> LogData::search(const QRegularExpression &re, int firstRow) const
+{
+    struct Task {
+        int begin;
+        int end;
+        QVector<int> matches;
+    };
+    const int kRowsPerTask = 16384;
+    QVector<Task> tasks;
+    for (int i = qMax(firstRow, 0); i < rows_.size(); i += kRowsPerTask)
+        tasks.append({ i, qMin(i + kRowsPerTask, rows_.size()), {} });
+
+    QtConcurrent::blockingMap(tasks, [this, &re](Task &task) {
+        const QRegularExpression taskRe(re);
+        for (int i = task.begin; i < task.end; ++i) {
+            const LogRow &row = rows_[i];
+            if (row.type == LOG_TYPE_AUX) {
+                task.matches.append(i);
+                continue;
+            }
+            const QByteArray line = lineBytes(row);
+            int labelBegin, labelEnd, textBegin;
+            splitLogLine(line.constData(), line.size(), &labelBegin, &labelEnd, &textBegin);
+            if (taskRe.match(QString::fromUtf8(line.constData() + textBegin, line.size() - textBegin)).hasMatch())
+                task.matches.append(i);
+        }
+    });
+
+    QVector<int> result;
+    for (const auto &task : qAsConst(tasks))
+        result += task.matches;
     return result;
 }
 
@@ -44,170 +107,164 @@ bool LogData::save(const QString &filename) const
     if (!qf.open(QIODevice::WriteOnly))
         return false;
 
-    const char *kTypeMarker[] = { "G", "E", "S" };
-    QTextStream qts(&qf);
-    qts.setFieldAlignment(QTextStream::AlignRight);
-    for (auto it = data_.constBegin(); it != data_.constEnd(); ++it) {
-        const auto timestamp =
-            QDateTime::fromMSecsSinceEpoch(it.key() >> 20).toString("ddMMyy hh:mm:ss:zzz");
-        if (it->type == LOG_TYPE_AUX) {
-            qts << it->text + "\n";
-        } else {
-            qts << kTypeMarker[it->type] << " [" << timestamp
-                << qSetFieldWidth(11) << it->label << qSetFieldWidth(0)
-                << "] " << it->text + "\n";
-        }
+    const char *kTypeMarker[] = { "G ", "E ", "S " };
+    for (const auto &row : qAsConst(rows_)) {
+        const QByteArray line = lineBytes(row);
+        if (row.type < NUM_LOG_TYPES && !hasTypeMarker(line))
+            qf.write(kTypeMarker[row.type]);
+        qf.write(line);
+        qf.write("\n");
     }
     qf.close();
     return true;
 }
 
-void LogData::clearDataByLogType(LogDataType type)
+void LogData::addIndex(LogIndexChunk chunk)
 {
-    WS_ASSERT(type < NUM_LOG_TYPES || type == LOG_TYPE_MIXED);
-    bool updated = false;
-    if (type == LOG_TYPE_MIXED) {
-        typeInfo_.clear();
-        data_.clear();
-        timestampCounter_ = 0;
-        updated = true;
-    } else {
-        typeInfo_.remove(type);
-        LogDataMutableIterator it(data_);
-        while (it.hasNext()) {
-            it.next();
-            if (it.value().type == type) {
-                it.remove();
-                updated = true;
-            }
-        }
+    auto &file = files_[chunk.logindex];
+    if (!file) {
+        file.reset(new LogFile);
+        file->type = chunk.type;
     }
-    if (updated)
-        emit dataUpdated();
-}
 
-void LogData::clearDataByLogIndex(quint32 index)
-{
-    bool updated = false;
-    typeInfo_.clear();
-    LogDataMutableIterator it(data_);
-    while (it.hasNext()) {
-        it.next();
-        if (it.value().logindex == index) {
-            it.remove();
-            updated = true;
-        } else {
-            auto &info = typeInfo_[it.value().type];
-            ++info.first;
-            info.second += getLogDataEntryStringSize(it.value());
+    // The chunk continues the bytes already kept, from the start of the partial line if there is one.
+    if (chunk.dataBegin > file->data.size()) {
+        clearDataByLogIndex(chunk.logindex);
+        return;
+    }
+
+    int firstChangedRow = rows_.size();
+
+    // The line which had no line break yet is in the new index again.
+    if (file->isLastLinePartial) {
+        const quint32 line = static_cast<quint32>(file->offsets.size() - 1);
+        for (int i = rows_.size() - 1; i >= 0; --i) {
+            if (rows_[i].logindex == chunk.logindex && rows_[i].line == line) {
+                if (rows_[i].type < NUM_LOG_TYPES)
+                    --typeCounts_[rows_[i].type];
+                rows_.remove(i);
+                firstChangedRow = i;
+                break;
+            }
         }
+        file->offsets.removeLast();
+        file->isLastLinePartial = false;
     }
-    if (updated)
-        emit dataUpdated();
-}
 
-void LogData::addLines(QStringList lines, LogDataType type, quint32 index,
-                       LogRangeCheckType rangeCheck)
-{
-    if (lines.empty())
-        return;
+    file->data.truncate(static_cast<int>(chunk.dataBegin));
+    file->data.append(chunk.data);
 
-    WS_ASSERT(type < NUM_LOG_TYPES || type == LOG_TYPE_MIXED);
-    const int kCurrentYearOffset = QDateTime::currentDateTime().date().year() - 1900;
-    QDateTime range[2];
-    if (data_.isEmpty())
-        rangeCheck = LogRangeCheckType::NONE;
-    switch (rangeCheck) {
+    bool isRangeCheck = !rows_.isEmpty();
+    qint64 range[2] = {};
+    switch (chunk.rangeCheck) {
     case LogRangeCheckType::MIN_TO_MAX:
-        range[0] = QDateTime::fromMSecsSinceEpoch(data_.firstKey() >> 20);
-        range[1] = QDateTime::fromMSecsSinceEpoch(data_.lastKey() >> 20);
+        if (isRangeCheck) {
+            range[0] = rows_.first().time;
+            range[1] = rows_.last().time;
+        }
         break;
     case LogRangeCheckType::MIN_TO_NOW:
-        range[0] = QDateTime::fromMSecsSinceEpoch(data_.firstKey() >> 20);
-        range[1] = QDateTime::currentDateTimeUtc();
-        range[1].setTimeSpec(Qt::LocalTime);
+        if (isRangeCheck) {
+            range[0] = rows_.first().time;
+            range[1] = currentLogTime();
+        }
         break;
     default:
+        isRangeCheck = false;
         break;
     }
-    for (auto &line : qAsConst(lines)) {
-        processLine(line, type, index, kCurrentYearOffset,
-            (rangeCheck != LogRangeCheckType::NONE) ? range : nullptr);
+
+    const quint32 baseLine = static_cast<quint32>(file->offsets.size());
+    file->offsets += chunk.offsets;
+    file->isLastLinePartial = chunk.isLastLinePartial;
+    maxLineLength_ = qMax(maxLineLength_, chunk.maxLineLength);
+
+    const int oldSize = rows_.size();
+    rows_.reserve(oldSize + chunk.rows.size());
+    for (LogRow row : qAsConst(chunk.rows)) {
+        if (isRangeCheck && (row.time < range[0] || row.time > range[1]))
+            continue;
+        row.line += baseLine;
+        row.logindex = static_cast<quint16>(chunk.logindex);
+        if (row.type < NUM_LOG_TYPES)
+            ++typeCounts_[row.type];
+        rows_.append(row);
+    }
+
+    // New lines usually come after all the others, otherwise merge the sorted runs.
+    if (oldSize > 0 && rows_.size() > oldSize && rows_[oldSize] < rows_[oldSize - 1]) {
+        const auto merged = std::upper_bound(rows_.begin(), rows_.begin() + oldSize, rows_[oldSize]);
+        firstChangedRow = qMin(firstChangedRow, static_cast<int>(merged - rows_.begin()));
+        std::inplace_merge(rows_.begin(), rows_.begin() + oldSize, rows_.end());
     }
-    emit dataUpdated();
+    firstChangedRow = qMin(firstChangedRow, oldSize);
+    emit dataUpdated(firstChangedRow);
 }
 
-void LogData::processLine(const QString &line, LogDataType type, quint32 index, int yoffset,
-                          QDateTime *range)
+void LogData::clearDataByLogType(LogDataType type)
 {
-    if (line.isEmpty())
+    WS_ASSERT(type < NUM_LOG_TYPES || type == LOG_TYPE_MIXED);
+    if (type == LOG_TYPE_MIXED) {
+        const bool updated = !rows_.isEmpty();
+        files_.clear();
+        rows_.clear();
+        updateTypeCounts();
+        if (updated)
+            emit dataUpdated(0);
         return;
-
-    // Verify type.
-    QString processingLine;
-    if (line.startsWith("G [")) {
-        WS_ASSERT(type == LOG_TYPE_MIXED);
-        processingLine = line.mid(2);
-        type = LOG_TYPE_GUI;
-    } else if (line.startsWith("E [")) {
-        WS_ASSERT(type == LOG_TYPE_MIXED);
-        type = LOG_TYPE_ENGINE;
-        processingLine = line.mid(2);
-    } else if (line.startsWith("S [")) {
-        WS_ASSERT(type == LOG_TYPE_MIXED);
-        type = LOG_TYPE_SERVICE;
-        processingLine = line.mid(2);
-    } else if (line.startsWith("===") || line.startsWith("---")) {
-        type = LOG_TYPE_AUX;
-        processingLine = line;
-    } else {
-        WS_ASSERT(type != LOG_TYPE_MIXED);
-        processingLine = line;
     }
 
-    int processingLineOffset = 0;
-    QDateTime datetime{ lastDateTime_ };
-    if (type != LOG_TYPE_AUX) {
-        ++processingLineOffset;
-        if (isYearInDatePresent(processingLine)) {
-            const auto datestr = processingLine.mid(processingLineOffset, 19);
-            processingLineOffset += 19;
-            datetime = QDateTime::fromString(datestr, "ddMMyy hh:mm:ss:zzz").addYears(100);
-        }
-        else {
-            const auto datestr = processingLine.mid(processingLineOffset, 17);
-            processingLineOffset += 17;
-            datetime = QDateTime::fromString(datestr, "ddMM hh:mm:ss:zzz").addYears(yoffset);
+    std::set<quint32> removedFiles;
+    for (auto it = files_.begin(); it != files_.end();) {
+        if (it->second->type == type) {
+            removedFiles.insert(it->first);
+            it = files_.erase(it);
+        } else {
+            ++it;
         }
     }
-    if (range && (datetime < range[0] || datetime > range[1]))
-        return;
-    if (lastDateTime_ != datetime) {
-        lastDateTime_ = datetime;
-        timestampCounter_ = 0;
+    const auto removed = std::remove_if(rows_.begin(), rows_.end(), [&](const LogRow &row) {
+        return row.type == type || removedFiles.count(row.logindex) > 0;
+    });
+    if (removed != rows_.end()) {
+        rows_.erase(removed, rows_.end());
+        updateTypeCounts();
+        emit dataUpdated(0);
     }
+}
 
-    // In QMultiMap, elements with the same key will be placed in a reverse order.
-    // https://doc.qt.io/qt-5/qmap-iterator.html#details
-    // To deal with the issue, we create a compound key: 44 bits for a timestamp, 2 bits for the
-    // source, and 18 additional lower bits for a "timestamp" (line serial number). We assume the
-    // maximum number of lines with unique timestamp never exceeds 262143, which is quite reasonable
-    // (it looks infeasible to output 250k+ lines to a log file within 1 ms).
-    const auto key = (static_cast<quint64>(datetime.toMSecsSinceEpoch()) << 20)
-        | (static_cast<quint64>(type & 3) << 18) | qMin(timestampCounter_++, 0x3ffff);
-
-    LogDataEntry entry;
-    entry.type = type;
-    entry.logindex = index;
-    entry.timestamp = datetime.toString("dd.MM.yy hh:mm:ss:zzz");
-    if (type != LOG_TYPE_AUX) {
-        entry.label = processingLine.mid(processingLineOffset, 11).trimmed();
-        processingLineOffset += 12;
+void LogData::clearDataByLogIndex(quint32 index)
+{
+    files_.erase(index);
+    const auto removed = std::remove_if(rows_.begin(), rows_.end(), [index](const LogRow &row) {
+        return row.logindex == index;
+    });
+    if (removed != rows_.end()) {
+        rows_.erase(removed, rows_.end());
+        updateTypeCounts();
+        emit dataUpdated(0);
     }
-    entry.text = processingLine.mid(processingLineOffset).trimmed();
+}
 
-    auto &info = typeInfo_[type];
-    ++info.first;
-    info.second += getLogDataEntryStringSize(entry);
-    data_.insert(key, entry);
+QByteArray LogData::lineBytes(const LogRow &row) const
+{
+    const auto it = files_.find(row.logindex);
+    if (it == files_.end() || row.line >= static_cast<quint32>(it->second->offsets.size()))
+        return QByteArray();
+    const LogFile &file = *it->second;
+    const qint64 offset = file.offsets[row.line];
+    if (offset >= file.data.size())
+        return QByteArray();
+    const char *data = file.data.constData();
+    return QByteArray::fromRawData(data + offset, logLineLength(data, offset, file.data.size()));
+}
+
+void LogData::updateTypeCounts()
+{
+    std::fill(std::begin(typeCounts_), std::end(typeCounts_), 0);
+    for (const auto &row : qAsConst(rows_))
+        if (row.type < NUM_LOG_TYPES)
+            ++typeCounts_[row.type];
+    if (rows_.isEmpty())
+        maxLineLength_ = 0;
 }
@@ -1,53 +1,75 @@
 #pragma once
 
-#include <QDateTime>
-#include <QHash>
-#include <QMultiMap>
+#include <map>
+#include <memory>
+#include <QByteArray>
 #include <QObject>
+#include <QRegularExpression>
 #include <QString>
+#include <QVector>
 #include "common.h"
+#include "logindex.h"
 
 struct LogDataEntry
 {
     LogDataType type;   // Log entry type (GUI, engine, etc.)
-    quint32 logindex;   // Log watcher file index.
     QString timestamp;  // Timestamp in human-readable form.
     QString label;      // Prefix label (e.g. [E 60.44])
     QString text;       // Actual log entry text.
 };
 
+// The lines of the watched log files, merged in the order of their timestamps. Only the raw bytes of the files and
+// their line offsets are kept in memory, so an entry is made on request from the bytes; this keeps a log of
+// hundreds of megabytes at its own size plus a few bytes of index per line. The files themselves are not kept open,
+// so they can be truncated or rewritten while the viewer runs.
 class LogData final : public QObject
 {
     Q_OBJECT
 
 public:
-    using LogDataMutableIterator = QMutableMapIterator<quint64, LogDataEntry>;
-    using LogDataStorage = QMultiMap<quint64, LogDataEntry>;
-
     LogData();
+    ~LogData();
     LogData(const LogData&) = delete;
     LogData &operator=(const LogData&) = delete;
 
-    int numTypes() const { return typeInfo_.size(); }
-    bool hasType(LogDataType type) const { return typeInfo_.contains(type); }
-    QPair<int, int> getDataSizeForType(LogDataType type) const;
-    const LogDataStorage &data() const { return data_; }
+    int numTypes() const;
+    bool hasType(LogDataType type) const { return type < NUM_LOG_TYPES && typeCounts_[type] > 0; }
+    int rowCount() const { return rows_.size(); }
+    const LogRow &row(int index) const { return rows_[index]; }
+    LogDataEntry entry(int index) const;
+    // In bytes, for the horizontal extent of the view.
+    int maxLineLength() const { return maxLineLength_; }
+    // Returns the first row at or after the time.
+    int findRowByTime(qint64 time) const;
+    // Returns the rows from firstRow on whose text matches, in order; the rows are split between the threads
+    // of the global thread pool. Aux rows always match.
+    QVector<int> search(const QRegularExpression &re, int firstRow = 0) const;
     bool save(const QString &filename) const;
 
 signals:
-    void dataUpdated();
+    // The rows from firstChangedRow on were added or changed.
+    void dataUpdated(int firstChangedRow);
 
 private slots:
-    void addLines(QStringList lines, LogDataType type, quint32 index, LogRangeCheckType rangeCheck);
+    void addIndex(LogIndexChunk chunk);
     void clearDataByLogType(LogDataType type);
     void clearDataByLogIndex(quint32 index);
 
 private:
-    void processLine(const QString &line, LogDataType type, quint32 index, int yoffset,
-                     QDateTime *range);
+    struct LogFile
+    {
+        LogDataType type = LOG_TYPE_UNKNOWN;
+        QByteArray data;                // The indexed part of the file.
+        QVector<qint64> offsets;        // Offset of each line, LogRow::line is the index here.
+        bool isLastLinePartial = false;
+    };
+
+    // Returns the line without the line break; the data is not copied.
+    QByteArray lineBytes(const LogRow &row) const;
+    void updateTypeCounts();
 
-    QHash<LogDataType, QPair<int, int>> typeInfo_;
-    LogDataStorage data_;
-    QDateTime lastDateTime_;
-    qint32 timestampCounter_;
+    std::map<quint32, std::unique_ptr<LogFile>> files_;
+    QVector<LogRow> rows_;
+    int typeCounts_[NUM_LOG_TYPES];
+    int maxLineLength_;
 };
@@ -0,0 +1,169 @@
+#include "logindex.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <QDate>
+
+namespace
+{
+qint64 daysFromCivil(int year, int month, int day)
+{
+    year -= month <= 2;
+    const int era = (year >= 0 ? year : year - 399) / 400;
+    const int yoe = year - era * 400;
+    const int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return static_cast<qint64>(era) * 146097 + doe - 719468;
+}
+
+// Returns -1 if there is a non-digit.
+int parseNumber(const char *s, int count)
+{
+    int value = 0;
+    for (int i = 0; i < count; ++i) {
+        if (s[i] < '0' || s[i] > '9')
+            return -1;
+        value = value * 10 + (s[i] - '0');
+    }
+    return value;
+}
+
+bool isYearInDatePresent(const char *line, int length)
+{
+    const int scan = qMin(7, length);
+    for (int i = 1; i < scan; ++i)
+        if (line[i] == ' ')
+            return false;
+    return true;
+}
+
+// Parses "[ddMMyy hh:mm:ss:zzz" or "[ddMM hh:mm:ss:zzz" of the current year. Doing it by hand rather than with
+// QDateTime::fromString() is what makes indexing a large log take seconds rather than minutes.
+qint64 parseTimestamp(const char *line, int length, int currentYear)
+{
+    if (length < 1 || line[0] != '[')
+        return -1;
+    const bool hasYear = isYearInDatePresent(line, length);
+    const int dateLength = hasYear ? 6 : 4;
+    if (length < 1 + dateLength + 13)
+        return -1;
+
+    const char *s = line + 1;
+    const int day = parseNumber(s, 2);
+    const int month = parseNumber(s + 2, 2);
+    const int year = hasYear ? 2000 + parseNumber(s + 4, 2) : currentYear;
+    s += dateLength;
+    if (s[0] != ' ' || s[3] != ':' || s[6] != ':' || s[9] != ':')
+        return -1;
+    const int hour = parseNumber(s + 1, 2);
+    const int minute = parseNumber(s + 4, 2);
+    const int second = parseNumber(s + 7, 2);
+    const int msec = parseNumber(s + 10, 3);
+    if (day < 1 || day > 31 || month < 1 || month > 12 || year < 2000 || hour < 0 || hour > 23 ||
+        minute < 0 || minute > 59 || second < 0 || second > 59 || msec < 0)
+        return -1;
+    return ((daysFromCivil(year, month, day) * 24 + hour) * 60 + minute) * 60000LL + second * 1000 + msec;
+}
+
+LogDataType getLineType(const char *line, int length, LogDataType fileType, int *prefixLength)
+{
+    *prefixLength = 0;
+    if (length >= 3 && line[1] == ' ' && line[2] == '[') {
+        switch (line[0]) {
+        case 'G': *prefixLength = 2; return LOG_TYPE_GUI;
+        case 'E': *prefixLength = 2; return LOG_TYPE_ENGINE;
+        case 'S': *prefixLength = 2; return LOG_TYPE_SERVICE;
+        default: break;
+        }
+    }
+    if (length >= 3 && (!strncmp(line, "===", 3) || !strncmp(line, "---", 3)))
+        return LOG_TYPE_AUX;
+    // Mixed logs have no lines of their own.
+    return fileType == LOG_TYPE_MIXED ? LOG_TYPE_AUX : fileType;
+}
+}  // namespace
+
+LogIndexChunk buildLogIndex(const QByteArray &data, qint64 begin, LogDataType type, qint64 *lastTime)
+{
+    LogIndexChunk chunk;
+    chunk.type = type;
+    chunk.data = data;
+    chunk.dataBegin = begin;
+    chunk.fileSize = begin + data.size();
+    chunk.nextPosition = chunk.fileSize;
+
+    const int currentYear = QDate::currentDate().year();
+    const char *bytes = data.constData();
+    const qint64 end = data.size();
+    qint64 time = *lastTime;
+    for (qint64 pos = 0; pos < end;) {
+        const char *lineEnd = static_cast<const char *>(memchr(bytes + pos, '\n', end - pos));
+        const qint64 lineEndPos = lineEnd ? lineEnd - bytes : end;
+        const char *line = bytes + pos;
+        int length = static_cast<int>(qMin<qint64>(lineEndPos - pos, INT_MAX));
+        if (length > 0 && line[length - 1] == '\r')
+            --length;
+        if (!lineEnd)
+            chunk.nextPosition = begin + pos;
+
+        if (length > 0) {
+            int prefixLength = 0;
+            const LogDataType lineType = getLineType(line, length, type, &prefixLength);
+            if (lineType != LOG_TYPE_AUX) {
+                const qint64 lineTime = parseTimestamp(line + prefixLength, length - prefixLength, currentYear);
+                if (lineTime >= 0)
+                    time = lineTime;
+            }
+            LogRow row;
+            row.time = time;
+            row.line = static_cast<quint32>(chunk.offsets.size());
+            row.logindex = 0;
+            row.type = static_cast<quint8>(lineType);
+            chunk.rows.append(row);
+            chunk.offsets.append(begin + pos);
+            chunk.maxLineLength = qMax(chunk.maxLineLength, length);
+            chunk.isLastLinePartial = !lineEnd;
+        }
+        if (lineEnd)
+            *lastTime = time;
+        pos = lineEndPos + 1;
+    }
+
+    // Lines of a single log are mostly in order already.
+    if (!std::is_sorted(chunk.rows.begin(), chunk.rows.end()))
+        std::sort(chunk.rows.begin(), chunk.rows.end());
+    return chunk;
+}
+
+int logLineLength(const char *data, qint64 offset, qint64 size)
+{
+    const char *line = data + offset;
+    const char *lineEnd = static_cast<const char *>(memchr(line, '\n', size - offset));
+    int length = static_cast<int>(qMin<qint64>((lineEnd ? lineEnd : data + size) - line, INT_MAX));
+    if (length > 0 && line[length - 1] == '\r')
+        --length;
+    return length;
+}
+
+void splitLogLine(const char *line, int length, int *labelBegin, int *labelEnd, int *textBegin)
+{
+    int prefixLength = 0;
+    const LogDataType type = getLineType(line, length, LOG_TYPE_GUI, &prefixLength);
+    const char *bracket = (type != LOG_TYPE_AUX && length > prefixLength && line[prefixLength] == '[')
+        ? static_cast<const char *>(memchr(line + prefixLength, ']', length - prefixLength)) : nullptr;
+    if (!bracket) {
+        *labelBegin = *labelEnd = *textBegin = 0;
+        return;
+    }
+
+    // The label follows the timestamp.
+    const int timestampLength = isYearInDatePresent(line + prefixLength, length - prefixLength) ? 20 : 18;
+    *labelBegin = qMin(prefixLength + timestampLength, static_cast<int>(bracket - line));
+    *labelEnd = static_cast<int>(bracket - line);
+    while (*labelBegin < *labelEnd && line[*labelBegin] == ' ')
+        ++*labelBegin;
+    *textBegin = *labelEnd + 1;
+    while (*textBegin < length && line[*textBegin] == ' ')
+        ++*textBegin;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include "common.h"
+
+struct LogRow
+{
+    qint64 time;        // Timestamp, ms since epoch of the log's wall clock time (taken as UTC).
+    quint32 line;       // Line number in the log file index.
+    quint16 logindex;   // Log watcher file index.
+    quint8 type;        // LogDataType of the line.
+};
+
+// Display order of the rows: by timestamp, then by the source, then by the order in the file.
+inline bool operator<(const LogRow &a, const LogRow &b)
+{
+    if (a.time != b.time)
+        return a.time < b.time;
+    if ((a.type & 3) != (b.type & 3))
+        return (a.type & 3) < (b.type & 3);
+    if (a.logindex != b.logindex)
+        return a.logindex < b.logindex;
+    return a.line < b.line;
+}
+
+// Index of the lines found in the new bytes of a log file; built by LogWatcher in its thread.
+struct LogIndexChunk
+{
+    QString filename;
+    quint32 logindex = 0;                   // Log watcher file index.
+    LogDataType type = LOG_TYPE_UNKNOWN;    // Log file type, may be LOG_TYPE_MIXED.
+    LogRangeCheckType rangeCheck = LogRangeCheckType::NONE;
+    QByteArray data;                        // The indexed bytes of the file, from dataBegin to fileSize.
+    qint64 dataBegin = 0;
+    qint64 fileSize = 0;                    // Size of the file the index was built for.
+    qint64 nextPosition = 0;                // Where to continue on growth: the end of the last complete line.
+    bool isLastLinePartial = false;         // The last row is a line without a line break yet, replaced on growth.
+    int maxLineLength = 0;                  // In bytes.
+    QVector<qint64> offsets;                // File offset of each non-empty line.
+    QVector<LogRow> rows;                   // Rows of the lines, sorted; line numbers are relative to the chunk.
+};
+
+Q_DECLARE_METATYPE(LogIndexChunk);
+
+// Builds the index of the non-empty lines of data, which are the bytes of the file from offset begin on; the chunk
+// keeps the bytes. lastTime is the timestamp of the line before begin, which is used for the lines without one;
+// it is updated to the timestamp of the last complete line.
+LogIndexChunk buildLogIndex(const QByteArray &data, qint64 begin, LogDataType type, qint64 *lastTime);
+
+// Returns the length of the line at data[offset, size), without the line break.
+int logLineLength(const char *data, qint64 offset, qint64 size);
+
+// Splits a log line "[timestamp label] text" into its parts, the type marker of mixed logs is skipped.
+// Lines without the label are all text.
+void splitLogLine(const char *line, int length, int *labelBegin, int *labelEnd, int *textBegin);
@@ -0,0 +1,356 @@
+#include "logview.h"
+#include "logdata.h"
+
+#include <algorithm>
+#include <QApplication>
+#include <QClipboard>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QScrollBar>
+
+namespace
+{
+const char *kLogTitles[NUM_LOG_TYPES] = { "GUI", "Engine", "Service" };
+const char *kTypeMarker[NUM_LOG_TYPES] = { "G", "E", "S" };
+const int kTimestampLength = 21;  // "dd.MM.yy hh:mm:ss:zzz"
+const int kPadding = 4;
+
+enum RowColorType {
+    COLOR_TYPE_NONE,
+    COLOR_TYPE_GUI,
+    COLOR_TYPE_ENGINE,
+    COLOR_TYPE_SERVICE,
+    COLOR_TYPE_MATCH,
+    COLOR_TYPE_CURRENT,
+    NUM_COLOR_TYPES
+};
+
+const QBrush &colorBrush(RowColorType type)
+{
+    static const QBrush kColorBrushes[NUM_COLOR_TYPES] = {
+        QBrush(),
+        QBrush(QColor(Qt::cyan).lighter(180)),
+        QBrush(QColor(Qt::yellow).lighter(180)),
+        QBrush(QColor(Qt::magenta).lighter(180)),
+        QBrush(QColor(Qt::red).lighter(180)),
+        QBrush(QColor(Qt::red).lighter(150))
+    };
+    return kColorBrushes[type];
+}
+}  // namespace
+
+LogView::LogView(const LogData *logData, QWidget *parent)
+    : QAbstractScrollArea(parent), logData_(logData), isFiltered_(false), currentRow_(-1),
+      columnMask_(0), isHighlight_(true), selectionAnchor_(-1), selectionEnd_(-1),
+      lineHeight_(1), charWidth_(1)
+{
+    setFocusPolicy(Qt::StrongFocus);
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
+    setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
+    updateMetrics();
+}
+
+void LogView::setHighlight(bool value)
+{
+    if (isHighlight_ == value)
+        return;
+    isHighlight_ = value;
+    viewport()->update();
+}
+
+void LogView::setColumns(int typeMask)
+{
+    if (columnMask_ == typeMask)
+        return;
+    columnMask_ = typeMask;
+    updateScrollBars();
+    viewport()->update();
+}
+
+void LogView::setFilteredRows(const QVector<int> &rows)
+{
+    filteredRows_ = rows;
+    isFiltered_ = true;
+    selectionAnchor_ = selectionEnd_ = -1;
+    updateRows();
+}
+
+void LogView::clearFilteredRows()
+{
+    if (!isFiltered_)
+        return;
+    filteredRows_.clear();
+    isFiltered_ = false;
+    selectionAnchor_ = selectionEnd_ = -1;
+    updateRows();
+}
+
+void LogView::setMatchedRows(const QVector<int> &rows)
+{
+    matchedRows_ = rows;
+    viewport()->update();
+}
+
+void LogView::setCurrentRow(int row)
+{
+    if (currentRow_ == row)
+        return;
+    currentRow_ = row;
+    viewport()->update();
+}
+
+void LogView::setPlaceholderText(const QString &text)
+{
+    if (placeholderText_ == text)
+        return;
+    placeholderText_ = text;
+    viewport()->update();
+}
+
+int LogView::rowCount() const
+{
+    return isFiltered_ ? filteredRows_.size() : logData_->rowCount();
+}
+
+void LogView::ensureRowVisible(int row)
+{
+    QScrollBar *scrollBar = verticalScrollBar();
+    if (row < scrollBar->value())
+        scrollBar->setValue(row);
+    else if (row >= scrollBar->value() + visibleRowCount())
+        scrollBar->setValue(row - visibleRowCount() + 1);
+}
+
+void LogView::scrollToBottom()
+{
+    verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+}
+
+void LogView::updateRows()
+{
+    if (selectionEnd_ >= rowCount())
+        selectionAnchor_ = selectionEnd_ = -1;
+    updateScrollBars();
+    viewport()->update();
+}
+
+void LogView::changeEvent(QEvent *event)
+{
+    if (event->type() == QEvent::FontChange)
+        updateMetrics();
+    QAbstractScrollArea::changeEvent(event);
+}
+
+void LogView::keyPressEvent(QKeyEvent *event)
+{
+    if (event->matches(QKeySequence::Copy)) {
+        copySelection();
+    } else if (event->matches(QKeySequence::SelectAll)) {
+        selectionAnchor_ = 0;
+        selectionEnd_ = rowCount() - 1;
+        viewport()->update();
+    } else if (event->matches(QKeySequence::MoveToStartOfDocument)) {
+        verticalScrollBar()->setValue(0);
+    } else if (event->matches(QKeySequence::MoveToEndOfDocument)) {
+        scrollToBottom();
+    } else {
+        QAbstractScrollArea::keyPressEvent(event);
+    }
+}
+
+void LogView::mouseMoveEvent(QMouseEvent *event)
+{
+    if (!(event->buttons() & Qt::LeftButton) || selectionAnchor_ < 0)
+        return;
+    const int row = rowAt(event->pos().y());
+    if (row >= 0 && row != selectionEnd_) {
+        selectionEnd_ = row;
+        ensureRowVisible(row);
+        viewport()->update();
+    }
+}
+
+void LogView::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton)
+        return;
+    const int row = rowAt(event->pos().y());
+    if (row >= 0 && (event->modifiers() & Qt::ShiftModifier) && selectionAnchor_ >= 0)
+        selectionEnd_ = row;
+    else
+        selectionAnchor_ = selectionEnd_ = row;
+    viewport()->update();
+}
+
+void LogView::paintEvent(QPaintEvent * /*event*/)
+{
+    QPainter painter(viewport());
+    painter.setFont(font());
+    const QRect rc = viewport()->rect();
+    painter.fillRect(rc, palette().brush(QPalette::Window));
+
+    const int kTimestampWidth = timestampWidth();
+    const int kTextWidth = qMax(0, rc.width() - kTimestampWidth);
+    const int kAscent = QFontMetrics(font()).ascent();
+    const int kScrollX = horizontalScrollBar()->value();
+
+    // Columns: the combined log, or one per visible type.
+    QVector<int> columnTypes;
+    for (int i = 0; i < NUM_LOG_TYPES; ++i)
+        if (columnMask_ & (1 << i))
+            columnTypes.append(i);
+    const bool kIsMulti = !columnTypes.isEmpty();
+    const int kNumColumns = kIsMulti ? columnTypes.size() : 1;
+    const int kColumnWidth = kTextWidth / kNumColumns;
+    auto columnRect = [&](int column, int y) {
+        return QRect(kTimestampWidth + column * kColumnWidth, y, kColumnWidth, lineHeight_);
+    };
+
+    // Header line.
+    painter.setPen(palette().color(QPalette::WindowText));
+    painter.drawText(kPadding, kAscent, tr("Timestamp") + ":");
+    for (int c = 0; c < kNumColumns; ++c) {
+        const QString title = kIsMulti ? tr(kLogTitles[columnTypes[c]]) : tr("Combined Logs");
+        painter.drawText(columnRect(c, 0).adjusted(kPadding, 0, 0, 0), Qt::AlignLeft | Qt::AlignVCenter,
+                         title + ":");
+    }
+    painter.setPen(palette().color(QPalette::Mid));
+    painter.drawLine(0, lineHeight_ - 1, rc.width(), lineHeight_ - 1);
+    for (int c = 0; c < kNumColumns; ++c)
+        painter.drawLine(columnRect(c, 0).left(), 0, columnRect(c, 0).left(), rc.height());
+
+    const int kRowCount = rowCount();
+    if (kRowCount == 0) {
+        painter.setPen(palette().color(QPalette::Disabled, QPalette::Text));
+        painter.drawText(columnRect(0, lineHeight_).adjusted(kPadding, 0, 0, 0),
+                         Qt::AlignLeft | Qt::AlignVCenter, placeholderText_);
+        return;
+    }
+
+    const int kFirstRow = verticalScrollBar()->value();
+    const int kLastRow = qMin(kRowCount, kFirstRow + visibleRowCount() + 1);
+    const int kSelectionFirst = qMin(selectionAnchor_, selectionEnd_);
+    const int kSelectionLast = qMax(selectionAnchor_, selectionEnd_);
+    for (int row = kFirstRow, y = lineHeight_; row < kLastRow; ++row, y += lineHeight_) {
+        const int kDataRow = dataRow(row);
+        const LogDataEntry entry = logData_->entry(kDataRow);
+        const bool kIsAux = entry.type == LOG_TYPE_AUX;
+        const bool kIsMatched = !kIsAux && isMatched(kDataRow);
+        const bool kIsSelected = kSelectionFirst >= 0 && row >= kSelectionFirst && row <= kSelectionLast;
+
+        RowColorType colorType = COLOR_TYPE_NONE;
+        if (row == currentRow_)
+            colorType = COLOR_TYPE_CURRENT;
+        else if (kIsMatched)
+            colorType = COLOR_TYPE_MATCH;
+        else if (isHighlight_ && !kIsAux)
+            colorType = static_cast<RowColorType>(COLOR_TYPE_GUI + entry.type);
+
+        const QRect timestampRect(0, y, kTimestampWidth, lineHeight_);
+        if (kIsSelected)
+            painter.fillRect(timestampRect, palette().brush(QPalette::Highlight));
+        painter.setPen(palette().color(kIsSelected ? QPalette::HighlightedText : QPalette::Text));
+        painter.drawText(timestampRect.adjusted(kPadding, 0, 0, 0), Qt::AlignLeft | Qt::AlignVCenter,
+                         entry.timestamp);
+
+        const QString text = rowText(entry, kIsMatched);
+        for (int c = 0; c < kNumColumns; ++c) {
+            // Aux lines (e.g. session separators) go to every column.
+            if (kIsMulti && !kIsAux && columnTypes[c] != entry.type)
+                continue;
+            const QRect cellRect = columnRect(c, y);
+            if (kIsSelected)
+                painter.fillRect(cellRect, palette().brush(QPalette::Highlight));
+            else if (colorType != COLOR_TYPE_NONE)
+                painter.fillRect(cellRect, colorBrush(colorType));
+            painter.save();
+            painter.setClipRect(cellRect);
+            painter.setPen(palette().color(kIsSelected ? QPalette::HighlightedText : QPalette::Text));
+            painter.drawText(cellRect.left() + kPadding - kScrollX, y + kAscent, text);
+            painter.restore();
+        }
+    }
+}
+
+void LogView::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+void LogView::scrollContentsBy(int /*dx*/, int /*dy*/)
+{
+    viewport()->update();
+}
+
+bool LogView::isMatched(int dataRow) const
+{
+    return std::binary_search(matchedRows_.cbegin(), matchedRows_.cend(), dataRow);
+}
+
+QString LogView::rowText(const LogDataEntry &entry, bool isMatched) const
+{
+    if (entry.type == LOG_TYPE_AUX)
+        return entry.text;
+    return QString("%1%2[%3] %4").arg(columnMask_ ? "" : kTypeMarker[entry.type],
+        isMatched ? "*" : ">", entry.label, entry.text);
+}
+
+int LogView::rowAt(int y) const
+{
+    if (y < lineHeight_ || rowCount() == 0)
+        return -1;
+    return qMin(verticalScrollBar()->value() + (y - lineHeight_) / lineHeight_, rowCount() - 1);
+}
+
+int LogView::visibleRowCount() const
+{
+    return qMax(1, (viewport()->height() - lineHeight_) / lineHeight_);
+}
+
+int LogView::timestampWidth() const
+{
+    return charWidth_ * kTimestampLength + 2 * kPadding;
+}
+
+void LogView::updateMetrics()
+{
+    const QFontMetrics fm(font());
+    lineHeight_ = qMax(1, fm.height());
+    charWidth_ = qMax(1, fm.horizontalAdvance('0'));
+    updateScrollBars();
+    viewport()->update();
+}
+
+void LogView::updateScrollBars()
+{
+    const int kVisibleRows = visibleRowCount();
+    verticalScrollBar()->setRange(0, qMax(0, rowCount() - kVisibleRows));
+    verticalScrollBar()->setPageStep(kVisibleRows);
+    verticalScrollBar()->setSingleStep(1);
+
+    int numColumns = 0;
+    for (int i = 0; i < NUM_LOG_TYPES; ++i)
+        if (columnMask_ & (1 << i))
+            ++numColumns;
+    // The lengths are in bytes, which is a bit more than needed for non-ASCII text.
+    const int kColumnWidth = qMax(0, viewport()->width() - timestampWidth()) / qMax(1, numColumns);
+    const int kContentWidth = (logData_->maxLineLength() + 4) * charWidth_ + 2 * kPadding;
+    horizontalScrollBar()->setRange(0, qMax(0, kContentWidth - kColumnWidth));
+    horizontalScrollBar()->setPageStep(kColumnWidth);
+    horizontalScrollBar()->setSingleStep(charWidth_);
+}
+
+void LogView::copySelection() const
+{
+    if (selectionAnchor_ < 0)
+        return;
+    QStringList lines;
+    const int kLast = qMin(qMax(selectionAnchor_, selectionEnd_), rowCount() - 1);
+    for (int row = qMin(selectionAnchor_, selectionEnd_); row <= kLast; ++row) {
+        const LogDataEntry entry = logData_->entry(dataRow(row));
+        lines.append(entry.timestamp + " " + rowText(entry, isMatched(dataRow(row))));
+    }
+    QApplication::clipboard()->setText(lines.join('\n'));
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <QAbstractScrollArea>
+#include <QVector>
+#include "common.h"
+
+class LogData;
+struct LogDataEntry;
+
+// Shows the rows of LogData under a header line, with a timestamp column. Only the rows in the viewport are painted,
+// and their lines are read from the log data while painting, so the size of the log does not matter. In the
+// multi-column mode each log type has a column of its own.
+class LogView final : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    explicit LogView(const LogData *logData, QWidget *parent = nullptr);
+
+    void setHighlight(bool value);
+    // Bits of the log types to show in columns of their own; 0 shows the combined log in a single column.
+    void setColumns(int typeMask);
+    // Shows only the given rows of the log data, in order.
+    void setFilteredRows(const QVector<int> &rows);
+    void clearFilteredRows();
+    // Rows of the log data to mark as filter matches, sorted.
+    void setMatchedRows(const QVector<int> &rows);
+    // Row (of the view) of the current match, -1 for none.
+    void setCurrentRow(int row);
+    void setPlaceholderText(const QString &text);
+
+    int rowCount() const;
+    void ensureRowVisible(int row);
+    void scrollToBottom();
+    // Updates the scroll range and repaints, after the rows of the log data were changed.
+    void updateRows();
+
+protected:
+    void changeEvent(QEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+
+private:
+    int dataRow(int row) const { return isFiltered_ ? filteredRows_[row] : row; }
+    bool isMatched(int dataRow) const;
+    QString rowText(const LogDataEntry &entry, bool isMatched) const;
+    int rowAt(int y) const;
+    int visibleRowCount() const;
+    int timestampWidth() const;
+    void updateMetrics();
+    void updateScrollBars();
+    void copySelection() const;
+
+    const LogData *logData_;
+    QVector<int> filteredRows_;
+    bool isFiltered_;
+    QVector<int> matchedRows_;
+    int currentRow_;
+    int columnMask_;
+    bool isHighlight_;
+    QString placeholderText_;
+    int selectionAnchor_;   // Rows of the view, -1 if nothing is selected.
+    int selectionEnd_;
+    int lineHeight_;
+    int charWidth_;
+};
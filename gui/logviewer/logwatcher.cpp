@@ -33,6 +33,7 @@ bool LogWatcher::add(const QString &filename, LogDataType type, LogRangeCheckTyp
         emit logIndexRemoved(it->index);
         it->datasize = 0;
         it->position = 0;
+        it->lasttime = 0;
         it->rangecheck = rangeCheck;
     }
     return true;
@@ -87,6 +88,7 @@ void LogWatcher::run()
                 if (it != logs_.end()) {
                     it->position = currentLogInfo[i].position;
                     it->datasize = currentLogInfo[i].datasize;
+                    it->lasttime = currentLogInfo[i].lasttime;
                 }
             }
             mutex_.unlock();
@@ -107,26 +109,32 @@ void LogWatcher::process(const QString &filename, LogFileInfo *info)
     const auto current_datasize = fi.size();
     if (info->datasize > current_datasize) {
         info->position = 0;
+        info->lasttime = 0;
         emit logIndexRemoved(info->index);
     } else {
         if (rangeCheck == LogRangeCheckType::MIN_TO_MAX)
             rangeCheck = LogRangeCheckType::MIN_TO_NOW;
     }
     info->datasize = current_datasize;
-    if (!current_datasize)
+    if (current_datasize <= info->position)
         return;
-    QStringList lines;
+    // Index only the new bytes and hand them to the viewer with the index. They are read rather than mapped: the
+    // file may be truncated while it is read, and a mapping would keep it from being truncated on Windows.
     QFile qf(filename);
-    if (!qf.open(QIODevice::ReadOnly))
+    if (!qf.open(QIODevice::ReadOnly) || !qf.seek(info->position))
         return;
-    QTextStream qts(&qf);
-    qts.seek(info->position);
-    while (!qts.atEnd())
-        lines.append(qts.readLine());
-    info->position = qts.pos();
+    const QByteArray data = qf.read(current_datasize - info->position);
     qf.close();
-    if (!lines.empty())
-        emit logLinesReady(lines, info->type, info->index, rangeCheck);
+    if (data.isEmpty())
+        return;
+    LogIndexChunk chunk = buildLogIndex(data, info->position, info->type, &info->lasttime);
+    info->position = chunk.nextPosition;
+    if (chunk.rows.isEmpty())
+        return;
+    chunk.filename = filename;
+    chunk.logindex = info->index;
+    chunk.rangeCheck = rangeCheck;
+    emit logIndexReady(chunk);
 }
 
 // static
@@ -5,6 +5,7 @@
 #include <QMutex>
 #include <QThread>
 #include "common.h"
+#include "logindex.h"
 
 
 class LogWatcher final : public QThread
@@ -24,19 +25,19 @@ public:
     static LogDataType detectLogType(const QString &filename);
 
 signals:
-    void logLinesReady(QStringList lines, LogDataType type, quint32 index,
-                       LogRangeCheckType rangeCheck);
+    void logIndexReady(LogIndexChunk chunk);
     void logTypeRemoved(LogDataType type);
     void logIndexRemoved(quint32 index);
 
 private:
     struct LogFileInfo {
-        LogFileInfo() : position(0), datasize(-1), index(0), type(LOG_TYPE_UNKNOWN),
+        LogFileInfo() : position(0), datasize(-1), lasttime(0), index(0), type(LOG_TYPE_UNKNOWN),
                         rangecheck(LogRangeCheckType::NONE) {}
         LogFileInfo(LogDataType theType, quint32 theIndex, LogRangeCheckType rangeCheck)
-            : position(0), datasize(-1), index(theIndex), type(theType), rangecheck(rangeCheck) {}
+            : position(0), datasize(-1), lasttime(0), index(theIndex), type(theType), rangecheck(rangeCheck) {}
         qint64 position;
         qint64 datasize;
+        qint64 lasttime;    // Timestamp of the line before position.
         quint32 index;
         LogDataType type;
         LogRangeCheckType rangecheck;
@@ -1,4 +1,5 @@
 #include "mainwindow.h"
+#include "logindex.h"
 
 #include <QApplication>
 #include <QCommandLineParser>
@@ -8,6 +9,7 @@ namespace
 {
 const int typeIdLogDataType = qRegisterMetaType<LogDataType>("LogDataType");
 const int typeIdLogRangeCheckType = qRegisterMetaType<LogRangeCheckType>("LogRangeCheckType");
+const int typeIdLogIndexChunk = qRegisterMetaType<LogIndexChunk>("LogIndexChunk");
 
 QStringList parseCommandLine()
 {
@@ -1,8 +1,9 @@
 #include "mainwindow.h"
 #include "logdata.h"
+#include "logview.h"
 #include "logwatcher.h"
-#include "texthighlighter.h"
 
+#include <algorithm>
 #include <QApplication>
 #include <QCheckBox>
 #include <QCommonStyle>
@@ -15,13 +16,10 @@
 #include <QLineEdit>
 #include <QMessageBox>
 #include <QMimeData>
-#include <QPlainTextEdit>
 #include <QPushButton>
+#include <QRegularExpression>
 #include <QScreen>
-#include <QScrollBar>
-#include <QSplitter>
 #include <QStandardPaths>
-#include <QTextBlock>
 #include <QToolButton>
 #include <QTimer>
 #include <QVBoxLayout>
@@ -52,21 +50,11 @@ MainWindow::MainWindow() : QWidget(), dpiScale_(1.0), logAutoScrollMode_(true),
                            logWatcher_(new LogWatcher), logData_(new LogData),
                            checkRangeOnAppend_(CheckRangeMode::NO),
                            openFilePath_(QStandardPaths::writableLocation(QStandardPaths::DataLocation)),
-                           isFilterCI_(true), isHideUnmatched_(true), textVisibilityMask_(0),
-                           currentFilterMatch_(-1), previousFilterMatch_(-1)
+                           isFilterCI_(true), isHideUnmatched_(true), currentFilterMatch_(-1)
 {
     // Default path for logs.
     openFilePath_.replace(qApp->applicationName(), "Windscribe2");
 
-    // Window-backround palette.
-    QPalette window_backround_palette;
-    window_backround_palette.setBrush(QPalette::Active, QPalette::Base,
-        palette().brush(QPalette::Active, QPalette::Window));
-    window_backround_palette.setBrush(QPalette::Inactive, QPalette::Base,
-        palette().brush(QPalette::Inactive, QPalette::Window));
-    window_backround_palette.setBrush(QPalette::Disabled, QPalette::Base,
-        palette().brush(QPalette::Disabled, QPalette::Window));
-
     // Setup controls.
     btnOpenLog_ = new QPushButton(tr("Open Logs..."), this);
     connect(btnOpenLog_, &QPushButton::clicked, this, &MainWindow::openLogFile);
@@ -116,43 +104,13 @@ MainWindow::MainWindow() : QWidget(), dpiScale_(1.0), logAutoScrollMode_(true),
 
     leFilter_ = new QLineEdit(this);
     leFilter_->setMinimumWidth(200 * dpiScale_);
-    leFilter_->setPlaceholderText(tr("Enter text filter..."));
+    leFilter_->setPlaceholderText(tr("Enter regex filter..."));
     connect(leFilter_, &QLineEdit::textEdited, this, &MainWindow::setFilter);
     filterTimer_ = new QTimer(this);
     filterTimer_->setSingleShot(true);
     connect(filterTimer_, &QTimer::timeout, this, &MainWindow::applyFilter);
 
-    timeLabel_ = new QLabel(tr("Timestamp") + ":", this);
-    timeEdit_ = new QPlainTextEdit(this);
-    timeEdit_->setReadOnly(true);
-    timeEdit_->setUndoRedoEnabled(false);
-    timeEdit_->setMaximumWidth(timeEdit_->minimumWidth());
-    timeEdit_->setLineWrapMode(QPlainTextEdit::NoWrap);
-    timeEdit_->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
-    timeEdit_->setPalette(window_backround_palette);
-    timeEdit_->setAutoFillBackground(true);
-    QSplitter *splitter = new QSplitter(this);
-    for (int i = 0; i < NUM_LOG_TYPES; ++i) {
-        textLabel_[i] = new QLabel(tr(kLogTitles[i]) + ":", this);
-        textEdit_[i] = new QPlainTextEdit(this);
-        textEdit_[i]->setReadOnly(true);
-        textEdit_[i]->setUndoRedoEnabled(false);
-        textEdit_[i]->setLineWrapMode(QPlainTextEdit::NoWrap);
-        textEdit_[i]->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
-        textEdit_[i]->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-        textEdit_[i]->setPalette(window_backround_palette);
-        textEdit_[i]->setAutoFillBackground(true);
-        connect(timeEdit_->verticalScrollBar(), &VerticalScrollBar::valueChanged, textEdit_[i]->verticalScrollBar(), &VerticalScrollBar::setValue);
-        connect(textEdit_[i]->verticalScrollBar(), &VerticalScrollBarvalueChanged, timeEdit_->verticalScrollBar(), &VerticalScrollBar::setValue);
-        auto *vlayout = new QVBoxLayout;
-        vlayout->setContentsMargins(0, 0, 0, 0);
-        vlayout->addWidget(textLabel_[i]);
-        vlayout->addWidget(textEdit_[i], 1);
-        textWidget_[i] = new QWidget;
-        textWidget_[i]->setLayout(vlayout);
-        textWidget_[i]->setVisible(false);
-        splitter->addWidget(textWidget_[i]);
-    }
+    logView_ = new LogView(logData_.get(), this);
 
     // Setup layouts.
     auto *toplayout = new QHBoxLayout;
@@ -170,18 +128,11 @@ MainWindow::MainWindow() : QWidget(), dpiScale_(1.0), logAutoScrollMode_(true),
     toplayout->addWidget(cbHideUnmatched_);
     toplayout->addWidget(btnNavigate_[0]);
     toplayout->addWidget(btnNavigate_[1]);
-    auto *loghlayout = new QHBoxLayout;
-    auto *logvlayout = new QVBoxLayout;
-    logvlayout->addWidget(timeLabel_);
-    logvlayout->addWidget(timeEdit_, 1);
-    loghlayout->setAlignment(Qt::AlignCenter);
-    loghlayout->addLayout(logvlayout);
-    loghlayout->addWidget(splitter);
     auto *vlayout = new QVBoxLayout(this);
     vlayout->setAlignment(Qt::AlignCenter);
     vlayout->addLayout(toplayout);
     vlayout->addWidget(horzLine);
-    vlayout->addLayout(loghlayout);
+    vlayout->addWidget(logView_, 1);
 
     // Make size of dialog to 70% of desktop size.
     const auto *desktopWidget = QApplication::desktop();
@@ -192,7 +143,7 @@ MainWindow::MainWindow() : QWidget(), dpiScale_(1.0), logAutoScrollMode_(true),
         desktopRc.height() * 0.7);
 
     // Setup log watching.
-    connect(logWatcher_.get(), &LogWatcher::logLinesReady, logData_.get(), &LogData::addLines);
+    connect(logWatcher_.get(), &LogWatcher::logIndexReady, logData_.get(), &LogData::addIndex);
     connect(logWatcher_.get(), &LogWatcher::logTypeRemoved, logData_.get(), &LogData::clearDataByLogType);
     connect(logWatcher_.get(), &LogWatcher::logIndexRemoved, logData_.get(), &LogData::clearDataByLogIndex);
     connect(logData_.get(), &LogData::dataUpdated, this, &MainWindow::onDataUpdated);
@@ -275,7 +226,7 @@ void MainWindow::setHighlight(bool value)
     if (logHightlightMode_ == value)
         return;
     logHightlightMode_ = value;
-    updateHighlight();
+    logView_->setHighlight(value);
 }
 
 void MainWindow::setMultiColumn(bool value)
@@ -284,9 +235,7 @@ void MainWindow::setMultiColumn(bool value)
     if (logDisplayMode_ == dm)
         return;
     logDisplayMode_ = dm;
-    setOverrideCursorIfNeeded();
-    updateDisplay();
-    restoreOverrideCursor();
+    updateColumns();
 }
 
 void MainWindow::setAutoScroll(bool value)
@@ -343,12 +292,11 @@ void MainWindow::gotoPrevMatch()
         return;
 
     const int numFilterMatches = filterMatches_.size();
-    previousFilterMatch_ = currentFilterMatch_;
     if (--currentFilterMatch_ < 0)
         currentFilterMatch_ = numFilterMatches-1;
     const int lineNumber = filterMatches_[currentFilterMatch_];
-    ensureLineNumberVisible(lineNumber);
-    updateHighlight(/*update_matching_lines_only=*/true);
+    logView_->ensureRowVisible(lineNumber);
+    logView_->setCurrentRow(lineNumber);
     updateMatchLabel();
 }
 
@@ -358,19 +306,20 @@ void MainWindow::gotoNextMatch()
         return;
 
     const int numFilterMatches = filterMatches_.size();
-    previousFilterMatch_ = currentFilterMatch_;
     if (++currentFilterMatch_ >= numFilterMatches)
         currentFilterMatch_ = 0;
     const int lineNumber = filterMatches_[currentFilterMatch_];
-    ensureLineNumberVisible(lineNumber);
-    updateHighlight(/*update_matching_lines_only=*/true);
+    logView_->ensureRowVisible(lineNumber);
+    logView_->setCurrentRow(lineNumber);
     updateMatchLabel();
 }
 
-void MainWindow::onDataUpdated()
+void MainWindow::onDataUpdated(int firstChangedRow)
 {
     updatePlaceholderText();
-    updateDisplay();
+    updateColumns();
+    updateDisplay(firstChangedRow);
+    logView_->updateRows();
     updateScroll();
 }
 
@@ -431,7 +380,7 @@ void MainWindow::appendLogFromFile(const QString &filename)
 void MainWindow::setOverrideCursorIfNeeded()
 {
     const int kDataSizeTooLarge = 5000;
-    if (overrideCursorSet_ || logData_->data().size() < kDataSizeTooLarge)
+    if (overrideCursorSet_ || logData_->rowCount() < kDataSizeTooLarge)
         return;
     qApp->setOverrideCursor(Qt::WaitCursor);
     overrideCursorSet_ = true;
@@ -445,31 +394,23 @@ void MainWindow::restoreOverrideCursor()
     }
 }
 
-bool MainWindow::checkFilter(LogDataType type, const QString &text) const
+QRegularExpression MainWindow::filterRegularExpression() const
 {
-    if (type == LOG_TYPE_AUX || currentFilter_.isEmpty())
-        return true;
-    return text.contains(currentFilter_, isFilterCI_ ? Qt::CaseInsensitive : Qt::CaseSensitive);
-}
-
-void MainWindow::ensureLineNumberVisible(int lineNumber)
-{
-    const QTextCursor timeCursor(timeEdit_->document()->findBlockByLineNumber(lineNumber));
-    timeEdit_->setTextCursor(timeCursor);
-    for (int i = 0; i < NUM_LOG_TYPES; ++i) {
-        if (!(textVisibilityMask_ & (1 << i)))
-            continue;
-        const QTextCursor textCursor(textEdit_[i]->document()->findBlockByLineNumber(lineNumber));
-        textEdit_[i]->setTextCursor(textCursor);
-    }
+    return QRegularExpression(currentFilter_, isFilterCI_
+        ? QRegularExpression::CaseInsensitiveOption : QRegularExpression::NoPatternOption);
 }
 
 void MainWindow::updatePlaceholderText()
 {
-    if (!logData_->numTypes() || currentFilter_.isEmpty())
-        textEdit_[0]->setPlaceholderText(tr("Logs are empty"));
+    if (!logData_->numTypes() || currentFilter_.isEmpty()) {
+        logView_->setPlaceholderText(tr("Logs are empty"));
+        return;
+    }
+    const QRegularExpression re = filterRegularExpression();
+    if (!re.isValid())
+        logView_->setPlaceholderText(tr("Invalid filter: %1").arg(re.errorString()));
     else
-        textEdit_[0]->setPlaceholderText(tr("No lines matching \"%1\"")
+        logView_->setPlaceholderText(tr("No lines matching \"%1\"")
             .arg(isFilterCI_ ? currentFilter_.toLower() : currentFilter_));
 }
 
@@ -486,12 +427,7 @@ void MainWindow::updateScale()
 #endif
     // Using fixed-pitch fonts.
     const auto textFont{ GetMonospaceFont(font().pointSize()) };
-    const int timeEditTextWidth = QFontMetrics(textFont).width("00.00.00 00:00:00:000");
-
-    timeEdit_->setFont(textFont);
-    timeEdit_->setMinimumWidth(25 * dpiScale_ + timeEditTextWidth);
-    for (int i = 0; i < NUM_LOG_TYPES; ++i)
-        textEdit_[i]->setFont(textFont);
+    logView_->setFont(textFont);
 
     btnOpenLog_->setFont(font());
     btnClearLog_->setFont(font());
@@ -499,196 +435,76 @@ void MainWindow::updateScale()
     matchLabel_->setFixedWidth(60 * dpiScale_);
 }
 
-void MainWindow::updateHighlight(bool update_matching_lines_only)
+void MainWindow::updateColumns()
 {
-    const bool kIsMulti = logDisplayMode_ == LogDisplayMode::MULTI_COLUMNS
-        && logData_->numTypes() > 1;
-
-    int currentFilterMatchLine = -1;
-    if (!isHideUnmatched_ && !filterMatches_.isEmpty() && currentFilterMatch_ >= 0)
-        currentFilterMatchLine = filterMatches_[currentFilterMatch_];
-
-    setOverrideCursorIfNeeded();
-    for (int i = 0; i < NUM_LOG_TYPES; ++i) {
-        if (!textWidget_[i]->isVisible())
-            continue;
-        TextHighlighter th(logHightlightMode_, currentFilterMatchLine,
-                           kIsMulti ? static_cast<LogDataType>(i) : LOG_TYPE_MIXED);
-        QList<int> lineNumbers;
-        if (update_matching_lines_only) {
-            if (previousFilterMatch_ >= 0)
-                lineNumbers.push_back(filterMatches_[previousFilterMatch_]);
-            if (currentFilterMatch_ >= 0)
-                lineNumbers.push_back(filterMatches_[currentFilterMatch_]);
-        }
-        th.processDocument(textEdit_[i]->document(), lineNumbers);
+    int columnMask = 0;
+    if (logDisplayMode_ == LogDisplayMode::MULTI_COLUMNS && logData_->numTypes() > 1) {
+        for (int i = 0; i < NUM_LOG_TYPES; ++i)
+            if (logData_->hasType(static_cast<LogDataType>(i)))
+                columnMask |= (1 << i);
     }
-    restoreOverrideCursor();
+    logView_->setColumns(columnMask);
+    cbMultiColumn_->setEnabled(logData_->numTypes() > 1);
 }
 
-void MainWindow::updateDisplay()
+void MainWindow::updateDisplay(int firstChangedRow)
 {
-    const bool kIsMulti = logDisplayMode_ == LogDisplayMode::MULTI_COLUMNS
-        && logData_->numTypes() > 1;
-
-    const int scrollPos = timeEdit_->verticalScrollBar()->value();
-    const auto &lines = logData_->data();
-    const auto global_info = logData_->getDataSizeForType(LOG_TYPE_MIXED);
-    const int oldvismask = textVisibilityMask_;
-    const bool kHasFilter = !currentFilter_.isEmpty();
-    QString texts[NUM_LOG_TYPES];
-    int nonAuxLineCount[NUM_LOG_TYPES] = {};
-
     filterTimer_->stop();
 
-    textVisibilityMask_ = 0;
-    filterMatches_.clear();
-    previousFilterMatch_ = currentFilterMatch_ = -1;
-
-    QString time_string;
-    time_string.reserve(global_info.first * 22); // Estimated timestamp size.
-
-    if (kIsMulti) {
-        QString timestamp;
-        int timestamp_lines[NUM_LOG_TYPES] = {};
-        int timestamp_line_count = 0;
-        auto trim_lines = [&](const QString &timestamp) {
-            const int add =
-                qMax(qMax(timestamp_lines[0], timestamp_lines[1]), timestamp_lines[2]);
-            for (int i = 0; i < NUM_LOG_TYPES; ++i) {
-                const int c = add - timestamp_lines[i];
-                if (c > 0)
-                    texts[i].append(QString().fill('\n', c));
-            }
-            for (int i = 1; i < add; ++i)
-                time_string.append(timestamp + "\n");
-            timestamp_line_count += qMax(0, add - 1);
-        };
-        for (int i = 0; i < NUM_LOG_TYPES; ++i) {
-            const auto local_info = logData_->getDataSizeForType(static_cast<LogDataType>(i));
-            texts[i].reserve(local_info.second + local_info.first * 6  // Estimated line sizes.
-                             + (global_info.first - local_info.first));
-        }
-        int counter = 1, prevmatch = -1;
-        LogDataType prevtype = LOG_TYPE_UNKNOWN;
-        for (auto it = lines.constBegin(); it != lines.constEnd(); ++it) {
-            bool is_filter_match = false;
-            if (kHasFilter) {
-                is_filter_match = checkFilter(it->type, it->text);
-                if (!is_filter_match && isHideUnmatched_)
-                    continue;
-            }
-            if (it->type == LOG_TYPE_AUX || timestamp != it->timestamp) {
-                if (!timestamp.isEmpty()) {
-                    trim_lines(timestamp);
-                    memset(timestamp_lines, 0, sizeof(timestamp_lines));
-                }
-                counter = timestamp_line_count++;
-                time_string.append(it->timestamp + "\n");
-                timestamp = it->timestamp;
-            }
-            if (it->type == LOG_TYPE_AUX) {
-                for (int i = 0; i < NUM_LOG_TYPES; ++i)
-                    texts[i].append(QString("%1\n").arg(it->text));
-            } else {
-                if (it->type == prevtype) {
-                    ++counter;
-                } else {
-                    counter = timestamp_line_count;
-                    prevtype = it->type;
-                }
-                ++timestamp_lines[it->type];
-                ++nonAuxLineCount[it->type];
-                texts[it->type].append(QString("%1[%2] %3\n")
-                    .arg(is_filter_match && !isHideUnmatched_ ? "*" : ">",it->label, it->text));
-            }
-            if (is_filter_match) {
-                if (counter > prevmatch + 1)
-                    filterMatches_.push_back(counter-1);
-                prevmatch = counter;
-            }
-        }
-        trim_lines(timestamp);
-        textLabel_[0]->setText(tr(kLogTitles[0]) + ":");
-    } else {
-        const char *kTypeMarker[] = { "G", "E", "S" };
-        texts[0].reserve(global_info.second + global_info.first * 6); // Estimated line sizes.
-        int counter = 0, prevmatch = 0;
-        for (auto it = lines.constBegin(); it != lines.constEnd(); ++it) {
-            bool is_filter_match = false;
-            if (kHasFilter) {
-                is_filter_match = checkFilter(it->type, it->text);
-                if (!is_filter_match && isHideUnmatched_)
-                    continue;
-                if (is_filter_match) {
-                    if (counter != prevmatch + 1)
-                        filterMatches_.push_back(counter);
-                    prevmatch = counter;
-                }
-                ++counter;
-            }
-            time_string.append(it->timestamp + "\n");
-            if (it->type == LOG_TYPE_AUX) {
-                texts[0].append(QString("%1\n").arg(it->text));
-                continue;
-            }
-            ++nonAuxLineCount[0];
-            texts[0].append(QString("%1%2[%3] %4\n").arg(kTypeMarker[it->type],
-                is_filter_match && !isHideUnmatched_ ? "*" : ">", it->label, it->text));
-        }
-        textLabel_[0]->setText(tr("Combined Logs") + ":");
+    const QRegularExpression re = filterRegularExpression();
+    if (currentFilter_.isEmpty() || !re.isValid()) {
+        matchedRows_.clear();
+        filterMatches_.clear();
+        currentFilterMatch_ = -1;
+        logView_->setMatchedRows(matchedRows_);
+        logView_->setCurrentRow(-1);
+        logView_->clearFilteredRows();
+        updateMatchLabel();
+        return;
     }
 
-    // If we don't hide unmatched lines, and there are no matches, clear the log anyway to prevent
-    // confusion.
-    if (kHasFilter && !isHideUnmatched_ && filterMatches_.isEmpty()) {
-        time_string.clear();
-        for (int i = 0; i < NUM_LOG_TYPES; ++i)
-            texts[i].clear();
+    // The search runs in parallel over the rows; the rows before the changed ones keep their matches.
+    matchedRows_.erase(std::lower_bound(matchedRows_.begin(), matchedRows_.end(), firstChangedRow),
+                       matchedRows_.end());
+    matchedRows_ += logData_->search(re, firstChangedRow);
+
+    if (isHideUnmatched_) {
+        filterMatches_.clear();
+        currentFilterMatch_ = -1;
+        logView_->setMatchedRows(QVector<int>());
+        logView_->setCurrentRow(-1);
+        logView_->setFilteredRows(matchedRows_);
+        updateMatchLabel();
+        return;
     }
 
-    timeEdit_->setPlainText(time_string);
-
-    for (int i = 0; i < NUM_LOG_TYPES; ++i) {
-        const bool is_empty = texts[i].trimmed().isEmpty();
-        if (!is_empty && nonAuxLineCount[i]) {
-            textEdit_[i]->setPlainText(texts[i]);
-            textWidget_[i]->setVisible(true);
-            textVisibilityMask_ |= (1 << i);
-        } else {
-            textEdit_[i]->clear();
-            textWidget_[i]->setVisible(false);
-        }
+    filterMatches_.clear();
+    for (int i = 0; i < matchedRows_.size(); ++i) {
+        if (i == 0 || matchedRows_[i] != matchedRows_[i - 1] + 1)
+            filterMatches_.push_back(matchedRows_[i]);
     }
+    logView_->setMatchedRows(matchedRows_);
 
-    cbMultiColumn_->setEnabled(logData_->numTypes() > 1);
-    if (!textVisibilityMask_) {
-        timeEdit_->clear();
-        textWidget_[0]->setVisible(true);
-    } else {
-        timeEdit_->verticalScrollBar()->setValue(scrollPos);
-    }
+    // If we don't hide unmatched lines, and there are no matches, clear the log anyway to prevent
+    // confusion.
+    if (filterMatches_.isEmpty())
+        logView_->setFilteredRows(QVector<int>());
+    else
+        logView_->clearFilteredRows();
 
-    if (logHightlightMode_) {
-        if (textVisibilityMask_ == oldvismask)
-            updateHighlight();
-        else
-            QTimer::singleShot(0, [&]() { updateHighlight(); });
+    if (firstChangedRow == 0 || currentFilterMatch_ >= filterMatches_.size()) {
+        currentFilterMatch_ = -1;
+        logView_->setCurrentRow(-1);
+        if (!filterMatches_.isEmpty())
+            gotoNextMatch();
     }
-
-    if (!filterMatches_.isEmpty())
-        gotoNextMatch();
     updateMatchLabel();
 }
 
 void MainWindow::updateScroll()
 {
-    if (logAutoScrollMode_) {
-        QTimer::singleShot(0, [&]() {
-            timeEdit_->verticalScrollBar()->setValue(
-                timeEdit_->verticalScrollBar()->maximum());
-        });
-    }
+    if (logAutoScrollMode_)
+        logView_->scrollToBottom();
 }
 
 void MainWindow::updateMatchLabel()
@@ -6,14 +6,15 @@
 
 class QDragEnterEvent;
 class QDropEvent;
-class QPlainTextEdit;
 class QPushButton;
 class QCheckBox;
 class QLabel;
 class QLineEdit;
+class QRegularExpression;
 class QToolButton;
 class LogWatcher;
 class LogData;
+class LogView;
 
 class MainWindow : public QWidget
 {
@@ -42,7 +43,7 @@ private slots:
     void applyFilter();
     void gotoPrevMatch();
     void gotoNextMatch();
-    void onDataUpdated();
+    void onDataUpdated(int firstChangedRow);
 
 private:
     enum class LogDisplayMode { SINGLE_COLUMN, MULTI_COLUMNS };
@@ -51,20 +52,16 @@ private:
     void appendLogFromFile(const QString &filename);
     void setOverrideCursorIfNeeded();
     void restoreOverrideCursor();
-    bool checkFilter(LogDataType type, const QString &text) const;
-    void ensureLineNumberVisible(int lineNumber);
+    QRegularExpression filterRegularExpression() const;
     void updatePlaceholderText();
     void updateScale();
-    void updateHighlight(bool update_matching_lines_only = false);
-    void updateDisplay();
+    void updateColumns();
+    // Filters the rows from firstChangedRow on, the matches of the rows before it are kept.
+    void updateDisplay(int firstChangedRow = 0);
     void updateScroll();
     void updateMatchLabel();
 
-    QPlainTextEdit *timeEdit_;
-    QPlainTextEdit *textEdit_[NUM_LOG_TYPES];
-    QLabel *timeLabel_;
-    QLabel *textLabel_[NUM_LOG_TYPES];
-    QWidget *textWidget_[NUM_LOG_TYPES];
+    LogView *logView_;
     QPushButton *btnOpenLog_;
     QPushButton *btnSaveLog_;
     QPushButton *btnClearLog_;
@@ -91,8 +88,7 @@ private:
     QString currentFilter_;
     bool isFilterCI_;
     bool isHideUnmatched_;
-    int textVisibilityMask_;
     int currentFilterMatch_;
-    int previousFilterMatch_;
-    QVector<int> filterMatches_;
+    QVector<int> matchedRows_;      // Rows of the log data matching the filter.
+    QVector<int> filterMatches_;    // First rows of the blocks of matches, for the navigation.
 };
@@ -1,4 +1,4 @@
-QT += core gui widgets
+QT += core gui widgets concurrent
 
 TARGET = WindscribeLogViewer
 TEMPLATE = app
@@ -21,17 +21,19 @@ macx {
 
 SOURCES += \
     logdata.cpp \
+    logindex.cpp \
+    logview.cpp \
     logwatcher.cpp \
     main.cpp \
-    mainwindow.cpp \
-    texthighlighter.cpp
+    mainwindow.cpp
 
 HEADERS += \
     common.h \
     logdata.h \
+    logindex.h \
+    logview.h \
     logwatcher.h \
-    mainwindow.h \
-    texthighlighter.h
+    mainwindow.h
 
 RESOURCES += \
     windscribelogviewer.qrc
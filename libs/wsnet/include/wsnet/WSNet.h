@@ -29,10 +29,15 @@ public:
     // difference between basePlatform and platformName is that platformName is more specific (for example windows_arm64/windows).
     // deviceId - unique device identifier, in particular used for the API StaticIps
     // must supply sessionTypeId, where 3 = DESKTOP, 4 = MOBILE (ios and android) to get an appropriate session type token
+    // persistentSettingsDir - if set, the persistent settings are stored in this directory (one file per value) and saved by
+    // savePersistentSettings(), persistentSettings is then used only to migrate the settings saved by currentPersistentSettings()
+    // isPersistentSettingsDirStale - the last savePersistentSettings() failed, so the files are not used even if they look
+    // complete: persistentSettings is taken and the files are rewritten by the next savePersistentSettings()
 
     static bool initialize(const std::string &basePlatform,  const std::string &platformName, const std::string &appVersion,
                            const std::string &deviceId, const std::string &openVpnVersion, const std::string &sessionTypeId,
-                           bool isUseStagingDomains, const std::string &language, const std::string &persistentSettings);
+                           bool isUseStagingDomains, const std::string &language, const std::string &persistentSettings,
+                           const std::string &persistentSettingsDir = std::string(), bool isPersistentSettingsDirStale = false);
     static std::shared_ptr<WSNet> instance();
     static void cleanup();
     static bool isValid();
@@ -41,6 +46,10 @@ public:
     virtual void setIsConnectedToVpnState(bool isConnected) = 0;
 
     virtual std::string currentPersistentSettings() = 0;
+    // writes the changed settings to persistentSettingsDir, returns false if it is not set or the write failed;
+    // after a failed write the string of currentPersistentSettings() must be passed to initialize() on the next start,
+    // with isPersistentSettingsDirStale set if persistentSettingsDir was used
+    virtual bool savePersistentSettings() = 0;
 
     virtual std::shared_ptr<WSNetDnsResolver> dnsResolver() = 0;
     virtual std::shared_ptr<WSNetHttpNetworkManager> httpNetworkManager() = 0;
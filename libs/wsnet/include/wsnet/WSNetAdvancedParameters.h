@@ -23,6 +23,17 @@ public:
 
     virtual void setLogApiResponce(bool isEnabled) = 0;
     virtual bool isLogApiResponce() const = 0;
+
+    // false by default
+    // if enabled API requests reuse warm connections (HTTP/2 multiplexed) per failover instead of a new connection per request
+    virtual void setAPIConnectionReuse(bool isEnabled) = 0;
+    virtual bool isAPIConnectionReuse() const = 0;
+
+    // false by default
+    // if enabled the domains of a failover are raced: the next one is started after a short delay without waiting
+    // for the previous one to time out, the first successful response wins
+    virtual void setAPIFailoverRacing(bool isEnabled) = 0;
+    virtual bool isAPIFailoverRacing() const = 0;
 };
 
 } // namespace wsnet
@@ -7,6 +7,7 @@
 #include "scapix_object.h"
 #include "WSNetCancelableCallback.h"
 #include "WSNetServerAPI.h"
+#include "WSNetServerList.h"
 
 namespace wsnet {
 
@@ -105,6 +106,11 @@ public:
     virtual std::string notifications() const = 0;
     virtual std::string checkUpdate() const = 0;
 
+    // the same locations as locations(), but already parsed, nullptr if there are no locations.
+    // The object is replaced only when a new server list is received, so it is shared as is and
+    // can be compared by pointer to skip the processing of an unchanged list (for example, when only the static IPs were updated)
+    virtual std::shared_ptr<WSNetServerList> serverList() const = 0;
+
     // this function is for debugging purposes, allows to set arbitrary resource update intervals
     virtual void setUpdateIntervals(int sessionInDisconnectedStateMs, int sessionInConnectedStateMs,
                                     int locationsMs, int staticIpsMs, int serverConfigsAndCredentialsMs,
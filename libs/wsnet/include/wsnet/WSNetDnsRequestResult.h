@@ -15,6 +15,8 @@ public:
     virtual std::uint32_t elapsedMs() = 0;
     virtual bool isError() = 0;
     virtual std::string errorString() = 0;
+    // the smallest TTL in seconds among the returned records, 0 if unknown (e.g. resolved from the hosts file)
+    virtual std::uint32_t ttl() = 0;
 };
 
 } // namespace wsnet
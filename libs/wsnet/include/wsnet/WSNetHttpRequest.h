@@ -67,6 +67,23 @@ public:
     // makes additional logs through which IP the request was made and its curl error
     virtual void setIsDebugLogCurlError(bool isEnabled) = 0;
     virtual bool isDebugLogCurlError() const = 0;
+
+    // empty by default, a fresh connection is opened for the request and closed right after it
+    // requests with the same non-empty key share a pool of connections (and DNS/TLS session caches),
+    // HTTP/2 is preferred so that concurrent requests are multiplexed over one connection
+    virtual void setConnectionPoolKey(const std::string &key) = 0;
+    virtual std::string connectionPoolKey() const = 0;
+
+    // empty by default
+    // conditional GET: sent as the If-None-Match header, the server answers 304 with an empty body if the ETag still matches
+    virtual void setIfNoneMatch(const std::string &etag) = 0;
+    virtual std::string ifNoneMatch() const = 0;
+
+    // valid after the request is finished
+    // the HTTP status code, 0 if there was no response
+    virtual std::uint32_t responseCode() const = 0;
+    // the value of the ETag response header, empty if absent
+    virtual std::string responseETag() const = 0;
 };
 
 } // namespace wsnet
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "scapix_object.h"
+
+namespace wsnet {
+
+// Scheduling and delivery options for WSNetPingManager::pingBatch, created with WSNetPingManager::createPingBatchOptions
+class WSNetPingBatchOptions : public scapix_object<WSNetPingBatchOptions>
+{
+public:
+    virtual ~WSNetPingBatchOptions() {}
+
+    // 0 by default, results are delivered as soon as each ping finishes (streamed)
+    // otherwise the results are accumulated and delivered in one chunk every coalesceIntervalMs
+    virtual void setCoalesceIntervalMs(std::uint32_t coalesceIntervalMs) = 0;
+    virtual std::uint32_t coalesceIntervalMs() const = 0;
+
+    // 0 by default, all the probes are queued at once (they are still limited by the number of parallel pings)
+    virtual void setMaxProbesPerSecond(std::uint32_t maxProbesPerSecond) = 0;
+    virtual std::uint32_t maxProbesPerSecond() const = 0;
+
+    // 0 by default, a random delay in [0, jitterMs] added between the probes when maxProbesPerSecond is set
+    virtual void setJitterMs(std::uint32_t jitterMs) = 0;
+    virtual std::uint32_t jitterMs() const = 0;
+
+    // 100 by default, the number of probes of the batch in flight at the same time, 0 for no limit
+    // (pings through the ping utility or the Windows ICMP API are also limited to 10 in total)
+    virtual void setMaxParallel(std::uint32_t maxParallel) = 0;
+    virtual std::uint32_t maxParallel() const = 0;
+};
+
+} // namespace wsnet
@@ -6,12 +6,15 @@
 #include <memory>
 #include "scapix_object.h"
 #include "WSNetCancelableCallback.h"
+#include "WSNetPingTarget.h"
+#include "WSNetPingResult.h"
+#include "WSNetPingBatchOptions.h"
 
 namespace wsnet {
 
-enum class PingType { kHttp = 0, kIcmp };
-
 typedef std::function<void(const std::string &ip, bool isSuccess, std::int32_t timeMs, bool isFromDisconnectedVpnState)> WSNetPingCallback;
+// isFinished is true for the last chunk of the batch
+typedef std::function<void(const std::vector<std::shared_ptr<WSNetPingResult>> &results, bool isFinished)> WSNetPingBatchCallback;
 
 // Useful for testing and debugging purposes
 class WSNetPingManager : public scapix_object<WSNetPingManager>
@@ -24,6 +27,16 @@ public:
     // pingType: 0 - HTTP, 1 - ICMP
     virtual std::shared_ptr<WSNetCancelableCallback> ping(const std::string &ip, const std::string &hostname,
                                                           PingType pingType, WSNetPingCallback callback) = 0;
+
+    virtual std::shared_ptr<WSNetPingTarget> createPingTarget(const std::string &ip, const std::string &hostname, PingType pingType) = 0;
+    virtual std::shared_ptr<WSNetPingBatchOptions> createPingBatchOptions() = 0;
+
+    // Ping a list of hosts with a single cancel handle. The probes are scheduled according to the options,
+    // the results are delivered in chunks (streamed or coalesced, see WSNetPingBatchOptions).
+    // options - optional, pass nullptr for the defaults
+    virtual std::shared_ptr<WSNetCancelableCallback> pingBatch(const std::vector<std::shared_ptr<WSNetPingTarget>> &targets,
+                                                               std::shared_ptr<WSNetPingBatchOptions> options,
+                                                               WSNetPingBatchCallback callback) = 0;
 };
 
 } // namespace wsnet
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+#include "scapix_object.h"
+
+namespace wsnet {
+
+// The result of a single ping from WSNetPingManager::pingBatch
+class WSNetPingResult : public scapix_object<WSNetPingResult>
+{
+public:
+    virtual ~WSNetPingResult() {}
+
+    virtual std::string ip() const = 0;
+    virtual bool isSuccess() const = 0;
+    virtual std::int32_t timeMs() const = 0;
+    virtual bool isFromDisconnectedVpnState() const = 0;
+};
+
+} // namespace wsnet
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include "scapix_object.h"
+
+namespace wsnet {
+
+enum class PingType { kHttp = 0, kIcmp };
+
+// A single host for WSNetPingManager::pingBatch, created with WSNetPingManager::createPingTarget
+class WSNetPingTarget : public scapix_object<WSNetPingTarget>
+{
+public:
+    virtual ~WSNetPingTarget() {}
+
+    virtual std::string ip() const = 0;
+    virtual std::string hostname() const = 0;
+    virtual PingType pingType() const = 0;
+};
+
+} // namespace wsnet
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "scapix_object.h"
+
+namespace wsnet {
+
+// Typed server list (the answer of the serverlist endpoint), parsed only once inside the library.
+// Locations, groups and nodes are kept in flat arrays and addressed by index: the groups of a location
+// and the nodes of a group are contiguous ranges of these arrays.
+// All strings are interned, so a repeated value (city, WireGuard key, x509 name, ...) is stored once
+// and every string field is an index in the strings table.
+// The object is immutable, a new one is created for every received server list, so the same pointer means the same list.
+class WSNetServerList : public scapix_object<WSNetServerList>
+{
+public:
+    virtual ~WSNetServerList() {}
+
+    // parses the server list json, returns nullptr if it is not a valid json object
+    static std::shared_ptr<WSNetServerList> createFromJson(const std::string &json);
+
+    virtual std::uint32_t stringsCount() const = 0;
+    virtual const std::string &string(std::uint32_t ind) const = 0;
+
+    // empty string if absent
+    virtual const std::string &countryOverride() const = 0;
+    // string indexes of the hostnames of the nodes with the force_disconnect flag, these nodes are not included in the groups
+    virtual const std::vector<std::uint32_t> &forceDisconnectNodes() const = 0;
+
+    // only valid locations are included: a location with an invalid group or node is dropped entirely
+    virtual std::uint32_t locationsCount() const = 0;
+    virtual std::int32_t locationId(std::uint32_t location) const = 0;
+    virtual std::uint32_t locationName(std::uint32_t location) const = 0;
+    virtual std::uint32_t locationCountryCode(std::uint32_t location) const = 0;
+    virtual std::uint32_t locationDnsHostName(std::uint32_t location) const = 0;
+    virtual std::int32_t locationPremiumOnly(std::uint32_t location) const = 0;
+    virtual std::int32_t locationP2P(std::uint32_t location) const = 0;
+    virtual std::uint32_t locationFirstGroup(std::uint32_t location) const = 0;
+    virtual std::uint32_t locationGroupsCount(std::uint32_t location) const = 0;
+
+    virtual std::int32_t groupId(std::uint32_t group) const = 0;
+    virtual std::uint32_t groupCity(std::uint32_t group) const = 0;
+    virtual std::uint32_t groupNick(std::uint32_t group) const = 0;
+    virtual std::int32_t groupPro(std::uint32_t group) const = 0;
+    virtual std::uint32_t groupPingIp(std::uint32_t group) const = 0;
+    virtual std::uint32_t groupPingHost(std::uint32_t group) const = 0;
+    virtual std::uint32_t groupWgPubKey(std::uint32_t group) const = 0;
+    virtual std::uint32_t groupOvpnX509(std::uint32_t group) const = 0;
+    virtual std::int32_t groupLinkSpeed(std::uint32_t group) const = 0;
+    // -1 if the value is missing or invalid
+    virtual std::int32_t groupHealth(std::uint32_t group) const = 0;
+    virtual std::uint32_t groupFirstNode(std::uint32_t group) const = 0;
+    virtual std::uint32_t groupNodesCount(std::uint32_t group) const = 0;
+
+    // ind is 0..2 (ip, ip2, ip3)
+    virtual std::uint32_t nodeIp(std::uint32_t node, std::uint32_t ind) const = 0;
+    virtual std::uint32_t nodeHostname(std::uint32_t node) const = 0;
+    virtual std::int32_t nodeWeight(std::uint32_t node) const = 0;
+};
+
+} // namespace wsnet
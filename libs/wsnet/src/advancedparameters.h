@@ -54,12 +54,36 @@ public:
         return isLogApiResponce_;
     }
 
+    void setAPIConnectionReuse(bool isEnabled) override
+    {
+        std::lock_guard locker(mutex_);
+        isAPIConnectionReuse_ = isEnabled;
+    }
+    bool isAPIConnectionReuse() const override
+    {
+        std::lock_guard locker(mutex_);
+        return isAPIConnectionReuse_;
+    }
+
+    void setAPIFailoverRacing(bool isEnabled) override
+    {
+        std::lock_guard locker(mutex_);
+        isAPIFailoverRacing_ = isEnabled;
+    }
+    bool isAPIFailoverRacing() const override
+    {
+        std::lock_guard locker(mutex_);
+        return isAPIFailoverRacing_;
+    }
+
 private:
     mutable std::mutex mutex_;
     bool isAPIExtraTLSPadding_ = false;
     bool isIgnoreCountryOverride_ = false;
     std::string countryOverrideValue_;
     bool isLogApiResponce_ = false;
+    bool isAPIConnectionReuse_ = false;
+    bool isAPIFailoverRacing_ = false;
 };
 
 } // namespace wsnet
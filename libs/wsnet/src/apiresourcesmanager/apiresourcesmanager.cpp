@@ -8,7 +8,7 @@ namespace wsnet {
 
 using namespace std::chrono;
 
-ApiResourcesManager::ApiResourcesManager(boost::asio::io_context &io_context, WSNetServerAPI *serverAPI, PersistentSettings &persistentSettings, ConnectState &connectState) :
+ApiResourcesManager::ApiResourcesManager(boost::asio::io_context &io_context, ServerAPI *serverAPI, PersistentSettings &persistentSettings, ConnectState &connectState) :
     io_context_(io_context),
     loginTimer_(io_context, boost::asio::chrono::seconds(1)),
     fetchTimer_(io_context, boost::asio::chrono::seconds(1)),
@@ -16,7 +16,7 @@ ApiResourcesManager::ApiResourcesManager(boost::asio::io_context &io_context, WS
     persistentSettings_(persistentSettings),
     connectState_(connectState)
 {
-    sessionStatus_.reset(SessionStatus::createFromJson(persistentSettings_.sessionStatus()));
+    sessionStatus_.reset(SessionStatus::createFromJson(*persistentSettings_.sessionStatus()));
 }
 
 ApiResourcesManager::~ApiResourcesManager()
@@ -46,15 +46,15 @@ void ApiResourcesManager::setAuthHash(const std::string &authHash)
 bool ApiResourcesManager::isExist() const
 {
     std::lock_guard locker(mutex_);
-    return !persistentSettings_.authHash().empty() &&
-            !persistentSettings_.sessionStatus().empty() &&
-            !persistentSettings_.locations().empty() &&
-            !persistentSettings_.serverCredentialsOvpn().empty() &&
-            !persistentSettings_.serverCredentialsIkev2().empty() &&
-            !persistentSettings_.serverConfigs().empty() &&
-            !persistentSettings_.portMap().empty() &&
-            !persistentSettings_.staticIps().empty() &&
-            !persistentSettings_.notifications().empty();
+    return !persistentSettings_.authHash()->empty() &&
+            !persistentSettings_.sessionStatus()->empty() &&
+            !persistentSettings_.locations()->empty() &&
+            !persistentSettings_.serverCredentialsOvpn()->empty() &&
+            !persistentSettings_.serverCredentialsIkev2()->empty() &&
+            !persistentSettings_.serverConfigs()->empty() &&
+            !persistentSettings_.portMap()->empty() &&
+            !persistentSettings_.staticIps()->empty() &&
+            !persistentSettings_.notifications()->empty();
 }
 
 bool ApiResourcesManager::loginWithAuthHash()
@@ -66,12 +66,12 @@ bool ApiResourcesManager::loginWithAuthHash()
         assert(false);
     }
 
-    if (persistentSettings_.authHash().empty())
+    if (persistentSettings_.authHash()->empty())
         return false;
 
     if (connectState_.isOnline()) {
         using namespace std::placeholders;
-        requestsInProgress_[RequestType::kSessionStatus] = serverAPI_->session(persistentSettings_.authHash(), appleId_, gpDeviceId_, std::bind(&ApiResourcesManager::onInitialSessionAnswer, this, _1, _2));
+        requestsInProgress_[RequestType::kSessionStatus] = serverAPI_->session(*persistentSettings_.authHash(), appleId_, gpDeviceId_, std::bind(&ApiResourcesManager::onInitialSessionAnswer, this, _1, _2));
     } else {
         // If we're not online, do it again in a second
         if (!startLoginTime_.has_value()) {
@@ -136,7 +136,7 @@ void ApiResourcesManager::logout()
     fetchTimer_.cancel();
 
     using namespace std::placeholders;
-    serverAPI_->deleteSession(persistentSettings_.authHash(), std::bind(&ApiResourcesManager::onDeleteSessionAnswer, this, _1, _2));
+    serverAPI_->deleteSession(*persistentSettings_.authHash(), std::bind(&ApiResourcesManager::onDeleteSessionAnswer, this, _1, _2));
 
     clearValues();
 }
@@ -160,7 +160,7 @@ void ApiResourcesManager::fetchServerCredentials()
     lastUpdateTimeMs_.erase(RequestType::kServerCredentialsIkev2);
     lastUpdateTimeMs_.erase(RequestType::kServerConfigs);
 
-    auto authHash = persistentSettings_.authHash();
+    auto authHash = *persistentSettings_.authHash();
     fetchServerCredentialsOpenVpn(authHash);
     fetchServerCredentialsIkev2(authHash);
     fetchServerConfigs(authHash);
@@ -168,7 +168,7 @@ void ApiResourcesManager::fetchServerCredentials()
 
 std::string ApiResourcesManager::authHash()
 {
-    return persistentSettings_.authHash();
+    return *persistentSettings_.authHash();
 }
 
 void ApiResourcesManager::removeFromPersistentSettings()
@@ -204,42 +204,54 @@ void ApiResourcesManager::setMobileDeviceId(const std::string &appleId, const st
 
 std::string ApiResourcesManager::sessionStatus() const
 {
-    return persistentSettings_.sessionStatus();
+    return *persistentSettings_.sessionStatus();
 }
 
 std::string ApiResourcesManager::portMap() const
 {
-    return persistentSettings_.portMap();
+    return *persistentSettings_.portMap();
 }
 
 std::string ApiResourcesManager::locations() const
 {
-    return persistentSettings_.locations();
+    return *persistentSettings_.locations();
 }
 
 std::string ApiResourcesManager::staticIps() const
 {
-    return persistentSettings_.staticIps();
+    return *persistentSettings_.staticIps();
+}
+
+std::shared_ptr<WSNetServerList> ApiResourcesManager::serverList() const
+{
+    std::lock_guard locker(serverListMutex_);
+    // the locations saved in the previous run are parsed on first use
+    if (!serverList_) {
+        auto json = persistentSettings_.locations();
+        if (!json->empty())
+            serverList_ = ServerList::createFromJson(*json);
+    }
+    return serverList_;
 }
 
 std::string ApiResourcesManager::serverCredentialsOvpn() const
 {
-    return persistentSettings_.serverCredentialsOvpn();
+    return *persistentSettings_.serverCredentialsOvpn();
 }
 
 std::string ApiResourcesManager::serverCredentialsIkev2() const
 {
-    return persistentSettings_.serverCredentialsIkev2();
+    return *persistentSettings_.serverCredentialsIkev2();
 }
 
 std::string ApiResourcesManager::serverConfigs() const
 {
-    return persistentSettings_.serverConfigs();
+    return *persistentSettings_.serverConfigs();
 }
 
 std::string ApiResourcesManager::notifications() const
 {
-    return persistentSettings_.notifications();
+    return *persistentSettings_.notifications();
 }
 
 std::string ApiResourcesManager::checkUpdate() const
@@ -315,15 +327,15 @@ void ApiResourcesManager::handleLoginOrSessionAnswer(ServerApiRetCode serverApiR
 
 void ApiResourcesManager::checkForReadyLogin()
 {
-    if (!persistentSettings_.authHash().empty() &&
-        !persistentSettings_.sessionStatus().empty() &&
-        !persistentSettings_.locations().empty() &&
-        !persistentSettings_.serverCredentialsOvpn().empty() &&
-        !persistentSettings_.serverCredentialsIkev2().empty() &&
-        !persistentSettings_.serverConfigs().empty() &&
-        !persistentSettings_.portMap().empty() &&
-        !persistentSettings_.staticIps().empty() &&
-        !persistentSettings_.notifications().empty()) {
+    if (!persistentSettings_.authHash()->empty() &&
+        !persistentSettings_.sessionStatus()->empty() &&
+        !persistentSettings_.locations()->empty() &&
+        !persistentSettings_.serverCredentialsOvpn()->empty() &&
+        !persistentSettings_.serverCredentialsIkev2()->empty() &&
+        !persistentSettings_.serverConfigs()->empty() &&
+        !persistentSettings_.portMap()->empty() &&
+        !persistentSettings_.staticIps()->empty() &&
+        !persistentSettings_.notifications()->empty()) {
 
         if (!isLoginOkEmitted_) {
             isLoginOkEmitted_ = true;
@@ -346,11 +358,11 @@ void ApiResourcesManager::fetchAll()
     if (connectState_.isVPNConnected()) {
         // every 1 min in the connected state
         if (isTimeoutForRequest(RequestType::kSessionStatus, sessionInConnectedStateMs_))
-            fetchSession(persistentSettings_.authHash());
+            fetchSession(*persistentSettings_.authHash());
     } else {
         // every 1 hour in the disconnected state
         if (isTimeoutForRequest(RequestType::kSessionStatus, sessionInDisconnectedStateMs_))
-            fetchSession(persistentSettings_.authHash());
+            fetchSession(*persistentSettings_.authHash());
     }
 
     // fetch locations every 24 hours
@@ -359,25 +371,25 @@ void ApiResourcesManager::fetchAll()
 
     // fetch static ips every 24 hours
     if (isTimeoutForRequest(RequestType::kStaticIps, staticIpsMs_))
-        fetchStaticIps(persistentSettings_.authHash());
+        fetchStaticIps(*persistentSettings_.authHash());
 
     // fetch server configs every 24 hours
     if (isTimeoutForRequest(RequestType::kServerConfigs, serverConfigsAndCredentialsMs_))
-        fetchServerConfigs(persistentSettings_.authHash());
+        fetchServerConfigs(*persistentSettings_.authHash());
 
     // fetch server credentials every 24 hours
     if (isTimeoutForRequest(RequestType::kServerCredentialsOpenVPN, serverConfigsAndCredentialsMs_))
-        fetchServerCredentialsOpenVpn(persistentSettings_.authHash());
+        fetchServerCredentialsOpenVpn(*persistentSettings_.authHash());
     if (isTimeoutForRequest(RequestType::kServerCredentialsIkev2, serverConfigsAndCredentialsMs_))
-        fetchServerCredentialsIkev2(persistentSettings_.authHash());
+        fetchServerCredentialsIkev2(*persistentSettings_.authHash());
 
     // fetch portmap every 24 hours
     if (isTimeoutForRequest(RequestType::kPortMap, portMapMs_))
-        fetchPortMap(persistentSettings_.authHash());
+        fetchPortMap(*persistentSettings_.authHash());
 
     // fetch notifications every 1 hour
     if (isTimeoutForRequest(RequestType::kNotifications, notificationsMs_))
-        fetchNotifications(persistentSettings_.authHash());
+        fetchNotifications(*persistentSettings_.authHash());
 
     // fetch updates every 24 hour
     if (isCheckUpdateDataSet_ && isTimeoutForRequest(RequestType::kCheckUpdate, checkUpdateMs_))
@@ -399,9 +411,14 @@ void ApiResourcesManager::fetchLocations()
     if (requestsInProgress_.find(RequestType::kLocations) != requestsInProgress_.end())
         return;
 
+    // a conditional request makes sense only if there is a stored list to fall back on
+    std::string ifNoneMatch;
+    if (!persistentSettings_.locations()->empty())
+        ifNoneMatch = *persistentSettings_.locationsETag();
+
     using namespace std::placeholders;
-    requestsInProgress_[RequestType::kLocations] = serverAPI_->serverLocations("en", sessionStatus_->revisionHash(), sessionStatus_->isPremium(), sessionStatus_->alcList(),
-                                                                               std::bind(&ApiResourcesManager::onServerLocationsAnswer, this, _1, _2));
+    requestsInProgress_[RequestType::kLocations] = serverAPI_->serverList("en", sessionStatus_->revisionHash(), sessionStatus_->isPremium(), sessionStatus_->alcList(),
+                                                                          ifNoneMatch, std::bind(&ApiResourcesManager::onServerLocationsAnswer, this, _1, _2, _3));
 }
 
 void ApiResourcesManager::fetchStaticIps(const std::string &authHash)
@@ -525,18 +542,18 @@ void ApiResourcesManager::updateSessionStatus()
             prevSessionStatus_->isPremium() != sessionStatus_->isPremium() ||
             prevSessionStatus_->billingPlanId() != sessionStatus_->billingPlanId()) {
 
-            fetchStaticIps(persistentSettings_.authHash());
+            fetchStaticIps(*persistentSettings_.authHash());
         }
 
         if (prevSessionStatus_->isPremium() != sessionStatus_->isPremium() || prevSessionStatus_->billingPlanId() != sessionStatus_->billingPlanId())  {
-            fetchServerCredentialsOpenVpn(persistentSettings_.authHash());
-            fetchServerCredentialsIkev2(persistentSettings_.authHash());
-            fetchNotifications(persistentSettings_.authHash());
+            fetchServerCredentialsOpenVpn(*persistentSettings_.authHash());
+            fetchServerCredentialsIkev2(*persistentSettings_.authHash());
+            fetchNotifications(*persistentSettings_.authHash());
         }
 
         if (prevSessionStatus_->status() == 2 && sessionStatus_->status() == 1) {
-            fetchServerCredentialsOpenVpn(persistentSettings_.authHash());
-            fetchServerCredentialsIkev2(persistentSettings_.authHash());
+            fetchServerCredentialsOpenVpn(*persistentSettings_.authHash());
+            fetchServerCredentialsIkev2(*persistentSettings_.authHash());
         }
     } else {
         spdlog::info("update session status (changed since last call)");
@@ -555,7 +572,7 @@ void ApiResourcesManager::onFetchTimer(const boost::system::error_code &err)
 
     std::lock_guard locker(mutex_);
 
-    if (!persistentSettings_.authHash().empty()) {
+    if (!persistentSettings_.authHash()->empty()) {
         fetchAll();
     } else  {
         spdlog::error("ApiResourcesManager::onFetchTimer, authHash is empty although it shouldn't");
@@ -614,11 +631,19 @@ void ApiResourcesManager::onSessionAnswer(ServerApiRetCode serverApiRetCode, con
     requestsInProgress_.erase(RequestType::kSessionStatus);
 }
 
-void ApiResourcesManager::onServerLocationsAnswer(ServerApiRetCode serverApiRetCode, const std::string &jsonData)
+void ApiResourcesManager::onServerLocationsAnswer(ServerApiRetCode serverApiRetCode, const std::string &jsonData, const ServerListAnswer &answer)
 {
     std::lock_guard locker(mutex_);
-    if (serverApiRetCode == ServerApiRetCode::kSuccess) {
-        persistentSettings_.setLocations(jsonData);
+    if (serverApiRetCode == ServerApiRetCode::kSuccess && answer.isNotModified) {
+        // the stored list is still actual, nothing to parse, save or notify about
+        if (!isLoginOkEmitted_)
+            checkForReadyLogin();
+    } else if (serverApiRetCode == ServerApiRetCode::kSuccess) {
+        persistentSettings_.setLocations(jsonData, answer.etag);
+        {
+            std::lock_guard serverListLocker(serverListMutex_);
+            serverList_ = answer.serverList;
+        }
         if (isLoginOkEmitted_)
             callback_->call(ApiResourcesManagerNotification::kLocationsUpdated, LoginResult::kSuccess, std::string());
         else
@@ -760,6 +785,10 @@ void ApiResourcesManager::clearValues()
     persistentSettings_.setAuthHash(std::string());
     persistentSettings_.setSessionStatus(std::string());
     persistentSettings_.setLocations(std::string());
+    {
+        std::lock_guard serverListLocker(serverListMutex_);
+        serverList_.reset();
+    }
     persistentSettings_.setServerCredentialsOvpn(std::string());
     persistentSettings_.setServerCredentialsIkev2(std::string());
     persistentSettings_.setServerConfigs(std::string());
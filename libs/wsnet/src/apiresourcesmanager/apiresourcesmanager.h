@@ -3,7 +3,8 @@
 #include "WSNetApiResourcesManager.h"
 #include <boost/asio.hpp>
 #include <optional>
-#include "WSNetServerAPI.h"
+#include "serverapi/serverapi.h"
+#include "serverapi/serverlist.h"
 #include "connectstate.h"
 #include "sessionstatus.h"
 #include "utils/persistentsettings.h"
@@ -16,7 +17,7 @@ enum class RequestType { kSessionStatus, kLocations, kServerCredentialsOpenVPN,
 class ApiResourcesManager : public WSNetApiResourcesManager
 {
 public:
-    explicit ApiResourcesManager(boost::asio::io_context &io_context, WSNetServerAPI *serverAPI, PersistentSettings &persistentSettings, ConnectState &connectState);
+    explicit ApiResourcesManager(boost::asio::io_context &io_context, ServerAPI *serverAPI, PersistentSettings &persistentSettings, ConnectState &connectState);
     virtual ~ApiResourcesManager();
 
     std::shared_ptr<WSNetCancelableCallback> setCallback(WSNetApiResourcesManagerCallback callback) override;
@@ -54,6 +55,8 @@ public:
     std::string notifications() const override;
     std::string checkUpdate() const override;
 
+    std::shared_ptr<WSNetServerList> serverList() const override;
+
     void setUpdateIntervals(int sessionInDisconnectedStateMs, int sessionInConnectedStateMs,
                             int locationsMs, int staticIpsMs, int serverConfigsAndCredentialsMs,
                             int portMapMs, int notificationsMs, int checkUpdateMs) override;
@@ -65,10 +68,14 @@ private:
     boost::asio::io_context &io_context_;
     boost::asio::steady_timer loginTimer_;
     boost::asio::steady_timer fetchTimer_;
-    WSNetServerAPI *serverAPI_;
+    ServerAPI *serverAPI_;
     PersistentSettings &persistentSettings_;
     ConnectState &connectState_;
 
+    // the typed server list of the locations stored in persistentSettings_, separate mutex as it is read from the client threads
+    mutable std::mutex serverListMutex_;
+    mutable std::shared_ptr<ServerList> serverList_;
+
     std::unique_ptr<SessionStatus> sessionStatus_;
     std::unique_ptr<SessionStatus> prevSessionStatus_;
     std::string checkUpdate_;
@@ -147,7 +154,7 @@ private:
     void onLoginAnswer(wsnet::ServerApiRetCode serverApiRetCode, const std::string &jsonData,
                        const std::string &username, const std::string &password, const std::string &code2fa);
     void onSessionAnswer(wsnet::ServerApiRetCode serverApiRetCode, const std::string &jsonData);
-    void onServerLocationsAnswer(wsnet::ServerApiRetCode serverApiRetCode, const std::string &jsonData);
+    void onServerLocationsAnswer(wsnet::ServerApiRetCode serverApiRetCode, const std::string &jsonData, const ServerListAnswer &answer);
     void onStaticIpsAnswer(wsnet::ServerApiRetCode serverApiRetCode, const std::string &jsonData);
     void onServerConfigsAnswer(wsnet::ServerApiRetCode serverApiRetCode, const std::string &jsonData);
     void onServerCredentialsOpenVpnAnswer(wsnet::ServerApiRetCode serverApiRetCode, const std::string &jsonData);
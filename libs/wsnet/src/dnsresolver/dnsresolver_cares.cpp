@@ -1,6 +1,7 @@
 #include <ares.h>
 #include "dnsresolver_cares.h"
 #include <assert.h>
+#include <algorithm>
 #include <spdlog/spdlog.h>
 #include "utils/utils.h"
 
@@ -168,13 +169,17 @@ void DnsResolver_cares::run()
         }
 
         // start new requests from the queue
+        // ares_getaddrinfo is used instead of ares_gethostbyname because it reports the TTLs of the records
+        struct ares_addrinfo_hints hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_INET;
         while (!localQueue.empty()) {
             QueueItem qi = localQueue.front();
             ArgToCaresCallback *arg = new ArgToCaresCallback();     // will be deleted in caresCallback
             arg->this_ = this;
             arg->qi = qi;
             arg->qi.startTime = std::chrono::steady_clock::now();
-            ares_gethostbyname(channel, arg->qi.hostname.c_str(), AF_INET, caresCallback, arg);
+            ares_getaddrinfo(channel, arg->qi.hostname.c_str(), NULL, &hints, caresCallback, arg);
             localQueue.pop();
         }
 
@@ -196,7 +201,7 @@ void DnsResolver_cares::run()
     ares_destroy(channel);
 }
 
-void DnsResolver_cares::caresCallback(void *arg, int status, int timeouts, hostent *host)
+void DnsResolver_cares::caresCallback(void *arg, int status, int timeouts, ares_addrinfo *addrinfo)
 {
     ArgToCaresCallback *pars = (ArgToCaresCallback *)arg;
 
@@ -212,10 +217,21 @@ void DnsResolver_cares::caresCallback(void *arg, int status, int timeouts, hoste
 
     std::shared_ptr<DnsRequestResult> result = std::make_shared<DnsRequestResult>();
     if (status == ARES_SUCCESS) {
-        for (char **p = host->h_addr_list; *p; p++) {
+        bool isTtlSet = false;
+        for (struct ares_addrinfo_node *node = addrinfo->nodes; node; node = node->ai_next) {
+            if (node->ai_family != AF_INET)
+                continue;
             char addr_buf[46] = "??";
-            ares_inet_ntop(host->h_addrtype, *p, addr_buf, sizeof(addr_buf));
-            result->ips_.push_back(addr_buf);
+            ares_inet_ntop(AF_INET, &((struct sockaddr_in *)node->ai_addr)->sin_addr, addr_buf, sizeof(addr_buf));
+            // the same address can be returned several times (for different socket types)
+            if (std::find(result->ips_.begin(), result->ips_.end(), addr_buf) == result->ips_.end())
+                result->ips_.push_back(addr_buf);
+
+            std::uint32_t ttl = node->ai_ttl > 0 ? (std::uint32_t)node->ai_ttl : 0;
+            if (!isTtlSet || ttl < result->ttl_) {
+                result->ttl_ = ttl;
+                isTtlSet = true;
+            }
         }
         result->isError_ = false;
     } else {
@@ -224,6 +240,8 @@ void DnsResolver_cares::caresCallback(void *arg, int status, int timeouts, hoste
     }
 
     result->elapsedMs_ = (unsigned int)utils::since(pars->qi.startTime).count();
+    if (addrinfo)
+        ares_freeaddrinfo(addrinfo);
 
     // if the channel was destroyed, then do not call a callback function
     if (status != ARES_EDESTRUCTION) {
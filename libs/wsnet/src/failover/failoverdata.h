@@ -23,6 +23,8 @@ public:
     std::string echConfig() const { return echConfig_; }
     std::string sniDomain() const { return sniDomain_; }
     std::optional<int> ttl() const { return ttl_; }
+    // ignores ttl_ and startTime_
+    std::string uniqueId() const { return domain_ + sniDomain_ + echConfig_; }
     bool isExpired() const
     {
         if (ttl_.has_value())
@@ -34,10 +36,7 @@ public:
     // needed for std::set<FailoverData>
     bool operator<(const FailoverData& rhs) const
     {
-        // ignore ttl_ and startTime_
-        std::string uniqId = domain_ + sniDomain_ + echConfig_;
-        std::string uniqId_rhs = rhs.domain_ + rhs.sniDomain_ + rhs.echConfig_;
-        return uniqId < uniqId_rhs;
+        return uniqueId() < rhs.uniqueId();
     }
 
 private:
@@ -0,0 +1,48 @@
+#include "curlconnectionpool.h"
+#include <spdlog/spdlog.h>
+
+namespace wsnet {
+
+CurlConnectionPool::CurlConnectionPool()
+{
+    share_ = curl_share_init();
+    if (!share_) {
+        spdlog::error("curl_share_init failed");
+        return;
+    }
+
+    bool ok = curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, lockFunction) == CURLSHE_OK &&
+              curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, unlockFunction) == CURLSHE_OK &&
+              curl_share_setopt(share_, CURLSHOPT_USERDATA, this) == CURLSHE_OK &&
+              curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS) == CURLSHE_OK &&
+              curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION) == CURLSHE_OK &&
+              curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT) == CURLSHE_OK;
+    if (!ok) {
+        spdlog::error("curl_share_setopt failed");
+        curl_share_cleanup(share_);
+        share_ = nullptr;
+    }
+}
+
+CurlConnectionPool::~CurlConnectionPool()
+{
+    if (share_) {
+        CURLSHcode code = curl_share_cleanup(share_);
+        if (code != CURLSHE_OK)
+            spdlog::error("curl_share_cleanup failed: {}", curl_share_strerror(code));
+    }
+}
+
+void CurlConnectionPool::lockFunction(CURL *handle, curl_lock_data data, curl_lock_access access, void *userptr)
+{
+    CurlConnectionPool *this_ = static_cast<CurlConnectionPool *>(userptr);
+    this_->locks_[data].lock();
+}
+
+void CurlConnectionPool::unlockFunction(CURL *handle, curl_lock_data data, void *userptr)
+{
+    CurlConnectionPool *this_ = static_cast<CurlConnectionPool *>(userptr);
+    this_->locks_[data].unlock();
+}
+
+} // namespace wsnet
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <curl/curl.h>
+#include <mutex>
+
+namespace wsnet {
+
+// Wrapper over a CURLSH handle: DNS, TLS session and connection caches shared between easy handles.
+// Easy handles that use the pool must keep a reference to it (shared_ptr) until curl_easy_cleanup is called,
+// curl_share_cleanup fails while the share is still in use.
+class CurlConnectionPool
+{
+public:
+    CurlConnectionPool();
+    ~CurlConnectionPool();
+
+    bool isValid() const { return share_ != nullptr; }
+    CURLSH *handle() const { return share_; }
+
+private:
+    CURLSH *share_ = nullptr;
+    // curl can access the share from several easy handles, one lock per data type
+    std::mutex locks_[CURL_LOCK_DATA_LAST];
+
+    static void lockFunction(CURL *handle, curl_lock_data data, curl_lock_access access, void *userptr);
+    static void unlockFunction(CURL *handle, curl_lock_data data, void *userptr);
+};
+
+} // namespace wsnet
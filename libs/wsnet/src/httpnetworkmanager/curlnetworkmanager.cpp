@@ -14,17 +14,31 @@
 #endif
 namespace wsnet {
 
-CurlNetworkManager::CurlNetworkManager(CurlFinishedCallback finishedCallback, CurlProgressCallback progressCallback, CurlReadyDataCallback readyDataCallback) :
-    finishedCallback_(finishedCallback), progressCallback_(progressCallback), readyDataCallback_(readyDataCallback),
-    finish_(false), multiHandle_(nullptr)
+CurlNetworkManager::CurlNetworkManager(boost::asio::io_context &io_context, CurlFinishedCallback finishedCallback, CurlProgressCallback progressCallback, CurlReadyDataCallback readyDataCallback) :
+    io_context_(io_context), finishedCallback_(finishedCallback), progressCallback_(progressCallback), readyDataCallback_(readyDataCallback),
+    multiHandle_(nullptr), timer_(io_context)
 {
 }
 
 CurlNetworkManager::~CurlNetworkManager()
 {
-    finish_ = true;
-    condition_.notify_all();
-    thread_.join();
+    // The io_context is already stopped here, so it's safe to clean up everything from this thread
+    timer_.cancel();
+    for (auto requestInfo : newRequests_.takeAll())
+        delete requestInfo;
+    canceledRequests_.takeAll();
+
+    if (multiHandle_) {
+        for (auto &it : activeRequests_) {
+            curl_multi_remove_handle(multiHandle_, it.second->curlEasyHandle);
+            delete it.second;
+        }
+        activeRequests_.clear();
+        curl_multi_cleanup(multiHandle_);
+    }
+    // the pools can close their connections
+    connectionPools_.clear();
+    sockets_.clear();
 
     if (isCurlGlobalInitialized_)
         curl_global_cleanup();
@@ -47,7 +61,16 @@ bool CurlNetworkManager::init()
         isCurlGlobalInitialized_ = true;
 
         multiHandle_ = curl_multi_init();
-        thread_ = std::thread(std::bind(&CurlNetworkManager::run, this));
+        if (!multiHandle_) {
+            spdlog::critical("curl_multi_init failed");
+            return false;
+        }
+        curl_multi_setopt(multiHandle_, CURLMOPT_SOCKETFUNCTION, multiSocketCallback);
+        curl_multi_setopt(multiHandle_, CURLMOPT_SOCKETDATA, this);
+        curl_multi_setopt(multiHandle_, CURLMOPT_TIMERFUNCTION, multiTimerCallback);
+        curl_multi_setopt(multiHandle_, CURLMOPT_TIMERDATA, this);
+        // allow HTTP/2 multiplexing for the requests that use connection pools
+        curl_multi_setopt(multiHandle_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
     }
     return true;
 }
@@ -71,24 +94,26 @@ void CurlNetworkManager::executeRequest(std::uint64_t requestId, const std::shar
     }
 
     if (requestInfo->curlEasyHandle)  {
-        std::lock_guard locker(mutex_);
-        if (setupOptions(requestInfo, request, ips, timeoutMs)) {
-            activeRequests_[requestId] = requestInfo;
-            condition_.notify_all();
-            curl_multi_wakeup(multiHandle_);
+        bool isOk;
+        {
+            std::lock_guard locker(mutex_);
+            isOk = setupOptions(requestInfo, request, ips, timeoutMs);
+        }
+        if (isOk) {
+            if (newRequests_.push(requestInfo))
+                boost::asio::post(io_context_, std::bind(&CurlNetworkManager::processQueues, this));
             return;
         }
     }
     // if we here then something failed
+    delete requestInfo;
     assert(false);
 }
 
 void CurlNetworkManager::cancelRequest(std::uint64_t requestId)
 {
-    std::lock_guard locker(mutex_);
-    auto it = activeRequests_.find(requestId);
-    if (it != activeRequests_.end())
-        it->second->isNeedRemoveFromMultiHandle = true;
+    if (canceledRequests_.push(requestId))
+        boost::asio::post(io_context_, std::bind(&CurlNetworkManager::processQueues, this));
 }
 
 void CurlNetworkManager::setProxySettings(const std::string &address, const std::string &username, const std::string &password)
@@ -97,6 +122,14 @@ void CurlNetworkManager::setProxySettings(const std::string &address, const std:
     proxySettings_.address = address;
     proxySettings_.username = username;
     proxySettings_.password = password;
+    // pooled connections were established with the old proxy settings
+    connectionPools_.clear();
+}
+
+void CurlNetworkManager::resetConnectionPools()
+{
+    std::lock_guard locker(mutex_);
+    connectionPools_.clear();
 }
 
 void CurlNetworkManager::setWhitelistSocketsCallback(std::shared_ptr<CancelableCallback<WSNetHttpNetworkManagerWhitelistSocketsCallback> > callback)
@@ -105,108 +138,184 @@ void CurlNetworkManager::setWhitelistSocketsCallback(std::shared_ptr<CancelableC
     whitelistSocketsCallback_ = callback;
 }
 
-void CurlNetworkManager::run()
+void CurlNetworkManager::processQueues()
 {
-    while (!finish_) {
+    // the new requests go first, so that a request canceled right after it was executed is found in activeRequests_
+    for (auto requestInfo : newRequests_.takeAll())
+        addRequest(requestInfo);
 
-        {
-            std::unique_lock<std::mutex> locker(mutex_);
-            while (activeRequests_.empty() && !finish_)
-                condition_.wait(locker);
-        }
+    for (auto requestId : canceledRequests_.takeAll())
+        removeRequest(requestId);
+}
 
-        if (finish_)
-            break;
+void CurlNetworkManager::addRequest(RequestInfo *requestInfo)
+{
+    assert(activeRequests_.find(requestInfo->id) == activeRequests_.end());
+    activeRequests_[requestInfo->id] = requestInfo;
+    // curl will call multiTimerCallback to kick off the transfer
+    curl_multi_add_handle(multiHandle_, requestInfo->curlEasyHandle);
+}
 
-        {
-            std::lock_guard locker(mutex_);
-            // add curl handles for requests which have not been added
-            for (auto it = activeRequests_.begin(); it != activeRequests_.end(); ++it) {
-                if (!it->second->isAddedToMultiHandle) {
-                    curl_multi_add_handle(multiHandle_, it->second->curlEasyHandle);
-                    it->second->isAddedToMultiHandle = true;
-                }
-            }
+void CurlNetworkManager::removeRequest(std::uint64_t requestId)
+{
+    auto it = activeRequests_.find(requestId);
+    if (it != activeRequests_.end()) {
+        RequestInfo *ri = it->second;
+        activeRequests_.erase(it);
+        curl_multi_remove_handle(multiHandle_, ri->curlEasyHandle);
+        delete ri;
+    }
+}
 
-            // check for need to be deleted requests (for cases when the function abort() was called)
-            for (auto it = activeRequests_.begin(); it != activeRequests_.end(); /*++it*/) {  // should not increment it in the for loop
-                if (it->second->isNeedRemoveFromMultiHandle) {
-                    RequestInfo *ri = it->second;
-                    if (it->second->isAddedToMultiHandle)
-                        curl_multi_remove_handle(multiHandle_, ri->curlEasyHandle);
-                    it = activeRequests_.erase(it);
-                    delete ri;
-                } else {
-                    ++it;
+void CurlNetworkManager::checkFinishedRequests()
+{
+    struct CURLMsg *curlMsg = nullptr;
+    do {
+        int msgq = 0;
+        curlMsg = curl_multi_info_read(multiHandle_, &msgq);
+        if (curlMsg && (curlMsg->msg == CURLMSG_DONE)) {
+            CURL *curlEasyHandle = curlMsg->easy_handle;
+            RequestInfo *requestInfo = nullptr;
+            curl_easy_getinfo(curlEasyHandle, CURLINFO_PRIVATE, &requestInfo);
+            assert(requestInfo != nullptr);
+            assert(requestInfo->curlEasyHandle == curlEasyHandle);
+
+            CURLcode result = curlMsg->data.result;
+            std::uint64_t id = requestInfo->id;
+
+            if (result != CURLE_OK) {
+                spdlog::debug("Curl request error: {}", curl_easy_strerror(result));
+
+                // Log all curl output for a failed request
+                if (requestInfo->isDebugLogCurlError) {
+                    for (const auto &log: requestInfo->debugLogs) {
+                        spdlog::info("{}", log);
+                    }
                 }
-            }
-        }
-
-        int still_running;
-        curl_multi_perform(multiHandle_, &still_running);
-        // check finished requests
-        struct CURLMsg *curlMsg = nullptr;
-        do {
-            int msgq = 0;
-            curlMsg = curl_multi_info_read(multiHandle_, &msgq);
-            if (curlMsg && (curlMsg->msg == CURLMSG_DONE)) {
-                CURL *curlEasyHandle = curlMsg->easy_handle;
-                std::uint64_t *pointerId;
-                curl_easy_getinfo(curlEasyHandle, CURLINFO_PRIVATE, &pointerId);
-                assert(pointerId != nullptr);
-
-                curl_off_t totalTime;
-                curl_easy_getinfo(curlEasyHandle, CURLINFO_TOTAL_TIME_T, &totalTime);
-
-                curl_multi_remove_handle(multiHandle_, curlEasyHandle);
-
-                CURLcode result = curlMsg->data.result;
-
-                std::uint64_t id;
-                //remove request from activeRequests
-                {
-                    std::lock_guard locker(mutex_);
-                    id = *pointerId;
-                    auto it = activeRequests_.find(id);
-                    assert(it != activeRequests_.end());
-                    assert(it->second->curlEasyHandle == curlEasyHandle);
-
-                    if (result != CURLE_OK) {
-                        spdlog::debug("Curl request error: {}", curl_easy_strerror(result));
-
-                        // Log all curl output for a failed request
-                        if (it->second->isDebugLogCurlError) {
-                            for (const auto &log: it->second->debugLogs) {
-                                spdlog::info("{}", log);
-                            }
-                        }
-                    } else {
-                        // Log curl output for a successful request, only strings containing "Trying" and "Connected" substrings to reduce log bloat
-                        if (it->second->isDebugLogCurlError) {
-                            for (const auto &log: it->second->debugLogs) {
-                                if (log.find("Trying") != std::string::npos || log.find("Connected") != std::string::npos) {
-                                    spdlog::info("{}", log);
-                                }
-                            }
+            } else {
+                // Log curl output for a successful request, only strings containing "Trying" and "Connected" substrings to reduce log bloat
+                if (requestInfo->isDebugLogCurlError) {
+                    for (const auto &log: requestInfo->debugLogs) {
+                        if (log.find("Trying") != std::string::npos || log.find("Connected") != std::string::npos) {
+                            spdlog::info("{}", log);
                         }
                     }
-
-                    delete it->second;
-                    activeRequests_.erase(id);
                 }
-                finishedCallback_(id, result == CURLE_OK, curl_easy_strerror(result));
             }
-        } while(curlMsg);
 
+            long responseCode = 0;
+            curl_easy_getinfo(curlEasyHandle, CURLINFO_RESPONSE_CODE, &responseCode);
+            std::string etag;
+            struct curl_header *header = nullptr;
+            if (curl_easy_header(curlEasyHandle, "ETag", 0, CURLH_HEADER, -1, &header) == CURLHE_OK)
+                etag = header->value;
 
-        // wait for activity or timeout
-        int numfds;
-        curl_multi_poll(multiHandle_, NULL, 0, 1000, &numfds);
+            // curlMsg is invalid after the handle is removed
+            removeRequest(id);
+            finishedCallback_(id, result == CURLE_OK, curl_easy_strerror(result), (std::uint32_t)responseCode, etag);
+        }
+    } while(curlMsg);
+}
+
+void CurlNetworkManager::watchSocket(curl_socket_t s)
+{
+    auto it = sockets_.find(s);
+    if (it == sockets_.end())
+        return;
+    SocketInfo &si = it->second;
+
+    if ((si.curlWhat & CURL_POLL_IN) && !si.isWaitingRead) {
+        si.isWaitingRead = true;
+        si.socket->async_wait(boost::asio::socket_base::wait_read, [this, s](const boost::system::error_code &ec) {
+            auto it = sockets_.find(s);
+            if (it != sockets_.end())
+                it->second.isWaitingRead = false;
+            if (!ec)
+                onSocketEvent(s, CURL_CSELECT_IN);
+        });
+    }
+    if ((si.curlWhat & CURL_POLL_OUT) && !si.isWaitingWrite) {
+        si.isWaitingWrite = true;
+        si.socket->async_wait(boost::asio::socket_base::wait_write, [this, s](const boost::system::error_code &ec) {
+            auto it = sockets_.find(s);
+            if (it != sockets_.end())
+                it->second.isWaitingWrite = false;
+            if (!ec)
+                onSocketEvent(s, CURL_CSELECT_OUT);
+        });
     }
+}
 
-    for (auto it = activeRequests_.begin(); it != activeRequests_.end(); ++it)
-        delete it->second;
-    activeRequests_.clear();
+void CurlNetworkManager::onSocketEvent(curl_socket_t s, int evBitmask)
+{
+    // the socket could have been closed by curl while the event handler was queued
+    if (sockets_.find(s) == sockets_.end())
+        return;
+
+    int stillRunning;
+    curl_multi_socket_action(multiHandle_, s, evBitmask, &stillRunning);
+    checkFinishedRequests();
+    // re-arm the wait if curl is still interested in this socket
+    watchSocket(s);
+}
+
+void CurlNetworkManager::onTimeout()
+{
+    int stillRunning;
+    curl_multi_socket_action(multiHandle_, CURL_SOCKET_TIMEOUT, 0, &stillRunning);
+    checkFinishedRequests();
+}
+
+int CurlNetworkManager::multiSocketCallback(CURL *easy, curl_socket_t s, int what, void *userp, void *socketp)
+{
+    CurlNetworkManager *this_ = static_cast<CurlNetworkManager *>(userp);
+    auto it = this_->sockets_.find(s);
+    if (it == this_->sockets_.end())
+        return 0;
+
+    if (what == CURL_POLL_REMOVE) {
+        // the pending waits (if any) will be completed with an error or ignored
+        it->second.curlWhat = CURL_POLL_NONE;
+        return 0;
+    }
+
+    it->second.curlWhat = what;
+    this_->watchSocket(s);
+    return 0;
+}
+
+int CurlNetworkManager::multiTimerCallback(CURLM *multi, long timeoutMs, void *userp)
+{
+    CurlNetworkManager *this_ = static_cast<CurlNetworkManager *>(userp);
+    this_->timer_.cancel();
+    if (timeoutMs >= 0) {
+        // even for zero timeout it must not call curl_multi_socket_action from this callback, so always go through the timer
+        this_->timer_.expires_after(std::chrono::milliseconds(timeoutMs));
+        this_->timer_.async_wait([this_](const boost::system::error_code &ec) {
+            if (!ec)
+                this_->onTimeout();
+        });
+    }
+    return 0;
+}
+
+curl_socket_t CurlNetworkManager::curlOpenSocketCallback(void *clientp, curlsocktype purpose, struct curl_sockaddr *address)
+{
+    CurlNetworkManager *this_ = static_cast<CurlNetworkManager *>(clientp);
+    if (purpose != CURLSOCKTYPE_IPCXN || address->socktype != SOCK_STREAM || (address->family != AF_INET && address->family != AF_INET6))
+        return CURL_SOCKET_BAD;
+
+    auto socket = std::make_unique<boost::asio::ip::tcp::socket>(this_->io_context_);
+    boost::system::error_code ec;
+    socket->open(address->family == AF_INET ? boost::asio::ip::tcp::v4() : boost::asio::ip::tcp::v6(), ec);
+    if (ec) {
+        spdlog::error("Cannot open a socket for curl: {}", ec.message());
+        return CURL_SOCKET_BAD;
+    }
+
+    curl_socket_t s = socket->native_handle();
+    this_->sockets_[s].socket = std::move(socket);
+    return s;
 }
 
 CURLcode CurlNetworkManager::sslctx_function(CURL *curl, void *sslctx, void *parm)
@@ -254,11 +363,19 @@ int CurlNetworkManager::curlSocketCallback(void *clientp, curl_socket_t curlfd,
 int CurlNetworkManager::curlCloseSocketCallback(void *clientp, curl_socket_t curlfd)
 {
     CurlNetworkManager *this_ = (CurlNetworkManager *)clientp;
+    auto it = this_->sockets_.find(curlfd);
+    if (it != this_->sockets_.end()) {
+        // closing the asio socket closes the descriptor and cancels the pending waits
+        boost::system::error_code ec;
+        it->second.socket->close(ec);
+        this_->sockets_.erase(it);
+    } else {
 #ifdef _WIN32
-    closesocket(curlfd);
+        closesocket(curlfd);
 #else
-    close(curlfd);
+        close(curlfd);
 #endif
+    }
     std::lock_guard locker(this_->mutexForWhiteListSockets_);
     // whitelist the deleted socket descriptor
     if (this_->whitelistSockets_.find(curlfd) != this_->whitelistSockets_.end()) {
@@ -274,7 +391,6 @@ int CurlNetworkManager::curlCloseSocketCallback(void *clientp, curl_socket_t cur
 int CurlNetworkManager::curlTrace(CURL *handle, curl_infotype type, char *data, size_t size, void *clientp)
 {
     RequestInfo *requestInfo = static_cast<RequestInfo *>(clientp);
-    std::lock_guard locker(requestInfo->curlNetworkManager->mutex_);
     if (type == CURLINFO_TEXT) {
         // replace all domains in the string with their md5 for privacy.
         std::string src = std::string(data, size);
@@ -299,6 +415,8 @@ bool CurlNetworkManager::setupOptions(RequestInfo *requestInfo, const std::share
     if (curl_easy_setopt(requestInfo->curlEasyHandle, CURLOPT_ACCEPT_ENCODING, "") != CURLE_OK) return false;
     if (curl_easy_setopt(requestInfo->curlEasyHandle, CURLOPT_URL, request->url().c_str()) != CURLE_OK) return false;
 
+    if (curl_easy_setopt(requestInfo->curlEasyHandle, CURLOPT_OPENSOCKETFUNCTION, curlOpenSocketCallback) != CURLE_OK) return false;
+    if (curl_easy_setopt(requestInfo->curlEasyHandle, CURLOPT_OPENSOCKETDATA, this) != CURLE_OK) return false;
     if (curl_easy_setopt(requestInfo->curlEasyHandle, CURLOPT_SOCKOPTFUNCTION, curlSocketCallback) != CURLE_OK) return false;
     if (curl_easy_setopt(requestInfo->curlEasyHandle, CURLOPT_SOCKOPTDATA, this) != CURLE_OK) return false;
     if (curl_easy_setopt(requestInfo->curlEasyHandle, CURLOPT_CLOSESOCKETFUNCTION, curlCloseSocketCallback) != CURLE_OK) return false;
@@ -306,9 +424,7 @@ bool CurlNetworkManager::setupOptions(RequestInfo *requestInfo, const std::share
 
     spdlog::debug("New curl request : {}", request->url().c_str());
 
-    if (curl_easy_setopt(requestInfo->curlEasyHandle, CURLOPT_FRESH_CONNECT, 1L) != CURLE_OK) return false;
-    // make connection get closed at once after use
-    if (curl_easy_setopt(requestInfo->curlEasyHandle, CURLOPT_FORBID_REUSE, 1L) != CURLE_OK) return false;
+    if (!setupConnectionReuse(requestInfo, request)) return false;
     if (curl_easy_setopt(requestInfo->curlEasyHandle, CURLOPT_CONNECTTIMEOUT_MS , timeoutMs) != CURLE_OK) return false;
 
     if (curl_easy_setopt(requestInfo->curlEasyHandle, CURLOPT_XFERINFOFUNCTION, progressCallback) != CURLE_OK) return false;
@@ -329,6 +445,12 @@ bool CurlNetworkManager::setupOptions(RequestInfo *requestInfo, const std::share
     std::string userAgentHeader = "User-Agent: Windscribe/" + Settings::instance().appVersion() + " (" + Settings::instance().platformName() + ")";
     list = curl_slist_append(list, userAgentHeader.c_str());
 
+    if (!request->ifNoneMatch().empty()) {
+        std::string temp = "If-None-Match: " + request->ifNoneMatch();
+        list = curl_slist_append(list, temp.c_str());
+        if (list == NULL) return false;
+    }
+
     if (!request->sniDomain().empty()) {
         std::string temp = "Host: " + request->hostname();
         list = curl_slist_append(list, temp.c_str());
@@ -354,7 +476,7 @@ bool CurlNetworkManager::setupOptions(RequestInfo *requestInfo, const std::share
             return false;
     }
 
-    curl_easy_setopt(requestInfo->curlEasyHandle, CURLOPT_PRIVATE, new std::uint64_t(requestInfo->id));    // our user data, must be deleted in the RequestInfo destructor
+    curl_easy_setopt(requestInfo->curlEasyHandle, CURLOPT_PRIVATE, requestInfo);    // our user data
 
     // set post data
     std::string postData = request->postData();
@@ -429,5 +551,36 @@ bool CurlNetworkManager::setupProxy(RequestInfo *requestInfo)
     return true;
 }
 
-} // namespace wsnet
+bool CurlNetworkManager::setupConnectionReuse(RequestInfo *requestInfo, const std::shared_ptr<WSNetHttpRequest> &request)
+{
+    std::shared_ptr<CurlConnectionPool> connectionPool;
+    const std::string key = request->connectionPoolKey();
+    if (!key.empty()) {
+        auto it = connectionPools_.find(key);
+        if (it != connectionPools_.end()) {
+            connectionPool = it->second;
+        } else {
+            connectionPool = std::make_shared<CurlConnectionPool>();
+            if (connectionPool->isValid())
+                connectionPools_[key] = connectionPool;
+            else
+                connectionPool.reset();
+        }
+    }
+
+    if (!connectionPool) {
+        if (curl_easy_setopt(requestInfo->curlEasyHandle, CURLOPT_FRESH_CONNECT, 1L) != CURLE_OK) return false;
+        // make connection get closed at once after use
+        if (curl_easy_setopt(requestInfo->curlEasyHandle, CURLOPT_FORBID_REUSE, 1L) != CURLE_OK) return false;
+        return true;
+    }
 
+    requestInfo->connectionPool = connectionPool;
+    if (curl_easy_setopt(requestInfo->curlEasyHandle, CURLOPT_SHARE, connectionPool->handle()) != CURLE_OK) return false;
+    // prefer HTTP/2 over TLS and wait for an existing connection to multiplex on rather than opening a new one
+    if (curl_easy_setopt(requestInfo->curlEasyHandle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS) != CURLE_OK) return false;
+    if (curl_easy_setopt(requestInfo->curlEasyHandle, CURLOPT_PIPEWAIT, 1L) != CURLE_OK) return false;
+    return true;
+}
+
+} // namespace wsnet
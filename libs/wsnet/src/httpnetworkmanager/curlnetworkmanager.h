@@ -1,27 +1,32 @@
 #pragma once
 
 #include <curl/curl.h>
-#include <thread>
 #include <mutex>
-#include <atomic>
 #include <map>
-#include <condition_variable>
+#include <unordered_map>
+#include <boost/asio.hpp>
 #include "WSNetHttpRequest.h"
 #include "WSNetHttpNetworkManager.h"
 #include "certmanager.h"
+#include "curlconnectionpool.h"
 #include "utils/cancelablecallback.h"
+#include "utils/mpscqueue.h"
 
 namespace wsnet {
 
-typedef std::function<void(std::uint64_t requestId, bool bSuccess, const std::string &curlError)> CurlFinishedCallback;
+typedef std::function<void(std::uint64_t requestId, bool bSuccess, const std::string &curlError,
+                           std::uint32_t responseCode, const std::string &etag)> CurlFinishedCallback;
 typedef std::function<void(std::uint64_t requestId, std::uint64_t bytesReceived, std::uint64_t bytesTotal)> CurlProgressCallback;
 typedef std::function<void(std::uint64_t requestId, const std::string &data)> CurlReadyDataCallback;
 
 // Implementing queries with curl library.
+// Event-driven: curl sockets and timeouts are watched by the io_context (curl_multi_socket_action), there is no separate thread.
+// executeRequest/cancelRequest can be called from any thread, they go through lock-free queues to the io_context thread.
+// The callbacks are called in the io_context thread.
 class CurlNetworkManager
 {
 public:
-    explicit CurlNetworkManager(CurlFinishedCallback finishedCallback, CurlProgressCallback progressCallback, CurlReadyDataCallback readyDataCallback);
+    explicit CurlNetworkManager(boost::asio::io_context &io_context, CurlFinishedCallback finishedCallback, CurlProgressCallback progressCallback, CurlReadyDataCallback readyDataCallback);
     virtual ~CurlNetworkManager();
 
     bool init();
@@ -32,12 +37,14 @@ public:
 
     void setProxySettings(const std::string &address, const std::string &username, const std::string &password);
 
-    void setWhitelistSocketsCallback(std::shared_ptr<CancelableCallback<WSNetHttpNetworkManagerWhitelistSocketsCallback> > callback);
+    // Drops all connection pools, for example when the VPN connect state changes and the pooled connections are no longer valid.
+    // Connections used by in-flight requests are closed when those requests finish.
+    void resetConnectionPools();
 
-private:
-    void run();
+    void setWhitelistSocketsCallback(std::shared_ptr<CancelableCallback<WSNetHttpNetworkManagerWhitelistSocketsCallback> > callback);
 
 private:
+    boost::asio::io_context &io_context_;
     bool isCurlGlobalInitialized_ = false;
     CurlFinishedCallback finishedCallback_;
     CurlProgressCallback progressCallback_;
@@ -45,10 +52,7 @@ private:
 
     CertManager certManager_;
 
-    std::mutex mutex_;
-    std::condition_variable condition_;
-    std::thread thread_;
-    std::atomic<bool> finish_;
+    std::mutex mutex_;  // protects proxySettings_ and connectionPools_
 
     struct ProxySettings {
         std::string address;
@@ -62,36 +66,58 @@ private:
         CurlNetworkManager *curlNetworkManager;
         CURL *curlEasyHandle = nullptr;
         std::vector<struct curl_slist *> curlLists;
-        bool isAddedToMultiHandle = false;
-        bool isNeedRemoveFromMultiHandle = false;
         bool isDebugLogCurlError = false;
         std::string domain;
         std::string domainMd5;
         std::vector<std::string> ips;
         std::vector<std::string> ipsMd5;
         std::vector<std::string> debugLogs;
+        // set if the request uses pooled connections, must outlive curlEasyHandle
+        std::shared_ptr<CurlConnectionPool> connectionPool;
 
         // free all curl handles and data
         ~RequestInfo() {
-            if (curlEasyHandle) {
-                // delete our user data (pointer to quint64)
-                std::uint64_t *id;
-                if (curl_easy_getinfo(curlEasyHandle, CURLINFO_PRIVATE, &id) == CURLE_OK && id != nullptr)
-                    delete id;
+            if (curlEasyHandle)
                 curl_easy_cleanup(curlEasyHandle);
-            }
             for (struct curl_slist *list : curlLists)
                 curl_slist_free_all(list);
         }
     };
 
     CURLM *multiHandle_;
-    std::map<std::uint64_t, RequestInfo *> activeRequests_;
+    // accessed only from the io_context thread
+    std::unordered_map<std::uint64_t, RequestInfo *> activeRequests_;
+    MpscQueue<RequestInfo *> newRequests_;
+    MpscQueue<std::uint64_t> canceledRequests_;
+
+    // the sockets are created by us in curlOpenSocketCallback so that they can be watched by the io_context
+    struct SocketInfo {
+        std::unique_ptr<boost::asio::ip::tcp::socket> socket;
+        int curlWhat = CURL_POLL_NONE;     // what curl wants to be notified about
+        bool isWaitingRead = false;
+        bool isWaitingWrite = false;
+    };
+    std::unordered_map<curl_socket_t, SocketInfo> sockets_;
+    boost::asio::steady_timer timer_;
+    // connection pools by the request connectionPoolKey
+    std::map<std::string, std::shared_ptr<CurlConnectionPool>> connectionPools_;
 
     std::mutex mutexForWhiteListSockets_; // this socket protects whitelistSocketsCallback_ variable
     std::shared_ptr<CancelableCallback<WSNetHttpNetworkManagerWhitelistSocketsCallback> > whitelistSocketsCallback_;
     std::set<int> whitelistSockets_;
 
+    void processQueues();
+    void addRequest(RequestInfo *requestInfo);
+    void removeRequest(std::uint64_t requestId);
+    void checkFinishedRequests();
+    void watchSocket(curl_socket_t s);
+    void onSocketEvent(curl_socket_t s, int evBitmask);
+    void onTimeout();
+
+    static int multiSocketCallback(CURL *easy, curl_socket_t s, int what, void *userp, void *socketp);
+    static int multiTimerCallback(CURLM *multi, long timeoutMs, void *userp);
+    static curl_socket_t curlOpenSocketCallback(void *clientp, curlsocktype purpose, struct curl_sockaddr *address);
+
     static CURLcode sslctx_function(CURL *curl, void *sslctx, void *parm);
     static size_t writeDataCallback(void *ptr, size_t size, size_t count, void *ri);
     static int progressCallback(void *ri,   curl_off_t dltotal,   curl_off_t dlnow,   curl_off_t ultotal,   curl_off_t ulnow);
@@ -103,6 +129,7 @@ private:
     bool setupResolveHosts(RequestInfo *requestInfo, const std::shared_ptr<WSNetHttpRequest> &request, const std::vector<std::string> &ips);
     bool setupSslVerification(RequestInfo *requestInfo, const std::shared_ptr<WSNetHttpRequest> &request);
     bool setupProxy(RequestInfo *requestInfo);
+    bool setupConnectionReuse(RequestInfo *requestInfo, const std::shared_ptr<WSNetHttpRequest> &request);
 };
 
 } // namespace wsnet
@@ -1,5 +1,6 @@
 #include "dnscache.h"
 #include <assert.h>
+#include <algorithm>
 #include <spdlog/spdlog.h>
 #include "settings.h"
 #include "utils/utils.h"
@@ -14,24 +15,46 @@ DnsCache::DnsCache(WSNetDnsResolver *dnsResolver, DnsCacheCallback callback) :
 DnsCache::~DnsCache()
 {
     std::lock_guard locker(mutex_);
-    for (auto &it : activeRequests_) {
-        it.second->cancel();
+    for (auto &it : inFlight_) {
+        it.second.asyncRequest->cancel();
     }
 }
 
 DnsCacheResult DnsCache::resolve(std::uint64_t id, const std::string &hostname, bool bypassCache)
 {
     std::lock_guard locker(mutex_);
-    assert(activeRequests_.find(id) == activeRequests_.end());
+    auto now = std::chrono::steady_clock::now();
 
     if (!bypassCache) {
         auto it = cache_.find(hostname);
         if (it != cache_.end()) {
-            return DnsCacheResult { id, true, it->second, true, 0 };
+            const CacheEntry &entry = it->second;
+            if (entry.isNegative) {
+                if (now < entry.expireTime) {
+                    stats_.negativeHits++;
+                    return DnsCacheResult { id, false, std::vector<std::string>(), true, 0 };
+                }
+                cache_.erase(it);
+            } else if (now < entry.expireTime + kStaleTimeout) {
+                stats_.hits++;
+                if (now >= entry.expireTime) {
+                    stats_.staleHits++;
+                    startLookup(hostname);
+                } else if (now >= entry.prefetchTime && inFlight_.find({ generation_, hostname }) == inFlight_.end()) {
+                    stats_.prefetches++;
+                    startLookup(hostname);
+                }
+                return DnsCacheResult { id, true, entry.ips, true, 0 };
+            } else {
+                cache_.erase(it);
+            }
         }
     }
-    auto asyncRequest = dnsResolver_->lookup(hostname, id, std::bind(&DnsCache::onDnsResolved, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
-    activeRequests_[id] = asyncRequest;
+
+    stats_.misses++;
+    if (inFlight_.find({ generation_, hostname }) != inFlight_.end())
+        stats_.coalesced++;
+    startLookup(hostname).waiters.push_back(Waiter { id, now });
     return DnsCacheResult { id, false, std::vector<std::string>(), false };
 }
 
@@ -39,38 +62,73 @@ void DnsCache::clear()
 {
     std::lock_guard locker(mutex_);
     cache_.clear();
-    spdlog::info("Clear DNS cache");
+    generation_++;
+    spdlog::info("Clear DNS cache (hits: {}, stale hits: {}, negative hits: {}, misses: {}, coalesced: {}, prefetches: {})",
+                 stats_.hits, stats_.staleHits, stats_.negativeHits, stats_.misses, stats_.coalesced, stats_.prefetches);
 }
 
-void DnsCache::onDnsResolved(std::uint64_t id, const std::string &hostname, std::shared_ptr<WSNetDnsRequestResult> result)
+DnsCacheStats DnsCache::stats()
 {
     std::lock_guard locker(mutex_);
-    auto it = activeRequests_.find(id);
-    assert(it != activeRequests_.end());
+    return stats_;
+}
 
-    // log no more than once per 1 second
-    bool isNeedLog = true;
-    if (tunnelTestLastLogTime_.has_value()) {
-        auto timeSinceLastLog = utils::since(tunnelTestLastLogTime_.value()).count();
-        isNeedLog = timeSinceLastLog >= 1000;
-    }
-    // useful log for tunnel test
-    if (isNeedLog && hostname.find(Settings::instance().serverTunnelTestSubdomain()) != std::string::npos) {
-        spdlog::info("DNS resolution for tunnel test, result: {}, timems: {}", result->errorString(), result->elapsedMs());
-        tunnelTestLastLogTime_ = std::chrono::steady_clock::now();
-    }
+DnsCache::InFlightLookup &DnsCache::startLookup(const std::string &hostname)
+{
+    auto it = inFlight_.find({ generation_, hostname });
+    if (it != inFlight_.end())
+        return it->second;
+
+    InFlightLookup &lookup = inFlight_[{ generation_, hostname }];
+    lookup.asyncRequest = dnsResolver_->lookup(hostname, generation_, std::bind(&DnsCache::onDnsResolved, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+    return lookup;
+}
 
-    if (!result->isError()) {
-        cache_[hostname] = result->ips();
-        callback_(DnsCacheResult { id, true, result->ips(), false,  result->elapsedMs()} );
+void DnsCache::onDnsResolved(std::uint64_t generation, const std::string &hostname, std::shared_ptr<WSNetDnsRequestResult> result)
+{
+    std::vector<Waiter> waiters;
+    {
+        std::lock_guard locker(mutex_);
+        auto it = inFlight_.find({ generation, hostname });
+        assert(it != inFlight_.end());
+        waiters = std::move(it->second.waiters);
+        inFlight_.erase(it);
+
+        // log no more than once per 1 second
+        bool isNeedLog = true;
+        if (tunnelTestLastLogTime_.has_value()) {
+            auto timeSinceLastLog = utils::since(tunnelTestLastLogTime_.value()).count();
+            isNeedLog = timeSinceLastLog >= 1000;
+        }
+        // useful log for tunnel test
+        if (isNeedLog && hostname.find(Settings::instance().serverTunnelTestSubdomain()) != std::string::npos) {
+            spdlog::info("DNS resolution for tunnel test, result: {}, timems: {}", result->errorString(), result->elapsedMs());
+            tunnelTestLastLogTime_ = std::chrono::steady_clock::now();
+        }
 
-    } else {
-        cache_.erase(hostname);
-        callback_(DnsCacheResult { id, false, std::vector<std::string>(), false, result->elapsedMs() } );
+        auto now = std::chrono::steady_clock::now();
+        if (generation != generation_) {
+            // started before clear(), the answer is for the waiters only
+        } else if (!result->isError()) {
+            auto ttl = std::clamp(std::chrono::seconds(result->ttl()), kMinTtl, kMaxTtl);
+            cache_[hostname] = CacheEntry { result->ips(), false, now + ttl - ttl / kPrefetchDivider, now + ttl };
+        } else {
+            // keep serving a stale entry if the refresh failed, otherwise remember the error for a short time
+            auto entry = cache_.find(hostname);
+            bool isStaleUsable = entry != cache_.end() && !entry->second.isNegative && now < entry->second.expireTime + kStaleTimeout;
+            if (!isStaleUsable)
+                cache_[hostname] = CacheEntry { std::vector<std::string>(), true, now + kNegativeTtl, now + kNegativeTtl };
+        }
     }
 
-    activeRequests_.erase(it);
+    // call the callbacks outside the mutex, so they can call resolve() again
+    for (const auto &waiter : waiters) {
+        std::uint32_t elapsedMs = (std::uint32_t)utils::since(waiter.startTime).count();
+        if (!result->isError())
+            callback_(DnsCacheResult { waiter.id, true, result->ips(), false, elapsedMs });
+        else
+            callback_(DnsCacheResult { waiter.id, false, std::vector<std::string>(), false, elapsedMs });
+    }
 }
 
 } // namespace wsnet
-
@@ -16,9 +16,27 @@ struct DnsCacheResult
     std::uint32_t elapsedMs;
 };
 
+struct DnsCacheStats
+{
+    std::uint64_t hits = 0;             // including stale hits
+    std::uint64_t staleHits = 0;        // served an expired entry while it was refreshed in the background
+    std::uint64_t negativeHits = 0;     // served a cached resolution error
+    std::uint64_t misses = 0;
+    std::uint64_t coalesced = 0;        // misses joined to an already running lookup of the same hostname
+    std::uint64_t prefetches = 0;       // background refreshes of the entries close to expiration
+};
+
 typedef std::function<void(const DnsCacheResult &result)> DnsCacheCallback;
 
-// TODO: add TTL support, remove from cache + whitelist ips handler
+// DNS cache on top of WSNetDnsResolver.
+// Entries live for the TTL of the records (clamped to [kMinTtl, kMaxTtl]), resolution errors are cached for kNegativeTtl.
+// An entry close to expiration is refreshed in the background on access, an expired one is served for kStaleTimeout
+// while it is being refreshed. Concurrent lookups of the same hostname are coalesced into one DNS request.
+// The callback is called only for the results that were not returned synchronously from resolve().
+// clear() starts a new generation: the lookups started before it still answer their waiters, but their results are not
+// cached and new lookups do not join them, since they may have been resolved on the previous network.
+// Thread safe
+// TODO: whitelist ips handler
 class DnsCache final
 {
 public:
@@ -28,16 +46,49 @@ public:
     DnsCacheResult resolve(std::uint64_t id, const std::string &hostname, bool bypassCache = false);
     void clear();
 
+    DnsCacheStats stats();
+
 private:
+    static constexpr std::chrono::seconds kMinTtl{30};
+    static constexpr std::chrono::seconds kMaxTtl{3600};
+    static constexpr std::chrono::seconds kNegativeTtl{5};
+    static constexpr std::chrono::seconds kStaleTimeout{600};
+    // refresh in the background when less than 1/kPrefetchDivider of the TTL is left
+    static constexpr int kPrefetchDivider = 10;
+
+    struct CacheEntry
+    {
+        std::vector<std::string> ips;
+        bool isNegative;
+        std::chrono::time_point<std::chrono::steady_clock> prefetchTime;
+        std::chrono::time_point<std::chrono::steady_clock> expireTime;
+    };
+
+    struct Waiter
+    {
+        std::uint64_t id;
+        std::chrono::time_point<std::chrono::steady_clock> startTime;
+    };
+
+    struct InFlightLookup
+    {
+        std::shared_ptr<WSNetCancelableCallback> asyncRequest;
+        std::vector<Waiter> waiters;      // empty for background refreshes
+    };
+
     WSNetDnsResolver *dnsResolver_;
     DnsCacheCallback callback_;
     std::mutex mutex_;
-    std::map<std::string, std::vector<std::string> > cache_;
-    std::map<std::uint64_t, std::shared_ptr<WSNetCancelableCallback> > activeRequests_;
+    std::map<std::string, CacheEntry> cache_;
+    // keyed by the generation and the hostname
+    std::map<std::pair<std::uint64_t, std::string>, InFlightLookup> inFlight_;
+    std::uint64_t generation_ = 0;
+    DnsCacheStats stats_;
 
     std::optional<std::chrono::time_point<std::chrono::steady_clock> > tunnelTestLastLogTime_;
 
-    void onDnsResolved(std::uint64_t id, const std::string &hostname, std::shared_ptr<WSNetDnsRequestResult> result);
+    InFlightLookup &startLookup(const std::string &hostname);
+    void onDnsResolved(std::uint64_t generation, const std::string &hostname, std::shared_ptr<WSNetDnsRequestResult> result);
 };
 
 } // namespace wsnet
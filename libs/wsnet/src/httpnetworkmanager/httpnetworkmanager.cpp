@@ -90,5 +90,11 @@ void HttpNetworkManager::clearDnsCache()
     });
 }
 
-} // namespace wsnet
+void HttpNetworkManager::resetConnectionPools()
+{
+    boost::asio::post(io_context_, [this] {
+        impl_.resetConnectionPools();
+    });
+}
 
+} // namespace wsnet
@@ -39,6 +39,7 @@ public:
     std::shared_ptr<WSNetCancelableCallback> setWhitelistSocketsCallback(WSNetHttpNetworkManagerWhitelistSocketsCallback whitelistSocketsCallback) override;
 
     void clearDnsCache();
+    void resetConnectionPools();
 
 private:
     boost::asio::io_context &io_context_;
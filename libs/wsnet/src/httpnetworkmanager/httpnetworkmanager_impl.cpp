@@ -1,13 +1,15 @@
 #include "httpnetworkmanager_impl.h"
 #include <spdlog/spdlog.h>
 #include "utils/utils.h"
+#include "httprequest.h"
 
 namespace wsnet {
 
 HttpNetworkManager_impl::HttpNetworkManager_impl(boost::asio::io_context &io_context, WSNetDnsResolver *dnsResolver) :
     io_context_(io_context),
     dnsCache_(dnsResolver, std::bind(&HttpNetworkManager_impl::onDnsResolvedCallback, this, std::placeholders::_1)),
-    curlNetworkManager_(std::bind(&HttpNetworkManager_impl::onCurlFinishedCallback, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3),
+    curlNetworkManager_(io_context, std::bind(&HttpNetworkManager_impl::onCurlFinishedCallback, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3,
+                                                  std::placeholders::_4, std::placeholders::_5),
                         std::bind(&HttpNetworkManager_impl::onCurlProgressCallback, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3),
                         std::bind(&HttpNetworkManager_impl::onCurlReadyDataCallback, this, std::placeholders::_1, std::placeholders::_2))
 {
@@ -71,6 +73,11 @@ void HttpNetworkManager_impl::clearDnsCache()
     dnsCache_.clear();
 }
 
+void HttpNetworkManager_impl::resetConnectionPools()
+{
+    curlNetworkManager_.resetConnectionPools();
+}
+
 void HttpNetworkManager_impl::onDnsResolvedCallback(const DnsCacheResult &result)
 {
     boost::asio::post(io_context_, [this, result] {
@@ -108,10 +115,10 @@ void HttpNetworkManager_impl::onDnsResolvedImpl(const DnsCacheResult &result)
     curlNetworkManager_.executeRequest(request->first, request->second.request, result.ips, request->second.request->timeoutMs() - result.elapsedMs);
 }
 
-void HttpNetworkManager_impl::onCurlFinishedCallback(std::uint64_t requestId, bool bSuccess, const std::string &curlError)
+void HttpNetworkManager_impl::onCurlFinishedCallback(std::uint64_t requestId, bool bSuccess, const std::string &curlError, std::uint32_t responseCode, const std::string &etag)
 {
-    boost::asio::post(io_context_, [this, requestId, bSuccess, curlError] {
-        onCurlFinishedCallbackImpl(requestId, bSuccess, curlError);
+    boost::asio::post(io_context_, [this, requestId, bSuccess, curlError, responseCode, etag] {
+        onCurlFinishedCallbackImpl(requestId, bSuccess, curlError, responseCode, etag);
     });
 }
 
@@ -129,12 +136,14 @@ void HttpNetworkManager_impl::onCurlReadyDataCallback(std::uint64_t requestId, c
     });
 }
 
-void HttpNetworkManager_impl::onCurlFinishedCallbackImpl(std::uint64_t requestId, bool bSuccess, const std::string &curlError)
+void HttpNetworkManager_impl::onCurlFinishedCallbackImpl(std::uint64_t requestId, bool bSuccess, const std::string &curlError, std::uint32_t responseCode, const std::string &etag)
 {
     auto request = requestsMap_.find(requestId);
     if (request != requestsMap_.end()) {
         NetworkError networkError = (bSuccess ? NetworkError::kSuccess : NetworkError::kCurlError);
         RequestData &rd = request->second;
+        // all the requests are created by HttpNetworkManager
+        static_cast<HttpRequest *>(rd.request.get())->setResponse(responseCode, etag);
         rd.callbacks->callFinished(rd.userDataId, utils::since(rd.startTime).count(), networkError, curlError, rd.data);
         if (rd.request->isRemoveFromWhitelistIpsAfterFinish())
             removeWhitelistIps(rd.ips);
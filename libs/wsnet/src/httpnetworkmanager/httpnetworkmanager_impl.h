@@ -30,6 +30,7 @@ public:
     void setWhitelistSocketsCallback(std::shared_ptr<CancelableCallback<WSNetHttpNetworkManagerWhitelistSocketsCallback> > callback);
 
     void clearDnsCache();
+    void resetConnectionPools();
 
 private:
     boost::asio::io_context &io_context_;
@@ -57,11 +58,11 @@ private:
     void onDnsResolvedCallback(const DnsCacheResult &result);
     void onDnsResolvedImpl(const DnsCacheResult &result);
 
-    void onCurlFinishedCallback(std::uint64_t requestId, bool bSuccess, const std::string &curlError);
+    void onCurlFinishedCallback(std::uint64_t requestId, bool bSuccess, const std::string &curlError, std::uint32_t responseCode, const std::string &etag);
     void onCurlProgressCallback(std::uint64_t requestId, std::uint64_t bytesReceived, std::uint64_t bytesTotal);
     void onCurlReadyDataCallback(std::uint64_t requestId, const std::string &data);
 
-    void onCurlFinishedCallbackImpl(std::uint64_t requestId, bool bSuccess, const std::string &curlError);
+    void onCurlFinishedCallbackImpl(std::uint64_t requestId, bool bSuccess, const std::string &curlError, std::uint32_t responseCode, const std::string &etag);
     void onCurlProgressCallbackImpl(std::uint64_t requestId, std::uint64_t bytesReceived, std::uint64_t bytesTotal);
     void onCurlReadyDataCallbackImpl(std::uint64_t requestId, const std::string &data);
 
@@ -19,6 +19,10 @@ struct HttpRequest::Impl
     std::string overrideIp;
     bool isWhiteListIps = true;
     bool isDebugLogCurlError = false;
+    std::string connectionPoolKey;
+    std::string ifNoneMatch;
+    std::uint32_t responseCode = 0;
+    std::string responseETag;
     skyr::url skyrUrl;
 };
 
@@ -178,5 +182,41 @@ bool HttpRequest::isDebugLogCurlError() const
     return pImpl_->isDebugLogCurlError;
 }
 
+void HttpRequest::setConnectionPoolKey(const std::string &key)
+{
+    pImpl_->connectionPoolKey = key;
+}
+
+std::string HttpRequest::connectionPoolKey() const
+{
+    return pImpl_->connectionPoolKey;
+}
+
+void HttpRequest::setIfNoneMatch(const std::string &etag)
+{
+    pImpl_->ifNoneMatch = etag;
+}
+
+std::string HttpRequest::ifNoneMatch() const
+{
+    return pImpl_->ifNoneMatch;
+}
+
+std::uint32_t HttpRequest::responseCode() const
+{
+    return pImpl_->responseCode;
+}
+
+std::string HttpRequest::responseETag() const
+{
+    return pImpl_->responseETag;
+}
+
+void HttpRequest::setResponse(std::uint32_t responseCode, const std::string &etag)
+{
+    pImpl_->responseCode = responseCode;
+    pImpl_->responseETag = etag;
+}
+
 } // namespace wsnet
 
@@ -63,6 +63,19 @@ public:
     void setIsDebugLogCurlError(bool isEnabled) override;
     bool isDebugLogCurlError() const override;
 
+    // empty by default
+    void setConnectionPoolKey(const std::string &key) override;
+    std::string connectionPoolKey() const override;
+
+    // empty by default
+    void setIfNoneMatch(const std::string &etag) override;
+    std::string ifNoneMatch() const override;
+
+    std::uint32_t responseCode() const override;
+    std::string responseETag() const override;
+    // set by the network manager when the request is finished
+    void setResponse(std::uint32_t responseCode, const std::string &etag);
+
 private:
     // internal implementation class (to hide include skyr/url.hpp from this header, there were compilation errors in Windows)
     struct Impl;
@@ -0,0 +1,363 @@
+#include "icmpengine_posix.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/ip_icmp.h>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+
+#include <spdlog/spdlog.h>
+
+namespace wsnet {
+
+namespace {
+
+constexpr std::uint8_t kIcmpEchoReply = 0;
+constexpr std::uint8_t kIcmpEchoRequest = 8;
+constexpr size_t kIcmpHeaderSize = 8;
+constexpr size_t kPayloadSize = 16;
+constexpr size_t kMaxPacketSize = 1500;
+
+}
+
+IcmpEngine_posix::IcmpEngine_posix(boost::asio::io_context &io_context) :
+    io_context_(io_context),
+    timer_(io_context)
+{
+}
+
+IcmpEngine_posix::~IcmpEngine_posix()
+{
+    stop();
+}
+
+bool IcmpEngine_posix::init()
+{
+    std::lock_guard locker(mutex_);
+    int fd = openSocket();
+    if (fd == -1)
+        return false;
+
+    socket_ = std::make_unique<boost::asio::posix::stream_descriptor>(io_context_, fd);
+    // For datagram sockets on Linux the kernel overwrites the identifier with the local port, so it doesn't matter.
+    // For raw sockets we need a value that is unlikely to collide with the replies to other processes.
+    identifier_ = static_cast<std::uint16_t>((getpid() ^ reinterpret_cast<std::uintptr_t>(this)) & 0xFFFF);
+    spdlog::info("IcmpEngine_posix initialized with {} socket", isDatagramSocket_ ? "datagram" : "raw");
+    return true;
+}
+
+void IcmpEngine_posix::stop()
+{
+    std::lock_guard locker(mutex_);
+    if (isStopped_)
+        return;
+    isStopped_ = true;
+    timer_.cancel();
+    if (socket_) {
+        boost::system::error_code ec;
+        socket_->cancel(ec);
+        socket_->close(ec);
+    }
+    pending_.clear();
+    requestIdToSeq_.clear();
+    deadlines_.clear();
+}
+
+std::uint64_t IcmpEngine_posix::ping(const std::string &ip, int timeoutMs, IcmpEngineCallback callback)
+{
+    std::lock_guard locker(mutex_);
+    if (isStopped_ || !socket_)
+        return 0;
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    if (inet_pton(AF_INET, ip.c_str(), &addr.sin_addr) != 1) {
+        spdlog::error("IcmpEngine_posix::ping incorrect IP-address: {}", ip);
+        return 0;
+    }
+
+    std::uint16_t seq;
+    if (!nextFreeSeq(seq)) {
+        spdlog::error("IcmpEngine_posix::ping too many pending requests");
+        return 0;
+    }
+
+    std::uint8_t packet[kIcmpHeaderSize + kPayloadSize];
+    memset(packet, 0, sizeof(packet));
+    packet[0] = kIcmpEchoRequest;
+    packet[1] = 0;
+    std::uint16_t netId = htons(identifier_);
+    std::uint16_t netSeq = htons(seq);
+    memcpy(packet + 4, &netId, 2);
+    memcpy(packet + 6, &netSeq, 2);
+    memcpy(packet + kIcmpHeaderSize, "HelloBufferBuffe", kPayloadSize);
+    std::uint16_t sum = checksum(packet, sizeof(packet));
+    memcpy(packet + 2, &sum, 2);
+
+    PendingRequest request;
+    request.requestId = curRequestId_++;
+    request.addr = addr.sin_addr.s_addr;
+    request.callback = callback;
+    clock_gettime(CLOCK_REALTIME, &request.sendTime);
+    request.sendTimeSteady = std::chrono::steady_clock::now();
+
+    ssize_t sent = sendto(socket_->native_handle(), packet, sizeof(packet), 0, (struct sockaddr *)&addr, sizeof(addr));
+    if (sent != sizeof(packet)) {
+        // Typically network unreachable, treat it as failed ping without waiting for the timeout
+        spdlog::debug("IcmpEngine_posix::ping sendto failed for {}, errno: {}", ip, errno);
+        return 0;
+    }
+
+    auto deadline = request.sendTimeSteady + std::chrono::milliseconds(timeoutMs);
+    request.deadlineIt = deadlines_.insert(std::make_pair(deadline, seq));
+    auto requestId = request.requestId;
+    requestIdToSeq_[requestId] = seq;
+    pending_[seq] = std::move(request);
+
+    scheduleTimer();
+    startRead();
+    return requestId;
+}
+
+void IcmpEngine_posix::cancel(std::uint64_t requestId)
+{
+    std::lock_guard locker(mutex_);
+    auto it = requestIdToSeq_.find(requestId);
+    if (it != requestIdToSeq_.end())
+        removeRequest(it->second);
+}
+
+int IcmpEngine_posix::openSocket()
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_ICMP);
+    if (fd != -1) {
+        isDatagramSocket_ = true;
+    } else {
+        // Unprivileged ICMP sockets can be disabled (for example, net.ipv4.ping_group_range on Linux)
+        spdlog::info("IcmpEngine_posix cannot create datagram ICMP socket (errno: {}), trying raw socket", errno);
+        fd = socket(AF_INET, SOCK_RAW, IPPROTO_ICMP);
+        if (fd == -1) {
+            spdlog::info("IcmpEngine_posix cannot create raw ICMP socket, errno: {}", errno);
+            return -1;
+        }
+        isDatagramSocket_ = false;
+    }
+
+    int on = 1;
+#ifdef SO_TIMESTAMPNS
+    if (setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) != 0)
+        spdlog::warn("IcmpEngine_posix cannot set SO_TIMESTAMPNS, errno: {}", errno);
+#else
+    if (setsockopt(fd, SOL_SOCKET, SO_TIMESTAMP, &on, sizeof(on)) != 0)
+        spdlog::warn("IcmpEngine_posix cannot set SO_TIMESTAMP, errno: {}", errno);
+#endif
+
+    // Large receive buffer so that a burst of replies for the whole batch is not dropped
+    int rcvBuf = 256 * 1024;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvBuf, sizeof(rcvBuf));
+
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    return fd;
+}
+
+bool IcmpEngine_posix::nextFreeSeq(std::uint16_t &seq)
+{
+    if (pending_.size() >= 0xFFFF)
+        return false;
+    do {
+        seq = curSeq_++;
+    } while (pending_.find(seq) != pending_.end());
+    return true;
+}
+
+void IcmpEngine_posix::startRead()
+{
+    if (isWaitingRead_ || isStopped_)
+        return;
+    isWaitingRead_ = true;
+    socket_->async_wait(boost::asio::posix::stream_descriptor::wait_read, [this](const boost::system::error_code &ec) {
+        if (ec == boost::asio::error::operation_aborted)
+            return;
+        onReadable();
+    });
+}
+
+void IcmpEngine_posix::onReadable()
+{
+    // Callbacks are called outside the mutex so that they can safely call ping()/cancel()
+    std::vector<std::pair<IcmpEngineCallback, std::int32_t>> finished;
+    {
+        std::lock_guard locker(mutex_);
+        isWaitingRead_ = false;
+        if (isStopped_)
+            return;
+        while (readReply(finished)) {}
+
+        if (!pending_.empty())
+            startRead();
+    }
+
+    for (auto &it : finished)
+        it.first->call(true, it.second);
+}
+
+bool IcmpEngine_posix::readReply(std::vector<std::pair<IcmpEngineCallback, std::int32_t>> &finished)
+{
+    std::uint8_t buf[kMaxPacketSize];
+    char control[256];
+    struct sockaddr_in from;
+    struct iovec iov;
+    iov.iov_base = buf;
+    iov.iov_len = sizeof(buf);
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &from;
+    msg.msg_namelen = sizeof(from);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t len = recvmsg(socket_->native_handle(), &msg, MSG_DONTWAIT);
+    if (len <= 0)
+        return false;
+
+    struct timespec recvTime;
+    bool hasKernelTimestamp = false;
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET)
+            continue;
+#ifdef SO_TIMESTAMPNS
+        if (cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+            memcpy(&recvTime, CMSG_DATA(cmsg), sizeof(recvTime));
+            hasKernelTimestamp = true;
+        }
+#else
+        if (cmsg->cmsg_type == SCM_TIMESTAMP) {
+            struct timeval tv;
+            memcpy(&tv, CMSG_DATA(cmsg), sizeof(tv));
+            recvTime.tv_sec = tv.tv_sec;
+            recvTime.tv_nsec = tv.tv_usec * 1000;
+            hasKernelTimestamp = true;
+        }
+#endif
+    }
+
+    // Raw sockets (and datagram sockets on macOS) deliver the IP header too
+    size_t offset = 0;
+    if (len >= 20 && (buf[0] >> 4) == 4) {
+        offset = (buf[0] & 0x0F) * 4;
+    }
+    if ((size_t)len < offset + kIcmpHeaderSize)
+        return true;
+
+    const std::uint8_t *icmp = buf + offset;
+    if (icmp[0] != kIcmpEchoReply)
+        return true;
+
+    std::uint16_t netId, netSeq;
+    memcpy(&netId, icmp + 4, 2);
+    memcpy(&netSeq, icmp + 6, 2);
+    std::uint16_t seq = ntohs(netSeq);
+
+#ifdef __linux__
+    // The kernel rewrites the identifier for datagram sockets and only delivers replies addressed to this socket
+    bool checkIdentifier = !isDatagramSocket_;
+#else
+    bool checkIdentifier = true;
+#endif
+    if (checkIdentifier && ntohs(netId) != identifier_)
+        return true;
+
+    auto it = pending_.find(seq);
+    if (it == pending_.end() || it->second.addr != from.sin_addr.s_addr)
+        return true;
+
+    std::int32_t timeMs;
+    if (hasKernelTimestamp) {
+        timeMs = elapsedMs(it->second.sendTime, recvTime);
+    } else {
+        timeMs = (std::int32_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - it->second.sendTimeSteady).count();
+    }
+
+    finished.push_back(std::make_pair(it->second.callback, timeMs));
+    removeRequest(seq);
+    return true;
+}
+
+void IcmpEngine_posix::scheduleTimer()
+{
+    if (deadlines_.empty())
+        return;
+    auto earliest = deadlines_.begin()->first;
+    if (timer_.expiry() == earliest)
+        return;
+    timer_.expires_at(earliest);
+    timer_.async_wait([this](const boost::system::error_code &ec) {
+        if (ec == boost::asio::error::operation_aborted)
+            return;
+        onTimer();
+    });
+}
+
+void IcmpEngine_posix::onTimer()
+{
+    std::vector<IcmpEngineCallback> timedOut;
+    {
+        std::lock_guard locker(mutex_);
+        if (isStopped_)
+            return;
+        auto now = std::chrono::steady_clock::now();
+        while (!deadlines_.empty() && deadlines_.begin()->first <= now) {
+            auto seq = deadlines_.begin()->second;
+            timedOut.push_back(pending_[seq].callback);
+            removeRequest(seq);
+        }
+        scheduleTimer();
+    }
+
+    for (auto &callback : timedOut)
+        callback->call(false, -1);
+}
+
+void IcmpEngine_posix::removeRequest(std::uint16_t seq)
+{
+    auto it = pending_.find(seq);
+    if (it == pending_.end())
+        return;
+    deadlines_.erase(it->second.deadlineIt);
+    requestIdToSeq_.erase(it->second.requestId);
+    pending_.erase(it);
+}
+
+std::uint16_t IcmpEngine_posix::checksum(const std::uint8_t *data, size_t len)
+{
+    std::uint32_t sum = 0;
+    for (size_t i = 0; i + 1 < len; i += 2) {
+        std::uint16_t word;
+        memcpy(&word, data + i, 2);
+        sum += word;
+    }
+    if (len & 1)
+        sum += data[len - 1];
+    while (sum >> 16)
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    return static_cast<std::uint16_t>(~sum);
+}
+
+std::int32_t IcmpEngine_posix::elapsedMs(const struct timespec &from, const struct timespec &to)
+{
+    std::int64_t ns = (std::int64_t)(to.tv_sec - from.tv_sec) * 1000000000LL + (to.tv_nsec - from.tv_nsec);
+    if (ns < 0)
+        return 0;
+    return (std::int32_t)(ns / 1000000);
+}
+
+} // namespace wsnet
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <boost/asio.hpp>
+#include "utils/cancelablecallback.h"
+
+namespace wsnet {
+
+typedef std::function<void(bool isSuccess, std::int32_t timeMs)> IcmpEngineCallbackFunc;
+// the owner of a ping cancels the callback before it is destroyed, a callback already running is waited for
+typedef std::shared_ptr<CancelableCallback<IcmpEngineCallbackFunc>> IcmpEngineCallback;
+
+// Native in-process ICMP echo engine for posix systems.
+// All pings are sent from a single socket and the replies are matched back to the requests by id/seq.
+// Tries an unprivileged SOCK_DGRAM/IPPROTO_ICMP socket first and falls back to a raw socket.
+// Round-trip times are calculated from kernel receive timestamps (SO_TIMESTAMPNS) when they are available.
+// Callbacks are called from the io_context thread, outside the mutex of the engine, through CancelableCallback.
+// Thread safe
+class IcmpEngine_posix
+{
+public:
+    explicit IcmpEngine_posix(boost::asio::io_context &io_context);
+    virtual ~IcmpEngine_posix();
+
+    // returns false if neither datagram nor raw ICMP sockets are allowed on this system
+    bool init();
+    void stop();
+
+    // returns a non-zero request id which can be passed to cancel(), or 0 if the ping could not be sent
+    std::uint64_t ping(const std::string &ip, int timeoutMs, IcmpEngineCallback callback);
+    void cancel(std::uint64_t requestId);
+
+private:
+    struct PendingRequest
+    {
+        std::uint64_t requestId;
+        std::uint32_t addr;         // network byte order
+        struct timespec sendTime;   // CLOCK_REALTIME, to compare with kernel timestamps
+        std::chrono::steady_clock::time_point sendTimeSteady;
+        std::multimap<std::chrono::steady_clock::time_point, std::uint16_t>::iterator deadlineIt;
+        IcmpEngineCallback callback;
+    };
+
+    boost::asio::io_context &io_context_;
+    std::unique_ptr<boost::asio::posix::stream_descriptor> socket_;
+    boost::asio::steady_timer timer_;
+    bool isDatagramSocket_ = false;
+    bool isStopped_ = false;
+    bool isWaitingRead_ = false;
+
+    std::mutex mutex_;
+    std::uint16_t identifier_ = 0;
+    std::uint16_t curSeq_ = 0;
+    std::uint64_t curRequestId_ = 1;
+    std::unordered_map<std::uint16_t, PendingRequest> pending_;             // seq -> request
+    std::unordered_map<std::uint64_t, std::uint16_t> requestIdToSeq_;
+    std::multimap<std::chrono::steady_clock::time_point, std::uint16_t> deadlines_;     // deadline -> seq
+
+    int openSocket();
+    bool nextFreeSeq(std::uint16_t &seq);
+    void startRead();
+    void onReadable();
+    bool readReply(std::vector<std::pair<IcmpEngineCallback, std::int32_t>> &finished);
+    void scheduleTimer();
+    void onTimer();
+    void removeRequest(std::uint16_t seq);
+
+    static std::uint16_t checksum(const std::uint8_t *data, size_t len);
+    static std::int32_t elapsedMs(const struct timespec &from, const struct timespec &to);
+};
+
+} // namespace wsnet
@@ -0,0 +1,172 @@
+#include "pingbatch.h"
+#include <spdlog/spdlog.h>
+#include "pingbatchtypes.h"
+#include "utils/utils.h"
+
+namespace wsnet {
+
+PingBatch::PingBatch(boost::asio::io_context &io_context, std::uint64_t id, const std::vector<std::shared_ptr<WSNetPingTarget>> &targets,
+                     std::uint32_t coalesceIntervalMs, std::uint32_t maxProbesPerSecond, std::uint32_t jitterMs, std::uint32_t maxParallel,
+                     std::shared_ptr<CancelableCallback<WSNetPingBatchCallback>> callback,
+                     PingBatchStartProbeFunc startProbeFunc, PingBatchFinishedFunc batchFinishedFunc) :
+    io_context_(io_context),
+    id_(id),
+    targets_(targets),
+    coalesceIntervalMs_(coalesceIntervalMs),
+    maxProbesPerSecond_(maxProbesPerSecond),
+    jitterMs_(jitterMs),
+    maxParallel_(maxParallel),
+    callback_(callback),
+    startProbeFunc_(startProbeFunc),
+    batchFinishedFunc_(batchFinishedFunc),
+    probeTimer_(io_context),
+    coalesceTimer_(io_context)
+{
+    results_.reserve(coalesceIntervalMs_ == 0 ? 1 : targets_.size());
+}
+
+void PingBatch::start()
+{
+    // The probe callback is called by PingManager under its mutex, so everything that can call back into
+    // PingManager or into the user code is posted to the io_context
+    std::weak_ptr<PingBatch> weakThis = shared_from_this();
+    probeCallback_ = std::make_shared<CancelableCallback<WSNetPingCallback>>(
+        [weakThis](const std::string &ip, bool isSuccess, std::int32_t timeMs, bool isFromDisconnectedVpnState) {
+            if (auto self = weakThis.lock())
+                self->onProbeFinished(ip, isSuccess, timeMs, isFromDisconnectedVpnState);
+        });
+
+    if (targets_.empty()) {
+        boost::asio::post(io_context_, [self = shared_from_this()] { self->finish(); });
+        return;
+    }
+
+    boost::asio::post(io_context_, [self = shared_from_this()] { self->onProbeTimer(); });
+}
+
+void PingBatch::stop()
+{
+    std::lock_guard locker(mutex_);
+    isStopped_ = true;
+    probeCallback_->cancel();
+    probeTimer_.cancel();
+    coalesceTimer_.cancel();
+}
+
+void PingBatch::onProbeTimer()
+{
+    std::vector<std::shared_ptr<WSNetPingTarget>> probes;
+    {
+        std::lock_guard locker(mutex_);
+        if (isStopped_)
+            return;
+
+        if (callback_->isCanceled()) {
+            // the rest of the targets will never be pinged, release the batch
+            isStopped_ = true;
+            boost::asio::post(io_context_, [self = shared_from_this()] { self->batchFinishedFunc_(self->id_); });
+            return;
+        }
+
+        auto hasSlot = [this] { return maxParallel_ == 0 || runningCount_ < maxParallel_; };
+        if (maxProbesPerSecond_ == 0) {
+            while (nextTarget_ < targets_.size() && hasSlot()) {
+                probes.push_back(targets_[nextTarget_++]);
+                runningCount_++;
+            }
+        } else if (!hasSlot()) {
+            isWaitingForSlot_ = true;
+        } else if (nextTarget_ < targets_.size()) {
+            probes.push_back(targets_[nextTarget_++]);
+            runningCount_++;
+            if (nextTarget_ < targets_.size())
+                scheduleNextProbe();
+        }
+    }
+
+    for (const auto &target : probes)
+        startProbeFunc_(target->ip(), target->hostname(), target->pingType(), probeCallback_);
+}
+
+void PingBatch::scheduleNextProbe()
+{
+    auto delay = std::chrono::microseconds(1000000 / maxProbesPerSecond_);
+    if (jitterMs_ > 0)
+        delay += std::chrono::milliseconds(utils::random(0, (int)jitterMs_));
+
+    probeTimer_.expires_after(delay);
+    probeTimer_.async_wait([self = shared_from_this()](const boost::system::error_code &ec) {
+        if (ec == boost::asio::error::operation_aborted)
+            return;
+        self->onProbeTimer();
+    });
+}
+
+void PingBatch::onProbeFinished(const std::string &ip, bool isSuccess, std::int32_t timeMs, bool isFromDisconnectedVpnState)
+{
+    std::lock_guard locker(mutex_);
+    if (isStopped_)
+        return;
+
+    results_.push_back(std::make_shared<PingResult>(ip, isSuccess, timeMs, isFromDisconnectedVpnState));
+    finishedCount_++;
+    runningCount_--;
+
+    // a slot is free for the next probe
+    if (nextTarget_ < targets_.size() && (maxProbesPerSecond_ == 0 || isWaitingForSlot_)) {
+        isWaitingForSlot_ = false;
+        boost::asio::post(io_context_, [self = shared_from_this()] { self->onProbeTimer(); });
+    }
+
+    if (finishedCount_ == targets_.size()) {
+        coalesceTimer_.cancel();
+        boost::asio::post(io_context_, [self = shared_from_this()] { self->finish(); });
+    } else if (coalesceIntervalMs_ == 0) {
+        boost::asio::post(io_context_, [self = shared_from_this()] { self->deliver(false); });
+    } else if (!isCoalesceTimerActive_) {
+        isCoalesceTimerActive_ = true;
+        coalesceTimer_.expires_after(std::chrono::milliseconds(coalesceIntervalMs_));
+        coalesceTimer_.async_wait([self = shared_from_this()](const boost::system::error_code &ec) {
+            if (ec == boost::asio::error::operation_aborted)
+                return;
+            self->onCoalesceTimer();
+        });
+    }
+}
+
+void PingBatch::onCoalesceTimer()
+{
+    {
+        std::lock_guard locker(mutex_);
+        isCoalesceTimerActive_ = false;
+    }
+    deliver(false);
+}
+
+void PingBatch::deliver(bool isFinished)
+{
+    std::vector<std::shared_ptr<WSNetPingResult>> results;
+    {
+        std::lock_guard locker(mutex_);
+        if (isStopped_)
+            return;
+        results.swap(results_);
+    }
+
+    if (!results.empty() || isFinished)
+        callback_->call(results, isFinished);
+}
+
+void PingBatch::finish()
+{
+    deliver(true);
+    {
+        std::lock_guard locker(mutex_);
+        if (isStopped_)
+            return;
+        isStopped_ = true;
+    }
+    batchFinishedFunc_(id_);
+}
+
+} // namespace wsnet
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include <boost/asio.hpp>
+#include "WSNetPingManager.h"
+#include "ipingmethod.h"
+
+namespace wsnet {
+
+typedef std::function<void(const std::string &ip, const std::string &hostname, PingType pingType, PingFinishedCallback callback)> PingBatchStartProbeFunc;
+typedef std::function<void(std::uint64_t batchId)> PingBatchFinishedFunc;
+
+// Schedules the probes of one WSNetPingManager::pingBatch call (rate limiting, jitter and parallelism) and
+// accumulates the results to deliver them in chunks.
+// All probes of the batch share one PingFinishedCallback, so there is no per-ip callback allocation.
+// Thread safe
+class PingBatch : public std::enable_shared_from_this<PingBatch>
+{
+public:
+    PingBatch(boost::asio::io_context &io_context, std::uint64_t id, const std::vector<std::shared_ptr<WSNetPingTarget>> &targets,
+              std::uint32_t coalesceIntervalMs, std::uint32_t maxProbesPerSecond, std::uint32_t jitterMs, std::uint32_t maxParallel,
+              std::shared_ptr<CancelableCallback<WSNetPingBatchCallback>> callback,
+              PingBatchStartProbeFunc startProbeFunc, PingBatchFinishedFunc batchFinishedFunc);
+
+    void start();
+    void stop();
+
+private:
+    boost::asio::io_context &io_context_;
+    std::uint64_t id_;
+    std::vector<std::shared_ptr<WSNetPingTarget>> targets_;
+    std::uint32_t coalesceIntervalMs_;
+    std::uint32_t maxProbesPerSecond_;
+    std::uint32_t jitterMs_;
+    std::uint32_t maxParallel_;
+    std::shared_ptr<CancelableCallback<WSNetPingBatchCallback>> callback_;
+    PingBatchStartProbeFunc startProbeFunc_;
+    PingBatchFinishedFunc batchFinishedFunc_;
+
+    std::mutex mutex_;
+    boost::asio::steady_timer probeTimer_;
+    boost::asio::steady_timer coalesceTimer_;
+    PingFinishedCallback probeCallback_;
+    size_t nextTarget_ = 0;
+    size_t finishedCount_ = 0;
+    size_t runningCount_ = 0;
+    // a rate limited probe is due but maxParallel_ probes are running, it is started when one of them finishes
+    bool isWaitingForSlot_ = false;
+    bool isCoalesceTimerActive_ = false;
+    bool isStopped_ = false;
+    std::vector<std::shared_ptr<WSNetPingResult>> results_;
+
+    void onProbeTimer();
+    void scheduleNextProbe();
+    void onProbeFinished(const std::string &ip, bool isSuccess, std::int32_t timeMs, bool isFromDisconnectedVpnState);
+    void onCoalesceTimer();
+    void deliver(bool isFinished);
+    void finish();
+};
+
+} // namespace wsnet
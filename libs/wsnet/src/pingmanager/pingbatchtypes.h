@@ -0,0 +1,70 @@
+#pragma once
+
+#include "WSNetPingTarget.h"
+#include "WSNetPingResult.h"
+#include "WSNetPingBatchOptions.h"
+
+namespace wsnet {
+
+class PingTarget : public WSNetPingTarget
+{
+public:
+    explicit PingTarget(const std::string &ip, const std::string &hostname, PingType pingType) :
+        ip_(ip), hostname_(hostname), pingType_(pingType)
+    {
+    }
+
+    std::string ip() const override { return ip_; }
+    std::string hostname() const override { return hostname_; }
+    PingType pingType() const override { return pingType_; }
+
+private:
+    std::string ip_;
+    std::string hostname_;
+    PingType pingType_;
+};
+
+class PingResult : public WSNetPingResult
+{
+public:
+    explicit PingResult(const std::string &ip, bool isSuccess, std::int32_t timeMs, bool isFromDisconnectedVpnState) :
+        ip_(ip), isSuccess_(isSuccess), timeMs_(timeMs), isFromDisconnectedVpnState_(isFromDisconnectedVpnState)
+    {
+    }
+
+    std::string ip() const override { return ip_; }
+    bool isSuccess() const override { return isSuccess_; }
+    std::int32_t timeMs() const override { return timeMs_; }
+    bool isFromDisconnectedVpnState() const override { return isFromDisconnectedVpnState_; }
+
+private:
+    std::string ip_;
+    bool isSuccess_;
+    std::int32_t timeMs_;
+    bool isFromDisconnectedVpnState_;
+};
+
+// Not thread safe, the options are copied by PingManager::pingBatch
+class PingBatchOptions : public WSNetPingBatchOptions
+{
+public:
+    void setCoalesceIntervalMs(std::uint32_t coalesceIntervalMs) override { coalesceIntervalMs_ = coalesceIntervalMs; }
+    std::uint32_t coalesceIntervalMs() const override { return coalesceIntervalMs_; }
+
+    void setMaxProbesPerSecond(std::uint32_t maxProbesPerSecond) override { maxProbesPerSecond_ = maxProbesPerSecond; }
+    std::uint32_t maxProbesPerSecond() const override { return maxProbesPerSecond_; }
+
+    void setJitterMs(std::uint32_t jitterMs) override { jitterMs_ = jitterMs; }
+    std::uint32_t jitterMs() const override { return jitterMs_; }
+
+    void setMaxParallel(std::uint32_t maxParallel) override { maxParallel_ = maxParallel; }
+    std::uint32_t maxParallel() const override { return maxParallel_; }
+
+private:
+    std::uint32_t coalesceIntervalMs_ = 0;
+    std::uint32_t maxProbesPerSecond_ = 0;
+    std::uint32_t jitterMs_ = 0;
+    std::uint32_t maxParallel_ = 100;
+};
+
+} // namespace wsnet
@@ -1,11 +1,14 @@
 #include "pingmanager.h"
+#include <limits>
 #include <spdlog/spdlog.h>
 #include "pingmethod_http.h"
+#include "pingbatchtypes.h"
 
 #ifdef _WIN32
     #include "pingmethod_icmp_win.h"
 #elif !defined IS_TVOS
     #include "pingmethod_icmp_posix.h"
+    #include "pingmethod_icmp_native_posix.h"
 #endif
 
 namespace wsnet {
@@ -17,7 +20,15 @@ PingManager::PingManager(boost::asio::io_context &io_context, WSNetHttpNetworkMa
 {
 
 #if !defined _WIN32 && !defined IS_TVOS
-    processManager_ = std::make_unique<ProcessManager>(io_context);
+    icmpEngine_ = std::make_unique<IcmpEngine_posix>(io_context);
+    if (icmpEngine_->init()) {
+        // all native ICMP pings share one socket and cost almost nothing, the batches limit their own probes
+        maxParallelPings_ = std::numeric_limits<int>::max();
+    } else {
+        spdlog::info("ICMP sockets are not available, using the ping utility for ICMP pings");
+        icmpEngine_.reset();
+        processManager_ = std::make_unique<ProcessManager>(io_context);
+    }
 #endif
 }
 
@@ -27,8 +38,13 @@ PingManager::~PingManager()
 #ifdef _WIN32
     eventCallbackManager_.stop();
 #elif !defined IS_TVOS
+    if (icmpEngine_)
+        icmpEngine_->stop();
     processManager_.reset();
 #endif
+    for (auto &it : batches_)
+        it.second->stop();
+    batches_.clear();
     map_.clear();
 }
 
@@ -38,7 +54,48 @@ std::shared_ptr<WSNetCancelableCallback> PingManager::ping(const std::string &ip
     std::lock_guard locker(mutex_);
 
     auto callbackFunc = std::make_shared<CancelableCallback<WSNetPingCallback>>(callback);
-    auto ping = createPingMethod(curPingId_, ip, hostname, pingType, callbackFunc);
+    startPing(ip, hostname, pingType, callbackFunc);
+    return callbackFunc;
+}
+
+std::shared_ptr<WSNetPingTarget> PingManager::createPingTarget(const std::string &ip, const std::string &hostname, PingType pingType)
+{
+    return std::make_shared<PingTarget>(ip, hostname, pingType);
+}
+
+std::shared_ptr<WSNetPingBatchOptions> PingManager::createPingBatchOptions()
+{
+    return std::make_shared<PingBatchOptions>();
+}
+
+std::shared_ptr<WSNetCancelableCallback> PingManager::pingBatch(const std::vector<std::shared_ptr<WSNetPingTarget>> &targets,
+                                                                std::shared_ptr<WSNetPingBatchOptions> options,
+                                                                WSNetPingBatchCallback callback)
+{
+    std::lock_guard locker(mutex_);
+
+    auto callbackFunc = std::make_shared<CancelableCallback<WSNetPingBatchCallback>>(callback);
+    if (!options)
+        options = std::make_shared<PingBatchOptions>();
+
+    auto batch = std::make_shared<PingBatch>(io_context_, curBatchId_, targets,
+        options->coalesceIntervalMs(), options->maxProbesPerSecond(), options->jitterMs(), options->maxParallel(), callbackFunc,
+        [this](const std::string &ip, const std::string &hostname, PingType pingType, PingFinishedCallback callback) {
+            std::lock_guard locker(mutex_);
+            startPing(ip, hostname, pingType, callback);
+        },
+        [this](std::uint64_t batchId) {
+            std::lock_guard locker(mutex_);
+            batches_.erase(batchId);
+        });
+    batches_[curBatchId_++] = batch;
+    batch->start();
+    return callbackFunc;
+}
+
+void PingManager::startPing(const std::string &ip, const std::string &hostname, PingType pingType, PingFinishedCallback callback)
+{
+    auto ping = createPingMethod(curPingId_, ip, hostname, pingType, callback);
     map_[curPingId_] = std::unique_ptr<IPingMethod>(ping);
 
     //TODO: add a delay between pings
@@ -52,7 +109,6 @@ std::shared_ptr<WSNetCancelableCallback> PingManager::ping(const std::string &ip
         processNextPingsInQueue();
     }
     curPingId_++;
-    return callbackFunc;
 }
 
 void PingManager::setIsConnectedToVpnState(bool isConnected)
@@ -92,6 +148,8 @@ IPingMethod *PingManager::createPingMethod(std::uint64_t id, const std::string &
     spdlog::error("ICMP pings are not supported on Apple tvOS");
     assert(false);
 #else
+        if (icmpEngine_)
+            return new PingMethodIcmpNative_posix(id, ip, hostname, true, callback, std::bind(&PingManager::onPingMethodFinished, this, std::placeholders::_1), icmpEngine_.get());
         return new PingMethodIcmp_posix(id, ip, hostname, true, callback, std::bind(&PingManager::onPingMethodFinished, this, std::placeholders::_1), processManager_.get());
 #endif
     } else {
@@ -102,7 +160,7 @@ IPingMethod *PingManager::createPingMethod(std::uint64_t id, const std::string &
 
 void PingManager::processNextPingsInQueue()
 {
-    while (curParallelPings_ < MAX_PARALLEL_PINGS && !queue_.empty()) {
+    while (curParallelPings_ < maxParallelPings_ && !queue_.empty()) {
         auto id = queue_.front();
         curParallelPings_++;
         auto &ping = map_[id];
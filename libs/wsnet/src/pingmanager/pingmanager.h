@@ -7,11 +7,13 @@
 #include "WSNetHttpNetworkManager.h"
 #include "WSNetAdvancedParameters.h"
 #include "ipingmethod.h"
+#include "pingbatch.h"
 
 #ifdef _WIN32
     #include "eventcallbackmanager_win.h"
 #elif !defined IS_TVOS
     #include "processmanager.h"
+    #include "icmpengine_posix.h"
 #endif
 
 namespace wsnet {
@@ -26,6 +28,12 @@ public:
     std::shared_ptr<WSNetCancelableCallback> ping(const std::string &ip, const std::string &hostname,
                                                   PingType pingType, WSNetPingCallback callback) override;
 
+    std::shared_ptr<WSNetPingTarget> createPingTarget(const std::string &ip, const std::string &hostname, PingType pingType) override;
+    std::shared_ptr<WSNetPingBatchOptions> createPingBatchOptions() override;
+    std::shared_ptr<WSNetCancelableCallback> pingBatch(const std::vector<std::shared_ptr<WSNetPingTarget>> &targets,
+                                                       std::shared_ptr<WSNetPingBatchOptions> options,
+                                                       WSNetPingBatchCallback callback) override;
+
     void setIsConnectedToVpnState(bool isConnected);
 
 private:
@@ -38,6 +46,8 @@ private:
     EventCallbackManager_win eventCallbackManager_;
 #elif !defined IS_TVOS
     // Required for ICMP pings for posix systems
+    // If the system allows ICMP sockets the in-process engine is used, otherwise fallback to the ping utility via ProcessManager
+    std::unique_ptr<IcmpEngine_posix> icmpEngine_;
     std::unique_ptr<ProcessManager> processManager_;
 #endif
     bool isConnectedToVpn_ = false;
@@ -45,11 +55,16 @@ private:
     std::uint64_t curPingId_ = 0;
     std::queue<std::uint64_t> queue_;
     std::map<std::uint64_t, std::unique_ptr<IPingMethod> > map_;
+    std::uint64_t curBatchId_ = 0;
+    std::map<std::uint64_t, std::shared_ptr<PingBatch> > batches_;
 
+    // for the pings which cost a process or a thread each; see WSNetPingBatchOptions::setMaxParallel for the batches
     static constexpr int MAX_PARALLEL_PINGS = 10;
+    int maxParallelPings_ = MAX_PARALLEL_PINGS;
     int curParallelPings_ = 0;
 
 
+    void startPing(const std::string &ip, const std::string &hostname, PingType pingType, PingFinishedCallback callback);
     void onPingMethodFinished(std::uint64_t id);
     IPingMethod *createPingMethod(std::uint64_t id, const std::string &ip, const std::string &hostname, PingType pingType, PingFinishedCallback callback);
     void processNextPingsInQueue();
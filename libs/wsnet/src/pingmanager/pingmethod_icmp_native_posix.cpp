@@ -0,0 +1,51 @@
+#include "pingmethod_icmp_native_posix.h"
+#include <spdlog/spdlog.h>
+#include "utils/utils.h"
+
+namespace wsnet {
+
+PingMethodIcmpNative_posix::PingMethodIcmpNative_posix(std::uint64_t id, const std::string &ip, const std::string &hostname, bool isParallelPing,
+        PingFinishedCallback callback, PingMethodFinishedCallback pingMethodFinishedCallback, IcmpEngine_posix *icmpEngine) :
+    IPingMethod(id, ip, hostname, isParallelPing, callback, pingMethodFinishedCallback),
+    icmpEngine_(icmpEngine)
+{
+}
+
+PingMethodIcmpNative_posix::~PingMethodIcmpNative_posix()
+{
+    // the engine may be calling the callback right now in its thread, cancel() waits for it to return
+    if (engineCallback_)
+        engineCallback_->cancel();
+    if (requestId_ != 0)
+        icmpEngine_->cancel(requestId_);
+}
+
+void PingMethodIcmpNative_posix::ping(bool isFromDisconnectedVpnState)
+{
+    if (!utils::isIpAddress(ip_)) {
+        spdlog::error("PingMethodIcmpNative_posix::ping incorrect IP-address: {}", ip_);
+        callFinished();
+        return;
+    }
+
+    isFromDisconnectedVpnState_ = isFromDisconnectedVpnState;
+
+    using namespace std::placeholders;
+    engineCallback_ = std::make_shared<CancelableCallback<IcmpEngineCallbackFunc>>(std::bind(&PingMethodIcmpNative_posix::onPingFinished, this, _1, _2));
+    requestId_ = icmpEngine_->ping(ip_, PING_TIMEOUT, engineCallback_);
+    if (requestId_ == 0) {
+        // the engine has already logged the reason
+        callFinished();
+    }
+}
+
+void PingMethodIcmpNative_posix::onPingFinished(bool isSuccess, std::int32_t timeMs)
+{
+    requestId_ = 0;
+    isSuccess_ = isSuccess;
+    if (isSuccess)
+        timeMs_ = timeMs;
+    callFinished();
+}
+
+} // namespace wsnet
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "ipingmethod.h"
+#include "icmpengine_posix.h"
+
+namespace wsnet {
+
+// ICMP ping via the shared in-process IcmpEngine_posix, no child processes are spawned
+class PingMethodIcmpNative_posix : public IPingMethod
+{
+public:
+    PingMethodIcmpNative_posix(std::uint64_t id, const std::string &ip, const std::string &hostname, bool isParallelPing,
+                    PingFinishedCallback callback, PingMethodFinishedCallback pingMethodFinishedCallback, IcmpEngine_posix *icmpEngine);
+
+    virtual ~PingMethodIcmpNative_posix();
+    void ping(bool isFromDisconnectedVpnState) override;
+
+private:
+    enum { PING_TIMEOUT = 2000 };
+    IcmpEngine_posix *icmpEngine_;
+    std::uint64_t requestId_ = 0;
+    IcmpEngineCallback engineCallback_;
+
+    void onPingFinished(bool isSuccess, std::int32_t timeMs);
+};
+
+} // namespace wsnet
@@ -32,8 +32,16 @@ public:
 
     virtual void handle(const std::string &arr);
 
-    bool isCanceled();
-    void callCallback();
+    // conditional GET: the ETag of the data the caller already has, empty by default
+    void setIfNoneMatch(const std::string &etag) { ifNoneMatch_ = etag; }
+    std::string ifNoneMatch() const { return ifNoneMatch_; }
+    // called instead of handle() when the server answered 304 to a conditional GET
+    virtual void handleNotModified() { setRetCode(ServerApiRetCode::kIncorrectJson); }
+    // the ETag of the answer, set before handle() is called
+    void setResponseETag(const std::string &etag) { responseETag_ = etag; }
+
+    virtual bool isCanceled();
+    virtual void callCallback();
 
     HttpMethod requestType() const { return requestType_; }
 
@@ -65,6 +73,8 @@ protected:
     std::string contentTypeHeader_;
     bool isIgnoreJsonParse_ = false;
     std::string json_;
+    std::string ifNoneMatch_;
+    std::string responseETag_;
 
     std::string hostname(const std::string &domain, SubdomainType subdomain) const;
 };
@@ -1,29 +1,31 @@
 #include "requestexecuterviafailover.h"
+#include <algorithm>
 #include <spdlog/spdlog.h>
 #include "serverapi_utils.h"
+#include "utils/crypto_utils.h"
 
 namespace wsnet {
 
-RequestExecuterViaFailover::RequestExecuterViaFailover(WSNetHttpNetworkManager *httpNetworkManager, std::unique_ptr<BaseRequest> request, std::unique_ptr<BaseFailover> failover,
-                                                       bool bIgnoreSslErrors, bool isConnectedVpnState, WSNetAdvancedParameters *advancedParameters, FailedFailovers &failedFailovers,
-                                                       RequestExecuterViaFailoverCallback callback) :
+RequestExecuterViaFailover::RequestExecuterViaFailover(boost::asio::io_context &io_context, WSNetHttpNetworkManager *httpNetworkManager, std::unique_ptr<BaseRequest> request,
+                                                       std::unique_ptr<BaseFailover> failover, bool bIgnoreSslErrors, bool isConnectedVpnState, WSNetAdvancedParameters *advancedParameters,
+                                                       PersistentSettings *persistentSettings, FailedFailovers &failedFailovers, RequestExecuterViaFailoverCallback callback) :
     httpNetworkManager_(httpNetworkManager),
     advancedParameters_(advancedParameters),
+    persistentSettings_(persistentSettings),
     request_(std::move(request)),
     failover_(std::move(failover)),
     bIgnoreSslErrors_(bIgnoreSslErrors),
     isConnectedVpnState_(isConnectedVpnState),
     isConnectStateChanged_(false),
     callback_(callback),
-    failedFailovers_(failedFailovers)
+    failedFailovers_(failedFailovers),
+    racingTimer_(io_context)
 {
 }
 
 RequestExecuterViaFailover::~RequestExecuterViaFailover()
 {
-    if (asyncCallback_) {
-        asyncCallback_->cancel();
-    }
+    cancelAll();
 }
 
 void RequestExecuterViaFailover::start()
@@ -59,46 +61,129 @@ void RequestExecuterViaFailover::onFailoverCallback(const std::vector<FailoverDa
         return;
     }
 
-    failoverData_ = data;
-    curIndFailoverData_ = 0;
-
     // if we have already tried this domain and it is failed skip it
     // keep in mind the failover can contain several domains
-    while (curIndFailoverData_ < failoverData_.size() && failedFailovers_.isContains(failoverData_[curIndFailoverData_]))  {
-        spdlog::info("Got an already failed domain, skip it");
-        curIndFailoverData_++;
+    failoverData_.clear();
+    for (const auto &it : data) {
+        if (failedFailovers_.isContains(it))
+            spdlog::info("Got an already failed domain, skip it");
+        else
+            failoverData_.push_back(it);
     }
-    if (curIndFailoverData_ >= failoverData_.size())
+    if (failoverData_.empty()) {
         callback_(RequestExecuterRetCode::kFailoverFailed, std::move(request_), FailoverData(""));
-    else
-        executeBaseRequest(failoverData_[curIndFailoverData_]);
+        return;
+    }
+
+    sortByStats();
+    curIndFailoverData_ = 0;
+    isRacing_ = advancedParameters_->isAPIFailoverRacing() && failoverData_.size() > 1;
+    executeNext();
+}
+
+void RequestExecuterViaFailover::sortByStats()
+{
+    if (!persistentSettings_ || failoverData_.size() < 2)
+        return;
+
+    // the domains that worked before go first (the fastest first), then unknown ones, then the ones that have never worked
+    // stable sort keeps the failover order among equal ones
+    auto stats = persistentSettings_->failoverStats();
+    auto rank = [&stats](const FailoverData &fd) {
+        auto it = stats.find(crypto_utils::md5(fd.uniqueId()));
+        if (it == stats.end())
+            return std::make_pair(1, (std::uint32_t)0);
+        if (it->second.successCount > 0)
+            return std::make_pair(0, it->second.latencyMs);
+        return std::make_pair(2, it->second.failureCount);
+    };
+    std::stable_sort(failoverData_.begin(), failoverData_.end(), [&rank](const FailoverData &l, const FailoverData &r) {
+        return rank(l) < rank(r);
+    });
+}
+
+void RequestExecuterViaFailover::executeNext()
+{
+    assert(curIndFailoverData_ < failoverData_.size());
+    executeBaseRequest(curIndFailoverData_);
+    curIndFailoverData_++;
+
+    racingTimer_.cancel();
+    if (isRacing_ && curIndFailoverData_ < failoverData_.size()) {
+        racingTimer_.expires_after(std::chrono::milliseconds(kRacingDelayMs));
+        racingTimer_.async_wait(std::bind(&RequestExecuterViaFailover::onRacingTimer, this, std::placeholders::_1));
+    }
 }
 
-void RequestExecuterViaFailover::executeBaseRequest(const FailoverData &failoverData)
+void RequestExecuterViaFailover::executeBaseRequest(int indFailoverData)
 {
     using namespace std::placeholders;
-    auto httpRequest = serverapi_utils::createHttpRequestWithFailoverParameters(httpNetworkManager_, failoverData, request_.get(), bIgnoreSslErrors_, advancedParameters_->isAPIExtraTLSPadding());
+    const FailoverData &failoverData = failoverData_[indFailoverData];
+    auto httpRequest = serverapi_utils::createHttpRequestWithFailoverParameters(httpNetworkManager_, failoverData, request_.get(), bIgnoreSslErrors_, advancedParameters_->isAPIExtraTLSPadding(),
+                                                                                advancedParameters_->isAPIConnectionReuse());
     httpRequest->setIsDebugLogCurlError(true);
-    asyncCallback_ = httpNetworkManager_->executeRequestEx(httpRequest, 0, std::bind(&RequestExecuterViaFailover::onHttpNetworkRequestFinished, this, _1, _2, _3, _4, _5),
-                                                           std::bind(&RequestExecuterViaFailover::onHttpNetworkRequestProgressCallback, this, _1, _2, _3));
+    auto asyncCallback = httpNetworkManager_->executeRequestEx(httpRequest, indFailoverData, std::bind(&RequestExecuterViaFailover::onHttpNetworkRequestFinished, this, _1, _2, _3, _4, _5),
+                                                               std::bind(&RequestExecuterViaFailover::onHttpNetworkRequestProgressCallback, this, _1, _2, _3));
+    attempts_[indFailoverData] = { httpRequest, asyncCallback };
+}
+
+void RequestExecuterViaFailover::onRacingTimer(const boost::system::error_code &ec)
+{
+    if (ec || !request_ || curIndFailoverData_ >= failoverData_.size())
+        return;
+
+    if (request_->isCanceled()) {
+        finish(RequestExecuterRetCode::kRequestCanceled, FailoverData(""));
+        return;
+    }
+    spdlog::info("No response from the failover domain yet, start the next one in parallel");
+    executeNext();
+}
+
+void RequestExecuterViaFailover::cancelAll()
+{
+    racingTimer_.cancel();
+    for (auto &it : attempts_)
+        it.second.asyncCallback->cancel();
+    attempts_.clear();
+}
+
+void RequestExecuterViaFailover::finish(RequestExecuterRetCode retCode, FailoverData failoverData)
+{
+    cancelAll();
+    // this object can be deleted in the callback
+    callback_(retCode, std::move(request_), failoverData);
+}
+
+void RequestExecuterViaFailover::updateStats(const FailoverData &failoverData, bool isSuccess, std::uint32_t latencyMs)
+{
+    if (persistentSettings_)
+        persistentSettings_->updateFailoverStats(crypto_utils::md5(failoverData.uniqueId()), isSuccess, latencyMs);
 }
 
 void RequestExecuterViaFailover::onHttpNetworkRequestFinished(std::uint64_t httpRequestId, std::uint32_t elapsedMs, NetworkError errCode, const std::string &curlError, const std::string &data)
 {
-    asyncCallback_.reset();
+    int ind = (int)httpRequestId;
+    auto attempt = attempts_.find(ind);
+    assert(attempt != attempts_.end());
+    std::shared_ptr<WSNetHttpRequest> httpRequest = attempt->second.httpRequest;
+    attempts_.erase(attempt);
+
     if (request_->isCanceled()) {
-        callback_(RequestExecuterRetCode::kRequestCanceled, std::move(request_), FailoverData(""));
+        finish(RequestExecuterRetCode::kRequestCanceled, FailoverData(""));
         return;
     }
 
     // if connect state changed then we can't be sure what failover worked right. Must repeat the request in ServerAPI
     if (isConnectStateChanged_) {
-        callback_(RequestExecuterRetCode::kConnectStateChanged, std::move(request_), FailoverData(""));
+        finish(RequestExecuterRetCode::kConnectStateChanged, FailoverData(""));
         return;
     }
 
     if (errCode == NetworkError::kSuccess) {
-        request_->handle(data);
+        // the previous raced response could have set an error code
+        request_->setRetCode(ServerApiRetCode::kSuccess);
+        serverapi_utils::handleAnswer(request_.get(), httpRequest.get(), data);
         if (advancedParameters_->isLogApiResponce()) {
             spdlog::info("API request {} finished", request_->name());
             spdlog::info("{}", data);
@@ -106,26 +191,28 @@ void RequestExecuterViaFailover::onHttpNetworkRequestFinished(std::uint64_t http
     }
 
     if (errCode != NetworkError::kSuccess || request_->retCode() == ServerApiRetCode::kIncorrectJson) {
-        failedFailovers_.add(failoverData_[curIndFailoverData_]);
+        failedFailovers_.add(failoverData_[ind]);
+        updateStats(failoverData_[ind], false, elapsedMs);
         // failover can contain several domains, let's try another one if there is one
-        curIndFailoverData_++;
-        if (curIndFailoverData_ >= failoverData_.size())
-            callback_(RequestExecuterRetCode::kFailoverFailed, std::move(request_), FailoverData(""));
-        else
-            executeBaseRequest(failoverData_[curIndFailoverData_]);
+        // in the racing mode do not wait for the racing timer
+        if (curIndFailoverData_ < failoverData_.size())
+            executeNext();
+        else if (attempts_.empty())
+            finish(RequestExecuterRetCode::kFailoverFailed, FailoverData(""));
         return;
     }
 
-    callback_(RequestExecuterRetCode::kSuccess, std::move(request_), failoverData_[curIndFailoverData_]);
+    updateStats(failoverData_[ind], true, elapsedMs);
+    if (isRacing_)
+        spdlog::info("Failover domain {} of {} won the race", ind + 1, failoverData_.size());
+    finish(RequestExecuterRetCode::kSuccess, failoverData_[ind]);
 }
 
 void RequestExecuterViaFailover::onHttpNetworkRequestProgressCallback(std::uint64_t requestId, std::uint64_t bytesReceived, std::uint64_t bytesTotal)
 {
     if (request_->isCanceled()) {
-        assert(asyncCallback_);
-        asyncCallback_->cancel();
-        asyncCallback_.reset();
-        callback_(RequestExecuterRetCode::kRequestCanceled, std::move(request_), FailoverData(""));
+        assert(!attempts_.empty());
+        finish(RequestExecuterRetCode::kRequestCanceled, FailoverData(""));
     }
 }
 
@@ -4,15 +4,21 @@
 #include "WSNetAdvancedParameters.h"
 #include <mutex>
 #include <thread>
+#include <map>
+#include <boost/asio.hpp>
 #include "baserequest.h"
 #include "failover/basefailover.h"
 #include "failedfailovers.h"
+#include "utils/persistentsettings.h"
 
 namespace wsnet {
 
 // Helper class used by ServerAPI.
 // Tries to execute a request through the specified failover and returns the result of this execution.
 // In short it executes the failover request first and then, if successful, the request itself
+// The domains of the failover are tried in the order of their past latency/success (if persistentSettings is set).
+// In the racing mode (WSNetAdvancedParameters::isAPIFailoverRacing) the next domain is started kRacingDelayMs after the previous one
+// without waiting for it to finish (in the spirit of RFC 8305), the first successful response wins and the rest are canceled.
 
 enum class RequestExecuterRetCode { kSuccess, kRequestCanceled, kFailoverFailed, kConnectStateChanged};
 
@@ -23,17 +29,21 @@ class RequestExecuterViaFailover
 {
 public:
     // The request starts executing from the constructor immediately
-    explicit RequestExecuterViaFailover(WSNetHttpNetworkManager *httpNetworkManager, std::unique_ptr<BaseRequest> request, std::unique_ptr<BaseFailover> failover,
-                                        bool bIgnoreSslErrors, bool isConnectedVpnState, WSNetAdvancedParameters *advancedParameters, FailedFailovers &failedFailovers,
-                                        RequestExecuterViaFailoverCallback callback);
+    // persistentSettings can be null, then the domain stats are not used
+    explicit RequestExecuterViaFailover(boost::asio::io_context &io_context, WSNetHttpNetworkManager *httpNetworkManager, std::unique_ptr<BaseRequest> request,
+                                        std::unique_ptr<BaseFailover> failover, bool bIgnoreSslErrors, bool isConnectedVpnState, WSNetAdvancedParameters *advancedParameters,
+                                        PersistentSettings *persistentSettings, FailedFailovers &failedFailovers, RequestExecuterViaFailoverCallback callback);
     virtual ~RequestExecuterViaFailover();
 
     void start();
     void setIsConnectedToVpnState(bool isConnected);
 
 private:
+    static constexpr int kRacingDelayMs = 250;
+
     WSNetHttpNetworkManager *httpNetworkManager_;
     WSNetAdvancedParameters *advancedParameters_;
+    PersistentSettings *persistentSettings_;
     RequestExecuterViaFailoverCallback callback_;
     FailedFailovers &failedFailovers_;
 
@@ -43,13 +53,26 @@ private:
     bool isConnectedVpnState_;
     bool isConnectStateChanged_;
 
-    std::shared_ptr<WSNetCancelableCallback> asyncCallback_;
+    std::vector<FailoverData> failoverData_;    // in the order of trying
+    int curIndFailoverData_;                    // the next one to try
+    bool isRacing_ = false;
+    boost::asio::steady_timer racingTimer_;
 
-    std::vector<FailoverData> failoverData_;
-    int curIndFailoverData_;
+    // the requests in progress, key is the index in failoverData_
+    struct Attempt {
+        std::shared_ptr<WSNetHttpRequest> httpRequest;
+        std::shared_ptr<WSNetCancelableCallback> asyncCallback;
+    };
+    std::map<int, Attempt> attempts_;
 
     void onFailoverCallback(const std::vector<FailoverData> &data);
-    void executeBaseRequest(const FailoverData &failoverData);
+    void sortByStats();
+    void executeNext();
+    void executeBaseRequest(int indFailoverData);
+    void onRacingTimer(const boost::system::error_code &ec);
+    void cancelAll();
+    void finish(RequestExecuterRetCode retCode, FailoverData failoverData);
+    void updateStats(const FailoverData &failoverData, bool isSuccess, std::uint32_t latencyMs);
     void onHttpNetworkRequestFinished(std::uint64_t httpRequestId, std::uint32_t elapsedMs, NetworkError errCode, const std::string &curlError, const std::string &data);
     // This callback function is necessary to cancel the request as quickly as possible if it was canceled on the calling side
     void onHttpNetworkRequestProgressCallback(std::uint64_t requestId, std::uint64_t bytesReceived, std::uint64_t bytesTotal);
@@ -47,7 +47,7 @@ BaseRequest *requests_factory::deleteSession(const std::string &authHash, Reques
 }
 
 BaseRequest *requests_factory::serverLocations(PersistentSettings &persistentSettings, const std::string &language, const std::string &revision, bool isPro, const std::vector<std::string> &alcList,
-                                               ConnectState &connectState, WSNetAdvancedParameters *advancedParameters, RequestFinishedCallback callback)
+                                               ConnectState &connectState, WSNetAdvancedParameters *advancedParameters, ServerListRequestFinishedCallback callback)
 {
     std::map<std::string, std::string> extraParams;
     // generate alc parameter
@@ -3,6 +3,7 @@
 #include "utils/persistentsettings.h"
 #include "connectstate.h"
 #include "WSNetAdvancedParameters.h"
+#include "serverlocations_request.h"
 
 namespace wsnet {
 
@@ -15,7 +16,7 @@ namespace requests_factory
     BaseRequest *deleteSession(const std::string &authHash, RequestFinishedCallback callback);
     BaseRequest *serverLocations(PersistentSettings &persistentSettings, const std::string &language, const std::string &revision,
                                  bool isPro, const std::vector<std::string> &alcList, ConnectState &connectState, WSNetAdvancedParameters *advancedParameters,
-                                 RequestFinishedCallback callback);
+                                 ServerListRequestFinishedCallback callback);
     BaseRequest *serverCredentials(const std::string &authHash, bool isOpenVpnProtocol, RequestFinishedCallback callback);
     BaseRequest *serverConfigs(const std::string &authHash, const std::string &ovpnVersion, RequestFinishedCallback callback);
     BaseRequest *portMap(const std::string &authHash, std::uint32_t version, const std::vector<std::string> &forceProtocols, RequestFinishedCallback callback);
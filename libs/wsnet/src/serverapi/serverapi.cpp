@@ -13,7 +13,7 @@ ServerAPI::ServerAPI(boost::asio::io_context &io_context, WSNetHttpNetworkManage
     advancedParameters_(advancedParameters),
     connectState_(connectState)
 {
-    impl_ = std::make_unique<ServerAPI_impl>(httpNetworkManager, failoverContainer, persistentSettings_, advancedParameters, connectState);
+    impl_ = std::make_unique<ServerAPI_impl>(io_context_, httpNetworkManager, failoverContainer, persistentSettings_, advancedParameters, connectState);
     subscriberId_ = connectState_.subscribeConnectedToVpnState(std::bind(&ServerAPI::onVPNConnectStateChanged, this, std::placeholders::_1));
 }
 
@@ -84,9 +84,18 @@ std::shared_ptr<WSNetCancelableCallback> ServerAPI::deleteSession(const std::str
 
 std::shared_ptr<WSNetCancelableCallback> ServerAPI::serverLocations(const std::string &language, const std::string &revision, bool isPro, const std::vector<std::string> &alcList, WSNetRequestFinishedCallback callback)
 {
-    auto cancelableCallback = std::make_shared<CancelableCallback<WSNetRequestFinishedCallback>>(callback);
+    return serverList(language, revision, isPro, alcList, std::string(), [callback](ServerApiRetCode serverApiRetCode, const std::string &jsonData, const ServerListAnswer &) {
+        callback(serverApiRetCode, jsonData);
+    });
+}
+
+std::shared_ptr<WSNetCancelableCallback> ServerAPI::serverList(const std::string &language, const std::string &revision, bool isPro, const std::vector<std::string> &alcList,
+                                                               const std::string &ifNoneMatch, ServerListFinishedCallback callback)
+{
+    auto cancelableCallback = std::make_shared<CancelableCallback<ServerListFinishedCallback>>(callback);
     BaseRequest *request = requests_factory::serverLocations(persistentSettings_, language, revision, isPro, alcList,
                                                              connectState_, advancedParameters_, cancelableCallback);
+    request->setIfNoneMatch(ifNoneMatch);
     boost::asio::post(io_context_, [this, request] { impl_->executeRequest(std::unique_ptr<BaseRequest>(request)); });
     return cancelableCallback;
 }
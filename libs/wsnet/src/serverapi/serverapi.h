@@ -7,6 +7,7 @@
 #include "failover/ifailovercontainer.h"
 #include "utils/persistentsettings.h"
 #include "connectstate.h"
+#include "serverlocations_request.h"
 
 namespace wsnet {
 
@@ -32,6 +33,11 @@ public:
     std::shared_ptr<WSNetCancelableCallback> serverLocations(const std::string &language, const std::string &revision,
                                                                      bool isPro, const std::vector<std::string> &alcList,
                                                                      WSNetRequestFinishedCallback callback) override;
+    // same as serverLocations(), but the callback also receives the typed server list, for internal use by ApiResourcesManager
+    // if ifNoneMatch is not empty, it is a conditional GET and the answer can be "not modified"
+    std::shared_ptr<WSNetCancelableCallback> serverList(const std::string &language, const std::string &revision,
+                                                        bool isPro, const std::vector<std::string> &alcList,
+                                                        const std::string &ifNoneMatch, ServerListFinishedCallback callback);
     std::shared_ptr<WSNetCancelableCallback> serverCredentials(const std::string &authHash, bool isOpenVpnProtocol, WSNetRequestFinishedCallback callback) override;
     std::shared_ptr<WSNetCancelableCallback> serverConfigs(const std::string &authHash, WSNetRequestFinishedCallback callback) override;
 
@@ -5,8 +5,9 @@
 
 namespace wsnet {
 
-ServerAPI_impl::ServerAPI_impl(WSNetHttpNetworkManager *httpNetworkManager, IFailoverContainer *failoverContainer, PersistentSettings &persistentSettings,
-                               WSNetAdvancedParameters *advancedParameters, ConnectState &connectState) :
+ServerAPI_impl::ServerAPI_impl(boost::asio::io_context &io_context, WSNetHttpNetworkManager *httpNetworkManager, IFailoverContainer *failoverContainer,
+                               PersistentSettings &persistentSettings, WSNetAdvancedParameters *advancedParameters, ConnectState &connectState) :
+    io_context_(io_context),
     httpNetworkManager_(httpNetworkManager),
     advancedParameters_(advancedParameters),
     connectState_(connectState),
@@ -14,7 +15,7 @@ ServerAPI_impl::ServerAPI_impl(WSNetHttpNetworkManager *httpNetworkManager, IFai
     persistentSettings_(persistentSettings)
 {
     // try reading a failover from the settings
-    auto failover = failoverContainer_->failoverById(persistentSettings_.failoverId(), &curFailoverInd_);
+    auto failover = failoverContainer_->failoverById(*persistentSettings_.failoverId(), &curFailoverInd_);
 
     // if it fails, use the first one
     if (!failover) {
@@ -148,8 +149,8 @@ void ServerAPI_impl::executeRequest(std::unique_ptr<BaseRequest> request)
 
             // start RequestExecuterViaFailover and wait for the result in the callback function
             using namespace std::placeholders;
-            requestExecutorViaFailover_.reset(new RequestExecuterViaFailover(httpNetworkManager_, std::move(request), std::move(curFailover),
-                                                                             bIgnoreSslErrors_, isConnectedToVpn_, advancedParameters_, failedFailovers_,
+            requestExecutorViaFailover_.reset(new RequestExecuterViaFailover(io_context_, httpNetworkManager_, std::move(request), std::move(curFailover),
+                                                                             bIgnoreSslErrors_, isConnectedToVpn_, advancedParameters_, &persistentSettings_, failedFailovers_,
                                                                              std::bind(&ServerAPI_impl::onRequestExecuterViaFailoverFinished, this, _1, _2, _3)));
             requestExecutorViaFailover_->start();
         } else {
@@ -168,12 +169,13 @@ void ServerAPI_impl::executeRequest(std::unique_ptr<BaseRequest> request)
 void ServerAPI_impl::executeRequestImpl(std::unique_ptr<BaseRequest> request, const FailoverData &failoverData)
 {
     using namespace std::placeholders;
-    auto httpRequest = serverapi_utils::createHttpRequestWithFailoverParameters(httpNetworkManager_, failoverData, request.get(), bIgnoreSslErrors_, advancedParameters_->isAPIExtraTLSPadding());
+    auto httpRequest = serverapi_utils::createHttpRequestWithFailoverParameters(httpNetworkManager_, failoverData, request.get(), bIgnoreSslErrors_, advancedParameters_->isAPIExtraTLSPadding(),
+                                                                                advancedParameters_->isAPIConnectionReuse());
     httpRequest->setIsDebugLogCurlError(true);
     std::uint64_t requestId = curUniqueId_++;
     auto asyncCallback_ = httpNetworkManager_->executeRequestEx(httpRequest, requestId, std::bind(&ServerAPI_impl::onHttpNetworkRequestFinished, this, _1, _2, _3, _4, _5),
                                                            std::bind(&ServerAPI_impl::onHttpNetworkRequestProgressCallback, this, _1, _2, _3));
-    HttpRequestInfo hti { std::move(request), asyncCallback_};
+    HttpRequestInfo hti { std::move(request), httpRequest, asyncCallback_};
     activeHttpRequests_[requestId] = std::move(hti);
 }
 
@@ -267,7 +269,7 @@ void ServerAPI_impl::onHttpNetworkRequestFinished(std::uint64_t requestId, std::
             spdlog::info("API request {} finished", it->second.request->name());
             spdlog::info("{}", data);
         }
-        it->second.request->handle(data);
+        serverapi_utils::handleAnswer(it->second.request.get(), it->second.httpRequest.get(), data);
         it->second.request->callCallback();
     } else {
         spdlog::info("API request {} failed with retCode = {} and curlError = {}", it->second.request->name(), (int)errCode, curlError);
@@ -6,6 +6,7 @@
 #include <map>
 #include <optional>
 #include <atomic>
+#include <boost/asio.hpp>
 #include "WSNetHttpNetworkManager.h"
 #include "WSNetAdvancedParameters.h"
 #include "baserequest.h"
@@ -23,7 +24,7 @@ namespace wsnet {
 class ServerAPI_impl
 {
 public:
-    explicit ServerAPI_impl(WSNetHttpNetworkManager *httpNetworkManager, IFailoverContainer *failoverContainer,
+    explicit ServerAPI_impl(boost::asio::io_context &io_context, WSNetHttpNetworkManager *httpNetworkManager, IFailoverContainer *failoverContainer,
                             PersistentSettings &persistentSettings, WSNetAdvancedParameters *advancedParameters, ConnectState &connectState);
     virtual ~ServerAPI_impl();
 
@@ -36,6 +37,7 @@ public:
     void executeRequest(std::unique_ptr<BaseRequest> request);
 
 private:
+    boost::asio::io_context &io_context_;
     WSNetHttpNetworkManager *httpNetworkManager_;
     WSNetAdvancedParameters *advancedParameters_;
     ConnectState &connectState_;
@@ -60,6 +62,7 @@ private:
 
     struct HttpRequestInfo {
         std::unique_ptr<BaseRequest> request;
+        std::shared_ptr<WSNetHttpRequest> httpRequest;
         std::shared_ptr<WSNetCancelableCallback> asyncCallback_;
     };
     std::map<std::uint64_t, HttpRequestInfo> activeHttpRequests_;
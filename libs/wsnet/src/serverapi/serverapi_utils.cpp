@@ -3,7 +3,7 @@
 namespace wsnet {
 
 std::shared_ptr<WSNetHttpRequest> serverapi_utils::createHttpRequestWithFailoverParameters(WSNetHttpNetworkManager *httpNetworkManager, const FailoverData &failoverData, BaseRequest *request,
-                                                                                           bool bIgnoreSslErrors, bool isAPIExtraTLSPadding)
+                                                                                           bool bIgnoreSslErrors, bool isAPIExtraTLSPadding, bool isAPIConnectionReuse)
 {
     // Make sure the network return code is reset
     request->setRetCode(ServerApiRetCode::kSuccess);
@@ -38,8 +38,25 @@ std::shared_ptr<WSNetHttpRequest> serverapi_utils::createHttpRequestWithFailover
     if (!failoverData.sniDomain().empty())
         httpRequest->setSniDomain(failoverData.sniDomain());
 
+    // one connection pool per failover endpoint
+    if (isAPIConnectionReuse)
+        httpRequest->setConnectionPoolKey(failoverData.uniqueId());
+
+    if (!request->ifNoneMatch().empty())
+        httpRequest->setIfNoneMatch(request->ifNoneMatch());
+
     return httpRequest;
 }
 
+void serverapi_utils::handleAnswer(BaseRequest *request, const WSNetHttpRequest *httpRequest, const std::string &data)
+{
+    if (httpRequest->responseCode() == 304 && !request->ifNoneMatch().empty()) {
+        request->handleNotModified();
+    } else {
+        request->setResponseETag(httpRequest->responseETag());
+        request->handle(data);
+    }
+}
+
 
 } // namespace wsnet
@@ -8,7 +8,10 @@ namespace wsnet {
 
 namespace serverapi_utils {
     std::shared_ptr<WSNetHttpRequest> createHttpRequestWithFailoverParameters(WSNetHttpNetworkManager *httpNetworkManager, const FailoverData &failoverData, BaseRequest *request,
-                                                                          bool bIgnoreSslErrors, bool isAPIExtraTLSPadding);
+                                                                          bool bIgnoreSslErrors, bool isAPIExtraTLSPadding, bool isAPIConnectionReuse);
+
+    // passes the successful answer to the request, as handleNotModified() for a 304 answer to a conditional GET
+    void handleAnswer(BaseRequest *request, const WSNetHttpRequest *httpRequest, const std::string &data);
 }
 
 } // namespace wsnet
@@ -0,0 +1,196 @@
+#include "serverlist.h"
+#include <cmath>
+#include <limits>
+
+namespace wsnet {
+
+namespace {
+
+// same conversion as QJsonValue::toInt(): integral numbers only, otherwise the default value
+std::int32_t toInt(const rapidjson::Value &obj, const char *name, std::int32_t defaultValue = 0)
+{
+    auto it = obj.FindMember(name);
+    if (it == obj.MemberEnd())
+        return defaultValue;
+    if (it->value.IsInt())
+        return it->value.GetInt();
+    if (it->value.IsDouble()) {
+        double d = it->value.GetDouble();
+        if (std::floor(d) == d && d >= std::numeric_limits<std::int32_t>::min() && d <= std::numeric_limits<std::int32_t>::max())
+            return (std::int32_t)d;
+    }
+    return defaultValue;
+}
+
+bool hasMembers(const rapidjson::Value &obj, std::initializer_list<const char *> names)
+{
+    for (auto name : names) {
+        if (!obj.HasMember(name))
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+std::shared_ptr<WSNetServerList> WSNetServerList::createFromJson(const std::string &json)
+{
+    return ServerList::createFromJson(json);
+}
+
+ServerList::ServerList()
+{
+    strings_.emplace_back();
+    stringsIndex_[std::string()] = 0;
+}
+
+std::shared_ptr<ServerList> ServerList::createFromJson(const std::string &json)
+{
+    rapidjson::Document doc;
+    doc.Parse(json.c_str(), json.size());
+    if (doc.HasParseError() || !doc.IsObject())
+        return nullptr;
+    return createFromDocument(doc);
+}
+
+std::shared_ptr<ServerList> ServerList::createFromDocument(const rapidjson::Document &doc)
+{
+    if (!doc.IsObject())
+        return nullptr;
+
+    std::shared_ptr<ServerList> sl(new ServerList());
+    auto itInfo = doc.FindMember("info");
+    if (itInfo != doc.MemberEnd() && itInfo->value.IsObject())
+        sl->countryOverride_ = sl->intern(itInfo->value, "country_override");
+
+    auto itData = doc.FindMember("data");
+    if (itData != doc.MemberEnd() && itData->value.IsArray()) {
+        const auto &data = itData->value.GetArray();
+        sl->locations_.reserve(data.Size());
+        for (const auto &location : data) {
+            if (location.IsObject())
+                sl->addLocation(location);
+        }
+    }
+
+    sl->stringsIndex_.clear();
+    sl->strings_.shrink_to_fit();
+    sl->locations_.shrink_to_fit();
+    sl->groups_.shrink_to_fit();
+    sl->nodes_.shrink_to_fit();
+    return sl;
+}
+
+std::uint32_t ServerList::intern(const rapidjson::Value &obj, const char *name)
+{
+    auto it = obj.FindMember(name);
+    if (it == obj.MemberEnd() || !it->value.IsString() || it->value.GetStringLength() == 0)
+        return 0;
+
+    std::string str(it->value.GetString(), it->value.GetStringLength());
+    auto res = stringsIndex_.emplace(std::move(str), (std::uint32_t)strings_.size());
+    if (res.second)
+        strings_.push_back(res.first->first);
+    return res.first->second;
+}
+
+bool ServerList::addLocation(const rapidjson::Value &obj)
+{
+    if (!hasMembers(obj, { "id", "name", "country_code", "premium_only", "p2p", "groups" }))
+        return false;
+
+    Location l;
+    l.id = toInt(obj, "id");
+    l.name = intern(obj, "name");
+    l.countryCode = intern(obj, "country_code");
+    l.premiumOnly = toInt(obj, "premium_only");
+    l.p2p = toInt(obj, "p2p");
+    l.dnsHostName = intern(obj, "dns_hostname");
+    l.firstGroup = (std::uint32_t)groups_.size();
+
+    const size_t nodesCount = nodes_.size();
+    const auto &groups = obj["groups"];
+    if (groups.IsArray()) {
+        for (const auto &group : groups.GetArray()) {
+            if (!addGroup(group)) {
+                // drop the whole location, as the previous implementation did
+                groups_.resize(l.firstGroup);
+                nodes_.resize(nodesCount);
+                return false;
+            }
+        }
+    }
+    l.groupsCount = (std::uint32_t)groups_.size() - l.firstGroup;
+    locations_.push_back(l);
+    return true;
+}
+
+bool ServerList::addGroup(const rapidjson::Value &obj)
+{
+    if (!obj.IsObject() || !hasMembers(obj, { "id", "city", "nick", "pro", "ping_ip", "wg_pubkey" }))
+        return false;
+
+    Group g;
+    g.id = toInt(obj, "id");
+    g.city = intern(obj, "city");
+    g.nick = intern(obj, "nick");
+    g.pro = toInt(obj, "pro");
+    g.pingIp = intern(obj, "ping_ip");
+    g.pingHost = intern(obj, "ping_host");
+    g.wgPubKey = intern(obj, "wg_pubkey");
+    g.ovpnX509 = intern(obj, "ovpn_x509");
+
+    // link_speed comes as a string
+    g.linkSpeed = 100;
+    auto itLinkSpeed = obj.FindMember("link_speed");
+    if (itLinkSpeed != obj.MemberEnd() && itLinkSpeed->value.IsString()) {
+        try {
+            size_t pos;
+            const std::string str = itLinkSpeed->value.GetString();
+            int linkSpeed = std::stoi(str, &pos);
+            if (pos == str.size())
+                g.linkSpeed = linkSpeed;
+        } catch (...) {
+        }
+    }
+
+    // -1 means that the health value is missing or invalid (for example, for premium locations for a free account)
+    g.health = toInt(obj, "health", -1);
+    if (g.health < 0 || g.health > 100)
+        g.health = -1;
+
+    g.firstNode = (std::uint32_t)nodes_.size();
+    auto itNodes = obj.FindMember("nodes");
+    if (itNodes != obj.MemberEnd() && itNodes->value.IsArray()) {
+        for (const auto &node : itNodes->value.GetArray()) {
+            if (!addNode(node))
+                return false;
+        }
+    }
+    g.nodesCount = (std::uint32_t)nodes_.size() - g.firstNode;
+    groups_.push_back(g);
+    return true;
+}
+
+bool ServerList::addNode(const rapidjson::Value &obj)
+{
+    if (!obj.IsObject() || !hasMembers(obj, { "ip", "ip2", "ip3", "hostname", "weight" }))
+        return false;
+
+    // a node with the force_disconnect flag is not added to the group, but to another list
+    if (toInt(obj, "force_disconnect") == 1) {
+        forceDisconnectNodes_.push_back(intern(obj, "hostname"));
+        return true;
+    }
+
+    Node n;
+    n.ips[0] = intern(obj, "ip");
+    n.ips[1] = intern(obj, "ip2");
+    n.ips[2] = intern(obj, "ip3");
+    n.hostname = intern(obj, "hostname");
+    n.weight = toInt(obj, "weight");
+    nodes_.push_back(n);
+    return true;
+}
+
+} // namespace wsnet
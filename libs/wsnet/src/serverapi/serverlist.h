@@ -0,0 +1,106 @@
+#pragma once
+
+#include <unordered_map>
+#include <rapidjson/document.h>
+#include "WSNetServerList.h"
+
+namespace wsnet {
+
+// Implementation of WSNetServerList, built from an already parsed json document,
+// so the serverlist answer is parsed by rapidjson only once (in ServerLocationsRequest).
+class ServerList : public WSNetServerList
+{
+public:
+    // return nullptr if failed
+    static std::shared_ptr<ServerList> createFromJson(const std::string &json);
+    static std::shared_ptr<ServerList> createFromDocument(const rapidjson::Document &doc);
+
+    std::uint32_t stringsCount() const override { return (std::uint32_t)strings_.size(); }
+    const std::string &string(std::uint32_t ind) const override { return strings_[ind]; }
+
+    const std::string &countryOverride() const override { return strings_[countryOverride_]; }
+    const std::vector<std::uint32_t> &forceDisconnectNodes() const override { return forceDisconnectNodes_; }
+
+    std::uint32_t locationsCount() const override { return (std::uint32_t)locations_.size(); }
+    std::int32_t locationId(std::uint32_t location) const override { return locations_[location].id; }
+    std::uint32_t locationName(std::uint32_t location) const override { return locations_[location].name; }
+    std::uint32_t locationCountryCode(std::uint32_t location) const override { return locations_[location].countryCode; }
+    std::uint32_t locationDnsHostName(std::uint32_t location) const override { return locations_[location].dnsHostName; }
+    std::int32_t locationPremiumOnly(std::uint32_t location) const override { return locations_[location].premiumOnly; }
+    std::int32_t locationP2P(std::uint32_t location) const override { return locations_[location].p2p; }
+    std::uint32_t locationFirstGroup(std::uint32_t location) const override { return locations_[location].firstGroup; }
+    std::uint32_t locationGroupsCount(std::uint32_t location) const override { return locations_[location].groupsCount; }
+
+    std::int32_t groupId(std::uint32_t group) const override { return groups_[group].id; }
+    std::uint32_t groupCity(std::uint32_t group) const override { return groups_[group].city; }
+    std::uint32_t groupNick(std::uint32_t group) const override { return groups_[group].nick; }
+    std::int32_t groupPro(std::uint32_t group) const override { return groups_[group].pro; }
+    std::uint32_t groupPingIp(std::uint32_t group) const override { return groups_[group].pingIp; }
+    std::uint32_t groupPingHost(std::uint32_t group) const override { return groups_[group].pingHost; }
+    std::uint32_t groupWgPubKey(std::uint32_t group) const override { return groups_[group].wgPubKey; }
+    std::uint32_t groupOvpnX509(std::uint32_t group) const override { return groups_[group].ovpnX509; }
+    std::int32_t groupLinkSpeed(std::uint32_t group) const override { return groups_[group].linkSpeed; }
+    std::int32_t groupHealth(std::uint32_t group) const override { return groups_[group].health; }
+    std::uint32_t groupFirstNode(std::uint32_t group) const override { return groups_[group].firstNode; }
+    std::uint32_t groupNodesCount(std::uint32_t group) const override { return groups_[group].nodesCount; }
+
+    std::uint32_t nodeIp(std::uint32_t node, std::uint32_t ind) const override { return nodes_[node].ips[ind]; }
+    std::uint32_t nodeHostname(std::uint32_t node) const override { return nodes_[node].hostname; }
+    std::int32_t nodeWeight(std::uint32_t node) const override { return nodes_[node].weight; }
+
+private:
+    ServerList(); // can only be created by the static functions
+
+    struct Location
+    {
+        std::int32_t id;
+        std::uint32_t name;
+        std::uint32_t countryCode;
+        std::uint32_t dnsHostName;
+        std::int32_t premiumOnly;
+        std::int32_t p2p;
+        std::uint32_t firstGroup;
+        std::uint32_t groupsCount;
+    };
+
+    struct Group
+    {
+        std::int32_t id;
+        std::uint32_t city;
+        std::uint32_t nick;
+        std::int32_t pro;
+        std::uint32_t pingIp;
+        std::uint32_t pingHost;
+        std::uint32_t wgPubKey;
+        std::uint32_t ovpnX509;
+        std::int32_t linkSpeed;
+        std::int32_t health;
+        std::uint32_t firstNode;
+        std::uint32_t nodesCount;
+    };
+
+    struct Node
+    {
+        std::uint32_t ips[3];
+        std::uint32_t hostname;
+        std::int32_t weight;
+    };
+
+    // index 0 is always the empty string
+    std::vector<std::string> strings_;
+    std::uint32_t countryOverride_ = 0;
+    std::vector<std::uint32_t> forceDisconnectNodes_;
+    std::vector<Location> locations_;
+    std::vector<Group> groups_;
+    std::vector<Node> nodes_;
+
+    // used only while building
+    std::unordered_map<std::string, std::uint32_t> stringsIndex_;
+
+    std::uint32_t intern(const rapidjson::Value &obj, const char *name);
+    bool addLocation(const rapidjson::Value &obj);
+    bool addGroup(const rapidjson::Value &obj);
+    bool addNode(const rapidjson::Value &obj);
+};
+
+} // namespace wsnet
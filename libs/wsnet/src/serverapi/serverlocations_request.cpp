@@ -7,11 +7,12 @@ namespace wsnet {
 
 ServerLocationsRequest::ServerLocationsRequest(RequestPriority priority, const std::string &name,
         std::map<std::string, std::string> extraParams, PersistentSettings &persistentSettings,
-        ConnectState &connectState, WSNetAdvancedParameters *advancedParameters, RequestFinishedCallback callback) :
-    BaseRequest(HttpMethod::kGet, SubdomainType::kAssets, priority, name, extraParams, callback),
+        ConnectState &connectState, WSNetAdvancedParameters *advancedParameters, ServerListRequestFinishedCallback callback) :
+    BaseRequest(HttpMethod::kGet, SubdomainType::kAssets, priority, name, extraParams, nullptr),
     persistentSettings_(persistentSettings),
     connectState_(connectState),
-    advancedParameters_(advancedParameters)
+    advancedParameters_(advancedParameters),
+    serverListCallback_(callback)
 {
 }
 
@@ -35,8 +36,8 @@ std::string ServerLocationsRequest::url(const std::string &domain) const
         if (!advancedParameters_->countryOverrideValue().empty()) {
             countryOverride = advancedParameters_->countryOverrideValue();
         } else if (connectState_.isVPNConnected()) {
-            if (!persistentSettings_.countryOverride().empty()) {
-                countryOverride = persistentSettings_.countryOverride();
+            if (!persistentSettings_.countryOverride()->empty()) {
+                countryOverride = *persistentSettings_.countryOverride();
             }
         }
     }
@@ -92,10 +93,29 @@ void ServerLocationsRequest::handle(const std::string &arr)
                 spdlog::info("API request ServerLocations removed countryOverride flag");
             }
         }
+
+        answer_.serverList = ServerList::createFromDocument(doc);
     }
+    answer_.etag = responseETag_;
     json_ = arr;
 }
 
+void ServerLocationsRequest::handleNotModified()
+{
+    spdlog::info("API request ServerLocations: the server list is not modified");
+    answer_.isNotModified = true;
+}
+
+bool ServerLocationsRequest::isCanceled()
+{
+    return serverListCallback_->isCanceled();
+}
+
+void ServerLocationsRequest::callCallback()
+{
+    serverListCallback_->call(retCode_, json_, answer_);
+}
+
 
 
 } // namespace wsnet
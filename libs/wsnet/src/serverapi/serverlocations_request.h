@@ -5,29 +5,47 @@
 #include "baserequest.h"
 #include "utils/persistentsettings.h"
 #include "connectstate.h"
+#include "serverlist.h"
 
 namespace wsnet {
 
+struct ServerListAnswer
+{
+    std::shared_ptr<ServerList> serverList;     // the typed list built from the answer, nullptr on failure or if not modified
+    std::string etag;                           // empty if the server did not send it
+    bool isNotModified = false;                 // 304 to the conditional GET, the caller's list is up to date and jsonData is empty
+};
+
+// Same as WSNetRequestFinishedCallback, but also delivers the typed server list and the ETag
+typedef std::function<void(ServerApiRetCode serverApiRetCode, const std::string &jsonData, const ServerListAnswer &answer)> ServerListFinishedCallback;
+using ServerListRequestFinishedCallback = std::shared_ptr<CancelableCallback<ServerListFinishedCallback>>;
+
 // This request is different from all the others, so we make a class with overriding behavior
 // In particular, the country override logic needs to be executed here
 // Also, do not pass client_auth_hash, platform, version parameters for this request
+// The json document parsed for validation is also turned into the typed ServerList, so the answer is parsed only once
 class ServerLocationsRequest : public BaseRequest
 {
 public:
     explicit ServerLocationsRequest(RequestPriority priority, const std::string &name,
                                     std::map<std::string, std::string> extraParams, PersistentSettings &persistentSettings,
-                                    ConnectState &connectState, WSNetAdvancedParameters *advancedParameters, RequestFinishedCallback callback);
+                                    ConnectState &connectState, WSNetAdvancedParameters *advancedParameters, ServerListRequestFinishedCallback callback);
     virtual ~ServerLocationsRequest() {};
 
     std::string url(const std::string &domain) const override;
     void handle(const std::string &arr) override;
+    void handleNotModified() override;
 
+    bool isCanceled() override;
+    void callCallback() override;
 
 private:
     PersistentSettings &persistentSettings_;
     mutable bool isFromDisconnectedVPNState_;
     ConnectState &connectState_;
     WSNetAdvancedParameters *advancedParameters_;
+    ServerListRequestFinishedCallback serverListCallback_;
+    ServerListAnswer answer_;
 };
 
 } // namespace wsnet
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace wsnet {
+
+// Lock-free multi-producer single-consumer queue.
+// Producers push onto an atomic stack, the consumer takes the whole stack at once and restores the FIFO order.
+// There is no ABA problem because the consumer never pops single nodes.
+template <typename T>
+class MpscQueue
+{
+public:
+    MpscQueue() : head_(nullptr) {}
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    ~MpscQueue()
+    {
+        takeAll();
+    }
+
+    // returns true if the queue was empty before the push, i.e. the consumer needs to be woken up
+    bool push(T value)
+    {
+        Node *node = new Node { std::move(value), head_.load(std::memory_order_relaxed) };
+        while (!head_.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {}
+        return node->next == nullptr;
+    }
+
+    // consumer only, returns the items in the push order
+    std::vector<T> takeAll()
+    {
+        std::vector<T> result;
+        Node *node = head_.exchange(nullptr, std::memory_order_acquire);
+        while (node) {
+            result.push_back(std::move(node->value));
+            Node *next = node->next;
+            delete node;
+            node = next;
+        }
+        std::reverse(result.begin(), result.end());
+        return result;
+    }
+
+private:
+    struct Node
+    {
+        T value;
+        Node *next;
+    };
+    std::atomic<Node *> head_;
+};
+
+} // namespace wsnet
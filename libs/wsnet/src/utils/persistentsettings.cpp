@@ -1,4 +1,6 @@
 #include "persistentsettings.h"
+#include <algorithm>
+#include <cassert>
 #include <rapidjson/document.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
@@ -7,7 +9,87 @@
 
 namespace wsnet {
 
-PersistentSettings::PersistentSettings(const std::string &settings)
+namespace {
+
+const char *kVersionKey = "version";
+const char *kFailoverStatsKey = "flvStats";
+
+const SettingValue &emptyValue()
+{
+    static const SettingValue value = std::make_shared<const std::string>();
+    return value;
+}
+
+// each value is an array [latencyMs, successCount, failureCount]
+void readFailoverStats(const rapidjson::Value &obj, std::map<std::string, FailoverStats> &failoverStats)
+{
+    for (auto &it : obj.GetObj()) {
+        if (!it.value.IsArray() || it.value.Size() != 3 || !it.value[0].IsUint() || !it.value[1].IsUint() || !it.value[2].IsUint())
+            continue;
+        failoverStats[it.name.GetString()] = FailoverStats { it.value[0].GetUint(), it.value[1].GetUint(), it.value[2].GetUint() };
+    }
+}
+
+rapidjson::Value writeFailoverStats(const std::map<std::string, FailoverStats> &failoverStats, rapidjson::Document::AllocatorType &allocator)
+{
+    using namespace rapidjson;
+    Value stats(kObjectType);
+    for (const auto &it : failoverStats) {
+        Value arr(kArrayType);
+        arr.PushBack(it.second.latencyMs, allocator);
+        arr.PushBack(it.second.successCount, allocator);
+        arr.PushBack(it.second.failureCount, allocator);
+        stats.AddMember(StringRef(it.first.c_str()), arr, allocator);
+    }
+    return stats;
+}
+
+} // namespace
+
+PersistentSettings::PersistentSettings(const std::string &settings, const std::string &settingsDir, bool isDirStale)
+{
+    for (auto &entry : entries_)
+        entry.value = emptyValue();
+
+    if (!settingsDir.empty()) {
+        storage_.reset(new PersistentSettingsStorage(settingsDir));
+        if (!storage_->isValid())
+            storage_.reset();
+    }
+
+    if (storage_) {
+        std::shared_ptr<const std::string> version;
+        if (isDirStale)
+            spdlog::info("ServerAPI settings in {} were not saved last time, use the json string", settingsDir);
+        else
+            version = storage_->read(kVersionKey);
+        if (version && *version == std::to_string(kVersion)) {
+            // the values are read on first access, only the small failover stats are read right away
+            for (auto &entry : entries_)
+                entry.isLoaded = false;
+            auto stats = storage_->read(kFailoverStatsKey);
+            if (stats) {
+                rapidjson::Document doc;
+                doc.Parse(stats->c_str(), stats->size());
+                if (!doc.HasParseError() && doc.IsObject())
+                    readFailoverStats(doc, failoverStats_);
+            }
+            spdlog::info("ServerAPI settings are stored in {}", settingsDir);
+            return;
+        }
+
+        // nothing is stored yet or the data format is changed, take the values from the json string (if any)
+        // and rewrite all the files on the next flush
+        for (auto &entry : entries_)
+            entry.isDirty = true;
+        isFailoverStatsDirty_ = true;
+        isVersionDirty_ = true;
+    }
+
+    parseJson(settings);
+}
+
+void PersistentSettings::parseJson(const std::string &settings)
 {
     using namespace rapidjson;
 
@@ -27,164 +109,283 @@ PersistentSettings::PersistentSettings(const std::string &settings)
             return;
         }
 
-        if (jsonObject.HasMember("flvId"))
-            failoverId_ = jsonObject["flvId"].GetString();
-        if (jsonObject.HasMember("countryOverride"))
-            countryOverride_ = jsonObject["countryOverride"].GetString();
-
-        if (jsonObject.HasMember("authHash"))
-            authHash_ = jsonObject["authHash"].GetString();
-        if (jsonObject.HasMember("sessionStatus"))
-            sessionStatus_ = jsonObject["sessionStatus"].GetString();
-        if (jsonObject.HasMember("locations"))
-            locations_ = jsonObject["locations"].GetString();
-        if (jsonObject.HasMember("serverCredentialsOvpn"))
-            serverCredentialsOvpn_ = jsonObject["serverCredentialsOvpn"].GetString();
-        if (jsonObject.HasMember("serverCredentialsIkev2"))
-            serverCredentialsIkev2_ = jsonObject["serverCredentialsIkev2"].GetString();
-        if (jsonObject.HasMember("serverConfigs"))
-            serverConfigs_ = jsonObject["serverConfigs"].GetString();
-        if (jsonObject.HasMember("portMap"))
-            portMap_ = jsonObject["portMap"].GetString();
-        if (jsonObject.HasMember("staticIps"))
-            staticIps_ = jsonObject["staticIps"].GetString();
-        if (jsonObject.HasMember("notifications"))
-            notifications_ = jsonObject["notifications"].GetString();
+        for (int i = 0; i < kKeysCount; ++i) {
+            auto it = jsonObject.FindMember(keyName((Key)i));
+            if (it != jsonObject.MemberEnd() && it->value.IsString())
+                entries_[i].value = std::make_shared<const std::string>(it->value.GetString(), it->value.GetStringLength());
+        }
+        if (entries_[kLocations].value->empty())
+            entries_[kLocationsETag].value = emptyValue();
+        if (jsonObject.HasMember(kFailoverStatsKey) && jsonObject[kFailoverStatsKey].IsObject())
+            readFailoverStats(jsonObject[kFailoverStatsKey], failoverStats_);
 
         spdlog::info("ServerAPI settings settled sucessfully");
     }
 }
 
+const char *PersistentSettings::keyName(Key key)
+{
+    switch (key) {
+    case kFailoverId: return "flvId";
+    case kCountryOverride: return "countryOverride";
+    case kAuthHash: return "authHash";
+    case kSessionStatus: return "sessionStatus";
+    case kLocations: return "locations";
+    case kLocationsETag: return "locationsETag";
+    case kServerCredentialsOvpn: return "serverCredentialsOvpn";
+    case kServerCredentialsIkev2: return "serverCredentialsIkev2";
+    case kServerConfigs: return "serverConfigs";
+    case kPortMap: return "portMap";
+    case kStaticIps: return "staticIps";
+    case kNotifications: return "notifications";
+    default:
+        assert(false);
+        return "";
+    }
+}
+
+SettingValue PersistentSettings::value(Key key) const
+{
+    Entry &entry = entries_[key];
+    if (!entry.isLoaded) {
+        entry.isLoaded = true;
+        auto value = storage_->read(keyName(key));
+        if (value)
+            entry.value = value;
+    }
+    return entry.value;
+}
+
+void PersistentSettings::setValue(Key key, const std::string &value)
+{
+    Entry &entry = entries_[key];
+    // the same value is not written again
+    if (entry.isLoaded && *entry.value == value)
+        return;
+    entry.value = value.empty() ? emptyValue() : std::make_shared<const std::string>(value);
+    entry.isLoaded = true;
+    entry.isDirty = true;
+}
+
 void PersistentSettings::setFailovedId(const std::string &failoverId)
 {
     std::lock_guard locker(mutex_);
-    failoverId_ = failoverId;
+    setValue(kFailoverId, failoverId);
 }
 
-std::string PersistentSettings::failoverId() const
+SettingValue PersistentSettings::failoverId() const
 {
     std::lock_guard locker(mutex_);
-    return failoverId_;
+    return value(kFailoverId);
 }
 
 void PersistentSettings::setCountryOverride(const std::string &countryOverride)
 {
     std::lock_guard locker(mutex_);
-    countryOverride_ = countryOverride;
+    setValue(kCountryOverride, countryOverride);
 }
 
-std::string PersistentSettings::countryOverride() const
+SettingValue PersistentSettings::countryOverride() const
 {
     std::lock_guard locker(mutex_);
-    return countryOverride_;
+    return value(kCountryOverride);
 }
 
 void PersistentSettings::setAuthHash(const std::string &authHash)
 {
     std::lock_guard locker(mutex_);
-    authHash_ = authHash;
+    setValue(kAuthHash, authHash);
 }
 
-std::string PersistentSettings::authHash() const
+SettingValue PersistentSettings::authHash() const
 {
     std::lock_guard locker(mutex_);
-    return authHash_;
+    return value(kAuthHash);
 }
 
 void PersistentSettings::setSessionStatus(const std::string &sessionStatus)
 {
     std::lock_guard locker(mutex_);
-    sessionStatus_ = sessionStatus;
+    setValue(kSessionStatus, sessionStatus);
 }
 
-std::string PersistentSettings::sessionStatus() const
+SettingValue PersistentSettings::sessionStatus() const
 {
     std::lock_guard locker(mutex_);
-    return sessionStatus_;
+    return value(kSessionStatus);
 }
 
-void PersistentSettings::setLocations(const std::string &locations)
+void PersistentSettings::setLocations(const std::string &locations, const std::string &etag)
 {
     std::lock_guard locker(mutex_);
-    locations_ = locations;
+    setValue(kLocations, locations);
+    setValue(kLocationsETag, etag);
 }
 
-std::string PersistentSettings::locations() const
+SettingValue PersistentSettings::locations() const
 {
     std::lock_guard locker(mutex_);
-    return locations_;
+    return value(kLocations);
+}
+
+SettingValue PersistentSettings::locationsETag() const
+{
+    std::lock_guard locker(mutex_);
+    return value(kLocationsETag);
 }
 
 void PersistentSettings::setServerCredentialsOvpn(const std::string &serverCredentials)
 {
     std::lock_guard locker(mutex_);
-    serverCredentialsOvpn_ = serverCredentials;
+    setValue(kServerCredentialsOvpn, serverCredentials);
 }
 
-std::string PersistentSettings::serverCredentialsOvpn() const
+SettingValue PersistentSettings::serverCredentialsOvpn() const
 {
     std::lock_guard locker(mutex_);
-    return serverCredentialsOvpn_;
+    return value(kServerCredentialsOvpn);
 }
 
 void PersistentSettings::setServerCredentialsIkev2(const std::string &serverCredentials)
 {
     std::lock_guard locker(mutex_);
-    serverCredentialsIkev2_ = serverCredentials;
+    setValue(kServerCredentialsIkev2, serverCredentials);
 }
 
-std::string PersistentSettings::serverCredentialsIkev2() const
+SettingValue PersistentSettings::serverCredentialsIkev2() const
 {
     std::lock_guard locker(mutex_);
-    return serverCredentialsIkev2_;
+    return value(kServerCredentialsIkev2);
 }
 
 void PersistentSettings::setServerConfigs(const std::string &serverConfigs)
 {
     std::lock_guard locker(mutex_);
-    serverConfigs_ = serverConfigs;
+    setValue(kServerConfigs, serverConfigs);
 }
 
-std::string PersistentSettings::serverConfigs() const
+SettingValue PersistentSettings::serverConfigs() const
 {
     std::lock_guard locker(mutex_);
-    return serverConfigs_;
+    return value(kServerConfigs);
 }
 
 void PersistentSettings::setPortMap(const std::string &portMap)
 {
     std::lock_guard locker(mutex_);
-    portMap_ = portMap;
+    setValue(kPortMap, portMap);
 }
 
-std::string PersistentSettings::portMap() const
+SettingValue PersistentSettings::portMap() const
 {
     std::lock_guard locker(mutex_);
-    return portMap_;
+    return value(kPortMap);
 }
 
 void PersistentSettings::setStaticIps(const std::string &staticIps)
 {
     std::lock_guard locker(mutex_);
-    staticIps_ = staticIps;
+    setValue(kStaticIps, staticIps);
 }
 
-std::string PersistentSettings::staticIps() const
+SettingValue PersistentSettings::staticIps() const
 {
     std::lock_guard locker(mutex_);
-    return staticIps_;
+    return value(kStaticIps);
 }
 
 void PersistentSettings::setNotifications(const std::string &notifications)
 {
     std::lock_guard locker(mutex_);
-    notifications_ = notifications;
+    setValue(kNotifications, notifications);
+}
+
+SettingValue PersistentSettings::notifications() const
+{
+    std::lock_guard locker(mutex_);
+    return value(kNotifications);
 }
 
-std::string PersistentSettings::notifications() const
+void PersistentSettings::updateFailoverStats(const std::string &failoverDataId, bool isSuccess, std::uint32_t latencyMs)
 {
     std::lock_guard locker(mutex_);
-    return notifications_;
+    auto it = failoverStats_.find(failoverDataId);
+    if (it == failoverStats_.end()) {
+        if (failoverStats_.size() >= kMaxFailoverStats) {
+            auto leastUsed = std::min_element(failoverStats_.begin(), failoverStats_.end(), [](const auto &l, const auto &r) {
+                return (std::uint64_t)l.second.successCount + l.second.failureCount < (std::uint64_t)r.second.successCount + r.second.failureCount;
+            });
+            failoverStats_.erase(leastUsed);
+        }
+        it = failoverStats_.insert(std::make_pair(failoverDataId, FailoverStats())).first;
+    }
+
+    FailoverStats &stats = it->second;
+    if (isSuccess) {
+        stats.latencyMs = stats.successCount == 0 ? latencyMs : (stats.latencyMs * 3 + latencyMs) / 4;
+        stats.successCount++;
+    } else {
+        stats.failureCount++;
+    }
+    isFailoverStatsDirty_ = true;
+}
+
+std::map<std::string, FailoverStats> PersistentSettings::failoverStats() const
+{
+    std::lock_guard locker(mutex_);
+    return failoverStats_;
+}
+
+bool PersistentSettings::flush()
+{
+    std::lock_guard locker(mutex_);
+    if (!storage_)
+        return false;
+
+    bool isOk = true;
+    for (int i = 0; i < kKeysCount; ++i) {
+        Entry &entry = entries_[i];
+        if (!entry.isDirty)
+            continue;
+        if (storage_->write(keyName((Key)i), *entry.value))
+            entry.isDirty = false;
+        else
+            isOk = false;
+    }
+
+    if (isFailoverStatsDirty_) {
+        std::string json;
+        if (!failoverStats_.empty()) {
+            rapidjson::Document doc;
+            rapidjson::Value stats = writeFailoverStats(failoverStats_, doc.GetAllocator());
+            rapidjson::StringBuffer sb;
+            rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+            stats.Accept(writer);
+            json = sb.GetString();
+        }
+        if (storage_->write(kFailoverStatsKey, json))
+            isFailoverStatsDirty_ = false;
+        else
+            isOk = false;
+    }
+
+    // the version is written last, so that an interrupted migration is repeated on the next start
+    if (isVersionDirty_ && isOk) {
+        if (storage_->write(kVersionKey, std::to_string(kVersion)))
+            isVersionDirty_ = false;
+        else
+            isOk = false;
+    }
+
+    // some files are stale now and the caller keeps the json string instead, remove the version so that the json
+    // string is taken on the next start; the version is written again once all the values are written
+    if (!isOk && !isVersionDirty_) {
+        spdlog::error("Failed to write the ServerAPI settings to the files, use the json string on the next start");
+        if (!storage_->write(kVersionKey, std::string()))
+            spdlog::error("Failed to remove the version of the ServerAPI settings files, the files are stale until the next save");
+        isVersionDirty_ = true;
+    }
+    return isOk;
 }
 
 std::string PersistentSettings::getAsString() const
@@ -195,29 +396,18 @@ std::string PersistentSettings::getAsString() const
     Document doc;
     doc.SetObject();
     doc.AddMember("version", kVersion, doc.GetAllocator());
-    if (!failoverId_.empty())
-        doc.AddMember("flvId", StringRef(failoverId_.c_str()), doc.GetAllocator());
-    if (!countryOverride_.empty())
-        doc.AddMember("countryOverride", StringRef(countryOverride_.c_str()), doc.GetAllocator());
-
-    if (!authHash_.empty())
-        doc.AddMember("authHash", StringRef(authHash_.c_str()), doc.GetAllocator());
-    if (!sessionStatus_.empty())
-        doc.AddMember("sessionStatus", StringRef(sessionStatus_.c_str()), doc.GetAllocator());
-    if (!locations_.empty())
-        doc.AddMember("locations", StringRef(locations_.c_str()), doc.GetAllocator());
-    if (!serverCredentialsOvpn_.empty())
-        doc.AddMember("serverCredentialsOvpn", StringRef(serverCredentialsOvpn_.c_str()), doc.GetAllocator());
-    if (!serverCredentialsIkev2_.empty())
-        doc.AddMember("serverCredentialsIkev2", StringRef(serverCredentialsIkev2_.c_str()), doc.GetAllocator());
-    if (!serverConfigs_.empty())
-        doc.AddMember("serverConfigs", StringRef(serverConfigs_.c_str()), doc.GetAllocator());
-    if (!portMap_.empty())
-        doc.AddMember("portMap", StringRef(portMap_.c_str()), doc.GetAllocator());
-    if (!staticIps_.empty())
-        doc.AddMember("staticIps", StringRef(staticIps_.c_str()), doc.GetAllocator());
-    if (!notifications_.empty())
-        doc.AddMember("notifications", StringRef(notifications_.c_str()), doc.GetAllocator());
+
+    // the values are held here until the json is written
+    std::array<SettingValue, kKeysCount> values;
+    for (int i = 0; i < kKeysCount; ++i) {
+        values[i] = value((Key)i);
+        if (!values[i]->empty())
+            doc.AddMember(StringRef(keyName((Key)i)), StringRef(values[i]->c_str(), values[i]->size()), doc.GetAllocator());
+    }
+    if (!failoverStats_.empty()) {
+        Value stats = writeFailoverStats(failoverStats_, doc.GetAllocator());
+        doc.AddMember(StringRef(kFailoverStatsKey), stats, doc.GetAllocator());
+    }
 
     StringBuffer sb;
     Writer<StringBuffer> writer(sb);
@@ -1,71 +1,111 @@
 #pragma once
+#include <array>
 #include <string>
+#include <memory>
 #include <mutex>
+#include <map>
+#include "persistentsettingsstorage.h"
 
 namespace wsnet {
 
-// Stores persistent settings for lib. Uses the json format.
+// Statistics of API requests made through a failover domain
+struct FailoverStats
+{
+    std::uint32_t latencyMs = 0;        // exponential moving average of successful requests
+    std::uint32_t successCount = 0;
+    std::uint32_t failureCount = 0;
+};
+
+// An immutable value shared between the settings and the readers, never null.
+typedef std::shared_ptr<const std::string> SettingValue;
+
+// Stores persistent settings for lib.
+// If settingsDir is empty, all the settings are kept in one json string, which is passed in the constructor and returned by getAsString().
+// Otherwise each value is stored in its own file in settingsDir (see PersistentSettingsStorage): a value is read on first access
+// and flush() writes only the changed values. The json string is then used only once, to migrate the settings of the previous versions.
 // thread safe
 class PersistentSettings
 {
 public:
-    explicit PersistentSettings(const std::string &settings);
+    // isDirStale - the files of settingsDir are not used, the values are taken from the json string and rewritten on flush()
+    explicit PersistentSettings(const std::string &settings, const std::string &settingsDir = std::string(), bool isDirStale = false);
 
     // empty string means no value for all functions
     void setFailovedId(const std::string &failoverId);
-    std::string failoverId() const;
+    SettingValue failoverId() const;
 
     void setCountryOverride(const std::string &countryOverride);
-    std::string countryOverride() const;
+    SettingValue countryOverride() const;
 
     void setAuthHash(const std::string &authHash);
-    std::string authHash() const;
+    SettingValue authHash() const;
 
     void setSessionStatus(const std::string &sessionStatus);
-    std::string sessionStatus() const;
+    SettingValue sessionStatus() const;
 
-    void setLocations(const std::string &locations);
-    std::string locations() const;
+    // the ETag is stored together with the locations, so it always refers to the stored list
+    void setLocations(const std::string &locations, const std::string &etag = std::string());
+    SettingValue locations() const;
+    SettingValue locationsETag() const;
 
     void setServerCredentialsOvpn(const std::string &serverCredentials);
-    std::string serverCredentialsOvpn() const;
+    SettingValue serverCredentialsOvpn() const;
 
     void setServerCredentialsIkev2(const std::string &serverCredentials);
-    std::string serverCredentialsIkev2() const;
+    SettingValue serverCredentialsIkev2() const;
 
     // openvpn config
     void setServerConfigs(const std::string &serverConfigs);
-    std::string serverConfigs() const;
+    SettingValue serverConfigs() const;
 
     void setPortMap(const std::string &portMap);
-    std::string portMap() const;
+    SettingValue portMap() const;
 
     void setStaticIps(const std::string &staticIps);
-    std::string staticIps() const;
+    SettingValue staticIps() const;
 
     void setNotifications(const std::string &notifications);
-    std::string notifications() const;
+    SettingValue notifications() const;
 
+    // failoverDataId is a hash of FailoverData::uniqueId(), the domains themselves are not stored
+    void updateFailoverStats(const std::string &failoverDataId, bool isSuccess, std::uint32_t latencyMs);
+    std::map<std::string, FailoverStats> failoverStats() const;
+
+    // writes the changed values to settingsDir, returns false if there is no settingsDir or a write failed;
+    // after a failed write the json string of getAsString() must be kept and passed with isDirStale on the next start,
+    // the version file is also removed but that may fail too
+    bool flush();
     std::string getAsString() const;
 
 private:
     // should increment the version if the data format is changed
     static constexpr int kVersion = 1;
+    // keep the stats only for a limited number of domains, the least used are evicted
+    static constexpr size_t kMaxFailoverStats = 32;
+
+    enum Key { kFailoverId, kCountryOverride, kAuthHash, kSessionStatus, kLocations, kLocationsETag, kServerCredentialsOvpn,
+               kServerCredentialsIkev2, kServerConfigs, kPortMap, kStaticIps, kNotifications, kKeysCount };
 
-    std::string failoverId_;
-    std::string countryOverride_;
+    struct Entry
+    {
+        SettingValue value;
+        bool isLoaded = true;
+        bool isDirty = false;
+    };
 
-    std::string authHash_;
-    std::string sessionStatus_;
-    std::string locations_;
-    std::string serverCredentialsOvpn_;
-    std::string serverCredentialsIkev2_;
-    std::string serverConfigs_;
-    std::string portMap_;
-    std::string staticIps_;
-    std::string notifications_;
+    mutable std::array<Entry, kKeysCount> entries_;
+    std::map<std::string, FailoverStats> failoverStats_;
+    bool isFailoverStatsDirty_ = false;
+    bool isVersionDirty_ = false;
+    std::unique_ptr<PersistentSettingsStorage> storage_;
 
     mutable std::mutex mutex_;
+
+    // the json key, also the file name in the storage
+    static const char *keyName(Key key);
+    void parseJson(const std::string &settings);
+    SettingValue value(Key key) const;
+    void setValue(Key key, const std::string &value);
 };
 
 } // namespace wsnet
@@ -0,0 +1,176 @@
+#include "persistentsettingsstorage.h"
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <boost/filesystem.hpp>
+#include <spdlog/spdlog.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace wsnet {
+
+namespace {
+
+const char kMagic[4] = { 'W', 'S', 'P', 'S' };
+
+std::uint32_t crc32(const char *data, size_t size)
+{
+    static const auto table = [] {
+        std::array<std::uint32_t, 256> t;
+        for (std::uint32_t i = 0; i < 256; ++i) {
+            std::uint32_t c = i;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    std::uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < size; ++i)
+        crc = table[(crc ^ (std::uint8_t)data[i]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFF;
+}
+
+void putUint(char *p, std::uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; ++i)
+        p[i] = (char)((value >> (8 * i)) & 0xFF);
+}
+
+std::uint64_t getUint(const char *p, int bytes)
+{
+    std::uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i)
+        value |= (std::uint64_t)(std::uint8_t)p[i] << (8 * i);
+    return value;
+}
+
+// the directory comes in UTF-8
+boost::filesystem::path toPath(const std::string &str)
+{
+#ifdef _WIN32
+    int len = MultiByteToWideChar(CP_UTF8, 0, str.c_str(), (int)str.size(), NULL, 0);
+    std::wstring wstr(len, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, str.c_str(), (int)str.size(), &wstr[0], len);
+    return boost::filesystem::path(wstr);
+#else
+    return boost::filesystem::path(str);
+#endif
+}
+
+FILE *openFile(const boost::filesystem::path &path, bool isWrite)
+{
+#ifdef _WIN32
+    return _wfopen(path.c_str(), isWrite ? L"wb" : L"rb");
+#else
+    return fopen(path.c_str(), isWrite ? "wb" : "rb");
+#endif
+}
+
+bool syncFile(FILE *f)
+{
+    if (fflush(f) != 0)
+        return false;
+#ifdef _WIN32
+    return _commit(_fileno(f)) == 0;
+#else
+    return fsync(fileno(f)) == 0;
+#endif
+}
+
+} // namespace
+
+PersistentSettingsStorage::PersistentSettingsStorage(const std::string &dir) : dir_(dir)
+{
+    boost::system::error_code ec;
+    boost::filesystem::create_directories(toPath(dir_), ec);
+    isValid_ = boost::filesystem::is_directory(toPath(dir_), ec);
+    if (!isValid_)
+        spdlog::error("PersistentSettingsStorage: can't create the directory: {}", ec.message());
+}
+
+bool PersistentSettingsStorage::exists(const std::string &key) const
+{
+    boost::system::error_code ec;
+    return boost::filesystem::exists(toPath(filePath(key)), ec);
+}
+
+std::shared_ptr<const std::string> PersistentSettingsStorage::read(const std::string &key) const
+{
+    const boost::filesystem::path path = toPath(filePath(key));
+    boost::system::error_code ec;
+    const std::uint64_t fileSize = boost::filesystem::file_size(path, ec);
+    if (ec)
+        return nullptr;
+    FILE *f = openFile(path, false);
+    if (!f)
+        return nullptr;
+
+    std::shared_ptr<std::string> value;
+    char header[kHeaderSize];
+    if (fread(header, 1, kHeaderSize, f) == kHeaderSize && memcmp(header, kMagic, sizeof(kMagic)) == 0 &&
+        getUint(header + 4, 4) == kFormatVersion && getUint(header + 8, 8) == fileSize - kHeaderSize) {
+        const size_t size = (size_t)(fileSize - kHeaderSize);
+        const std::uint32_t crc = (std::uint32_t)getUint(header + 16, 4);
+        // the payload is read directly into the string which is then shared by all readers
+        value = std::make_shared<std::string>(size, '\0');
+        if (size > 0 && (fread(&(*value)[0], 1, size, f) != size || crc32(value->data(), value->size()) != crc))
+            value.reset();
+    }
+    fclose(f);
+
+    if (!value)
+        spdlog::error("PersistentSettingsStorage: the value of {} is corrupted, ignored", key);
+    return value;
+}
+
+bool PersistentSettingsStorage::write(const std::string &key, const std::string &value)
+{
+    boost::system::error_code ec;
+    const boost::filesystem::path path = toPath(filePath(key));
+    if (value.empty()) {
+        boost::filesystem::remove(path, ec);
+        return !ec;
+    }
+
+    char header[kHeaderSize];
+    memcpy(header, kMagic, sizeof(kMagic));
+    putUint(header + 4, kFormatVersion, 4);
+    putUint(header + 8, value.size(), 8);
+    putUint(header + 16, crc32(value.data(), value.size()), 4);
+
+    const boost::filesystem::path tmpPath = toPath(filePath(key) + ".tmp");
+    FILE *f = openFile(tmpPath, true);
+    if (!f) {
+        spdlog::error("PersistentSettingsStorage: can't open {} for writing", key);
+        return false;
+    }
+    bool isOk = fwrite(header, 1, kHeaderSize, f) == kHeaderSize &&
+                fwrite(value.data(), 1, value.size(), f) == value.size() &&
+                syncFile(f);
+    isOk = (fclose(f) == 0) && isOk;
+
+    if (isOk) {
+        // rename replaces the old file atomically, a reader sees either the old or the new content
+        boost::filesystem::rename(tmpPath, path, ec);
+        isOk = !ec;
+    }
+    if (!isOk) {
+        spdlog::error("PersistentSettingsStorage: can't write {}", key);
+        boost::filesystem::remove(tmpPath, ec);
+    }
+    return isOk;
+}
+
+std::string PersistentSettingsStorage::filePath(const std::string &key) const
+{
+    return dir_ + "/" + key + ".dat";
+}
+
+} // namespace wsnet
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace wsnet {
+
+// File storage of the persistent settings, one file per key in the given directory.
+// File layout: magic "WSPS", format version (uint32), payload size (uint64), crc32 of the payload (uint32), payload.
+// All numbers are little-endian. A file with another version, a wrong size or a wrong checksum is treated as absent.
+// A file is replaced atomically: the new content is written to a temporary file, which is then renamed over the old one.
+// not thread safe, the owner must serialize the calls
+class PersistentSettingsStorage
+{
+public:
+    explicit PersistentSettingsStorage(const std::string &dir);
+
+    // false if the directory does not exist and cannot be created
+    bool isValid() const { return isValid_; }
+
+    bool exists(const std::string &key) const;
+    // returns nullptr if there is no value or the file is corrupted
+    std::shared_ptr<const std::string> read(const std::string &key) const;
+    // an empty value removes the file
+    bool write(const std::string &key, const std::string &value);
+
+private:
+    // should increment the version if the file layout is changed
+    static constexpr std::uint32_t kFormatVersion = 1;
+    static constexpr size_t kHeaderSize = 4 + 4 + 8 + 4;
+
+    std::string dir_;
+    bool isValid_ = false;
+
+    std::string filePath(const std::string &key) const;
+};
+
+} // namespace wsnet
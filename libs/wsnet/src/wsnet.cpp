@@ -41,7 +41,8 @@ public:
 
     bool initializeImpl(const std::string &basePlatform,  const std::string &platformName, const std::string &appVersion, const std::string &deviceId,
                         const std::string &openVpnVersion, const std::string &sessionTypeId,
-                        bool isUseStagingDomains, const std::string &language, const std::string &persistentSettings)
+                        bool isUseStagingDomains, const std::string &language, const std::string &persistentSettings,
+                        const std::string &persistentSettingsDir, bool isPersistentSettingsDirStale)
     {
         spdlog::info("wsnet version: {}.{}.{}", WINDSCRIBE_MAJOR_VERSION, WINDSCRIBE_MINOR_VERSION, WINDSCRIBE_BUILD_VERSION);
 
@@ -73,7 +74,7 @@ public:
         Settings::instance().setLanguage(language);
         Settings::instance().setSessionTypeId(sessionTypeId);
 
-        persistentSettings_.reset(new PersistentSettings(persistentSettings));
+        persistentSettings_.reset(new PersistentSettings(persistentSettings, persistentSettingsDir, isPersistentSettingsDirStale));
 
         failoverContainer_ = std::make_unique<FailoverContainer>(httpNetworkManager_.get());
         advancedParameters_ = std::make_shared<AdvancedParameters>();
@@ -94,8 +95,9 @@ public:
     {
         if (connectState_.isVPNConnected() != isConnected) {
             connectState_.setIsConnectedToVpnState(isConnected);
-            // When connecting/disconnecting the VPN clear the DNS cache.
+            // When connecting/disconnecting the VPN clear the DNS cache and drop the pooled connections.
             httpNetworkManager_->clearDnsCache();
+            httpNetworkManager_->resetConnectionPools();
         }
     }
 
@@ -104,6 +106,11 @@ public:
         return persistentSettings_->getAsString();
     }
 
+    bool savePersistentSettings() override
+    {
+        return persistentSettings_->flush();
+    }
+
     std::shared_ptr<WSNetDnsResolver> dnsResolver() override { return dnsResolver_; }
     std::shared_ptr<WSNetHttpNetworkManager> httpNetworkManager() override { return httpNetworkManager_; }
     std::shared_ptr<WSNetServerAPI> serverAPI() override { return serverAPI_; }
@@ -152,13 +159,15 @@ void WSNet::setLogger(WSNetLoggerFunction loggerFunction, bool debugLog)
 
 bool WSNet::initialize(const std::string &basePlatform,  const std::string &platformName, const std::string &appVersion, const std::string &deviceId,
                        const std::string &openVpnVersion, const std::string &sessionTypeId,
-                       bool isUseStagingDomains, const std::string &language, const std::string &persistentSettings)
+                       bool isUseStagingDomains, const std::string &language, const std::string &persistentSettings,
+                       const std::string &persistentSettingsDir, bool isPersistentSettingsDirStale)
 {
     std::lock_guard locker(g_mutex);
     assert(g_wsNet == nullptr);
     g_wsNet.reset(new WSNet_impl);
     return g_wsNet->initializeImpl(basePlatform, platformName, appVersion, deviceId, openVpnVersion,
-                                   sessionTypeId, isUseStagingDomains, language, persistentSettings);
+                                   sessionTypeId, isUseStagingDomains, language, persistentSettings, persistentSettingsDir,
+                                   isPersistentSettingsDirStale);
 }
 
 std::shared_ptr<WSNet> WSNet::instance()